@@ -0,0 +1,236 @@
+#include "bench.h"
+#include <aura-core/build.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <fstream>
+
+namespace aura
+{
+
+namespace
+{
+
+//! Text after '"key": ' in one of our own result lines, up to the next ',' or '}'
+std::string json_field(std::string const& line, char const* key)
+{
+  auto const tag = std::string{"\""} + key + "\": ";
+  auto begin = line.find(tag);
+  if (begin == std::string::npos)
+  {
+    return {};
+  }
+  begin += tag.size();
+  if (line[begin] == '"')
+  {
+    ++begin;
+    return line.substr(begin, line.find('"', begin) - begin);
+  }
+  return line.substr(begin, line.find_first_of(",}", begin) - begin);
+}
+
+double json_number(std::string const& line, char const* key)
+{
+  return std::strtod(json_field(line, key).c_str(), nullptr);
+}
+
+} // namespace {}
+
+bench_runner::bench_runner(bench_config config)
+  : m_config{std::move(config)}
+{
+  using clock = std::chrono::steady_clock;
+  auto overhead = std::chrono::nanoseconds::max();
+  for (int i = 0; i < 1000; ++i)
+  {
+    auto const start = clock::now();
+    overhead = std::min(overhead, std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start));
+  }
+  m_clock_overhead_ps = overhead.count() * 1000;
+}
+
+bool bench_runner::wants(std::string const& name) const
+{
+  return m_config.filter.empty() || name.find(m_config.filter) != std::string::npos;
+}
+
+void bench_runner::set_items(double items_per_call)
+{
+  if (!m_results.empty())
+  {
+    m_results.back().items = items_per_call;
+  }
+}
+
+void bench_runner::record_bytes(std::string const& name, std::string const& board, std::size_t bytes)
+{
+  if (!wants(name))
+  {
+    return;
+  }
+  bench_result r;
+  r.name = name;
+  r.board = board;
+  r.bytes = static_cast<double>(bytes);
+  m_results.emplace_back(std::move(r));
+}
+
+void bench_runner::add(std::string const& name, std::string const& board, histogram const& ps_per_call,
+  std::uint64_t allocations, std::int64_t allocation_budget, bool over_budget)
+{
+  bench_result r;
+  r.name = name;
+  r.board = board;
+  r.ops = ps_per_call.count();
+  r.mean_ns = ps_per_call.mean() / 1000.0;
+  r.p50_ns = static_cast<double>(ps_per_call.value_at_percentile(50.0)) / 1000.0;
+  r.p99_ns = static_cast<double>(ps_per_call.value_at_percentile(99.0)) / 1000.0;
+  r.min_ns = static_cast<double>(ps_per_call.min()) / 1000.0;
+  r.allocations = static_cast<double>(allocations) / static_cast<double>(std::max<std::uint64_t>(1, r.ops));
+  r.allocation_budget = static_cast<double>(allocation_budget);
+  r.over_budget = over_budget;
+  m_results.emplace_back(std::move(r));
+}
+
+void print_results(std::vector<bench_result> const& results)
+{
+  AURA_PRINT(L"%-36hs %6ls %12ls %12ls %12ls %12ls %10ls %10ls\n", "benchmark", L"board", L"mean ns", L"p50 ns",
+    L"p99 ns", L"min ns", L"allocs", L"items/s");
+  for (auto const& r : results)
+  {
+    if (r.bytes > 0.0)
+    {
+      AURA_PRINT(L"%-36hs %6hs %12.0f bytes\n", r.name.c_str(), r.board.c_str(), r.bytes);
+      continue;
+    }
+    wchar_t items_per_second[24] = L"-";
+    if (r.items > 0.0 && r.mean_ns > 0.0)
+    {
+      std::swprintf(items_per_second, 24, L"%.0f", r.items * 1e9 / r.mean_ns);
+    }
+    AURA_PRINT(L"%-36hs %6hs %12.1f %12.1f %12.1f %12.1f %10.2f %10ls%hs\n", r.name.c_str(), r.board.c_str(), r.mean_ns,
+      r.p50_ns, r.p99_ns, r.min_ns, r.allocations, items_per_second, r.over_budget ? "  OVER BUDGET" : "");
+  }
+}
+
+std::error_code write_results(std::vector<bench_result> const& results, std::string const& path)
+{
+  auto* f = std::fopen(path.c_str(), "w");
+  if (!f)
+  {
+    return {errno, std::generic_category()};
+  }
+  std::fprintf(f, "{\n  \"suite\": \"aura-core\",\n");
+  // logging and debug checks sit on the measured paths, so they travel with the numbers
+#ifdef NDEBUG
+  constexpr bool asserts = false;
+#else
+  constexpr bool asserts = true;
+#endif
+  std::fprintf(f, "  \"build\": {\"asserts\": %s, \"min_log_level\": %d, \"counting_allocations\": %s},\n",
+    asserts ? "true" : "false", AURA_MIN_LOG_LEVEL, counting_allocations ? "true" : "false");
+  std::fprintf(f, "  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    auto const& r = results[i];
+    std::fprintf(f,
+      "    {\"name\": \"%s\", \"board\": \"%s\", \"ops\": %llu, \"mean_ns\": %.3f, \"p50_ns\": %.3f, "
+      "\"p99_ns\": %.3f, \"min_ns\": %.3f, \"allocations\": %.3f, \"items\": %.3f, \"allocation_budget\": %.0f, "
+      "\"over_budget\": %s, \"bytes\": %.0f}%s\n",
+      r.name.c_str(), r.board.c_str(), static_cast<unsigned long long>(r.ops), r.mean_ns, r.p50_ns, r.p99_ns, r.min_ns,
+      r.allocations, r.items, r.allocation_budget, r.over_budget ? "true" : "false", r.bytes,
+      i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+  if (std::fclose(f) != 0)
+  {
+    return {errno, std::generic_category()};
+  }
+  return {};
+}
+
+std::pair<std::error_code, std::vector<bench_result>> read_results(std::string const& path)
+{
+  std::ifstream in{path};
+  if (!in)
+  {
+    return {std::make_error_code(std::errc::no_such_file_or_directory), {}};
+  }
+  std::vector<bench_result> results;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    auto name = json_field(line, "name");
+    if (name.empty())
+    {
+      continue;
+    }
+    bench_result r;
+    r.name = std::move(name);
+    r.board = json_field(line, "board");
+    r.ops = static_cast<std::uint64_t>(json_number(line, "ops"));
+    r.mean_ns = json_number(line, "mean_ns");
+    r.p50_ns = json_number(line, "p50_ns");
+    r.p99_ns = json_number(line, "p99_ns");
+    r.min_ns = json_number(line, "min_ns");
+    r.allocations = json_number(line, "allocations");
+    r.items = json_number(line, "items");
+    // results written before budgets existed had none
+    auto const budget = json_field(line, "allocation_budget");
+    r.allocation_budget = budget.empty() ? -1.0 : std::strtod(budget.c_str(), nullptr);
+    r.over_budget = json_field(line, "over_budget") == "true";
+    r.bytes = json_number(line, "bytes");
+    results.emplace_back(std::move(r));
+  }
+  return {{}, std::move(results)};
+}
+
+int compare_results(std::vector<bench_result> const& baseline, std::vector<bench_result> const& results,
+  double threshold_percent)
+{
+  int num_regressed = 0;
+  AURA_PRINT(L"\n%-36hs %6ls %12ls %12ls %8ls\n", "against baseline", L"board", L"was", L"now", L"change");
+  for (auto const& r : results)
+  {
+    auto const it = std::find_if(baseline.begin(), baseline.end(), [&](bench_result const& b)
+    {
+      return b.name == r.name && b.board == r.board;
+    });
+    if (it == baseline.end())
+    {
+      continue;
+    }
+    // size results are held to their bytes, timed ones to their median
+    auto const sized = r.bytes > 0.0;
+    auto const was = sized ? it->bytes : it->p50_ns;
+    auto const now = sized ? r.bytes : r.p50_ns;
+    if (was <= 0.0)
+    {
+      continue;
+    }
+    auto const change = 100.0 * (now - was) / was;
+    auto const regressed = change > threshold_percent;
+    num_regressed += regressed ? 1 : 0;
+    AURA_PRINT(L"%-36hs %6hs %12.1f %12.1f %+7.1f%%%hs\n", r.name.c_str(), r.board.c_str(), was, now, change,
+      regressed ? (sized ? "  LARGER" : "  SLOWER") : "");
+  }
+  return num_regressed;
+}
+
+int check_allocation_budgets(std::vector<bench_result> const& results)
+{
+  int num_over = 0;
+  for (auto const& r : results)
+  {
+    if (r.over_budget)
+    {
+      AURA_PRINT(L"%hs %hs: %.2f allocations per call, over its budget of %.0f\n", r.name.c_str(), r.board.c_str(),
+        r.allocations, r.allocation_budget);
+      ++num_over;
+    }
+  }
+  return num_over;
+}
+
+} // namespace aura
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <aura-core/allocation_counter.h>
+#include <aura-core/histogram.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace aura
+{
+
+//! Keeps the compiler from optimizing away a value a benchmark computes
+template <typename T>
+inline void keep(T const& value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static_cast<void>(*static_cast<char const volatile*>(static_cast<void const*>(&value)));
+#endif
+}
+
+struct bench_result
+{
+  std::string name;
+  std::string board;           //!< lanes x lane height, e.g. "4x4"
+  std::uint64_t ops{0};        //!< timed calls
+  double mean_ns{0.0};         //!< per call
+  double p50_ns{0.0};
+  double p99_ns{0.0};
+  double min_ns{0.0};
+  double allocations{0.0};     //!< per call; counted builds only
+  double items{0.0};           //!< per call, e.g. actions per game; 0 if not applicable
+  double allocation_budget{-1.0};  //!< most allocations a call may make; negative if it has none
+  bool over_budget{false};     //!< a batch went over the budget; counted builds only
+  double bytes{0.0};           //!< what a measured object holds, for size results; 0 for timed ones
+};
+
+struct bench_config
+{
+  std::chrono::milliseconds min_time{300};  //!< per benchmark, setup included
+  std::string filter;                       //!< runs only names containing this
+};
+
+//! Times operations in batches. Each batch is timed as a whole and recorded
+//! per call, so the percentiles describe batches of calls rather than single
+//! calls unless the batch size is 1.
+class bench_runner
+{
+public:
+  explicit bench_runner(bench_config config);
+
+  bool wants(std::string const& name) const;
+
+  //! For benchmarks whose calls may allocate as much as they like
+  static constexpr std::int64_t no_budget = -1;
+
+  //! Times 'op'. 'setup' runs untimed before every batch of 'batch_size'
+  //! calls; a batch size of 0 picks one that takes ~20us. In counted builds
+  //! a batch that allocates more than 'allocation_budget' per call marks
+  //! the result over budget.
+  template <typename Setup, typename Op>
+  void run(std::string const& name, std::string const& board, int batch_size, Setup const& setup, Op const& op,
+    std::int64_t allocation_budget = no_budget)
+  {
+    if (!wants(name))
+    {
+      return;
+    }
+    using clock = std::chrono::steady_clock;
+    if (batch_size <= 0)
+    {
+      batch_size = 1;
+      while (batch_size < (1 << 20))
+      {
+        setup();
+        auto const start = clock::now();
+        for (int i = 0; i < batch_size; ++i)
+        {
+          op();
+        }
+        if (clock::now() - start >= std::chrono::microseconds{20})
+        {
+          break;
+        }
+        batch_size *= 2;
+      }
+    }
+
+    histogram ps_per_call;  // picoseconds keep a few ns worth recording
+    std::uint64_t allocations = 0;
+    bool over_budget = false;
+    int batches = 0;
+    auto const deadline = clock::now() + m_config.min_time;
+    do
+    {
+      setup();
+      allocation_scope const scope;
+      auto const start = clock::now();
+      for (int i = 0; i < batch_size; ++i)
+      {
+        op();
+      }
+      auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+      auto const batch_allocations = scope.counts().allocations;
+      allocations += batch_allocations;
+      over_budget |= allocation_budget >= 0
+        && batch_allocations > static_cast<std::uint64_t>(allocation_budget) * static_cast<std::uint64_t>(batch_size);
+      auto const ps = std::max<std::int64_t>(0, elapsed * 1000 - m_clock_overhead_ps);
+      ps_per_call.record(static_cast<std::uint64_t>(ps / batch_size), static_cast<std::uint64_t>(batch_size));
+      ++batches;
+    } while (clock::now() < deadline || batches < min_batches);
+
+    add(name, board, ps_per_call, allocations, allocation_budget, over_budget);
+  }
+
+  template <typename Op>
+  void run(std::string const& name, std::string const& board, Op const& op, std::int64_t allocation_budget = no_budget)
+  {
+    run(name, board, 0, [] {}, op, allocation_budget);
+  }
+
+  //! Sets what the last benchmark did per call, for throughput figures
+  void set_items(double items_per_call);
+
+  //! Records a size rather than a timing, e.g. what a session holds in
+  //! memory; a baseline holds it to the same threshold as the medians
+  void record_bytes(std::string const& name, std::string const& board, std::size_t bytes);
+
+  std::vector<bench_result> const& results() const noexcept { return m_results; }
+
+private:
+  static constexpr int min_batches = 16;
+
+  void add(std::string const& name, std::string const& board, histogram const& ps_per_call, std::uint64_t allocations,
+    std::int64_t allocation_budget, bool over_budget);
+
+  bench_config m_config;
+  std::int64_t m_clock_overhead_ps{0};  //!< of reading the clock twice, taken off every batch
+  std::vector<bench_result> m_results;
+};
+
+//! Prints a table of 'results'
+void print_results(std::vector<bench_result> const& results);
+
+//! Writes 'results' as JSON, one result per line, along with the build
+//! settings that change the numbers
+std::error_code write_results(std::vector<bench_result> const& results, std::string const& path);
+
+//! Reads results back from write_results()
+std::pair<std::error_code, std::vector<bench_result>> read_results(std::string const& path);
+
+//! Prints how 'results' moved against 'baseline' and returns how many got
+//! slower at the median, or larger for size results, by more than
+//! 'threshold_percent'
+int compare_results(std::vector<bench_result> const& baseline, std::vector<bench_result> const& results,
+  double threshold_percent);
+
+//! Prints the results that went over their allocation budget and returns
+//! how many did
+int check_allocation_budgets(std::vector<bench_result> const& results);
+
+} // namespace aura
@@ -0,0 +1,448 @@
+#include "core_benchmarks.h"
+#include <aura-core/build.h>
+#include <aura-core/card_preset_definitions.h>
+#include <aura-core/local_rules_engine.h>
+#include <aura-core/lockstep_rules_engine.h>
+#include <aura-core/player_action.h>
+#include <aura-core/session_digest.h>
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <random>
+
+namespace aura
+{
+
+//! Reaches the engine internals the benchmarks time
+struct engine_bench
+{
+  static card_info* find_actor(local_rules_engine& engine, int uid) { return engine.find_actor(uid); }
+
+  static card_info* find_target(local_rules_engine& engine, int uid) { return engine.find_target(uid); }
+
+  static void apply_all_terrain_modifiers(local_rules_engine& engine)
+  {
+    engine.apply_all_terrain_modifiers(engine.m_session_info);
+  }
+};
+
+namespace
+{
+
+constexpr int max_actions_per_game = 5000;
+
+//! Turn the prepared mid-game positions are taken at
+constexpr int midgame_turn = 20;
+
+struct board
+{
+  int num_lanes;
+  int max_lane_height;
+};
+
+constexpr board boards[] = {{4, 4}, {8, 8}};
+
+std::string to_string(board b)
+{
+  return std::to_string(b.num_lanes) + "x" + std::to_string(b.max_lane_height);
+}
+
+ruleset make_rules(board b)
+{
+  ruleset rs;
+  rs.num_lanes = b.num_lanes;
+  rs.max_lane_height = b.max_lane_height;
+  return rs;
+}
+
+//! Plays every affordable card and attacks straight down each lane with
+//! every card that can act, trying each card once a turn. Without 'attack'
+//! nobody takes damage, so the lanes fill up instead.
+class bot
+{
+public:
+  bot(std::uint64_t seed, bool attack)
+    : m_rng{static_cast<unsigned>(seed)}
+    , m_attack{attack}
+  {
+  }
+
+  player_action next(session_info const& info)
+  {
+    if (info.turn != m_turn || info.current_player != m_player)
+    {
+      m_tried.clear();
+      m_turn = info.turn;
+      m_player = info.current_player;
+    }
+
+    auto const& me = info.players[info.current_player];
+    auto const& other = info.players[1 - info.current_player];
+    if (!info.picks.empty() && me.picks_available)
+    {
+      return {action_type::pick, info.picks[m_rng() % info.picks.size()].uid, 0};
+    }
+    for (auto const& card : me.hand)
+    {
+      if (card.cost <= me.mana && !card.has_trait(unit_traits::item) && try_card(card.uid))
+      {
+        return {action_type::deploy, card.uid, static_cast<int>(1 + m_rng() % me.lanes.size())};
+      }
+    }
+    for (size_t l = 0; m_attack && l < me.lanes.size(); ++l)
+    {
+      for (auto const& card : me.lanes[l])
+      {
+        if (card.energy > 0 && card.action_type != card_action_type::none && try_card(card.uid))
+        {
+          auto const& target_lane = other.lanes[l];
+          return {action_type::primary_action, card.uid, target_lane.empty() ? other.uid : target_lane.back().uid};
+        }
+      }
+    }
+    return {action_type::end_turn, 0, 0};
+  }
+
+private:
+  //! False if 'uid' was already tried this turn
+  bool try_card(int uid)
+  {
+    if (std::find(m_tried.begin(), m_tried.end(), uid) != m_tried.end())
+    {
+      return false;
+    }
+    m_tried.push_back(uid);
+    return true;
+  }
+
+  std::mt19937 m_rng;
+  bool m_attack;
+  std::vector<int> m_tried;
+  int m_turn{-1};
+  int m_player{-1};
+};
+
+//! Plays a game out; returns how many actions were accepted
+int play_game(ruleset const& rs, std::uint64_t seed)
+{
+  local_rules_engine engine{rs, seed};
+  bot b{seed, true};
+  int accepted = 0;
+  for (int i = 0; i < max_actions_per_game && !engine.is_game_over(); ++i)
+  {
+    if (!engine.commit_action(b.next(engine.get_session_info())))
+    {
+      ++accepted;
+    }
+  }
+  return accepted;
+}
+
+//! Plays a game out between the two ends of a lockstep game in this
+//! process; returns how many actions were accepted and adds what the ends
+//! sent each other to 'bytes'
+int play_lockstep_game(ruleset const& rs, std::uint64_t seed, size_t& bytes)
+{
+  lockstep_pipe pipe;
+  lockstep_rules_engine first{rs, seed, 0, pipe.end(0)};
+  lockstep_rules_engine second{rs, seed, 1, pipe.end(1)};
+  bot b{seed, true};
+  int accepted = 0;
+  for (int i = 0; i < max_actions_per_game && !first.is_game_over(); ++i)
+  {
+    auto& end = first.get_session_info().current_player == first.seat() ? first : second;
+    if (!end.commit_action(b.next(end.get_session_info())))
+    {
+      ++accepted;
+    }
+  }
+  bytes += first.bytes_sent() + second.bytes_sent();
+  return accepted;
+}
+
+//! A peaceful game played up to 'midgame_turn', so the lanes are well filled
+local_rules_engine make_midgame(ruleset const& rs)
+{
+  local_rules_engine engine{rs, 7};
+  bot b{7, false};
+  for (int i = 0; i < max_actions_per_game && engine.get_session_info().turn < midgame_turn; ++i)
+  {
+    engine.commit_action(b.next(engine.get_session_info()));
+  }
+  return engine;
+}
+
+//! An action of 'type' that 'engine' accepts, found by trying candidates on copies
+std::optional<player_action> find_legal(local_rules_engine const& engine, action_type type, int num_lanes)
+{
+  auto const& info = engine.get_session_info();
+  auto const& player = info.players[info.current_player];
+  auto const& other = info.players[1 - info.current_player];
+  std::vector<player_action> candidates;
+  switch (type)
+  {
+  case action_type::pick:
+    for (auto const& card : info.picks)
+    {
+      candidates.push_back({type, card.uid, 0});
+    }
+    break;
+  case action_type::deploy:
+    for (auto const& card : player.hand)
+    {
+      for (int lane = 1; lane <= num_lanes; ++lane)
+      {
+        candidates.push_back({type, card.uid, lane});
+      }
+    }
+    break;
+  case action_type::primary_action:
+    // the front of each lane against the front of the lane opposite, then the player behind it
+    for (size_t l = 0; l < player.lanes.size(); ++l)
+    {
+      if (!player.lanes[l].empty())
+      {
+        auto const& target_lane = other.lanes[l];
+        candidates.push_back({type, player.lanes[l].back().uid, target_lane.empty() ? other.uid : target_lane.back().uid});
+        candidates.push_back({type, player.lanes[l].back().uid, other.uid});
+      }
+    }
+    break;
+  default:
+    candidates.push_back({type, 0, 0});
+    break;
+  }
+
+  for (auto const& action : candidates)
+  {
+    auto copy = engine;
+    if (!copy.commit_action(action))
+    {
+      return action;
+    }
+  }
+  return std::nullopt;
+}
+
+struct prepared_action
+{
+  local_rules_engine engine;
+  player_action action;
+};
+
+//! Plays on from 'engine' until an action of 'type' is legal
+std::optional<prepared_action> prepare(local_rules_engine engine, action_type type, int num_lanes)
+{
+  bot b{11, false};
+  for (int i = 0; i < max_actions_per_game && !engine.is_game_over(); ++i)
+  {
+    if (auto const action = find_legal(engine, type, num_lanes))
+    {
+      return prepared_action{std::move(engine), *action};
+    }
+    engine.commit_action(b.next(engine.get_session_info()));
+  }
+  return std::nullopt;
+}
+
+void bench_commit_action(bench_runner& runner, local_rules_engine const& midgame, board b)
+{
+  static constexpr std::pair<char const*, action_type> types[] = {
+    {"commit_action/end_turn", action_type::end_turn},
+    {"commit_action/pick", action_type::pick},
+    {"commit_action/deploy", action_type::deploy},
+    {"commit_action/primary_action", action_type::primary_action},
+  };
+  for (auto const& [name, type] : types)
+  {
+    if (!runner.wants(name))
+    {
+      continue;
+    }
+    auto const prepared = prepare(midgame, type, b.num_lanes);
+    if (!prepared)
+    {
+      AURA_PRINT(L"%hs %hs: no legal action found, skipped\n", name, to_string(b).c_str());
+      continue;
+    }
+    // a legal action changes the engine, so every call gets a fresh copy
+    auto engine = prepared->engine;
+    runner.run(name, to_string(b), 1, [&] { engine = prepared->engine; }, [&]
+    {
+      keep(engine.commit_action(prepared->action));
+    });
+  }
+
+  // turning an action down leaves the engine as it was and must not
+  // allocate, so bots that probe for legal moves stay cheap
+  static constexpr std::pair<char const*, player_action> rejected[] = {
+    {"commit_action/rejected", {action_type::deploy, -1, 1}},
+    {"commit_action/rejected_pick", {action_type::pick, -1, 0}},
+    {"commit_action/rejected_primary_action", {action_type::primary_action, -1, -1}},
+  };
+  auto engine = midgame;
+  for (auto const& [name, action] : rejected)
+  {
+    runner.run(name, to_string(b), [&] { keep(engine.commit_action(action)); }, 0);
+  }
+}
+
+void bench_lookups(bench_runner& runner, local_rules_engine const& midgame, board b)
+{
+  auto engine = midgame;
+  auto const& info = engine.get_session_info();
+  auto const& player = info.players[info.current_player];
+  auto const& other = info.players[1 - info.current_player];
+
+  // the last card each search reaches, the worst case short of a miss
+  auto actor_uid = player.uid;
+  for (auto const& lane : player.lanes)
+  {
+    actor_uid = lane.empty() ? actor_uid : lane.back().uid;
+  }
+  auto target_uid = other.uid;
+  for (auto const& lane : other.lanes)
+  {
+    target_uid = lane.empty() ? target_uid : lane.back().uid;
+  }
+
+  runner.run("find_actor", to_string(b), [&] { keep(engine_bench::find_actor(engine, actor_uid)); });
+  runner.run("find_target", to_string(b), [&] { keep(engine_bench::find_target(engine, target_uid)); });
+}
+
+void bench_session(bench_runner& runner, local_rules_engine const& midgame, board b)
+{
+  // what start_game_session hands the display for every action
+  runner.run("session_copy", to_string(b), [&]
+  {
+    keep(std::make_shared<session_info>(midgame.get_session_info()));
+  });
+
+  // a third of the lane cards dead, as after a big exchange
+  auto dead = midgame.get_session_info();
+  int n = 0;
+  for (auto& player : dead.players)
+  {
+    for (auto& lane : player.lanes)
+    {
+      for (auto& card : lane)
+      {
+        card.health = n++ % 3 ? card.health : -10;
+      }
+    }
+  }
+  auto session = dead;
+  runner.run("remove_dead_lane_card", to_string(b), 1, [&] { session = dead; }, [&]
+  {
+    session.remove_dead_lane_card([](card_info const& card) { keep(card.uid); });
+  });
+
+  auto engine = midgame;
+  runner.run("apply_all_terrain_modifiers", to_string(b), [&] { engine_bench::apply_all_terrain_modifiers(engine); });
+
+  // the digest lockstep play compares every turn, from scratch and kept up
+  // to date across a turn; an end of turn changes most of the session
+  runner.run("hash_session", to_string(b), [&] { keep(hash_session(midgame.get_session_info())); });
+  auto later = midgame;
+  later.commit_action({action_type::end_turn, 0, 0});
+  session_info const* turns[] = {&midgame.get_session_info(), &later.get_session_info()};
+  incremental_digest digest;
+  size_t i = 0;
+  runner.run("incremental_digest/turn", to_string(b), [&] { keep(digest.update(*turns[i++ % 2])); }, 0);
+}
+
+void bench_footprint(bench_runner& runner, local_rules_engine const& midgame, board b)
+{
+  // what a session manager holds per game, as reported on /metrics
+  runner.record_bytes("session_bytes/new_game", to_string(b),
+    local_rules_engine{make_rules(b), 7}.memory_footprint().total());
+  runner.record_bytes("session_bytes/midgame", to_string(b), midgame.memory_footprint().total());
+}
+
+void bench_full_game(bench_runner& runner, board b)
+{
+  auto const rs = make_rules(b);
+  std::uint64_t games = 0;
+  std::uint64_t actions = 0;
+  runner.run("full_game", to_string(b), 1, [] {}, [&]
+  {
+    // the same sixteen games over and over
+    actions += static_cast<std::uint64_t>(play_game(rs, 1 + games++ % 16));
+  });
+  if (games)
+  {
+    runner.set_items(static_cast<double>(actions) / static_cast<double>(games));
+  }
+}
+
+void bench_lockstep(bench_runner& runner, board b)
+{
+  auto const rs = make_rules(b);
+  std::uint64_t games = 0;
+  std::uint64_t actions = 0;
+  size_t bytes = 0;
+  runner.run("lockstep/full_game", to_string(b), 1, [] {}, [&]
+  {
+    // the games of full_game, with both ends checking every turn
+    actions += static_cast<std::uint64_t>(play_lockstep_game(rs, 1 + games++ % 16, bytes));
+  });
+  if (games)
+  {
+    runner.set_items(static_cast<double>(actions) / static_cast<double>(games));
+  }
+
+  // what a relayed game costs on the wire before the relay's framing, over
+  // the sixteen games once so the figure doesn't depend on the timing
+  if (runner.wants("lockstep_bytes/game"))
+  {
+    bytes = 0;
+    for (std::uint64_t seed = 1; seed <= 16; ++seed)
+    {
+      play_lockstep_game(rs, seed, bytes);
+    }
+    runner.record_bytes("lockstep_bytes/game", to_string(b), bytes / 16);
+  }
+}
+
+void bench_cards(bench_runner& runner)
+{
+  auto d = make_standard_deck();
+  random_engine rng{1};
+  // draws until the deck runs dry, then it resets itself
+  runner.run("deck/draw", "-", [&] { keep(d.draw(1, 10, rng)); });
+  runner.run("deck/reset", "-", [&]
+  {
+    d.reset();
+    keep(d.remaining_cards.data());
+  });
+
+  // every card made registers its actions with the engine, so the maps
+  // start over with each batch
+  auto const base = local_rules_engine{ruleset{}, 1};
+  auto engine = base;
+  size_t i = 0;
+  runner.run("to_card_info", "-", 0, [&] { engine = base; }, [&]
+  {
+    auto const& preset = d.all_cards[i++ % d.all_cards.size()];
+    keep(engine.to_card_info(preset, preset.cid));
+  });
+}
+
+} // namespace {}
+
+void run_core_benchmarks(bench_runner& runner)
+{
+  bench_cards(runner);
+  for (auto const b : boards)
+  {
+    auto const midgame = make_midgame(make_rules(b));
+    bench_commit_action(runner, midgame, b);
+    bench_lookups(runner, midgame, b);
+    bench_session(runner, midgame, b);
+    bench_footprint(runner, midgame, b);
+    bench_full_game(runner, b);
+    bench_lockstep(runner, b);
+  }
+}
+
+} // namespace aura
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "bench.h"
+
+namespace aura
+{
+
+//! Times the rules engine's hot paths on each board size, every game
+//! played from fixed seeds
+void run_core_benchmarks(bench_runner& runner);
+
+} // namespace aura
@@ -0,0 +1,88 @@
+#include "core_benchmarks.h"
+#include <aura-core/build.h>
+#include <aura-core/platform.h>
+#include <string>
+
+int wmain(int argc, wchar_t** argv)
+{
+  aura::bench_config config{};
+  std::string json_path;
+  std::string baseline_path;
+  double threshold_percent = 10.0;
+  for (int i = 1; i < argc; ++i)
+  {
+    auto const option = std::wstring_view{argv[i]};
+    auto const value = [&] { return i + 1 < argc ? std::wstring{argv[++i]} : std::wstring{L"0"}; };
+    auto const narrow = [&] { return aura::to_utf8_string(value()); };
+    if (option == L"--json")
+    {
+      json_path = narrow();
+    }
+    else if (option == L"--filter")
+    {
+      config.filter = narrow();
+    }
+    else if (option == L"--min-time")
+    {
+      config.min_time = std::chrono::milliseconds{std::stoi(value())};
+    }
+    else if (option == L"--baseline")
+    {
+      baseline_path = narrow();
+    }
+    else if (option == L"--threshold")
+    {
+      threshold_percent = std::stod(value());
+    }
+  }
+
+  if constexpr (aura::log_enabled(aura::log_level::error))
+  {
+    AURA_PRINT(L"Logging is compiled in (AURA_MIN_LOG_LEVEL=%d) and timed along with the engine; configure with "
+      L"AURA_MIN_LOG_LEVEL=4 to time the engine alone\n", AURA_MIN_LOG_LEVEL);
+  }
+  if constexpr (!aura::counting_allocations)
+  {
+    AURA_PRINT(L"Allocations aren't counted in this build, so budgets go unchecked; configure with "
+      L"AURA_COUNT_ALLOCATIONS=ON to hold the benchmarks to them\n");
+  }
+
+  aura::bench_runner runner{config};
+  aura::run_core_benchmarks(runner);
+  aura::log_flush();
+  aura::print_results(runner.results());
+
+  if (!json_path.empty())
+  {
+    if (auto const e = aura::write_results(runner.results(), json_path))
+    {
+      AURA_PRINT(L"Cannot write %hs: %hs\n", json_path.c_str(), e.message().c_str());
+      return 1;
+    }
+  }
+
+  // budgets don't depend on a baseline, so they are checked on every run
+  if (auto const num_over = aura::check_allocation_budgets(runner.results()))
+  {
+    AURA_PRINT(L"%d benchmarks allocated more than their budget\n", num_over);
+    return 3;
+  }
+
+  if (!baseline_path.empty())
+  {
+    auto const [error, baseline] = aura::read_results(baseline_path);
+    if (error)
+    {
+      AURA_PRINT(L"Cannot read %hs: %hs\n", baseline_path.c_str(), error.message().c_str());
+      return 1;
+    }
+    // a regression fails the run, so scripts can hold a deploy back on it
+    if (auto const num_regressed = aura::compare_results(baseline, runner.results(), threshold_percent))
+    {
+      AURA_PRINT(L"%d benchmarks are more than %.0f%% slower or larger than the baseline\n", num_regressed,
+        threshold_percent);
+      return 2;
+    }
+  }
+  return 0;
+}
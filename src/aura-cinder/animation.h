@@ -1,44 +1,160 @@
 #pragma once
 
 #include <cinder/Rect.h>
-#include <string>
+#include <algorithm>
 #include <chrono>
-#include <functional>
+#include <cstdint>
+#include <vector>
 
 namespace aura
 {
 
-struct anim_info
+enum class easing : std::uint8_t
 {
-  //! total time elapsed since the beginning of the animation
-  std::chrono::nanoseconds time_elapsed;
+  linear,
+  ease_in,
+  ease_out,
+  ease_in_out
+};
 
-  //! ratio of time elapsed from the total specified duration
-  float ratio_elapsed;
+//! 't' in [0, 1] shaped by 'e'
+inline float ease(easing e, float t) noexcept
+{
+  switch (e)
+  {
+  case easing::linear: return t;
+  case easing::ease_in: return t * t;
+  case easing::ease_out: return t * (2.0f - t);
+  case easing::ease_in_out: return t < 0.5f ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+  }
+  return t;
+}
 
-  //! 
-  int render_index;
+//! What the eased value of an animation drives, on top of stepping through
+//! the frames of its sprite sheet
+enum class anim_property : std::uint8_t
+{
+  none,
+  alpha,
+  scale  //!< of the rect, about its center
 };
 
-using anim_renderer_t = std::function<void(anim_info&)>;
+//! An animation to start; see animation_timeline::add()
+struct animation
+{
+  int sheet{};  //!< sprite sheet played over the duration, up to the renderer
+  ci::Rectf rect;
+  std::chrono::nanoseconds duration{};
+  std::chrono::nanoseconds delay{};  //!< before it starts, to stagger effects
+  anim_property property{anim_property::none};
+  easing ease{easing::linear};
+  float from{0.0f};
+  float to{1.0f};
+};
 
-struct dynamic_animation
+//! A running animation as of the time sample it was evaluated at
+struct anim_info
 {
-  //! Duration of the animation after which it is to be removed
-  std::chrono::nanoseconds total_duration;
+  int sheet;
+  ci::Rectf const& rect;
+
+  //! ratio of time elapsed from the total duration, in [0, 1)
+  float ratio_elapsed;
 
-  int index;
+  anim_property property;
 
-  std::chrono::steady_clock::time_point time_triggered = std::chrono::steady_clock::now();
-  
-  anim_renderer_t renderer;
+  //! 'from' to 'to', eased
+  float value;
 };
 
-inline auto make_animation(std::chrono::nanoseconds duration, anim_renderer_t renderer)
+//! The running animations, one array per field so evaluating a frame of
+//! them reads memory in order. A frame is one pass with one time sample;
+//! finished animations are retired by moving the last one into their
+//! place, so they don't keep their order. The arrays keep their capacity,
+//! so starting an animation only allocates when more run at once than
+//! ever before. Render thread only.
+class animation_timeline
 {
-  return dynamic_animation{duration, 0, std::chrono::steady_clock::now(), std::move(renderer)};
-}
+public:
+  using clock = std::chrono::steady_clock;
 
-} // namespace aura
+  //! Starts 'a' at 'now' plus its delay
+  void add(animation const& a, clock::time_point now)
+  {
+    m_start.push_back(now + a.delay);
+    m_inv_duration.push_back(1.0f / std::max(std::chrono::duration<float>(a.duration).count(), 1e-6f));
+    m_from.push_back(a.from);
+    m_to.push_back(a.to);
+    m_easing.push_back(a.ease);
+    m_property.push_back(a.property);
+    m_sheet.push_back(a.sheet);
+    m_rect.push_back(a.rect);
+  }
+
+  //! Retires the animations finished at 'now' and calls 'fn' with an
+  //! anim_info for each one that has started
+  template <typename Fn>
+  void update(clock::time_point now, Fn const& fn)
+  {
+    size_t i = 0;
+    while (i < m_start.size())
+    {
+      auto const t = std::chrono::duration<float>(now - m_start[i]).count() * m_inv_duration[i];
+      if (t >= 1.0f)
+      {
+        retire(i);
+        continue;
+      }
+      if (t >= 0.0f)
+      {
+        auto const value = m_from[i] + (m_to[i] - m_from[i]) * ease(m_easing[i], t);
+        fn(anim_info{m_sheet[i], m_rect[i], t, m_property[i], value});
+      }
+      ++i;
+    }
+  }
+
+  bool empty() const noexcept
+  {
+    return m_start.empty();
+  }
 
+  size_t size() const noexcept
+  {
+    return m_start.size();
+  }
 
+private:
+  void retire(size_t i)
+  {
+    auto const last = m_start.size() - 1;
+    m_start[i] = m_start[last];
+    m_inv_duration[i] = m_inv_duration[last];
+    m_from[i] = m_from[last];
+    m_to[i] = m_to[last];
+    m_easing[i] = m_easing[last];
+    m_property[i] = m_property[last];
+    m_sheet[i] = m_sheet[last];
+    m_rect[i] = m_rect[last];
+
+    m_start.pop_back();
+    m_inv_duration.pop_back();
+    m_from.pop_back();
+    m_to.pop_back();
+    m_easing.pop_back();
+    m_property.pop_back();
+    m_sheet.pop_back();
+    m_rect.pop_back();
+  }
+
+  std::vector<clock::time_point> m_start;
+  std::vector<float> m_inv_duration;  //!< per second
+  std::vector<float> m_from;
+  std::vector<float> m_to;
+  std::vector<easing> m_easing;
+  std::vector<anim_property> m_property;
+  std::vector<int> m_sheet;
+  std::vector<ci::Rectf> m_rect;
+};
+
+} // namespace aura
@@ -0,0 +1,193 @@
+#include "board_layout.h"
+#include <aura-core/build.h>
+#include <aura-cinder/grid.h>
+
+namespace aura
+{
+
+bool operator==(board_layout_key const& a, board_layout_key const& b) noexcept
+{
+  return a.window == b.window && a.current_player == b.current_player && a.hand_size[0] == b.hand_size[0]
+    && a.hand_size[1] == b.hand_size[1] && a.picks == b.picks && a.lanes == b.lanes
+    && a.lane_height == b.lane_height;
+}
+
+bool board_layout::update(board_layout_key const& key, display_constants const& c)
+{
+  if (m_valid && key == m_key)
+  {
+    return false;
+  }
+
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  m_key = key;
+  compute(c);
+  m_valid = true;
+  return true;
+}
+
+board_layout::rects board_layout::get(layout_part part, bool top) const noexcept
+{
+  auto const& r = m_runs[(top ? 0 : static_cast<std::size_t>(layout_part::count)) + static_cast<std::size_t>(part)];
+  return rects{m_rects.data() + r.first, r.size};
+}
+
+ci::Rectf const& board_layout::tile(int lane, int index, bool top) const noexcept
+{
+  return get(layout_part::tile, top)[static_cast<std::size_t>(lane) * m_key.lane_height + index];
+}
+
+void board_layout::compute(display_constants const& c)
+{
+  m_rects.clear();
+  m_runs.fill(run{});
+  // every rect fits without growing, so runs from get() stay valid while
+  // later ones are added
+  auto const per_side = 6 + m_key.lanes * (1 + m_key.lane_height);
+  m_rects.reserve(static_cast<std::size_t>(2 * per_side + m_key.hand_size[0] + m_key.hand_size[1] + m_key.picks + 2));
+  compute_side(c, true);
+  compute_side(c, false);
+  compute_picks(c);
+}
+
+void board_layout::compute_side(display_constants const& c, bool top)
+{
+  auto const is_current_player = m_key.current_player == (top ? 0 : 1);
+  auto const hand_size = m_key.hand_size[top ? 0 : 1];
+  auto const scale_factor = is_current_player ? c.card_active_hand_height_multiplier : c.card_passive_hand_width_multiplier;
+  auto const hand_height = static_cast<float>(scale_factor * c.full_card_height + (2 * c.hand_vertical_padding));
+
+  auto win_frame = make_frame(ci::Rectf{0.0f, 0.0f, c.window_width, c.window_height});
+  win_frame.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
+  win_frame.align_horizontal(horizontal_alignment_t::center);
+  win_frame.set_stretch(false);
+
+  win_frame.add_element(c.window_width, hand_height, [&](auto const& hand_area)
+  {
+    add(layout_part::hand_area, top, hand_area);
+    if (hand_size <= 0)
+    {
+      return;
+    }
+
+    auto f = make_grid(hand_area);
+    f.align_horizontal(horizontal_alignment_t::center);
+    f.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
+    f.set_padding(c.hand_horizontal_padding, c.hand_vertical_padding);
+    f.set_element_size(c.full_card_width * scale_factor, c.full_card_height * scale_factor);
+    f.arrange(hand_size, 1, [&](auto const& rect)
+    {
+      add(layout_part::hand_card, top, rect);
+    });
+  });
+
+  // health bar
+  constexpr auto health_bar_h = 40.0f;
+  win_frame.add_element(490.0f, health_bar_h, [&](auto const& bar)
+  {
+    add(layout_part::stats_bar, top, bar);
+
+    auto f = make_frame(bar);
+    f.align_horizontal(horizontal_alignment_t::center);
+    f.align_vertical(vertical_alignment_t::center);
+    f.set_min_padding(4.0f, 4.0f);
+    f.set_stretch(false);
+    f.add_element(200.0f, health_bar_h, [&](auto const& rect) { add(layout_part::stats_name, top, rect); });
+    f.add_element(40.0f, health_bar_h, [&](auto const& rect) { add(layout_part::stats_health, top, rect); });
+    f.add_element(40.0f, health_bar_h, [&](auto const& ){});
+    f.add_element(40.0f, health_bar_h, [&](auto const& rect) { add(layout_part::stats_mana, top, rect); });
+    f.add_element(40.0f, health_bar_h, [&](auto const& ){});
+    f.add_element(120.0f, 30.0f, [&](auto const& rect) { add(layout_part::end_turn, top, rect); });
+    f.arrange_horizontally();
+  });
+
+  // lanes
+  auto const lane_height = (c.card_board_height * 4) + (c.board_vertical_padding * 8);
+  auto const lane_width = (c.card_board_width * 4) + (c.board_horizontal_padding * 8);
+
+  win_frame.add_element(lane_width, lane_height, [&](auto const& lanes_area)
+  {
+    if (m_key.lanes <= 0 || m_key.lane_height <= 0)
+    {
+      return;
+    }
+
+    auto g = make_grid(lanes_area);
+    g.set_padding(c.board_horizontal_padding, 0.0f);
+    g.set_element_size(c.card_board_width, lanes_area.getHeight());
+    g.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
+    g.arrange(m_key.lanes, 1, [&](auto const& rect)
+    {
+      add(layout_part::lane_area, top, rect);
+    });
+
+    for (auto const& lane : get(layout_part::lane_area, top))
+    {
+      auto g2 = make_grid(lane);
+      g2.set_element_size(c.card_board_width, c.card_board_height);
+      g2.set_padding(0.0f, c.board_vertical_padding);
+      g2.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
+      g2.arrange(1, m_key.lane_height, [&](auto const& tile_rect)
+      {
+        add(layout_part::tile, top, tile_rect);
+      });
+    }
+  });
+  win_frame.arrange_vertically();
+}
+
+void board_layout::compute_picks(display_constants const& c)
+{
+  if (m_key.picks <= 0)
+  {
+    return;
+  }
+
+  auto wind = make_frame(ci::Rectf{0.0f, 0.0f, c.window_width, c.window_height});
+  wind.align_vertical(vertical_alignment_t::center);
+  wind.add_element(c.window_width, c.pick_modal_height, [&](auto const& rect)
+  {
+    add(layout_part::picks_area, true, rect);
+  });
+  wind.arrange_horizontally();
+  auto const modal_area = get(layout_part::picks_area)[0];
+
+  auto f = make_frame(modal_area);
+  f.align_horizontal(horizontal_alignment_t::center);
+  f.align_vertical(vertical_alignment_t::center);
+
+  auto g = make_grid(modal_area);
+  g.set_padding(c.hand_horizontal_padding, c.hand_vertical_padding);
+  g.set_element_size(c.full_card_width / 2, c.full_card_height / 2);
+  g.align_vertical(vertical_alignment_t::center);
+  g.align_horizontal(horizontal_alignment_t::center);
+
+  auto [grid_x, grid_y] = g.measure(m_key.picks, 1);
+  f.add_element(grid_x, grid_y, [&](auto const& rect)
+  {
+    g.bounds = rect;
+    g.arrange(m_key.picks, 1, [&](auto const& element)
+    {
+      add(layout_part::pick_card, true, element);
+    });
+  });
+  f.add_element(500.0f, 100.0f, [&](auto const& rect)
+  {
+    add(layout_part::picks_caption, true, rect);
+  });
+  f.arrange_vertically();
+}
+
+void board_layout::add(layout_part part, bool top, ci::Rectf const& r)
+{
+  auto& a = m_runs[(top ? 0 : static_cast<std::size_t>(layout_part::count)) + static_cast<std::size_t>(part)];
+  if (!a.size)
+  {
+    a.first = static_cast<std::uint32_t>(m_rects.size());
+  }
+  AURA_ASSERT(a.first + a.size == m_rects.size());
+  m_rects.push_back(r);
+  ++a.size;
+}
+
+} // namespace aura
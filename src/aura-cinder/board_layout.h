@@ -0,0 +1,103 @@
+#pragma once
+
+#include "display_constants.h"
+#include <cinder/Rect.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aura
+{
+
+//! The kinds of rects on the board; each player's side has its own run of
+//! every kind except the picks, which are only on the top side
+enum class layout_part : int
+{
+  hand_area,
+  hand_card,      //!< one per card in the hand, left to right
+  stats_bar,
+  stats_name,
+  stats_health,
+  stats_mana,
+  end_turn,
+  lane_area,      //!< one per lane, left to right
+  tile,           //!< 'lane_height' per lane, lanes left to right
+  picks_area,
+  pick_card,      //!< one per pick, left to right
+  picks_caption,
+  count
+};
+
+//! What the positions of the board's rects depend on; the rest of the game
+//! state only changes what is drawn in them
+struct board_layout_key
+{
+  ci::ivec2 window{};
+  int current_player{-1};
+  int hand_size[2]{};
+  int picks{};
+  int lanes{};
+  int lane_height{};
+};
+
+bool operator==(board_layout_key const& a, board_layout_key const& b) noexcept;
+
+//! Every rect the board is drawn into, computed once per key into one flat
+//! array. Drawing and hit testing both read from it instead of running the
+//! grids and frames each time the board is rendered.
+class board_layout
+{
+public:
+  //! A run of rects of one kind
+  class rects
+  {
+  public:
+    rects(ci::Rectf const* first, std::size_t size) noexcept
+      : m_first{first}
+      , m_size{size}
+    {
+    }
+
+    ci::Rectf const* begin() const noexcept { return m_first; }
+    ci::Rectf const* end() const noexcept { return m_first + m_size; }
+    std::size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return !m_size; }
+    ci::Rectf const& operator[](std::size_t i) const noexcept { return m_first[i]; }
+
+  private:
+    ci::Rectf const* m_first;
+    std::size_t m_size;
+  };
+
+  //! Lays the board out again if 'key' differs from the last one; true if
+  //! it did
+  bool update(board_layout_key const& key, display_constants const& c);
+
+  //! The rects of 'part' on the top or bottom side
+  rects get(layout_part part, bool top = true) const noexcept;
+
+  //! Tile 'index' of 'lane', counted from the top of the window
+  ci::Rectf const& tile(int lane, int index, bool top) const noexcept;
+
+private:
+  void compute(display_constants const& c);
+  void compute_side(display_constants const& c, bool top);
+  void compute_picks(display_constants const& c);
+
+  //! Appends 'r' to the run of 'part'; runs are filled one at a time
+  void add(layout_part part, bool top, ci::Rectf const& r);
+
+  struct run
+  {
+    std::uint32_t first{0};
+    std::uint32_t size{0};
+  };
+
+  board_layout_key m_key{};
+  bool m_valid{false};
+  std::vector<ci::Rectf> m_rects;
+  std::array<run, 2 * static_cast<std::size_t>(layout_part::count)> m_runs{};
+};
+
+} // namespace aura
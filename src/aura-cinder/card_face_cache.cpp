@@ -0,0 +1,167 @@
+#include "card_face_cache.h"
+#include <aura-core/build.h>
+#include <aura-core/session_digest.h>
+#include <cinder/gl/gl.h>
+#include <algorithm>
+#include <functional>
+
+namespace aura
+{
+
+namespace
+{
+
+constexpr int page_size = 2048;
+
+//! Two pages hold 80 faces at the default size, more than a board shows
+constexpr int max_pages = 2;
+
+} // namespace {}
+
+card_face_key card_face_key::of(card_info const& card) noexcept
+{
+  card_face_key k;
+  k.cid = card.cid;
+  k.health = card.health;
+  k.strength = card.strength;
+  k.cost = card.cost;
+  k.starting_energy = card.starting_energy;
+  k.resting = card.is_resting();
+  k.visible = card.is_visible;
+  k.terrain_bonus = card.on_preferred_terrain;
+  for (auto const t : card.traits)
+  {
+    k.traits = chain_hash(k.traits, static_cast<std::uint64_t>(t));
+  }
+  return k;
+}
+
+std::uint64_t card_face_key::digest() const noexcept
+{
+  auto h = chain_hash(static_cast<std::uint64_t>(cid), static_cast<std::uint64_t>(health));
+  h = chain_hash(h, static_cast<std::uint64_t>(strength));
+  h = chain_hash(h, static_cast<std::uint64_t>(cost));
+  h = chain_hash(h, static_cast<std::uint64_t>(starting_energy));
+  h = chain_hash(h, (resting ? 1 : 0) | (visible ? 2 : 0) | (terrain_bonus ? 4 : 0));
+  return chain_hash(h, traits);
+}
+
+bool operator==(card_face_key const& a, card_face_key const& b) noexcept
+{
+  return a.cid == b.cid && a.health == b.health && a.strength == b.strength && a.cost == b.cost
+    && a.starting_energy == b.starting_energy && a.resting == b.resting && a.visible == b.visible
+    && a.terrain_bonus == b.terrain_bonus && a.traits == b.traits;
+}
+
+card_face_cache::card_face_cache(sprite_batch& sprites, ci::ivec2 face_size)
+  : m_sprites{sprites}
+  , m_face_size{face_size}
+{
+}
+
+void card_face_cache::clear()
+{
+  m_entries.clear();
+  for (auto& s : m_slots)
+  {
+    s.in_use = false;
+  }
+}
+
+void card_face_cache::end_frame()
+{
+  ++m_frame;
+}
+
+sprite card_face_cache::find(card_face_key const& key)
+{
+  auto const it = m_entries.find(key.digest());
+  if (it == m_entries.end() || !(it->second.key == key))
+  {
+    return {};
+  }
+  m_slots[it->second.slot].last_drawn = m_frame;
+  return face(it->second.slot);
+}
+
+int card_face_cache::allocate(card_face_key const& key)
+{
+  auto const digest = key.digest();
+  auto const s = std::invoke([&]
+  {
+    // a different face with the same digest gives up its slot
+    if (auto const it = m_entries.find(digest); it != m_entries.end())
+    {
+      return it->second.slot;
+    }
+
+    auto const free = std::find_if(m_slots.begin(), m_slots.end(), [](auto const& s) { return !s.in_use; });
+    if (free != m_slots.end())
+    {
+      return static_cast<int>(free - m_slots.begin());
+    }
+
+    auto const cols = page_size / m_face_size.x;
+    auto const rows = page_size / m_face_size.y;
+    if (static_cast<int>(m_pages.size()) < max_pages && cols > 0 && rows > 0)
+    {
+      auto const page = static_cast<int>(m_pages.size());
+      m_pages.push_back(ci::gl::Fbo::create(page_size, page_size, true));
+      auto const first = static_cast<int>(m_slots.size());
+      for (int y = 0; y < rows; ++y)
+      {
+        for (int x = 0; x < cols; ++x)
+        {
+          m_slots.push_back(slot{page, {x * m_face_size.x, y * m_face_size.y}});
+        }
+      }
+      AURA_LOG(L"Added card face page %d with room for %d faces", page + 1, cols * rows);
+      return first;
+    }
+
+    auto const lru = std::min_element(m_slots.begin(), m_slots.end(), [](auto const& a, auto const& b)
+    {
+      return a.last_drawn < b.last_drawn;
+    });
+    m_entries.erase(lru->owner);
+    return static_cast<int>(lru - m_slots.begin());
+  });
+
+  auto& sl = m_slots[s];
+  sl.owner = digest;
+  sl.in_use = true;
+  sl.last_drawn = m_frame;
+  m_entries.insert_or_assign(digest, entry{key, s});
+  return s;
+}
+
+sprite card_face_cache::face(int s) const
+{
+  // the slot's top row is its highest, framebuffer rows run bottom up
+  auto const& sl = m_slots[s];
+  auto const size = static_cast<float>(page_size);
+  auto const x1 = sl.origin.x / size;
+  auto const x2 = (sl.origin.x + m_face_size.x) / size;
+  auto const y_top = (sl.origin.y + m_face_size.y) / size;
+  auto const y_bottom = sl.origin.y / size;
+  return sprite{m_pages[sl.page]->getColorTexture(), ci::Rectf{x1, y_top, x2, y_bottom}};
+}
+
+card_face_cache::compose_scope::compose_scope(card_face_cache& cache, int s)
+  : m_cache{cache}
+  , m_framebuffer{cache.m_pages[cache.m_slots[s].page]}
+  , m_viewport{cache.m_slots[s].origin, cache.m_face_size}
+  , m_scissor{cache.m_slots[s].origin, cache.m_face_size}
+  , m_matrices{}
+{
+  ci::gl::setMatricesWindow(m_cache.m_face_size);
+  ci::gl::setModelMatrix(ci::mat4{1.0f});
+  ci::gl::clear(ci::ColorA{0.0f, 0.0f, 0.0f, 0.0f});
+}
+
+card_face_cache::compose_scope::~compose_scope()
+{
+  m_cache.m_sprites.flush();
+}
+
+} // namespace aura
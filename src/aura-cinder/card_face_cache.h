@@ -0,0 +1,121 @@
+#pragma once
+
+#include "sprite_batch.h"
+#include <aura-core/session_info.h>
+#include <cinder/gl/Fbo.h>
+#include <cinder/gl/scoped.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace aura
+{
+
+//! What a card face shows that can change during a game; the rest of it
+//! follows from the card preset 'cid'
+struct card_face_key
+{
+  int cid{};
+  int health{};
+  int strength{};
+  int cost{};
+  int starting_energy{};
+  bool resting{};
+  bool visible{};
+  bool terrain_bonus{};
+  std::uint64_t traits{};  //!< digest of the trait list
+
+  static card_face_key of(card_info const& card) noexcept;
+
+  std::uint64_t digest() const noexcept;
+};
+
+bool operator==(card_face_key const& a, card_face_key const& b) noexcept;
+
+//! Card faces composed once into offscreen atlas pages. The art, icons and
+//! description of a face are drawn again only when its key changes, or
+//! when it was evicted to make room for faces drawn more recently.
+//! Render thread only.
+class card_face_cache
+{
+public:
+  //! Faces are 'face_size' pixels, drawn at 1:1 in their own coordinates
+  card_face_cache(sprite_batch& sprites, ci::ivec2 face_size);
+
+  //! The face 'key' describes; unless it is cached, 'compose' is called to
+  //! draw it from (0, 0) to the face size into a cleared slot first
+  template <typename Fn>
+  sprite get(card_face_key const& key, Fn const& compose)
+  {
+    if (auto const cached = find(key))
+    {
+      return cached;
+    }
+
+    // what's queued belongs to the target bound now, not the cache page
+    m_sprites.flush();
+    auto const s = allocate(key);
+    {
+      compose_scope scope{*this, s};
+      compose();
+    }
+    return face(s);
+  }
+
+  //! Forgets every face, e.g. once images they were composed with change
+  void clear();
+
+  //! Call once a frame
+  void end_frame();
+
+private:
+  struct slot
+  {
+    int page{};
+    ci::ivec2 origin{};  //!< lower left, in the page's pixels
+    std::uint64_t owner{};  //!< digest of the face in it
+    bool in_use{false};
+    std::uint64_t last_drawn{0};
+  };
+
+  struct entry
+  {
+    card_face_key key;
+    int slot{};
+  };
+
+  //! Targets a slot of a page for the lifetime of the scope
+  class compose_scope
+  {
+  public:
+    compose_scope(card_face_cache& cache, int s);
+    ~compose_scope();
+
+    compose_scope(compose_scope const&) = delete;
+    compose_scope& operator=(compose_scope const&) = delete;
+
+  private:
+    card_face_cache& m_cache;
+    ci::gl::ScopedFramebuffer m_framebuffer;
+    ci::gl::ScopedViewport m_viewport;
+    ci::gl::ScopedScissor m_scissor;
+    ci::gl::ScopedMatrices m_matrices;
+  };
+
+  //! The cached face of 'key', or null
+  sprite find(card_face_key const& key);
+
+  //! A slot for 'key', evicting the least recently drawn face if need be
+  int allocate(card_face_key const& key);
+
+  sprite face(int s) const;
+
+  sprite_batch& m_sprites;
+  ci::ivec2 m_face_size;
+  std::vector<ci::gl::FboRef> m_pages;
+  std::vector<slot> m_slots;
+  std::unordered_map<std::uint64_t, entry> m_entries;  //!< by key digest
+  std::uint64_t m_frame{0};
+};
+
+} // namespace aura
@@ -2,7 +2,6 @@
 #include <aura-core/platform.h>
 #include <aura-core/session_info.h>
 #include <aura-core/build.h>
-#include <aura-cinder/grid.h>
 
 #include "cind_display_helpers.h"
 
@@ -82,6 +81,57 @@ std::string format_card_descr(rules_engine const& re, card_info const& card)
   return s;
 }
 
+wchar_t const* terrain_tile_name(terrain_types t)
+{
+  switch (t)
+  {
+  case terrain_types::plains:     return L"tile-plains.png";
+  case terrain_types::riverlands: return L"tile-riverlands.png";
+  case terrain_types::mountains:  return L"tile-mountains.png";
+  case terrain_types::forests:    return L"tile-forests.png";
+  default:                        return L"tile-placeholder.png";
+  }
+}
+
+wchar_t const* terrain_icon_name(terrain_types t)
+{
+  switch (t)
+  {
+  case terrain_types::plains:     return L"icon-plains.png";
+  case terrain_types::riverlands: return L"icon-riverlands.png";
+  case terrain_types::mountains:  return L"icon-mountains.png";
+  case terrain_types::forests:    return L"icon-forests.png";
+  default:                        return L"icon-placeholder.png";
+  }
+}
+
+//! Where a tile's terrain icon goes: on its left edge, centered vertically
+ci::Rectf terrain_icon_rect(ci::Rectf const& tile_rect)
+{
+  auto [icon_w, icon_h] = std::pair{40.0f, 40.0f};
+  ci::Rectf terrain_rect{tile_rect.x1, (tile_rect.y1 + tile_rect.y2)/2.0f - icon_w/2.0f, 0.0f, 0.0f};
+  terrain_rect.x2 = terrain_rect.x1 + icon_w;
+  terrain_rect.y2 = terrain_rect.y1 + icon_h;
+  return terrain_rect;
+}
+
+//! A flipbook animation, its frames named <base><n>.png
+struct sprite_sheet
+{
+  wchar_t const* base;
+  int frames;
+};
+
+//! Indexed by animation::sheet
+enum sheet_id : int
+{
+  slash_sheet
+};
+
+constexpr sprite_sheet sprite_sheets[] = {
+  {L"Slash", 6},
+};
+
 } // namespace {}
 
 auto terrain_to_color(terrain_types t)
@@ -127,7 +177,6 @@ void cind_display_engine::display_tile_overlay(
   //! whether this is the next usable (empty) tile in the lane
   auto const is_next_tile_in_lane = (player.lanes[lane_no].size() == normalized_lane_index);
 
-  std::lock_guard lk{m_mutex};
   if (!has_card)
   {
     if (!hovered)
@@ -135,29 +184,24 @@ void cind_display_engine::display_tile_overlay(
       return;
     }
 
-    if (is_current_player
-      && m_ui_action.is(cind_action_type::selected_hand_card)
-      && is_next_tile_in_lane
-      && m_selected_card && m_selected_card->can_be_deployed())
+    if (is_current_player && is_next_tile_in_lane && m_ui_action.is(uiact::hovered_lane))
     {
-      ci::gl::draw(get_texture(L"tile-move.png"), tile_rect);
+      m_sprites.draw(get_texture(L"tile-move.png"), tile_rect);
 
-      m_ui_action.add(uiact::hovered_lane, lane_no);
-      m_hovered_description = to_string(tile_terrain);
       if (m_selected_card && m_selected_card->prefers_terrain(tile_terrain))
       {
-        m_hovered_description += " (terrain bonus: +1 defense)";
         ci::gl::ScopedColor col{0.0f, 1.0f, 0.0f, 1.0f};
+        m_sprites.before_draw();
         ci::gl::drawStrokedRoundedRect(tile_rect, 5.0f);
       }
     }
-    else if (player.lanes[lane_no].size() == normalized_lane_index
+    else if (is_next_tile_in_lane
       && is_current_player
       && m_ui_action.is(cind_action_type::selected_hand_card))
     {
       ci::gl::ScopedColor col{1.0f, 1.0f, 1.0f, 0.3f};
+      m_sprites.before_draw();
       ci::gl::drawSolidRoundedRect(tile_rect, 4.0f);
-      m_hovered_description = to_string(tile_terrain);
     }
     return;
   }
@@ -168,48 +212,30 @@ void cind_display_engine::display_tile_overlay(
   if (card.on_preferred_terrain)
   {
     ci::gl::ScopedColor col{0.0f, 1.0f, 0.0f, 1.0f};
+    m_sprites.before_draw();
     ci::gl::drawStrokedRoundedRect(tile_rect, 5.0f);
   }
 
   if (is_selected)
   {
-    ci::gl::draw(get_texture(L"tile-selected.png"), tile_rect);
+    m_sprites.draw(get_texture(L"tile-selected.png"), tile_rect);
   }
 
   if (card.is_resting() && is_current_player)
   {
-    ci::gl::draw(get_texture(L"resting.png"), tile_rect);
+    m_sprites.draw(get_texture(L"resting.png"), tile_rect);
   }
 
-  if (!hovered)
+  if (!hovered || is_selected)
   {
     return;
   }
-  m_hovered_description = to_utf8_string(card.get_hovered_description());
-  if (m_selected_card && m_selected_card->prefers_terrain(tile_terrain))
-  {
-    m_hovered_description += " (terrain bonus: +1 damage)";
-  }
-
-  if (is_selected)
-  {
-    m_ui_action.add(uiact::hovered_lane_card, card.uid);
-    return;
-  }
-
-  m_hovered_card = &card;
 
+  // hover_tile() decided what the selected card can do here
   if (m_ui_action.is(cind_action_type::selected_lane_card) ||
        m_ui_action.is(cind_action_type::selected_hand_card))
   {
-    bool in_sight = (m_selected_card && m_selected_card->action_type == card_action_type::ranged_attack)
-      || ((player.lanes[lane_no].size() - 1) == normalized_lane_index);
-
-    bool can_target = m_selected_card && 
-      ((m_selected_card->can_target_enemy() && !is_current_player && in_sight)
-      || (m_selected_card->can_target_friendly() && is_current_player)); 
-
-    if (can_target)
+    if (m_ui_action.is(uiact::hovered_lane_card))
     {
       auto const texture = std::invoke([&]
       {
@@ -222,28 +248,20 @@ void cind_display_engine::display_tile_overlay(
         }
         return L"tile-attack.png";
       });
-      ci::gl::draw(get_texture(texture), tile_rect);
-
-      ci::gl::ScopedColor col{1.0f, 0.0f, 0.0f, 1.0f};
-      ci::gl::drawStrokedRoundedRect(tile_rect, 5.0f);
-      m_ui_action.add(uiact::hovered_lane_card, card.uid);
+      m_sprites.draw(get_texture(texture), tile_rect);
     }
-    else
+    else if (m_hover_refused)
     {
-      //if (m_selected_card)
-      //{
-      //  AURA_LOG(L"%ls: %d %d %d", m_selected_card->name.c_str(), m_selected_card->action_targets, m_selected_card->action_type, in_sight);
-      //}
-      ci::gl::draw(get_texture(L"tile-not-allowed.png"), tile_rect);
-
-      ci::gl::ScopedColor col{1.0f, 0.0f, 0.0f, 1.0f};
-      ci::gl::drawStrokedRoundedRect(tile_rect, 5.0f);
+      m_sprites.draw(get_texture(L"tile-not-allowed.png"), tile_rect);
     }
+
+    ci::gl::ScopedColor col{1.0f, 0.0f, 0.0f, 1.0f};
+    m_sprites.before_draw();
+    ci::gl::drawStrokedRoundedRect(tile_rect, 5.0f);
   }
-  else if (card.can_act() && is_current_player)
+  else if (m_ui_action.is(uiact::hovered_lane_card))
   {
-    ci::gl::draw(get_texture(L"tile-highlight.png"), tile_rect);
-    m_ui_action.add(uiact::hovered_lane_card, card.uid);
+    m_sprites.draw(get_texture(L"tile-highlight.png"), tile_rect);
   }
 }
 
@@ -256,18 +274,6 @@ void cind_display_engine::display_tile(
   terrain_types tile_terrain,
   ci::Rectf const& tile_rect)
 {
-  auto const texture_name = std::invoke([&]
-  {
-    switch (tile_terrain)
-    {
-    case terrain_types::plains:     return L"tile-plains.png";
-    case terrain_types::riverlands: return L"tile-riverlands.png";
-    case terrain_types::mountains:  return L"tile-mountains.png";
-    case terrain_types::forests:    return L"tile-forests.png";
-    default:                        return L"tile-placeholder.png";
-    }
-  });
-
   auto const normalized_lane_index = top ? lane_index : m_ruleset.max_lane_height - lane_index - 1;
 
   if (player.lanes[lane_no].size() <= normalized_lane_index)
@@ -278,7 +284,7 @@ void cind_display_engine::display_tile(
       && m_selected_card && m_selected_card->can_be_deployed()))
     {
       m_is_tile_revealed[lane_no][normalized_lane_index] = true;
-      ci::gl::draw(get_texture(texture_name), tile_rect);
+      m_sprites.draw(terrain_sprite(tile_terrain, tile_rect, false), tile_rect);
     }
     else
     {
@@ -291,29 +297,15 @@ void cind_display_engine::display_tile(
 
   auto& card = player.lanes[lane_no][normalized_lane_index];
 
-  ci::gl::draw(tile_card_texture(card), tile_rect);
+  m_sprites.draw(tile_card_texture(card), tile_rect);
   
   {
-    auto const icon_name = std::invoke([&]
-    {
-      switch (tile_terrain)
-      {
-      case terrain_types::plains:     return L"icon-plains.png";
-      case terrain_types::riverlands: return L"icon-riverlands.png";
-      case terrain_types::mountains:  return L"icon-mountains.png";
-      case terrain_types::forests:    return L"icon-forests.png";
-      default:                        return L"icon-placeholder.png";
-      }
-    });
-    auto [icon_w, icon_h] = std::pair{40.0f, 40.0f};
-    ci::Rectf terrain_rect{tile_rect.x1, (tile_rect.y1 + tile_rect.y2)/2.0f - icon_w/2.0f, 0.0f, 0.0f};
-    terrain_rect.x2 = terrain_rect.x1 + icon_w;
-    terrain_rect.y2 = terrain_rect.y1 + icon_h;
-    ci::gl::draw(get_texture(icon_name), terrain_rect);
+    auto const terrain_rect = terrain_icon_rect(tile_rect);
+    m_sprites.draw(terrain_sprite(tile_terrain, terrain_rect, true), terrain_rect);
 
     auto line_h = 15.0f;
     ci::Rectf line_rect{tile_rect.x1, tile_rect.y2 - line_h, tile_rect.x2, tile_rect.y2};
-    aura::draw_line(line_rect, to_utf8_string(card.name));
+    aura::draw_line(m_text, line_rect, to_utf8_string(card.name));
   }
 
   auto const scale_factor = 0.8f;
@@ -332,27 +324,15 @@ void cind_display_engine::display_tile(
 
 void cind_display_engine::display_player_overlay(ci::Rectf const& hand_area, player_info const& player, bool is_current_player)
 {
-  if (!hand_area.contains({m_constants.mouse_x, m_constants.mouse_y}))
-  {
-    return;
-  }
-
-  if (!m_selected_card)
-  {
-    return;
-  }
-  
-  if (!is_current_player && !m_selected_card->can_target_enemy())
+  if (!m_selected_card || !hand_area.contains({m_constants.mouse_x, m_constants.mouse_y}))
   {
-    std::lock_guard lk{m_mutex};
-    m_hovered_description = player.name + ": no actions possible at this time";
     return;
   }
 
-  if (is_current_player && !((int)m_selected_card->action_targets & (int)card_action_targets::friendly_hero))
+  // hover_player() decided whether the selected card can go for the player
+  auto const targeted = m_ui_action.is(uiact::hovered_player) && m_ui_action.value(uiact::hovered_player) == player.uid;
+  if (!targeted && !m_hover_refused)
   {
-    std::lock_guard lk{m_mutex};
-    m_hovered_description = "Player: can't attack self";
     return;
   }
 
@@ -362,44 +342,26 @@ void cind_display_engine::display_player_overlay(ci::Rectf const& hand_area, pla
   auto y4 = y3 + m_constants.card_board_height;
 
   ci::Rectf r2{x3, y3, x4, y4};
-
-  if (!is_current_player && !player.has_free_lane() && m_selected_card->action_type != card_action_type::ranged_attack)
-  {
-    ci::gl::draw(get_texture(L"tile-not-allowed.png"), r2);
-    {
-      ci::gl::ScopedColor col{1.0f, 0.0f, 0.0f, 1.0f};
-      ci::gl::drawStrokedRoundedRect(hand_area, 20.0f, 10.0f);
-    }
-    std::lock_guard lk{m_mutex};
-    m_hovered_description = player.name + ": no free lane available to attack";
-    return;
-  }
-  ci::gl::draw(get_texture(L"tile-attack.png"), r2);
+  m_sprites.draw(get_texture(targeted ? L"tile-attack.png" : L"tile-not-allowed.png"), r2);
 
   ci::gl::ScopedColor col{1.0f, 0.0f, 0.0f, 1.0f};
+  m_sprites.before_draw();
   ci::gl::drawStrokedRoundedRect(hand_area, 20.0f, 10.0f);
-
-  std::lock_guard lk{m_mutex};
-  m_ui_action.add(uiact::hovered_player, player.uid);
 }
 
 void cind_display_engine::display_player_hand(
   player_info const& player,
   bool top,
-  bool is_current_player,
-  ci::Rectf const& hand_area)
+  bool is_current_player)
 {
-  auto const& c = m_constants;
   auto const scale_factor = is_current_player ? m_constants.card_active_hand_height_multiplier : m_constants.card_passive_hand_width_multiplier;
 
-  auto f = make_grid(hand_area);
-  f.align_horizontal(horizontal_alignment_t::center);
-  f.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
-  f.set_padding(m_constants.hand_horizontal_padding, m_constants.hand_vertical_padding);
-  f.set_element_size(m_constants.full_card_width * scale_factor, m_constants.full_card_height * scale_factor);
-
-  f.arrange_horizontally(player.hand, [&](auto const& item, ci::Rectf const& orig_rect)
+  auto const rects = m_layout.get(layout_part::hand_card, top);
+  auto const num_cards = std::min(player.hand.size(), rects.size());
+  for (size_t slot = 0; slot < num_cards; ++slot)
   {
+    auto const& item = player.hand[slot];
+    auto const& orig_rect = rects[slot];
     auto const cur_mana = m_session_info->players[m_session_info->current_player].mana;
     auto const playable = item.cost <= cur_mana;
 
@@ -419,8 +381,8 @@ void cind_display_engine::display_player_hand(
       display_card_full(item);
     }
 
-    auto [x1, x2] = std::minmax(0.0f, m_constants.full_card_width);
-    auto [y1, y2] = std::minmax(0.0f, m_constants.full_card_height);
+    auto [x1, x2] = std::minmax({0.0f, m_constants.full_card_width});
+    auto [y1, y2] = std::minmax({0.0f, m_constants.full_card_height});
 
     ci::Rectf size_rect{x1, y1, x2, y2};
     auto const coord = ci::gl::windowToObjectCoord({m_constants.mouse_x, m_constants.mouse_y});
@@ -430,89 +392,58 @@ void cind_display_engine::display_player_hand(
     // draw hover highlight
     if (!is_current_player)
     {
-      ci::gl::draw(get_texture(L"card-hidden.png"), size_rect);
+      m_sprites.draw(get_texture(L"card-hidden.png"), size_rect);
     }
     else if (!playable)
     {
-      ci::gl::draw(get_texture(L"card-passive.png"), size_rect);
+      m_sprites.draw(get_texture(L"card-passive.png"), size_rect);
     }
     else if (selected)
     {
-      ci::gl::draw(get_texture(L"card-selected.png"), size_rect);
+      m_sprites.draw(get_texture(L"card-selected.png"), size_rect);
     }
     else if (hovered)
     {
-      ci::gl::draw(get_texture(L"card-highlight.png"), size_rect);
+      m_sprites.draw(get_texture(L"card-highlight.png"), size_rect);
     }
-
-    std::lock_guard lk{m_mutex};
-    if (hovered)
-    {
-      m_ui_action.add(uiact::hovered_hand_card, item.uid);
-      if (is_current_player)
-      {
-        m_hovered_card = &item;
-        if (playable)
-        {
-          m_hovered_description = to_utf8_string(item.get_hovered_description());
-        }
-        else
-        {
-          m_hovered_description = to_utf8_string(item.name) + " (Insufficient mana to play this card)";
-        }
-      }
-
-    }
-  });
+  }
 }
 
 void cind_display_engine::display_player_stats(
   player_info const& player,
   bool top,
-  bool is_current_player,
-  ci::Rectf const& hand_area)
+  bool is_current_player)
 {
-  constexpr auto health_bar_h = 40.0f;
-  ci::gl::draw(get_texture(L"player-bar.png"), hand_area);
+  auto const& bar = m_layout.get(layout_part::stats_bar, top)[0];
+  m_sprites.draw(get_texture(L"player-bar.png"), bar);
 
-  auto f = make_frame(hand_area);
-  f.align_horizontal(horizontal_alignment_t::center);
-  f.align_vertical(vertical_alignment_t::center);
-  f.set_min_padding(4.0f, 4.0f);
-  f.set_stretch(false);
-  f.add_element(200.0f, health_bar_h, [&](auto const& rect)
+  draw_line(m_text, m_layout.get(layout_part::stats_name, top)[0], "Player");
   {
-    draw_line(rect, "Player");
-  });
-  f.add_element(40.0f, health_bar_h, [&](auto const& rect)
-  {
-    ci::gl::draw(get_texture(L"icon-health.png"), rect);
+    auto const& rect = m_layout.get(layout_part::stats_health, top)[0];
+    m_sprites.draw(get_texture(L"icon-health.png"), rect);
     auto const r2 = rect.inflated({40.0f, 0.0f});
-    aura::draw_line(r2, std::to_string(player.health) + "/" + std::to_string(player.starting_health));
-  });
-  f.add_element(40.0f, health_bar_h, [&](auto const& ){});
-  f.add_element(40.0f, health_bar_h, [&](auto const& rect)
+    aura::draw_line(m_text, r2, std::to_string(player.health) + "/" + std::to_string(player.starting_health));
+  }
   {
-    ci::gl::draw(get_texture(L"icon-gem.png"), rect);
+    auto const& rect = m_layout.get(layout_part::stats_mana, top)[0];
+    m_sprites.draw(get_texture(L"icon-gem.png"), rect);
     auto const r2 = rect.inflated({40.0f, 0.0f});
-    aura::draw_line(r2, std::to_string(player.mana) + "/" + std::to_string(player.starting_mana));
-  });
-  f.add_element(40.0f, health_bar_h, [&](auto const& ){});
-  f.add_element(120.0f, 30.0f, [&](auto const& rect)
-  {
+    aura::draw_line(m_text, r2, std::to_string(player.mana) + "/" + std::to_string(player.starting_mana));
+  }
 
+  auto const& rect = m_layout.get(layout_part::end_turn, top)[0];
   if (is_current_player)
   {
-    if (rect.contains({m_constants.mouse_x, m_constants.mouse_y}))
+    if (m_ui_action.is(uiact::hovered_end_turn))
     {
       ci::gl::ScopedColor col{1.0, 0.0, 0.0, 1.0};
+      m_sprites.before_draw();
       ci::gl::drawSolidRoundedRect(rect, 10, 10);
-      std::lock_guard lk{m_mutex};
-      m_ui_action.add(uiact::hovered_end_turn, 0);
     }
     else
     {
       ci::gl::ScopedColor col{0.4, 0.4, 0.4, 1.0};
+      m_sprites.before_draw();
       ci::gl::drawSolidRoundedRect(rect, 10, 10);
     }
     display_text(std::string{"END TURN"}, rect, {0.9, 0.9, 0.9, 1.0}, rect.getHeight(), true);
@@ -521,73 +452,37 @@ void cind_display_engine::display_player_stats(
   {
     {
       ci::gl::ScopedColor col{0.9, 0.9, 0.4, 1.0};
+      m_sprites.before_draw();
       ci::gl::drawSolidRoundedRect(rect, 10, 10);
     }
     display_text(std::string{"WAITING"}, rect, {0.1, 0.1, 0.1, 1.0}, rect.getHeight(), true);
   }
-  });
-  f.arrange_horizontally();
 
   // attacking the opponent champion
-  display_player_overlay(hand_area, player, is_current_player);
+  display_player_overlay(bar, player, is_current_player);
 }
 
 void cind_display_engine::display_player_lanes(
     player_info const& player,
     bool top,
-    bool is_current_player,
-    ci::Rectf const& hand_area)
+    bool is_current_player)
 {
-  auto g = make_grid(hand_area);
-  g.set_padding(m_constants.board_horizontal_padding, 0.0f);
-  g.set_element_size(m_constants.card_board_width, hand_area.getHeight());
-  g.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
-
-  int lane_no = 0;
-  g.arrange_horizontally(m_session_info->terrain, [&](auto const& item, auto const& rect)
+  auto const num_lanes = std::min(m_session_info->terrain.size(), m_layout.get(layout_part::lane_area, top).size());
+  for (size_t lane_no = 0; lane_no < num_lanes; ++lane_no)
   {
+    auto const& item = m_session_info->terrain[lane_no];
     if (item.empty())
     {
-      return;
+      continue;
     }
-
-    auto g2 = make_grid(rect);
-    g2.set_element_size(m_constants.card_board_width, m_constants.card_board_height);
-    g2.set_padding(0.0f, m_constants.board_vertical_padding);
-    g2.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
-    g2.set_reverse(top);
-
-    int lane_index = 0;
-    g2.arrange(1, m_ruleset.max_lane_height, [&](auto const& tile_rect)
+    for (int lane_index = 0; lane_index < m_ruleset.max_lane_height; ++lane_index)
     {
+      auto const& tile_rect = m_layout.tile(static_cast<int>(lane_no), lane_index, top);
       auto const& tile_terrain = item[top ? lane_index : lane_index + item.size() / 2];//item[top ? lane_index : (item.size() - lane_index - 1)];
-      display_tile(player, top, is_current_player, lane_no, lane_index, tile_terrain, tile_rect);
-      display_tile_overlay(player, top, is_current_player, lane_no, lane_index, tile_terrain, tile_rect);
-      lane_index++;
-    });
-    lane_no++;
-  });
-
-  g.arrange_horizontally(player.lanes, [&](auto const& item, auto const& rect)
-  {
-    if (item.empty())
-    {
-      return;
+      display_tile(player, top, is_current_player, static_cast<int>(lane_no), lane_index, tile_terrain, tile_rect);
+      display_tile_overlay(player, top, is_current_player, static_cast<int>(lane_no), lane_index, tile_terrain, tile_rect);
     }
-
-    auto g2 = make_grid(rect);
-    g2.set_element_size(m_constants.card_board_width, m_constants.card_board_height);
-    g2.set_padding(0.0f, m_constants.board_vertical_padding);
-    g2.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
-
-    g2.arrange_vertically(item, [&](auto const& sub_item, auto const& sub_rect)
-    {
-      ci::gl::ScopedModelMatrix mat{};
-      ci::gl::translate(sub_rect.x1, sub_rect.y1);
-      //ci::gl::rotate(-3.14159f * 0.5f);
-      ci::gl::scale(0.2f, 0.2f);
-    });
-  });
+  }
 }
 
 void cind_display_engine::display_player(
@@ -595,44 +490,9 @@ void cind_display_engine::display_player(
   bool top,
   bool is_current_player)
 {
-  auto const card_height =
-      is_current_player ? (m_constants.card_active_hand_height_multiplier * m_constants.full_card_height)
-                        : (m_constants.card_passive_hand_width_multiplier * m_constants.full_card_height);
-  auto const hand_height = static_cast<float>(
-      card_height + (2 * m_constants.hand_vertical_padding));
-
-  auto win_frame = make_frame(ci::Rectf{0.0f, 0.0f, m_constants.window_width, m_constants.window_height});
-  win_frame.align_vertical(top ? vertical_alignment_t::top : vertical_alignment_t::bottom);
-  win_frame.align_horizontal(horizontal_alignment_t::center);
-  win_frame.set_stretch(false);
- 
-  win_frame.add_element(m_constants.window_width, hand_height, [&](auto const& hand_area)
-  {
-    display_player_hand(player, top, is_current_player, hand_area);
-  });
-
-  //! Find the left corner co-ordinate to display a rectangle of 'width' at the center
-  auto const lcenter_for = [&](auto const width)
-  {
-    return (m_constants.window_width - width) / 2;
-  };
-
-  // health bar
-  auto const health_bar_h = 40.0f;
-  win_frame.add_element(490.0f, health_bar_h, [&](auto const& hand_area)
-  {
-    display_player_stats(player, top, is_current_player, hand_area);
-  });
-
-  // lanes
-  auto const lane_height = (m_constants.card_board_height * 4) + (m_constants.board_vertical_padding * 8);
-  auto const lane_width = (m_constants.card_board_width * 4) + (m_constants.board_horizontal_padding * 8);
-
-  win_frame.add_element(lane_width, lane_height, [&](auto const& hand_area)
-  {
-    display_player_lanes(player, top, is_current_player, hand_area);
-  });
-  win_frame.arrange_vertically();
+  display_player_hand(player, top, is_current_player);
+  display_player_stats(player, top, is_current_player);
+  display_player_lanes(player, top, is_current_player);
 }
 
 void
@@ -643,21 +503,10 @@ cind_display_engine::display_text(
   float point_size,
   bool center) const
 {
-  ci::TextBox box;
-  box.font(ci::Font{"Cambria", point_size});
-
-  box.text(text);
-  box.setColor(col);
-  box.size(rect.getSize());
-  if (center) {
-    box.setAlignment(ci::TextBox::Alignment::CENTER);
-  }
-  auto const surf = box.render({2, 2});
-  auto const textr = ci::gl::Texture::create(surf);
-  ci::gl::draw(textr, rect);
+  m_text.draw(text, rect, col, point_size, center);
 }
 
-ci::gl::Texture2dRef cind_display_engine::choose_texture(terrain_types t) const noexcept
+sprite cind_display_engine::choose_texture(terrain_types t) const noexcept
 {
   switch(t)
   {
@@ -679,7 +528,7 @@ void cind_display_engine::display_player_bottom(player_info const& player, bool
   display_player(player, false, is_current);
 }
 
-ci::gl::Texture2dRef cind_display_engine::hand_card_texture(card_info const& card) const
+sprite cind_display_engine::hand_card_texture(card_info const& card) const
 {
   auto const card_name = L"card-" + card.name + L".png";
   if (auto const t = get_texture(card_name))
@@ -689,12 +538,12 @@ ci::gl::Texture2dRef cind_display_engine::hand_card_texture(card_info const& car
   return get_texture(L"card-placeholder.png");
 }
 
-ci::gl::Texture2dRef cind_display_engine::lane_card_texture(card_info const& card) const
+sprite cind_display_engine::lane_card_texture(card_info const& card) const
 {
   return hand_card_texture(card);
 }
 
-ci::gl::Texture2dRef cind_display_engine::tile_card_texture(card_info const& card) const
+sprite cind_display_engine::tile_card_texture(card_info const& card) const
 {
   auto const card_name = L"tile-" + card.name + L".png";
   if (auto const t = get_texture(card_name))
@@ -704,42 +553,12 @@ ci::gl::Texture2dRef cind_display_engine::tile_card_texture(card_info const& car
   return get_texture(L"tile-placeholder.png");
 }
 
-ci::gl::Texture2dRef cind_display_engine::get_texture(std::wstring const& card_name) const
+sprite cind_display_engine::get_texture(std::wstring const& card_name) const
 {
-  if (auto const it = m_textures.find(card_name); it != m_textures.end())
-  {
-    return it->second;
-  }
-
-  auto const path = ci::app::getAssetPath(card_name);
-  if (path.empty())
-  {
-    return nullptr;
-  }
-
-  auto const asset = ci::app::loadAsset(card_name);
-  if (!asset)
-  {
-    return nullptr;
-  }
-
-  auto const img = ci::loadImage(asset);
-  if (!img)
-  {
-    return nullptr;
-  }
-
-  auto const textr = ci::gl::Texture2d::create(img);
-  if (!textr)
-  {
-    return nullptr;
-  }
-
-  m_textures.emplace(card_name, textr);
-  return textr;
+  return m_textures.get(card_name);
 }
 
-ci::gl::Texture2dRef cind_display_engine::hovered_card_texture(card_info const& card) const
+sprite cind_display_engine::hovered_card_texture(card_info const& card) const
 {
   auto const card_name = L"card-" + card.name + L".png";
   if (auto const t = get_texture(card_name))
@@ -758,8 +577,8 @@ void cind_display_engine::display_cost(ci::Rectf const& target, float scale, car
   // show cost
   {
     ci::Rectf cost_rect{0.0f, 0.0f, 40.0f, 40.0f};
-    ci::gl::draw(get_texture(L"icon-gem.png"), cost_rect);
-    aura::draw_line(cost_rect, std::to_string(card.cost));
+    m_sprites.draw(get_texture(L"icon-gem.png"), cost_rect);
+    aura::draw_line(m_text, cost_rect, std::to_string(card.cost));
   }
 }
 
@@ -778,11 +597,11 @@ static void display_generic_icon(ci::Rectf const& target, float scale, int index
 
 bool cind_display_engine::display_strength(ci::Rectf const& target, float scale, int index, card_info const& card) const
 {
-  auto const strength_texture = std::invoke([&]() -> ci::gl::Texture2dRef
+  auto const strength_texture = std::invoke([&]() -> sprite
   {
     if (!card.strength || card.has_trait(unit_traits::item))
     {
-      return nullptr;
+      return {};
     }
 
     if (card.strength < 0)
@@ -807,10 +626,10 @@ bool cind_display_engine::display_strength(ci::Rectf const& target, float scale,
   {
     ci::Rectf sub_rect{0.0f, 0.0f, 40.0f, 40.0f};
 
-    ci::gl::draw(strength_texture, sub_rect);
+    m_sprites.draw(strength_texture, sub_rect);
     auto const raw_strength = std::to_string(std::abs(card.strength));
     auto const str = card.starting_energy > 1 ? raw_strength + "x" + std::to_string(card.starting_energy) : raw_strength;
-    aura::draw_line(sub_rect, str);
+    aura::draw_line(m_text, sub_rect, str);
   });
 
   return true;
@@ -830,8 +649,8 @@ bool cind_display_engine::display_health(ci::Rectf const& target, float scale, i
   {
     ci::Rectf sub_rect{0.0f, 0.0f, 40.0f, 40.0f};
 
-    ci::gl::draw(get_texture(L"icon-health.png"), sub_rect);
-    aura::draw_line(sub_rect, card.health_as_string());
+    m_sprites.draw(get_texture(L"icon-health.png"), sub_rect);
+    aura::draw_line(m_text, sub_rect, card.health_as_string());
   });
 
   return true;
@@ -839,11 +658,11 @@ bool cind_display_engine::display_health(ci::Rectf const& target, float scale, i
 
 bool cind_display_engine::display_preferred_terrain(ci::Rectf const& target, float scale, int index, card_info const& card) const
 {
-  auto const terrain_texture = std::invoke([&]() -> ci::gl::Texture2dRef
+  auto const terrain_texture = std::invoke([&]() -> sprite
   {
     if (card.preferred_terrain.empty())
     {
-      return nullptr;
+      return {};
     }
     return choose_texture(card.preferred_terrain[0]);
   });
@@ -857,32 +676,39 @@ bool cind_display_engine::display_preferred_terrain(ci::Rectf const& target, flo
   {
     ci::Rectf sub_rect{0.0f, 0.0f, 40.0f, 40.0f};
 
-    ci::gl::draw(terrain_texture, sub_rect);
+    m_sprites.draw(terrain_texture, sub_rect);
   });
   return true;
 }
 
-void cind_display_engine::display_card_texture(ci::gl::Texture2dRef const& t) const
+void cind_display_engine::display_card_texture(sprite const& t) const
 {
-  auto [x1, x2] = std::minmax(0.0f, m_constants.full_card_width);
-  auto [y1, y2] = std::minmax(0.0f, m_constants.full_card_height);
+  auto [x1, x2] = std::minmax({0.0f, m_constants.full_card_width});
+  auto [y1, y2] = std::minmax({0.0f, m_constants.full_card_height});
 
   ci::Rectf rect{x1, y1, x2, y2};
   
-  ci::gl::draw(t, rect);
+  m_sprites.draw(t, rect);
 }
 
 void cind_display_engine::display_card_full(card_info const& card) const
 {
-  auto const mid_height = m_constants.window_height/2.0f;
+  auto [x1, x2] = std::minmax({0.0f, m_constants.full_card_width});
+  auto [y1, y2] = std::minmax({0.0f, m_constants.full_card_height});
 
-  auto [x1, x2] = std::minmax(0.0f, m_constants.full_card_width);
-  auto [y1, y2] = std::minmax(0.0f, m_constants.full_card_height);
+  ci::Rectf rect{x1, y1, x2, y2};
+  m_sprites.draw(m_card_faces.get(card_face_key::of(card), [&] { compose_card_face(card); }), rect);
+}
+
+void cind_display_engine::compose_card_face(card_info const& card) const
+{
+  auto [x1, x2] = std::minmax({0.0f, m_constants.full_card_width});
+  auto [y1, y2] = std::minmax({0.0f, m_constants.full_card_height});
 
   ci::Rectf rect{x1, y1, x2, y2};
   
   {
-    ci::gl::draw(hovered_card_texture(card), rect);
+    m_sprites.draw(hovered_card_texture(card), rect);
   }
 
   // show name
@@ -892,7 +718,7 @@ void cind_display_engine::display_card_full(card_info const& card) const
     auto const height = 20.0f;
 
     ci::Rectf sub_rect{x1 + pad_x, y2 - height - pad_y, x2 - pad_x, y2 - pad_y};
-    aura::draw_line(sub_rect, to_utf8_string(card.name));
+    aura::draw_line(m_text, sub_rect, to_utf8_string(card.name));
   }
 
   // show description
@@ -903,7 +729,7 @@ void cind_display_engine::display_card_full(card_info const& card) const
 
     ci::Rectf sub_rect{x1 + pad_x, y2 - height - pad_y, x2 - pad_x, y2 - pad_y};
     auto const d = format_card_descr(m_rules_engine, card);
-    aura::draw_multiline(sub_rect, d, false);
+    aura::draw_multiline(m_text, sub_rect, d, false);
   }
 
   auto [icon_w, icon_h] = std::pair{40.0f, 40.0f};
@@ -936,11 +762,11 @@ void cind_display_engine::display_selected_card() const
 
   auto const mid_height = m_constants.window_height/2.0f;
 
-  auto [x1, x2] = std::minmax(m_constants.window_width - m_constants.full_card_width, m_constants.window_width);
+  auto [x1, x2] = std::minmax({m_constants.window_width - m_constants.full_card_width, m_constants.window_width});
   auto [y1, y2] =
-      std::minmax(mid_height + m_constants.board_vertical_padding,
+      std::minmax({mid_height + m_constants.board_vertical_padding,
                   mid_height + m_constants.board_vertical_padding +
-                      m_constants.full_card_height);
+                      m_constants.full_card_height});
   ci::Rectf rect{x1, y1, x2, y2};
 
   {
@@ -951,18 +777,24 @@ void cind_display_engine::display_selected_card() const
   }
 }
 
-void cind_display_engine::display_hovered_card() const
+ci::Rectf cind_display_engine::hovered_card_area() const
 {
   auto const mid_height = m_constants.window_height/2.0f;
 
-  auto [x1, x2] = std::minmax(m_constants.window_width - m_constants.full_card_width, m_constants.window_width);
+  auto [x1, x2] = std::minmax({m_constants.window_width - m_constants.full_card_width, m_constants.window_width});
 
   auto [y1, y2] = m_selected_card
-    ? std::minmax(mid_height - m_constants.board_vertical_padding, mid_height - (m_constants.board_vertical_padding + m_constants.full_card_height))
-    : std::minmax(mid_height - m_constants.full_card_height/2.0f, mid_height + m_constants.full_card_height/2.0f);
+    ? std::minmax({mid_height - m_constants.board_vertical_padding, mid_height - (m_constants.board_vertical_padding + m_constants.full_card_height)})
+    : std::minmax({mid_height - m_constants.full_card_height/2.0f, mid_height + m_constants.full_card_height/2.0f});
 
-  ci::Rectf rect{x1, y1, x2, y2};
+  return ci::Rectf{x1, y1, x2, y2};
+}
 
+void cind_display_engine::display_hovered_card() const
+{
+  auto const mid_height = m_constants.window_height/2.0f;
+
+  auto rect = hovered_card_area();
   auto const en_rect = rect.inflated({40.0f, 40.0f});
 
   // if the mouse overlaps with the hover region, we want to display on the left instead
@@ -991,7 +823,7 @@ void cind_display_engine::display_hovered_card() const
     auto y4 = y3 + m_constants.card_board_height;
 
     ci::Rectf r2{x3, y3, x4, y4};
-    ci::gl::draw(get_texture(L"tile-attack.png"), r2);
+    m_sprites.draw(get_texture(L"tile-attack.png"), r2);
   }
 }
 
@@ -1012,6 +844,7 @@ void cind_display_engine::display_hovered_description() const
   hover_rect.offset({10.0f, 20.0f});
   {
     ci::gl::ScopedColor col{0.1f, 0.1f, 0.1f, 0.5f};
+    m_sprites.before_draw();
     ci::gl::drawSolidRect(hover_rect);
   }
   display_text(m_hovered_description, hover_rect, {1.0, 1.0, 1.0, 1.0}, hover_rect.getHeight() / num_lines, false);
@@ -1024,88 +857,63 @@ void cind_display_engine::display_picks()
     return;
   }
 
-  auto const modal_area = std::invoke([&]()
   {
-    ci::Rectf sub_area{};
-
-    auto wind = make_frame(ci::Rectf{0.0f, 0.0f, m_constants.window_width, m_constants.window_height});
-    wind.align_vertical(vertical_alignment_t::center);
-    wind.add_element(m_constants.window_width, m_constants.pick_modal_height, [&](auto const& rect)
-    {
-      ci::gl::ScopedColor col{0.1, 0.1, 0.1, 0.6};
-      ci::gl::drawSolidRect(rect);
-      sub_area = rect;
-    });
-    wind.arrange_horizontally();
-    return sub_area;
-  });
-
-  // Draw red-bordered turn indicator
-  auto f = make_frame(modal_area);
-  f.align_horizontal(horizontal_alignment_t::center);
-  f.align_vertical(vertical_alignment_t::center);
-
-  auto g = make_grid(modal_area);
-  g.set_padding(m_constants.hand_horizontal_padding, m_constants.hand_vertical_padding);
-
-  g.set_element_size(m_constants.full_card_width / 2, m_constants.full_card_height / 2);
-  g.align_vertical(vertical_alignment_t::center);
-  g.align_horizontal(horizontal_alignment_t::center);
-
-  auto [grid_x, grid_y] = g.measure(m_session_info->picks.size(), 1);
+    ci::gl::ScopedColor col{0.1, 0.1, 0.1, 0.6};
+    m_sprites.before_draw();
+    ci::gl::drawSolidRect(m_layout.get(layout_part::picks_area)[0]);
+  }
 
-  f.add_element(grid_x, grid_y, [&](auto const& rect)
+  auto const rects = m_layout.get(layout_part::pick_card);
+  auto const num_picks = std::min(m_session_info->picks.size(), rects.size());
+  for (size_t slot = 0; slot < num_picks; ++slot)
   {
-    g.bounds = rect;    
-    g.arrange_horizontally(m_session_info->picks, [&](auto const& card, auto const& element)
-    {
-      bool const hovered = element.contains(ci::vec2{m_constants.mouse_x, m_constants.mouse_y});
+    auto const& card = m_session_info->picks[slot];
+    auto const& element = rects[slot];
+    bool const hovered = m_ui_action.is(uiact::hovered_pick_card) && m_ui_action.value(uiact::hovered_pick_card) == card.uid;
 
-      ci::gl::ScopedModelMatrix mat{};
-      ci::gl::translate(element.getX1(), element.getY1());
-      ci::gl::scale(0.5f, 0.5f);
-
-      display_card_full(card);
+    ci::gl::ScopedModelMatrix mat{};
+    ci::gl::translate(element.getX1(), element.getY1());
+    ci::gl::scale(0.5f, 0.5f);
 
-      if (hovered)
-      {
-        display_card_texture(get_texture(L"card-highlight.png"));
+    display_card_full(card);
 
-        std::lock_guard lk{m_mutex};
-        m_ui_action.add(uiact::hovered_pick_card, card.uid);
-        m_hovered_description = to_utf8_string(card.name);
-        m_hovered_card = &card;
-      }
-    });
-  });
-  f.add_element(500.0f, 100.0f, [&](auto const& rect)
-  {
-    auto& player = m_session_info->players[m_session_info->current_player];
-    auto const num_draws = player.picks_available; //player.num_draws_per_turn - player.num_drawn_this_turn;
-    auto const text = stringprintf<64>("Turn %d\nPlayer %d, pick %d card%c: ", m_session_info->turn,
-      m_session_info->current_player + 1, num_draws, num_draws > 1 ? 's' : ' ');
-    display_text(text, rect, {0.9, 0.9, 0.9, 1.0}, rect.getHeight() / 2, true);
-    auto const col = ci::gl::ScopedColor{1.0, 0.0, 0.0, 1.0};
-    ci::gl::drawStrokedRect(rect);
-  });
+    if (hovered)
+    {
+      display_card_texture(get_texture(L"card-highlight.png"));
+    }
+  }
 
-  f.arrange_vertically();
+  auto const& rect = m_layout.get(layout_part::picks_caption)[0];
+  auto& player = m_session_info->players[m_session_info->current_player];
+  auto const num_draws = player.picks_available; //player.num_draws_per_turn - player.num_drawn_this_turn;
+  auto const text = stringprintf<64>("Turn %d\nPlayer %d, pick %d card%c: ", m_session_info->turn,
+    m_session_info->current_player + 1, num_draws, num_draws > 1 ? 's' : ' ');
+  display_text(text, rect, {0.9, 0.9, 0.9, 1.0}, rect.getHeight() / 2, true);
+  auto const col = ci::gl::ScopedColor{1.0, 0.0, 0.0, 1.0};
+  m_sprites.before_draw();
+  ci::gl::drawStrokedRect(rect);
 }
 
 void cind_display_engine::display_background() const
 {
-  auto [x1, x2] = std::minmax(0.0f, m_constants.window_width);
-  auto [y1, y2] = std::minmax(0.0f, m_constants.window_height);
+  auto [x1, x2] = std::minmax({0.0f, m_constants.window_width});
+  auto [y1, y2] = std::minmax({0.0f, m_constants.window_height});
   ci::Rectf rect{x1, y1, x2, y2};
   if (auto const t = get_texture(L"woodfloor_c.jpg"))
   {
-    ci::gl::draw(t, rect);
+    m_sprites.draw(t, rect);
   }
 }
 
 void cind_display_engine::mouseDown(ci::app::MouseEvent event)
 {
-  std::lock_guard lk{m_mutex};
+  wake();
+  // a click can arrive before the move that got the mouse here was handled
+  if (m_hits.key_at(event.getPos()) != m_hover_key)
+  {
+    resolve_hover(event.getPos());
+    m_board_dirty = true;
+  }
 
   AURA_LOG(L"+ 0x%x", m_ui_action.type);
 
@@ -1114,32 +922,21 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
     auto [x, y] = std::make_pair(getMousePos().x - getWindowPos().x, getMousePos().y - getWindowPos().y);
 
     ci::Rectf r{static_cast<float>(x) - 100.0f, static_cast<float>(y) - 100.0f, x + 100.0f, y + 100.0f};
-    m_dynamic_animations.emplace_back(make_animation(std::chrono::milliseconds(250), [rect = r, this](auto const& info)
-    {
-      constexpr auto num_frames = 6;
-      auto const sprite_base = std::wstring{L"Slash"};
-        
-      auto const frame_no = static_cast<int>(info.ratio_elapsed * num_frames);
-
-      auto const sprite_name = sprite_base + std::to_wstring(frame_no) + L".png";
-      if (auto const t = get_texture(sprite_name))
-      {
-        ci::gl::draw(t, rect); 
-      }
-    }));
+    m_animations.add(animation{slash_sheet, r, std::chrono::milliseconds(250)}, animation_timeline::clock::now());
   };
 
   auto const reset_action = [&]()
   {
     m_ui_action.reset_selected();
     m_selected_card.reset();
+    m_board_dirty = true;
   };
 
   // Pick card
   if (m_ui_action.is(uiact::hovered_pick_card))
   {
     auto const hovered_card = m_ui_action.value(uiact::hovered_pick_card);
-    m_action.set_value(make_pick_action(hovered_card));
+    send_action(make_pick_action(hovered_card));
     reset_action();
     return;
   }
@@ -1152,7 +949,7 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
     auto const hovered_lane = m_ui_action.value(uiact::hovered_lane);
     AURA_LOG(L"Setting action with %d, %d", selected_value, hovered_lane + 1);
     reset_action();
-    m_action.set_value(make_deploy_action(selected_value, hovered_lane + 1));
+    send_action(make_deploy_action(selected_value, hovered_lane + 1));
     return;
   }
 
@@ -1162,7 +959,7 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
       && m_ui_action.value(uiact::selected_lane_card) != m_ui_action.value(uiact::hovered_lane_card)
     )
   {
-    m_action.set_value(make_primary_action(m_ui_action.value(uiact::selected_lane_card), m_ui_action.value(uiact::hovered_lane_card)));
+    send_action(make_primary_action(m_ui_action.value(uiact::selected_lane_card), m_ui_action.value(uiact::hovered_lane_card)));
     start_animation();
     reset_action();
     return;
@@ -1172,7 +969,7 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
   if (m_ui_action.is(uiact::selected_hand_card)
       && m_ui_action.is(uiact::hovered_lane_card))
   {
-    m_action.set_value(make_primary_action(m_ui_action.value(uiact::selected_hand_card), m_ui_action.value(uiact::hovered_lane_card)));
+    send_action(make_primary_action(m_ui_action.value(uiact::selected_hand_card), m_ui_action.value(uiact::hovered_lane_card)));
     reset_action();
     return;
   }
@@ -1181,7 +978,7 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
   if (m_ui_action.is(uiact::selected_hand_card)
       && m_ui_action.is(uiact::hovered_player))
   {
-    m_action.set_value(make_primary_action(m_ui_action.value(uiact::selected_hand_card), m_ui_action.value(uiact::hovered_player)));
+    send_action(make_primary_action(m_ui_action.value(uiact::selected_hand_card), m_ui_action.value(uiact::hovered_player)));
     reset_action();
     return;
   }
@@ -1190,14 +987,14 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
   if (m_ui_action.is(uiact::selected_lane_card)
     && m_ui_action.is(uiact::hovered_player))
   {
-    m_action.set_value(make_primary_action(m_ui_action.value(uiact::selected_lane_card), m_ui_action.value(uiact::hovered_player)));
+    send_action(make_primary_action(m_ui_action.value(uiact::selected_lane_card), m_ui_action.value(uiact::hovered_player)));
     reset_action();
     return;
   }
 
   if (m_ui_action.is(uiact::hovered_end_turn))
   {
-    m_action.set_value(make_end_turn_action());
+    send_action(make_end_turn_action());
     return;
   }
 
@@ -1208,6 +1005,7 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
   {
     m_ui_action.rm(uiact::selected_hand_card);
     m_selected_card = {};
+    m_board_dirty = true;
     return;
   }
 
@@ -1219,6 +1017,7 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
     AURA_LOG(L"Unsetting selected lane card");
     m_ui_action.rm(uiact::selected_lane_card);
     m_selected_card = {};
+    m_board_dirty = true;
     return;
   }
 
@@ -1233,6 +1032,7 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
     m_ui_action.add(uiact::selected_lane_card, hovered_card);
     m_can_be_targetted = m_rules_engine.get_target_list(hovered_card);
     m_selected_card = *m_hovered_card;
+    m_board_dirty = true;
     return;
   }
 
@@ -1243,14 +1043,115 @@ void cind_display_engine::mouseDown(ci::app::MouseEvent event)
     m_ui_action.add(uiact::selected_hand_card, hovered_card);
     m_can_be_targetted = m_rules_engine.get_target_list(hovered_card);
     m_selected_card = *m_hovered_card;
+    m_board_dirty = true;
   }
   AURA_LOG(L"- 0x%x", m_ui_action.type);
 }
 
-void cind_display_engine::display_terrain()
+void cind_display_engine::mouseMove(ci::app::MouseEvent event)
+{
+  wake();
+  // moving within the same targets changes nothing on the board
+  if (m_hits.key_at(event.getPos()) != m_hover_key)
+  {
+    resolve_hover(event.getPos());
+    m_board_dirty = true;
+  }
+}
+
+void cind_display_engine::resize()
+{
+  wake();
+}
+
+void cind_display_engine::keyDown(ci::app::KeyEvent event)
+{
+  wake();
+  if (event.getCode() == ci::app::KeyEvent::KEY_F3)
+  {
+    m_constants.show_frame_stats = !m_constants.show_frame_stats;
+  }
+}
+
+void cind_display_engine::display_terrain(session_info const& sesh)
+{
+  ci::ivec2 const window{static_cast<int>(m_constants.window_width), static_cast<int>(m_constants.window_height)};
+  auto const complete = m_textures.preloaded();
+  // the terrain never changes during a game, but the lanes move with the
+  // window and with whose turn it is, since the current player's hand is taller
+  if (m_terrain_fbo && window == m_terrain_window && sesh.current_player == m_terrain_player
+    && complete == m_terrain_complete)
+  {
+    return;
+  }
+
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  // tiles in the upper half, their icons in the lower half at the same offsets
+  auto const size = toPixels(ci::ivec2{window.x, 2 * window.y});
+  if (size.x <= 0 || size.y <= 0)
+  {
+    return;
+  }
+  if (!m_terrain_fbo || m_terrain_fbo->getSize() != size)
+  {
+    m_terrain_fbo = ci::gl::Fbo::create(size.x, size.y, true);
+  }
+
+  {
+    ci::gl::ScopedFramebuffer fb{m_terrain_fbo};
+    ci::gl::ScopedViewport vp{ci::ivec2{0, 0}, size};
+    ci::gl::ScopedMatrices matrices{};
+    ci::gl::setMatricesWindow(window.x, 2 * window.y);
+    // texels are copied as they are, so blitting them later blends exactly
+    // like drawing the original images would
+    ci::gl::ScopedBlend blend{false};
+    ci::gl::clear(ci::ColorA{0.0f, 0.0f, 0.0f, 0.0f});
+    for (auto const top : {true, false})
+    {
+      auto const num_lanes = std::min(sesh.terrain.size(), m_layout.get(layout_part::lane_area, top).size());
+      for (size_t lane_no = 0; lane_no < num_lanes; ++lane_no)
+      {
+        auto const& item = sesh.terrain[lane_no];
+        if (item.empty())
+        {
+          continue;
+        }
+        for (int lane_index = 0; lane_index < m_ruleset.max_lane_height; ++lane_index)
+        {
+          bake_tile(item[top ? lane_index : lane_index + item.size() / 2],
+            m_layout.tile(static_cast<int>(lane_no), lane_index, top));
+        }
+      }
+    }
+    m_sprites.flush();
+  }
+
+  m_terrain_window = window;
+  m_terrain_player = sesh.current_player;
+  m_terrain_complete = complete;
+  AURA_LOG(L"Baked the terrain layer at %dx%d", size.x, size.y);
+}
+
+void cind_display_engine::bake_tile(terrain_types t, ci::Rectf const& tile_rect)
+{
+  m_sprites.draw(get_texture(terrain_tile_name(t)), tile_rect);
+  auto const icon_rect = terrain_icon_rect(tile_rect);
+  m_sprites.draw(get_texture(terrain_icon_name(t)), icon_rect + ci::vec2{0.0f, m_constants.window_height});
+}
+
+sprite cind_display_engine::terrain_sprite(terrain_types t, ci::Rectf const& rect, bool icon) const
 {
-  //auto g = make_grid();
-  //g.
+  if (!m_terrain_fbo)
+  {
+    return get_texture(icon ? terrain_icon_name(t) : terrain_tile_name(t));
+  }
+
+  // framebuffer rows run bottom up
+  auto const w = static_cast<float>(m_terrain_window.x);
+  auto const h = 2.0f * m_terrain_window.y;
+  auto const y = icon ? rect.y1 + m_terrain_window.y : rect.y1;
+  auto const uv = ci::Rectf{rect.x1 / w, 1.0f - y / h, rect.x2 / w, 1.0f - (y + rect.getHeight()) / h};
+  return sprite{m_terrain_fbo->getColorTexture(), uv};
 }
 
 void cind_display_engine::display_mouse()
@@ -1260,98 +1161,496 @@ void cind_display_engine::display_mouse()
 
 void cind_display_engine::display_animations()
 {
-  std::vector<decltype(m_dynamic_animations.begin())> erase_list;
-  for (auto it = begin(m_dynamic_animations); it != end(m_dynamic_animations); ++it)
+  // one time sample for all of them, so effects started together stay in step
+  auto const now = animation_timeline::clock::now();
+  m_animations.update(now, [&](anim_info const& info)
+  {
+    auto const& sheet = sprite_sheets[info.sheet];
+    auto const frame_no = std::min(static_cast<int>(info.ratio_elapsed * sheet.frames), sheet.frames - 1);
+    auto const t = sheet_frame(info.sheet, frame_no);
+    if (!t)
+    {
+      return;
+    }
+
+    auto rect = info.rect;
+    auto alpha = 1.0f;
+    switch (info.property)
+    {
+    case anim_property::alpha: alpha = info.value; break;
+    case anim_property::scale: rect.scaleCentered(info.value); break;
+    case anim_property::none: break;
+    }
+    ci::gl::ScopedColor col{1.0f, 1.0f, 1.0f, alpha};
+    m_sprites.draw(t, rect);
+  });
+  m_last_frame_time = now;
+}
+
+sprite cind_display_engine::sheet_frame(int sheet, int frame_no) const
+{
+  if (m_sheet_frames.empty())
+  {
+    m_sheet_frames.resize(std::size(sprite_sheets));
+  }
+  auto& frames = m_sheet_frames[sheet];
+  if (frames.empty())
   {
-    auto const now = std::chrono::steady_clock::now();
-    auto const time_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - it->time_triggered);
-    
-    if (time_elapsed > it->total_duration)
+    frames.resize(sprite_sheets[sheet].frames);
+  }
+  // looked up by name only until the frame has loaded; the placeholder
+  // shown meanwhile must not be kept in its place
+  auto& s = frames[frame_no];
+  if (!s)
+  {
+    auto const name = sprite_sheets[sheet].base + std::to_wstring(frame_no) + L".png";
+    auto const t = get_texture(name);
+    if (!m_textures.loaded(name))
     {
-      erase_list.emplace_back(it);
-      break;
+      return t;
     }
+    s = t;
+  }
+  return s;
+}
 
-    anim_info in{
-      time_elapsed,
-      static_cast<float>(time_elapsed.count()) / it->total_duration.count(),
-      it->index++
-    };
+std::vector<std::wstring> cind_display_engine::asset_manifest(std::filesystem::path const& asset_dir)
+{
+  auto names = texture_manager::make_manifest(asset_dir);
+  for (auto const& sheet : sprite_sheets)
+  {
+    for (int i = 0; i < sheet.frames; ++i)
+    {
+      names.emplace_back(sheet.base + std::to_wstring(i) + L".png");
+    }
+  }
+  return names;
+}
 
-    //AURA_LOG(L"Ratio elapsed: (%lld / %lld) %.02f, Index: %d", time_elapsed.count(), it->total_duration.count(), 
-    //  in.ratio_elapsed, in.render_index);
-    it->renderer(in);
+void cind_display_engine::display_frame_stats() const
+{
+  if (!m_constants.show_frame_stats)
+  {
+    return;
   }
 
-  for (auto const& e : erase_list)
+  // counts of the previous frame; this one is still being drawn
+  auto const& s = m_sprites.last_frame();
+  auto const text = stringprintf<96>("%.0f fps, %d draw calls, %d sprites in %d batches", getAverageFps(),
+    s.draw_calls, s.sprites, s.batches);
+  ci::Rectf const rect{8.0f, 8.0f, 408.0f, 28.0f};
   {
-    m_dynamic_animations.erase(e);
+    m_sprites.before_draw();
+    ci::gl::ScopedColor col{0.1f, 0.1f, 0.1f, 0.7f};
+    ci::gl::drawSolidRect(rect.inflated({4.0f, 2.0f}));
   }
-  m_last_frame_time = std::chrono::steady_clock::now();
+  display_text(text, rect, {0.9f, 0.9f, 0.9f, 1.0f}, 16.0f, false);
 }
 
 player_action cind_display_engine::display_session(std::shared_ptr<session_info> info, bool redraw)
 {
-  with_lock([&] { m_session_info = std::move(info); });
-
-  auto const action = m_action.get_future().get();
-  std::promise<player_action> p;
+  // logic thread; the render thread picks the snapshot up on its next frame
+  m_sessions.publish(std::move(info));
+  return m_actions.pop();
+}
 
-  with_lock([&] { m_action.swap(p); });
-  
-  return action;
+void cind_display_engine::send_action(player_action const& action)
+{
+  // one action per snapshot, or the next would act on a board the player
+  // hasn't seen yet
+  if (m_action_pending)
+  {
+    AURA_LOG(L"Ignoring an action while the last one is being played");
+    return;
+  }
+  if (!m_actions.try_push(action))
+  {
+    AURA_LOG(L"Dropping an action, the logic thread is behind");
+    return;
+  }
+  m_action_pending = true;
 }
 
 void cind_display_engine::draw()
 {
-  auto const sesh = with_lock([&]
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  // uploads what the decode threads finished, leaving most of the frame to drawing
+  auto const uploaded = m_textures.upload(std::chrono::milliseconds{2});
+  if (uploaded)
   {
-    m_ui_action.reset_hovered();
+    // faces may have been composed with placeholders
+    m_card_faces.clear();
+  }
+
+  if (m_sessions.update())
+  {
+    m_session_info = m_sessions.latest();
+    m_action_pending = false;
+  }
+
+  auto const ws = getWindowBounds().getSize();
+  auto const mouse = getMousePos() - getWindowPos();
 
-    auto const ws = getWindowBounds().getSize();
+  // the board is only rendered again when something it shows may differ;
+  // the mouse handlers mark it dirty when the hover or selection changes
+  auto const dirty = m_board_dirty || uploaded || !m_board_fbo || m_session_info != m_board_session
+    || ws != m_board_window_size;
+  if (dirty)
+  {
     m_constants.window_width = ws.x;
     m_constants.window_height = ws.y;
-    m_constants.mouse_x = getMousePos().x - getWindowPos().x;
-    m_constants.mouse_y = getMousePos().y - getWindowPos().y;
-
-    m_hovered_description.clear();
     m_mouse_texture = get_texture(L"mouse-pointer.png");
-    m_hovered_card = nullptr;
-    return m_session_info;
-  });
+
+    // a new snapshot or selection can change what the mouse is over even
+    // where it stays put; indexing the targets is cheap next to rendering
+    m_board_session = m_session_info;
+    m_board_window_size = ws;
+    m_board_dirty = false;
+    layout_board();
+    resolve_hover(mouse);
+    render_board(mouse);
+  }
+  m_constants.mouse_x = mouse.x;
+  m_constants.mouse_y = mouse.y;
 
   ci::gl::clear();
+  if (m_board_fbo)
+  {
+    // framebuffer rows run bottom up; the board is opaque and replaces
+    // whatever is there
+    ci::gl::ScopedBlend blend{false};
+    m_sprites.draw(sprite{m_board_fbo->getColorTexture(), ci::Rectf{0.0f, 1.0f, 1.0f, 0.0f}}, getWindowBounds());
+    m_sprites.flush();
+  }
+  // follows the mouse, so it is drawn every frame rather than into the board
+  if (!m_hovered_description.empty())
+  {
+    display_hovered_description();
+  }
+  display_mouse();
+  display_animations();
+  display_frame_stats();
+  m_sprites.end_frame();
+  m_text.end_frame();
+  m_card_faces.end_frame();
+  pace_frames(dirty || !m_animations.empty());
+}
 
+void cind_display_engine::layout_board()
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  m_hits.reset(ci::Rectf{0.0f, 0.0f, m_constants.window_width, m_constants.window_height});
+  auto const sesh = m_session_info.get();
   if (!sesh)
   {
     return;
   }
 
-  assert(sesh->current_player == 0 || sesh->current_player == 1);
-  //display_background();
+  // most renders only move the hover, which leaves every rect in place
+  board_layout_key key;
+  key.window = ci::ivec2{static_cast<int>(m_constants.window_width), static_cast<int>(m_constants.window_height)};
+  key.current_player = sesh->current_player;
+  key.hand_size[0] = static_cast<int>(sesh->players[0].hand.size());
+  key.hand_size[1] = static_cast<int>(sesh->players[1].hand.size());
+  key.picks = static_cast<int>(sesh->picks.size());
+  key.lanes = static_cast<int>(sesh->terrain.size());
+  key.lane_height = m_ruleset.max_lane_height;
+  m_layout.update(key, m_constants);
+
+  // in the order the board is drawn, so what is drawn on top is hovered last
+  for (int side = 0; side < 2; ++side)
+  {
+    auto const& player = sesh->players[side];
+    auto const top = side == 0;
+    auto const is_current_player = sesh->current_player == side;
+    auto const scale_factor = is_current_player ? m_constants.card_active_hand_height_multiplier : m_constants.card_passive_hand_width_multiplier;
+    auto const cur_mana = sesh->players[sesh->current_player].mana;
+
+    auto const hand = m_layout.get(layout_part::hand_card, top);
+    auto const num_cards = std::min(player.hand.size(), hand.size());
+    for (size_t slot = 0; slot < num_cards; ++slot)
+    {
+      // unplayable cards are drawn nudged towards the edge
+      auto rect = hand[slot];
+      if (is_current_player && player.hand[slot].cost > cur_mana)
+      {
+        rect.offset({0.0f, top ? -4.0f : 4.0f});
+      }
+      ci::Rectf const window_rect{rect.x1, rect.y1, rect.x1 + m_constants.full_card_width * scale_factor,
+        rect.y1 + m_constants.full_card_height * scale_factor};
+      m_hits.add(hit_target{hit_zone::hand_card, -1, static_cast<int>(slot), player.hand[slot].uid, player.uid, window_rect});
+    }
+
+    m_hits.add(hit_target{hit_zone::player, -1, -1, player.uid, player.uid, m_layout.get(layout_part::stats_bar, top)[0]});
+    if (is_current_player)
+    {
+      m_hits.add(hit_target{hit_zone::end_turn, -1, -1, -1, player.uid, m_layout.get(layout_part::end_turn, top)[0]});
+    }
 
-  display_terrain();
-  display_player_top(sesh->players[0], sesh->current_player == 0);
-  display_player_bottom(sesh->players[1], sesh->current_player == 1);
+    auto const num_lanes = std::min(sesh->terrain.size(), m_layout.get(layout_part::lane_area, top).size());
+    for (size_t lane_no = 0; lane_no < num_lanes; ++lane_no)
+    {
+      if (sesh->terrain[lane_no].empty())
+      {
+        continue;
+      }
+      auto const& lane = player.lanes[lane_no];
+      for (int lane_index = 0; lane_index < m_ruleset.max_lane_height; ++lane_index)
+      {
+        auto const normalized_lane_index = top ? lane_index : m_ruleset.max_lane_height - lane_index - 1;
+        auto const tile_uid = lane.size() > static_cast<size_t>(normalized_lane_index) ? lane[normalized_lane_index].uid : -1;
+        m_hits.add(hit_target{hit_zone::tile, static_cast<int>(lane_no), normalized_lane_index, tile_uid, player.uid,
+          m_layout.tile(static_cast<int>(lane_no), lane_index, top)});
+      }
+    }
+  }
 
-  display_picks();
+  auto const picks = m_layout.get(layout_part::pick_card);
+  auto const num_picks = std::min(sesh->picks.size(), picks.size());
+  for (size_t slot = 0; slot < num_picks; ++slot)
   {
-    std::lock_guard lk{m_mutex};
-    if (!m_hovered_description.empty())
+    m_hits.add(hit_target{hit_zone::pick_card, -1, static_cast<int>(slot), sesh->picks[slot].uid, -1, picks[slot]});
+  }
+
+  // the hovered card moves aside when the mouse is where it would go
+  m_hits.add(hit_target{hit_zone::card_preview, -1, -1, -1, -1, hovered_card_area().inflated({40.0f, 40.0f})});
+}
+
+void cind_display_engine::resolve_hover(ci::vec2 const& p)
+{
+  m_ui_action.reset_hovered();
+  m_hovered_description.clear();
+  m_hovered_card = nullptr;
+  m_hover_refused = false;
+  m_hover_key = m_hits.key_at(p);
+
+  auto const sesh = m_session_info.get();
+  if (!sesh)
+  {
+    return;
+  }
+  m_hits.for_each_at(p, [&](hit_target const& t)
+  {
+    switch (t.zone)
     {
-      display_hovered_description();
+    case hit_zone::hand_card:
+      hover_hand_card(*sesh, t);
+      break;
+    case hit_zone::tile:
+      hover_tile(*sesh, t);
+      break;
+    case hit_zone::player:
+      hover_player(*sesh, t);
+      break;
+    case hit_zone::end_turn:
+      m_ui_action.add(uiact::hovered_end_turn, 0);
+      break;
+    case hit_zone::pick_card:
+    {
+      auto const& card = sesh->picks[t.slot];
+      m_ui_action.add(uiact::hovered_pick_card, card.uid);
+      m_hovered_description = to_utf8_string(card.name);
+      m_hovered_card = &card;
+      break;
     }
-    if (m_selected_card)
+    case hit_zone::card_preview:
+      break;
+    }
+  });
+}
+
+void cind_display_engine::hover_hand_card(session_info const& sesh, hit_target const& t)
+{
+  auto const side = sesh.players[0].uid == t.player ? 0 : 1;
+  auto const& item = sesh.players[side].hand[t.slot];
+  m_ui_action.add(uiact::hovered_hand_card, item.uid);
+  if (sesh.current_player != side)
+  {
+    return;
+  }
+
+  m_hovered_card = &item;
+  if (item.cost <= sesh.players[side].mana)
+  {
+    m_hovered_description = to_utf8_string(item.get_hovered_description());
+  }
+  else
+  {
+    m_hovered_description = to_utf8_string(item.name) + " (Insufficient mana to play this card)";
+  }
+}
+
+void cind_display_engine::hover_tile(session_info const& sesh, hit_target const& t)
+{
+  auto const side = sesh.players[0].uid == t.player ? 0 : 1;
+  auto const top = side == 0;
+  auto const is_current_player = sesh.current_player == side;
+  auto const& lane = sesh.players[side].lanes[t.lane];
+  auto const& terrain = sesh.terrain[t.lane];
+  auto const lane_index = top ? t.slot : m_ruleset.max_lane_height - t.slot - 1;
+  auto const tile_terrain = terrain[top ? lane_index : lane_index + terrain.size() / 2];
+
+  if (lane.size() <= static_cast<size_t>(t.slot))
+  {
+    // only the next empty tile of the player to move takes a card
+    if (!is_current_player || lane.size() != static_cast<size_t>(t.slot)
+      || !m_ui_action.is(uiact::selected_hand_card))
     {
-      display_selected_card();
+      return;
     }
-    if (m_hovered_card)
+    m_hovered_description = to_string(tile_terrain);
+    if (m_selected_card && m_selected_card->can_be_deployed())
     {
-      display_hovered_card();
+      m_ui_action.add(uiact::hovered_lane, t.lane);
+      if (m_selected_card->prefers_terrain(tile_terrain))
+      {
+        m_hovered_description += " (terrain bonus: +1 defense)";
+      }
     }
+    return;
+  }
+
+  auto const& card = lane[t.slot];
+  m_hovered_description = to_utf8_string(card.get_hovered_description());
+  if (m_selected_card && m_selected_card->prefers_terrain(tile_terrain))
+  {
+    m_hovered_description += " (terrain bonus: +1 damage)";
+  }
+
+  if (m_ui_action.is(uiact::selected_lane_card) && card.uid == m_ui_action.value(uiact::selected_lane_card))
+  {
+    m_ui_action.add(uiact::hovered_lane_card, card.uid);
+    return;
+  }
+
+  m_hovered_card = &card;
+
+  if (m_ui_action.is(cind_action_type::selected_lane_card) ||
+       m_ui_action.is(cind_action_type::selected_hand_card))
+  {
+    bool in_sight = (m_selected_card && m_selected_card->action_type == card_action_type::ranged_attack)
+      || ((lane.size() - 1) == static_cast<size_t>(t.slot));
+
+    bool can_target = m_selected_card &&
+      ((m_selected_card->can_target_enemy() && !is_current_player && in_sight)
+      || (m_selected_card->can_target_friendly() && is_current_player));
+
+    if (can_target)
+    {
+      m_ui_action.add(uiact::hovered_lane_card, card.uid);
+    }
+    else
+    {
+      m_hover_refused = true;
+    }
+  }
+  else if (card.can_act() && is_current_player)
+  {
+    m_ui_action.add(uiact::hovered_lane_card, card.uid);
+  }
+}
+
+void cind_display_engine::hover_player(session_info const& sesh, hit_target const& t)
+{
+  if (!m_selected_card)
+  {
+    return;
+  }
+
+  auto const side = sesh.players[0].uid == t.player ? 0 : 1;
+  auto const& player = sesh.players[side];
+  auto const is_current_player = sesh.current_player == side;
+  if (!is_current_player && !m_selected_card->can_target_enemy())
+  {
+    m_hovered_description = player.name + ": no actions possible at this time";
+    return;
+  }
+
+  if (is_current_player && !((int)m_selected_card->action_targets & (int)card_action_targets::friendly_hero))
+  {
+    m_hovered_description = "Player: can't attack self";
+    return;
+  }
+
+  if (!is_current_player && !player.has_free_lane() && m_selected_card->action_type != card_action_type::ranged_attack)
+  {
+    m_hovered_description = player.name + ": no free lane available to attack";
+    m_hover_refused = true;
+    return;
+  }
+  m_ui_action.add(uiact::hovered_player, player.uid);
+}
+
+void cind_display_engine::render_board(ci::ivec2 mouse)
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  // the draw functions highlight what resolve_hover() found under the mouse
+  m_constants.mouse_x = mouse.x;
+  m_constants.mouse_y = mouse.y;
+
+  auto const size = toPixels(getWindowSize());
+  if (size.x <= 0 || size.y <= 0)
+  {
+    // minimized
+    return;
+  }
+  if (!m_board_fbo || m_board_fbo->getSize() != size)
+  {
+    m_board_fbo = ci::gl::Fbo::create(size.x, size.y, true);
+  }
+  auto const sesh = m_session_info.get();
+  if (sesh)
+  {
+    display_terrain(*sesh);
+  }
+
+  {
+    ci::gl::ScopedFramebuffer fb{m_board_fbo};
+    ci::gl::ScopedViewport vp{ci::ivec2{0, 0}, size};
+    ci::gl::clear();
+    if (sesh)
+    {
+      assert(sesh->current_player == 0 || sesh->current_player == 1);
+      //display_background();
+
+      display_player_top(sesh->players[0], sesh->current_player == 0);
+      display_player_bottom(sesh->players[1], sesh->current_player == 1);
+
+      display_picks();
+      if (m_selected_card)
+      {
+        display_selected_card();
+      }
+      if (m_hovered_card)
+      {
+        display_hovered_card();
+      }
+    }
+    m_sprites.flush();
+  }
+}
+
+void cind_display_engine::wake()
+{
+  m_idle_frames = 0;
+  if (getFrameRate() != m_constants.active_frame_rate)
+  {
+    setFrameRate(m_constants.active_frame_rate);
+  }
+}
+
+void cind_display_engine::pace_frames(bool busy)
+{
+  if (busy)
+  {
+    wake();
+    return;
+  }
+  // idle frames only redraw the cached board and poll for a new session
+  if (++m_idle_frames == m_constants.frames_before_idle)
+  {
+    setFrameRate(m_constants.idle_frame_rate);
   }
-  display_mouse();
-  display_animations();
 }
 
 }
@@ -6,11 +6,12 @@
 #include <cinder/app/App.h>
 #include <cinder/app/RendererGl.h>
 #include <cinder/gl/gl.h>
+#include <cinder/gl/Fbo.h>
 #include <cinder/Log.h>
 #include <cinder/Text.h>
+#include <algorithm>
 #include <vector>
 #include <memory>
-#include <mutex>
 #include <thread>
 #include <optional>
 #include "display_constants.h"
@@ -18,8 +19,16 @@
 #include <aura-cinder/animation.h>
 
 #include <aura-core/session_info.h>
+#include <aura-core/spsc_queue.h>
+#include <aura-core/triple_buffer.h>
 
+#include "board_layout.h"
+#include "card_face_cache.h"
 #include "cind_action.h"
+#include "hit_test.h"
+#include "sprite_batch.h"
+#include "text_renderer.h"
+#include "texture_manager.h"
 
 namespace aura
 {
@@ -37,6 +46,12 @@ public:
     auto const abs_path = std::filesystem::absolute(std::filesystem::current_path() / L"assets").wstring();
     AURA_LOG(L"assets path = %ls", abs_path.c_str());
     ci::app::addAssetDirectory(abs_path);  
+    // decode on up to four threads, leaving the render and logic threads a core each
+    auto const hw = static_cast<int>(std::thread::hardware_concurrency());
+    m_textures.start(abs_path, std::clamp(hw - 2, 1, 4));
+    m_textures.preload(asset_manifest(abs_path));
+    // setup() and draw() run on the same thread
+    trace_set_thread_name("render");
     card_info in{};
 
     std::vector<bool> v(m_ruleset.max_lane_height, false);
@@ -44,6 +59,7 @@ public:
 
     m_logic_thread = std::thread{[this]
     {
+      trace_set_thread_name("logic");
       start_game_session(m_ruleset, m_rules_engine, *this);
     }};
   }
@@ -59,6 +75,15 @@ public:
 	//! Override to receive mouse-down events.
 	void mouseDown(ci::app::MouseEvent event) override;
 
+  //! Mouse movement brings the frame rate back up from idle and resolves
+  //! what is hovered
+  void mouseMove(ci::app::MouseEvent event) override;
+
+  //! F3 toggles the frame stats overlay
+  void keyDown(ci::app::KeyEvent event) override;
+
+  void resize() override;
+
   //! ci::app::App interface
   void draw() override;
 
@@ -87,20 +112,17 @@ public:
   void display_player_lanes(
     player_info const& player,
     bool top,
-    bool is_current_player,
-    ci::Rectf const& hand_area);
+    bool is_current_player);
 
   void display_player_stats(
     player_info const& player,
     bool top,
-    bool is_current_player,
-    ci::Rectf const& hand_area);
+    bool is_current_player);
 
   void display_player_hand(
     player_info const& player,
     bool top,
-    bool is_current_player,
-    ci::Rectf const& hand_area);
+    bool is_current_player);
 
   void display_player(
     player_info const& player,
@@ -113,9 +135,17 @@ public:
 
   enum class selection : int { passive, hovered, selected };
 
-  ci::gl::Texture2dRef choose_texture(terrain_types t) const noexcept;
+  sprite choose_texture(terrain_types t) const noexcept;
+
+  //! Bakes the terrain tiles and icons of the board into m_terrain_fbo if
+  //! the layout changed since they were last baked
+  void display_terrain(session_info const& sesh);
 
-  void display_terrain();
+  void bake_tile(terrain_types t, ci::Rectf const& tile_rect);
+
+  //! The baked terrain tile or 'icon' of type 't' drawn at 'rect'; the
+  //! image itself until the terrain is baked
+  sprite terrain_sprite(terrain_types t, ci::Rectf const& rect, bool icon) const;
 
   void display_text(std::string const& text, ci::Rectf const&, ci::ColorAf const& , float point_size, bool) const;
 
@@ -129,11 +159,18 @@ public:
 
   bool display_strength(ci::Rectf const& target, float scale, int index, card_info const& card) const;
 
-  void display_card_texture(ci::gl::Texture2dRef const& t) const;
+  void display_card_texture(sprite const& t) const;
+  //! Draws the card's face, composed or from m_card_faces
   void display_card_full(card_info const&) const;
 
+  //! Draws art, icons, name and description of a card face
+  void compose_card_face(card_info const&) const;
+
   void display_selected_card() const;
 
+  //! Where the hovered card is shown, unless the mouse is there
+  ci::Rectf hovered_card_area() const;
+
   void display_hovered_card() const;
 
   void display_hovered_description() const;
@@ -146,22 +183,50 @@ public:
 
   void display_animations();
 
-  ci::gl::Texture2dRef hand_card_texture(card_info const&) const;
+  //! Frame 'frame_no' of sprite sheet 'sheet'; see animation::sheet
+  sprite sheet_frame(int sheet, int frame_no) const;
 
-  ci::gl::Texture2dRef lane_card_texture(card_info const&) const;
+  //! The assets to preload: texture_manager::make_manifest() and the
+  //! frames of every sprite sheet
+  static std::vector<std::wstring> asset_manifest(std::filesystem::path const& asset_dir);
 
-  ci::gl::Texture2dRef tile_card_texture(card_info const&) const;
+  void display_frame_stats() const;
 
-  ci::gl::Texture2dRef hovered_card_texture(card_info const&) const;
+  //! Lays the board out for the current snapshot and window and indexes
+  //! what the mouse can be over in m_hits
+  void layout_board();
 
-  ci::gl::Texture2dRef get_texture(std::wstring const& name) const;
+  //! Sets the hovered part of m_ui_action, the hovered card and its
+  //! description from the targets at 'p'; the draw functions only show it
+  void resolve_hover(ci::vec2 const& p);
 
-  template <typename Fn>
-  auto with_lock(Fn const& fn)
-  {
-    std::lock_guard lock{m_mutex};
-    return fn();
-  }
+  void hover_hand_card(session_info const& sesh, hit_target const& t);
+
+  void hover_tile(session_info const& sesh, hit_target const& t);
+
+  void hover_player(session_info const& sesh, hit_target const& t);
+
+  //! Draws the board, hands, stats and hover overlays into m_board_fbo
+  void render_board(ci::ivec2 mouse);
+
+  //! Back to the active frame rate; call on input
+  void wake();
+
+  //! Drops to the idle frame rate once nothing has changed for a while
+  void pace_frames(bool busy);
+
+  sprite hand_card_texture(card_info const&) const;
+
+  sprite lane_card_texture(card_info const&) const;
+
+  sprite tile_card_texture(card_info const&) const;
+
+  sprite hovered_card_texture(card_info const&) const;
+
+  sprite get_texture(std::wstring const& name) const;
+
+  //! Queues 'action' for the logic thread unless one is still being played
+  void send_action(player_action const& action);
 
 private:
   display_constants m_constants;
@@ -170,9 +235,32 @@ private:
 
   aura::local_rules_engine m_rules_engine{m_ruleset};
 
+  //! Snapshots from the logic thread, latest first; see display_session()
+  triple_buffer<std::shared_ptr<session_info>> m_sessions;
+
+  //! Actions for the logic thread, which waits on them in display_session()
+  spsc_queue<player_action, 16> m_actions;
+
+  //! The snapshot being drawn; render thread only, like everything below
+  //! that isn't documented otherwise
   std::shared_ptr<session_info> m_session_info;
 
-  mutable std::mutex m_mutex;
+  //! Where everything on the board goes; laid out again by render_board()
+  //! only when the window or the shape of the game state changes
+  board_layout m_layout;
+
+  //! What the mouse can be over on the board as last laid out
+  hit_test_grid m_hits;
+
+  //! What the mouse was over when the hover was last resolved, see
+  //! hit_test_grid::key_at()
+  std::uint64_t m_hover_key{};
+
+  //! The selected card can't be used on the hovered target
+  bool m_hover_refused{false};
+
+  //! Set from sending an action until the snapshot it produced arrives
+  bool m_action_pending{false};
 
   std::thread m_logic_thread;
 
@@ -186,22 +274,53 @@ private:
   // selected card is persisted across turns, so it must be copied
   std::optional<card_info> m_selected_card{};
 
-  ci::gl::Texture2dRef m_mouse_texture{};
+  sprite m_mouse_texture{};
 
-  std::vector<dynamic_animation> m_dynamic_animations;
+  //! Effects playing on top of the board, such as attack slashes
+  animation_timeline m_animations;
+
+  //! Frames of each sprite sheet, looked up on first use
+  mutable std::vector<std::vector<sprite>> m_sheet_frames;
 
   std::chrono::steady_clock::time_point m_last_frame_time;
 
-  mutable std::unordered_map<std::wstring, ci::gl::Texture2dRef> m_textures;
+  //! Loads assets in the background; see get_texture()
+  mutable texture_manager m_textures;
+
+  //! Queues the textured quads of a frame and draws them in as few calls as
+  //! the texture changes allow; see sprite_batch
+  mutable sprite_batch m_sprites;
+
+  //! Glyph atlases and laid out strings for everything display_text() and
+  //! the draw helpers put on screen
+  mutable text_renderer m_text{m_sprites};
+
+  //! Card faces composed at full size, redrawn when what they show changes
+  mutable card_face_cache m_card_faces{m_sprites,
+    ci::ivec2{static_cast<int>(m_constants.full_card_width), static_cast<int>(m_constants.full_card_height)}};
 
   //! If a card is selected, this vector stores all other cards that can be targetted
   std::vector<int> m_can_be_targetted;
 
-  std::promise<player_action> m_action;
-
   std::unordered_map<int, float> ratios;
 
   std::vector<std::vector<bool>> m_is_tile_revealed{};
+
+  //! The board as last rendered and what it was rendered from; draw() only
+  //! renders it again when one of these changes
+  ci::gl::FboRef m_board_fbo;
+  std::shared_ptr<session_info> m_board_session;
+  ci::ivec2 m_board_window_size{};
+  bool m_board_dirty{true};  //!< set by input that changes the hover or selection
+
+  //! Every terrain tile of the board, and below them their icons, rendered
+  //! once for the layout they were baked for
+  ci::gl::FboRef m_terrain_fbo;
+  ci::ivec2 m_terrain_window{};
+  int m_terrain_player{-1};
+  bool m_terrain_complete{false};  //!< baked after the preload finished
+
+  int m_idle_frames{0};
   //float m_ratio{0.0f};
 };
 
@@ -4,11 +4,13 @@
 #include <cinder/gl/Texture.h>
 #include <string>
 
+#include "text_renderer.h"
+
 namespace aura
 {
 
 void draw(ci::Rectf const& rect, ci::gl::Texture2dRef texture);
-void draw_line(ci::Rectf const& rect, std::string const& text, bool center = true);
-void draw_multiline(ci::Rectf const& rect, std::string const& text, bool center = true);
+void draw_line(text_renderer& renderer, ci::Rectf const& rect, std::string const& text, bool center = true);
+void draw_multiline(text_renderer& renderer, ci::Rectf const& rect, std::string const& text, bool center = true);
 
 } // namespace aura
@@ -53,9 +53,20 @@ struct display_constants
   float mouse_x{};
   float mouse_y{};
 
+  //! Frame rate while anything on screen changes
+  float active_frame_rate = 60.0f;
+
+  //! Frame rate once nothing has changed for 'frames_before_idle' frames;
+  //! also how long the first frame after input can take to show
+  float idle_frame_rate = 15.0f;
+  int frames_before_idle = 30;
+
   //! Intended for debugging only
   bool always_display_terrain_tiles = false;
 
+  //! Draw calls and fps of the last frame in the top left corner; F3 toggles
+  bool show_frame_stats = false;
+
   ci::ColorAf hand_card_color{0.1, 0.1, 0.1, 1.0};
   ci::ColorAf hand_hovered_color{0.15f, 0.15f, 0.15f, 0.4f};
   ci::ColorAf hand_selected_color{0.1, 0.4, 0.1, 1.0};
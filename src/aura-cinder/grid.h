@@ -238,8 +238,8 @@ struct frame
       auto const cur_y = aligned_y(el.y, min_padding_y) + pad_y;
       cur_x += pad_x;
 
-      auto [x1, x2] = std::minmax(cur_x, cur_x + el.x);
-      auto [y1, y2] = std::minmax(cur_y, cur_y + el.y);
+      auto [x1, x2] = std::minmax({cur_x, cur_x + el.x});
+      auto [y1, y2] = std::minmax({cur_y, cur_y + el.y});
 
       ci::Rectf r{x1, y1, x2, y2};
       el.eval(r);
@@ -277,8 +277,8 @@ struct frame
         cur_y += top_sign * (el.y + pad_y);
       }
 
-      auto [x1, x2] = std::minmax(cur_x, cur_x + el.x);
-      auto [y1, y2] = std::minmax(cur_y, cur_y + el.y);
+      auto [x1, x2] = std::minmax({cur_x, cur_x + el.x});
+      auto [y1, y2] = std::minmax({cur_y, cur_y + el.y});
 
       ci::Rectf r{x1, y1, x2, y2};
       el.eval(r);
@@ -0,0 +1,83 @@
+#include "hit_test.h"
+#include <aura-core/session_digest.h>
+#include <algorithm>
+#include <cmath>
+
+namespace aura
+{
+
+namespace
+{
+
+//! About half a board tile, so a target spans a handful of cells
+constexpr float cell_size = 64.0f;
+
+} // namespace {}
+
+void hit_test_grid::reset(ci::Rectf const& bounds)
+{
+  m_bounds = bounds;
+  m_cols = std::max(1, static_cast<int>(std::ceil(bounds.getWidth() / cell_size)));
+  m_rows = std::max(1, static_cast<int>(std::ceil(bounds.getHeight() / cell_size)));
+  m_targets.clear();
+  // cells keep their capacity, so a rebuilt frame allocates nothing
+  m_cells.resize(static_cast<size_t>(m_cols) * m_rows);
+  for (auto& c : m_cells)
+  {
+    c.clear();
+  }
+}
+
+void hit_test_grid::add(hit_target const& t)
+{
+  auto const r = t.rect.getClipBy(m_bounds);
+  if (r.getWidth() < 0.0f || r.getHeight() < 0.0f || !m_cols)
+  {
+    return;
+  }
+
+  auto const index = static_cast<std::uint32_t>(m_targets.size());
+  m_targets.push_back(t);
+  auto const cell = [&](float v, float origin, int n)
+  {
+    return std::clamp(static_cast<int>((v - origin) / cell_size), 0, n - 1);
+  };
+  auto const x1 = cell(r.x1, m_bounds.x1, m_cols);
+  auto const x2 = cell(r.x2, m_bounds.x1, m_cols);
+  auto const y1 = cell(r.y1, m_bounds.y1, m_rows);
+  auto const y2 = cell(r.y2, m_bounds.y1, m_rows);
+  for (int y = y1; y <= y2; ++y)
+  {
+    for (int x = x1; x <= x2; ++x)
+    {
+      m_cells[static_cast<size_t>(y) * m_cols + x].push_back(index);
+    }
+  }
+}
+
+std::uint64_t hit_test_grid::key_at(ci::vec2 const& p) const
+{
+  std::uint64_t h = 0;
+  for_each_at(p, [&](hit_target const& t)
+  {
+    h = chain_hash(h, static_cast<std::uint64_t>(t.zone));
+    h = chain_hash(h, static_cast<std::uint64_t>(t.lane));
+    h = chain_hash(h, static_cast<std::uint64_t>(t.slot));
+    h = chain_hash(h, static_cast<std::uint64_t>(t.uid));
+    h = chain_hash(h, static_cast<std::uint64_t>(t.player));
+  });
+  return h;
+}
+
+int hit_test_grid::cell_of(ci::vec2 const& p) const noexcept
+{
+  if (!m_cols || !m_bounds.contains(p))
+  {
+    return -1;
+  }
+  auto const x = std::min(static_cast<int>((p.x - m_bounds.x1) / cell_size), m_cols - 1);
+  auto const y = std::min(static_cast<int>((p.y - m_bounds.y1) / cell_size), m_rows - 1);
+  return y * m_cols + x;
+}
+
+} // namespace aura
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cinder/Rect.h>
+#include <cstdint>
+#include <vector>
+
+namespace aura
+{
+
+enum class hit_zone : int
+{
+  hand_card,
+  tile,
+  player,
+  end_turn,
+  pick_card,
+  card_preview  //!< where the hovered card is shown, unless the mouse is there
+};
+
+//! Something on screen the mouse can be over
+struct hit_target
+{
+  hit_zone zone;
+  int lane{-1};
+  int slot{-1};  //!< position in the hand, lane or picks
+  int uid{-1};   //!< of the card or player, if there is one
+  int player{-1};  //!< uid of the player whose side it is on
+  ci::Rectf rect;
+};
+
+//! Uniform grid over the layout rects of a frame, so finding what is under
+//! the mouse looks at one cell instead of every rect. Rebuilt with the
+//! board; render thread only.
+class hit_test_grid
+{
+public:
+  //! Forgets all targets and covers 'bounds' with cells
+  void reset(ci::Rectf const& bounds);
+
+  void add(hit_target const& t);
+
+  //! Calls 'fn' with each target containing 'p', in the order they were added
+  template <typename Fn>
+  void for_each_at(ci::vec2 const& p, Fn const& fn) const
+  {
+    auto const c = cell_of(p);
+    if (c < 0)
+    {
+      return;
+    }
+    for (auto const i : m_cells[c])
+    {
+      if (m_targets[i].rect.contains(p))
+      {
+        fn(m_targets[i]);
+      }
+    }
+  }
+
+  //! Digest of the targets containing 'p'; equal at two points when the
+  //! mouse is over the same things at both
+  std::uint64_t key_at(ci::vec2 const& p) const;
+
+private:
+  int cell_of(ci::vec2 const& p) const noexcept;
+
+  ci::Rectf m_bounds;
+  int m_cols{0};
+  int m_rows{0};
+  std::vector<hit_target> m_targets;
+  std::vector<std::vector<std::uint32_t>> m_cells;  //!< indices into m_targets
+};
+
+} // namespace aura
@@ -0,0 +1,114 @@
+#include "sprite_batch.h"
+#include <aura-core/build.h>
+#include <cinder/gl/gl.h>
+#include <algorithm>
+
+namespace aura
+{
+
+namespace
+{
+
+//! Room for a few hundred quads; a frame of the board draws fewer
+constexpr size_t initial_vbo_bytes = 64 * 1024;
+
+} // namespace {}
+
+void sprite_batch::draw(sprite const& s, ci::Rectf const& rect)
+{
+  if (!s)
+  {
+    return;
+  }
+  if (s.texture != m_texture)
+  {
+    flush();
+    m_texture = s.texture;
+  }
+
+  // corners go to window coordinates now, so quads under different
+  // transforms can share a draw call
+  auto const model = ci::gl::getModelMatrix();
+  auto const color = ci::ColorA8u{ci::gl::context()->getCurrentColor()};
+  auto const corner = [&](float x, float y, float u, float v)
+  {
+    auto const p = model * ci::vec4{x, y, 0.0f, 1.0f};
+    return vertex{{p.x, p.y}, {u, v}, color};
+  };
+  auto const top_left = corner(rect.x1, rect.y1, s.uv.x1, s.uv.y1);
+  auto const top_right = corner(rect.x2, rect.y1, s.uv.x2, s.uv.y1);
+  auto const bottom_right = corner(rect.x2, rect.y2, s.uv.x2, s.uv.y2);
+  auto const bottom_left = corner(rect.x1, rect.y2, s.uv.x1, s.uv.y2);
+  m_vertices.insert(m_vertices.end(), {top_left, top_right, bottom_right, top_left, bottom_right, bottom_left});
+  ++m_frame.sprites;
+}
+
+void sprite_batch::before_draw()
+{
+  flush();
+  ++m_frame.draw_calls;
+}
+
+void sprite_batch::end_frame()
+{
+  flush();
+  m_last_frame = m_frame;
+  m_frame = {};
+}
+
+void sprite_batch::flush()
+{
+  if (m_vertices.empty())
+  {
+    return;
+  }
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  if (!m_vao)
+  {
+    create_buffers();
+  }
+
+  ci::gl::ScopedVao vao{m_vao};
+  ci::gl::ScopedBuffer vbo{m_vbo};
+  auto const bytes = m_vertices.size() * sizeof(vertex);
+  if (bytes > m_vbo_bytes)
+  {
+    m_vbo_bytes = std::max(bytes, 2 * m_vbo_bytes);
+  }
+  // orphan the old storage so the driver doesn't wait on the previous batch
+  m_vbo->bufferData(m_vbo_bytes, nullptr, GL_STREAM_DRAW);
+  m_vbo->bufferSubData(0, bytes, m_vertices.data());
+
+  ci::gl::ScopedGlslProg shader{m_shader};
+  ci::gl::ScopedTextureBind texture{m_texture};
+  ci::gl::ScopedModelMatrix model{};
+  ci::gl::setModelMatrix(ci::mat4{1.0f});
+  ci::gl::setDefaultShaderVars();
+  ci::gl::drawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_vertices.size()));
+
+  ++m_frame.draw_calls;
+  ++m_frame.batches;
+  m_vertices.clear();
+}
+
+void sprite_batch::create_buffers()
+{
+  m_shader = ci::gl::getStockShader(ci::gl::ShaderDef().texture().color());
+  m_vbo_bytes = initial_vbo_bytes;
+  m_vbo = ci::gl::Vbo::create(GL_ARRAY_BUFFER, m_vbo_bytes, nullptr, GL_STREAM_DRAW);
+  m_vao = ci::gl::Vao::create();
+
+  ci::gl::ScopedVao vao{m_vao};
+  ci::gl::ScopedBuffer vbo{m_vbo};
+  auto const attribute = [&](ci::geom::Attrib semantic, GLint size, GLenum type, GLboolean normalized, size_t offset)
+  {
+    auto const location = m_shader->getAttribSemanticLocation(semantic);
+    ci::gl::enableVertexAttribArray(location);
+    ci::gl::vertexAttribPointer(location, size, type, normalized, sizeof(vertex), reinterpret_cast<void const*>(offset));
+  };
+  attribute(ci::geom::Attrib::POSITION, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, position));
+  attribute(ci::geom::Attrib::TEX_COORD_0, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, uv));
+  attribute(ci::geom::Attrib::COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(vertex, color));
+}
+
+} // namespace aura
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cinder/Color.h>
+#include <cinder/Rect.h>
+#include <cinder/gl/GlslProg.h>
+#include <cinder/gl/Texture.h>
+#include <cinder/gl/Vao.h>
+#include <cinder/gl/Vbo.h>
+#include <cstddef>
+#include <vector>
+
+namespace aura
+{
+
+//! An image to draw: a whole texture, or the part of an atlas page that
+//! 'uv' covers, in texture coordinates with the image's top row at uv.y1
+struct sprite
+{
+  ci::gl::Texture2dRef texture;
+  ci::Rectf uv{0.0f, 0.0f, 1.0f, 1.0f};
+
+  explicit operator bool() const noexcept
+  {
+    return static_cast<bool>(texture);
+  }
+};
+
+//! Collects textured quads into one vertex buffer and draws each run of
+//! quads sharing a texture with a single draw call. A quad takes the model
+//! matrix and color current when it is queued, so callers keep using
+//! ScopedModelMatrix and ScopedColor as they would around ci::gl::draw.
+//! Anything drawn some other way must call before_draw() first to stay on
+//! top of the sprites queued ahead of it. Render thread only.
+class sprite_batch
+{
+public:
+  struct frame_stats
+  {
+    int draw_calls{0};  //!< everything, sprite batches included
+    int batches{0};
+    int sprites{0};
+  };
+
+  //! Queues 's' stretched over 'rect'; a null sprite draws nothing
+  void draw(sprite const& s, ci::Rectf const& rect);
+
+  //! Draws the queued sprites ahead of a draw that doesn't go through the
+  //! batch, and counts that draw
+  void before_draw();
+
+  //! Draws the queued sprites now, e.g. before leaving a framebuffer
+  void flush();
+
+  //! Draws what is still queued and starts counting the next frame
+  void end_frame();
+
+  //! The counts of the last finished frame
+  frame_stats const& last_frame() const noexcept
+  {
+    return m_last_frame;
+  }
+
+private:
+  struct vertex
+  {
+    ci::vec2 position;  //!< in window coordinates
+    ci::vec2 uv;
+    ci::ColorA8u color;
+  };
+
+  void create_buffers();
+
+  std::vector<vertex> m_vertices;
+  ci::gl::Texture2dRef m_texture;  //!< of everything in m_vertices
+  ci::gl::GlslProgRef m_shader;
+  ci::gl::VboRef m_vbo;
+  ci::gl::VaoRef m_vao;
+  size_t m_vbo_bytes{0};
+  frame_stats m_frame;
+  frame_stats m_last_frame;
+};
+
+} // namespace aura
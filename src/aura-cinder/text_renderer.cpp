@@ -0,0 +1,97 @@
+#include "text_renderer.h"
+#include <aura-core/build.h>
+#include <aura-core/session_digest.h>
+#include <cinder/gl/gl.h>
+#include <algorithm>
+#include <cmath>
+
+namespace aura
+{
+
+namespace
+{
+
+// sizes are rounded to whole points so the number of atlases stays small
+constexpr int min_point_size = 6;
+constexpr int max_point_size = 96;
+
+//! How long a layout is kept after it was last drawn, ~10s at 60 fps
+constexpr std::uint64_t layout_lifetime = 600;
+
+std::uint64_t layout_key(std::string const& text, int point_size, float width, bool center) noexcept
+{
+  // FNV-1a; hovered descriptions are the longest strings and run to a few hundred bytes
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  for (auto const c : text)
+  {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+  }
+  h = chain_hash(h, static_cast<std::uint64_t>(point_size));
+  h = chain_hash(h, static_cast<std::uint64_t>(std::lround(width)));
+  return chain_hash(h, center ? 1 : 0);
+}
+
+} // namespace {}
+
+text_renderer::text_renderer(sprite_batch& sprites, std::string face)
+  : m_sprites{sprites}
+  , m_face{std::move(face)}
+{
+}
+
+void text_renderer::draw(std::string const& text, ci::Rectf const& rect, ci::ColorAf const& color, float point_size,
+  bool center)
+{
+  if (text.empty())
+  {
+    return;
+  }
+
+  auto const size = std::clamp(static_cast<int>(std::lround(point_size)), min_point_size, max_point_size);
+  auto& a = get_atlas(size);
+
+  auto const key = layout_key(text, size, rect.getWidth(), center);
+  auto it = m_layouts.find(key);
+  if (it == m_layouts.end() || it->second.text != text)
+  {
+    // layout only: TextBox places the glyphs, nothing is rasterized
+    ci::TextBox box;
+    box.font(a.font);
+    box.text(text);
+    box.size(static_cast<int>(rect.getWidth()), ci::TextBox::GROW);
+    box.alignment(center ? ci::TextBox::Alignment::CENTER : ci::TextBox::Alignment::LEFT);
+    it = m_layouts.insert_or_assign(key, layout{text, box.measureGlyphs(), 0}).first;
+  }
+  it->second.last_drawn = m_frame;
+
+  m_sprites.before_draw();
+  ci::gl::ScopedColor col{color};
+  a.glyphs->drawGlyphs(it->second.glyphs, rect.getUpperLeft());
+}
+
+void text_renderer::end_frame()
+{
+  if (++m_frame % 60)
+  {
+    return;
+  }
+  for (auto it = m_layouts.begin(); it != m_layouts.end();)
+  {
+    it = m_frame - it->second.last_drawn > layout_lifetime ? m_layouts.erase(it) : std::next(it);
+  }
+}
+
+text_renderer::atlas& text_renderer::get_atlas(int point_size)
+{
+  if (auto const it = m_atlases.find(point_size); it != m_atlases.end())
+  {
+    return it->second;
+  }
+
+  AURA_LOG(L"Rasterizing %hs at %dpt into a glyph atlas", m_face.c_str(), point_size);
+  ci::Font font{m_face, static_cast<float>(point_size)};
+  auto glyphs = ci::gl::TextureFont::create(font);
+  return m_atlases.emplace(point_size, atlas{std::move(font), std::move(glyphs)}).first->second;
+}
+
+} // namespace aura
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "sprite_batch.h"
+#include <cinder/Color.h>
+#include <cinder/Font.h>
+#include <cinder/Rect.h>
+#include <cinder/Text.h>
+#include <cinder/gl/TextureFont.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace aura
+{
+
+//! Draws text from glyph atlases. Each point size of the face is rasterized
+//! once into an atlas texture, and each distinct string is laid out once;
+//! after that drawing it is a cache lookup and one batch of textured quads.
+//! Text is drawn in order with the sprites queued before it. Render thread
+//! only.
+class text_renderer
+{
+public:
+  explicit text_renderer(sprite_batch& sprites, std::string face = "Cambria");
+
+  //! Draws 'text' from the top of 'rect', wrapped to its width and broken at '\n'
+  void draw(std::string const& text, ci::Rectf const& rect, ci::ColorAf const& color, float point_size, bool center);
+
+  //! Forgets layouts that haven't been drawn for a while; call once a frame
+  void end_frame();
+
+private:
+  //! Glyph indices and their positions, as TextureFont::drawGlyphs takes them
+  using glyph_list = decltype(std::declval<ci::TextBox const&>().measureGlyphs());
+
+  struct atlas
+  {
+    ci::Font font;
+    ci::gl::TextureFontRef glyphs;
+  };
+
+  struct layout
+  {
+    std::string text;  //!< tells hash collisions apart
+    glyph_list glyphs;
+    std::uint64_t last_drawn{0};
+  };
+
+  atlas& get_atlas(int point_size);
+
+  sprite_batch& m_sprites;
+  std::string m_face;
+  std::unordered_map<int, atlas> m_atlases;         //!< by point size
+  std::unordered_map<std::uint64_t, layout> m_layouts;  //!< by text, size, width and alignment
+  std::uint64_t m_frame{0};
+};
+
+} // namespace aura
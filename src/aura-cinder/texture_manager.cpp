@@ -0,0 +1,323 @@
+#include "texture_manager.h"
+#include <aura-core/build.h>
+#include <aura-core/metrics.h>
+#include <aura-core/platform.h>
+#include <cinder/DataSource.h>
+#include <cinder/ImageIo.h>
+#include <cinder/gl/gl.h>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <optional>
+
+namespace aura
+{
+
+namespace
+{
+
+metric_histogram const g_decode_us{"aura_texture_decode_us"};
+metric_histogram const g_upload_us{"aura_texture_upload_us"};
+
+// a 2048 page holds six full size card images or a few dozen tiles and icons
+constexpr int atlas_size = 2048;
+constexpr int max_packed_size = atlas_size / 2;
+
+//! Transparent pixels kept around each image so filtering at its edges
+//! never samples a neighbour
+constexpr int atlas_padding = 2;
+
+double to_ms(std::chrono::nanoseconds t)
+{
+  return std::chrono::duration<double, std::milli>(t).count();
+}
+
+std::uint64_t to_us(std::chrono::nanoseconds t)
+{
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(t).count());
+}
+
+} // namespace {}
+
+texture_manager::~texture_manager()
+{
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto& w : m_workers)
+  {
+    w.join();
+  }
+}
+
+void texture_manager::start(std::filesystem::path asset_dir, int num_workers)
+{
+  m_asset_dir = std::move(asset_dir);
+  for (int i = 0; i < std::max(1, num_workers); ++i)
+  {
+    m_workers.emplace_back([this]
+    {
+      trace_set_thread_name("texture decode");
+      decode_loop();
+    });
+  }
+}
+
+void texture_manager::preload(std::vector<std::wstring> const& names)
+{
+  m_preload_start = std::chrono::steady_clock::now();
+  for (auto const& name : names)
+  {
+    request(name, true);
+  }
+  AURA_LOG(L"Preloading %zu textures on %zu threads", m_preloads_left, m_workers.size());
+}
+
+sprite texture_manager::get(std::wstring const& name)
+{
+  auto const it = m_entries.find(name);
+  if (it == m_entries.end())
+  {
+    request(name, false);
+    return placeholder();
+  }
+
+  switch (it->second.status)
+  {
+  case state::ready:   return it->second.image;
+  case state::missing: return {};
+  default:             return placeholder();
+  }
+}
+
+bool texture_manager::loaded(std::wstring const& name) const
+{
+  auto const it = m_entries.find(name);
+  return it != m_entries.end() && it->second.status != state::loading;
+}
+
+bool texture_manager::upload(std::chrono::microseconds budget)
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  {
+    std::lock_guard lock{m_mutex};
+    std::move(m_decoded.begin(), m_decoded.end(), std::back_inserter(m_uploads));
+    m_decoded.clear();
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+  auto const num_waiting = m_uploads.size();
+  while (!m_uploads.empty())
+  {
+    auto const d = std::move(m_uploads.front());
+    m_uploads.pop_front();
+
+    auto& e = m_entries[d.name];
+    auto const upload_start = std::chrono::steady_clock::now();
+    if (d.surface)
+    {
+      e.image = pack(*d.surface);
+    }
+    e.status = e.image ? state::ready : state::missing;
+    auto const now = std::chrono::steady_clock::now();
+
+    auto const upload_time = now - upload_start;
+    if (e.image)
+    {
+      g_decode_us.record(to_us(d.decode_time));
+      g_upload_us.record(to_us(upload_time));
+      AURA_LOG(L"Texture %ls: decoded in %.1fms, uploaded in %.1fms", d.name.c_str(), to_ms(d.decode_time),
+        to_ms(upload_time));
+    }
+    if (e.preloaded)
+    {
+      m_preload_decode_time += d.decode_time;
+      m_preload_upload_time += upload_time;
+    }
+    resolve(e);
+
+    if (now - start >= budget)
+    {
+      break;
+    }
+  }
+  return m_uploads.size() != num_waiting;
+}
+
+std::vector<std::wstring> texture_manager::make_manifest(std::filesystem::path const& asset_dir)
+{
+  std::vector<std::wstring> names;
+  std::error_code ec;
+  for (auto const& f : std::filesystem::directory_iterator{asset_dir, ec})
+  {
+    auto const name = f.path().filename().wstring();
+    auto const ext = f.path().extension().wstring();
+    auto const has_prefix = [&](wchar_t const* prefix) { return name.rfind(prefix, 0) == 0; };
+    if ((ext == L".png" || ext == L".jpg") && (has_prefix(L"card-") || has_prefix(L"tile-") || has_prefix(L"icon-")))
+    {
+      names.emplace_back(name);
+    }
+  }
+  if (ec)
+  {
+    AURA_ERROR(ec, L"Cannot list assets in %ls", asset_dir.wstring().c_str());
+  }
+  return names;
+}
+
+void texture_manager::request(std::wstring const& name, bool preloaded)
+{
+  auto const [it, inserted] = m_entries.try_emplace(name);
+  if (!inserted)
+  {
+    return;
+  }
+  it->second.preloaded = preloaded;
+  m_preloads_left += preloaded ? 1 : 0;
+  {
+    std::lock_guard lock{m_mutex};
+    m_requests.emplace_back(name);
+  }
+  m_wake.notify_one();
+}
+
+void texture_manager::resolve(entry& e)
+{
+  if (!e.preloaded || !m_preloads_left || --m_preloads_left)
+  {
+    return;
+  }
+  AURA_LOG(L"Preloaded textures in %.0fms: %.0fms decoding across the workers, %.0fms uploading into %zu atlas pages",
+    to_ms(std::chrono::steady_clock::now() - m_preload_start), to_ms(m_preload_decode_time),
+    to_ms(m_preload_upload_time), m_pages.size());
+}
+
+sprite texture_manager::pack(ci::Surface8u const& surface)
+{
+  auto const w = surface.getWidth();
+  auto const h = surface.getHeight();
+  if (w > max_packed_size || h > max_packed_size)
+  {
+    return sprite{ci::gl::Texture2d::create(surface)};
+  }
+
+  auto const cell_w = w + 2 * atlas_padding;
+  auto const cell_h = h + 2 * atlas_padding;
+  auto const place = [&](atlas_page& p) -> std::optional<ci::ivec2>
+  {
+    if (p.cursor_x + cell_w > atlas_size)
+    {
+      if (p.shelf_y + p.shelf_height + cell_h > atlas_size)
+      {
+        return std::nullopt;
+      }
+      p.shelf_y += p.shelf_height;
+      p.cursor_x = 0;
+      p.shelf_height = 0;
+    }
+    if (p.shelf_y + cell_h > atlas_size)
+    {
+      return std::nullopt;
+    }
+    ci::ivec2 const at{p.cursor_x + atlas_padding, p.shelf_y + atlas_padding};
+    p.cursor_x += cell_w;
+    p.shelf_height = std::max(p.shelf_height, cell_h);
+    return at;
+  };
+
+  atlas_page* page = nullptr;
+  std::optional<ci::ivec2> at;
+  for (auto& p : m_pages)
+  {
+    if ((at = place(p)))
+    {
+      page = &p;
+      break;
+    }
+  }
+  if (!page)
+  {
+    // cleared, so the padding between images is transparent
+    std::vector<std::uint8_t> const clear(size_t{atlas_size} * atlas_size * 4, 0);
+    auto const format = ci::gl::Texture2d::Format().internalFormat(GL_RGBA8);
+    page = &m_pages.emplace_back();
+    page->texture = ci::gl::Texture2d::create(clear.data(), GL_RGBA, atlas_size, atlas_size, format);
+    at = place(*page);
+    AURA_LOG(L"Started texture atlas page %zu", m_pages.size());
+  }
+
+  ci::gl::ScopedTextureBind bind{page->texture};
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(surface.getRowBytes() / surface.getPixelInc()));
+  glTexSubImage2D(GL_TEXTURE_2D, 0, at->x, at->y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, surface.getData());
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  // rows were uploaded top first, so the image's top row is at the lower v
+  auto const size = static_cast<float>(atlas_size);
+  return sprite{page->texture, ci::Rectf{at->x / size, at->y / size, (at->x + w) / size, (at->y + h) / size}};
+}
+
+void texture_manager::decode_loop()
+{
+  while (true)
+  {
+    std::wstring name;
+    {
+      std::unique_lock lock{m_mutex};
+      m_wake.wait(lock, [&] { return m_stop || !m_requests.empty(); });
+      if (m_stop)
+      {
+        return;
+      }
+      name = std::move(m_requests.front());
+      m_requests.pop_front();
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    ci::Surface8uRef surface;
+    auto const path = m_asset_dir / name;
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec))
+    {
+      // cinder reports undecodable images by throwing
+      try
+      {
+        auto const image = ci::Surface8u::create(ci::loadImage(ci::loadFile(path.wstring())));
+        // converted here rather than by the driver on the render thread; atlas
+        // pages take RGBA rows
+        surface = ci::Surface8u::create(image->getWidth(), image->getHeight(), true, ci::SurfaceChannelOrder::RGBA);
+        surface->copyFrom(*image, image->getBounds());
+      }
+      catch (std::exception const& e)
+      {
+        AURA_LOG(L"Cannot decode %ls: %hs", name.c_str(), e.what());
+      }
+    }
+    auto const decode_time = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard lock{m_mutex};
+    m_decoded.push_back(decoded{std::move(name), std::move(surface), decode_time});
+  }
+}
+
+sprite const& texture_manager::placeholder()
+{
+  if (!m_placeholder)
+  {
+    // a faint grey square where the image will appear
+    ci::Surface8u s{4, 4, true};
+    for (int y = 0; y < 4; ++y)
+    {
+      for (int x = 0; x < 4; ++x)
+      {
+        s.setPixel({x, y}, ci::ColorA8u{128, 128, 128, 64});
+      }
+    }
+    m_placeholder = sprite{ci::gl::Texture2d::create(s)};
+  }
+  return m_placeholder;
+}
+
+} // namespace aura
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "sprite_batch.h"
+#include <cinder/Surface.h>
+#include <cinder/gl/Texture.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace aura
+{
+
+//! Loads textures without stalling the render thread. Worker threads read
+//! and decode images; the render thread uploads a few of them each frame
+//! within a time budget. Until an asset is uploaded get() hands out a
+//! placeholder, so the first sight of a card or tile never costs a frame.
+//! Images up to half a page in size are packed into shared atlas pages so
+//! the sprite batch can draw most of the board from a few textures.
+class texture_manager
+{
+public:
+  texture_manager() = default;
+  ~texture_manager();
+
+  texture_manager(texture_manager const&) = delete;
+  texture_manager& operator=(texture_manager const&) = delete;
+
+  //! Starts decoding assets from 'asset_dir' on 'num_workers' threads
+  void start(std::filesystem::path asset_dir, int num_workers);
+
+  //! Queues 'names' ahead of anything requested later and reports once
+  //! they have all loaded. Render thread.
+  void preload(std::vector<std::wstring> const& names);
+
+  //! The image of asset 'name'. Queues the asset the first time it is
+  //! asked for and returns the placeholder until it is uploaded; null if
+  //! it doesn't exist or can't be decoded. Render thread.
+  sprite get(std::wstring const& name);
+
+  //! Whether asset 'name' is uploaded or known missing, so get() no longer
+  //! hands out the placeholder for it. Render thread.
+  bool loaded(std::wstring const& name) const;
+
+  //! Uploads decoded images for up to 'budget', at least one per call, and
+  //! tells whether any asset stopped loading. Call once a frame on the render
+  //! thread.
+  bool upload(std::chrono::microseconds budget);
+
+  //! Whether everything passed to preload() is uploaded or known missing
+  bool preloaded() const noexcept
+  {
+    return m_preloads_left == 0;
+  }
+
+  //! The card, tile and icon images in 'asset_dir'
+  static std::vector<std::wstring> make_manifest(std::filesystem::path const& asset_dir);
+
+private:
+  enum class state
+  {
+    loading,
+    ready,
+    missing
+  };
+
+  struct entry
+  {
+    state status{state::loading};
+    bool preloaded{false};
+    sprite image;
+  };
+
+  //! Images are placed left to right along shelves as tall as the tallest
+  //! image on them; a new shelf starts below when a row is full
+  struct atlas_page
+  {
+    ci::gl::Texture2dRef texture;
+    int cursor_x{0};
+    int shelf_y{0};
+    int shelf_height{0};
+  };
+
+  //! A worker's result, always RGBA; a null surface means the asset
+  //! couldn't be loaded
+  struct decoded
+  {
+    std::wstring name;
+    ci::Surface8uRef surface;
+    std::chrono::nanoseconds decode_time;
+  };
+
+  void request(std::wstring const& name, bool preloaded);
+
+  void resolve(entry& e);
+
+  //! Copies 'surface' into an atlas page, or into a texture of its own if
+  //! it is too big to share one
+  sprite pack(ci::Surface8u const& surface);
+
+  void decode_loop();
+
+  sprite const& placeholder();
+
+  // render thread only
+  std::unordered_map<std::wstring, entry> m_entries;
+  std::deque<decoded> m_uploads;
+  std::vector<atlas_page> m_pages;
+  sprite m_placeholder;
+  size_t m_preloads_left{0};
+  std::chrono::steady_clock::time_point m_preload_start;
+  std::chrono::nanoseconds m_preload_decode_time{0};
+  std::chrono::nanoseconds m_preload_upload_time{0};
+
+  // shared with the workers
+  std::filesystem::path m_asset_dir;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::deque<std::wstring> m_requests;
+  std::vector<decoded> m_decoded;
+  bool m_stop{false};
+
+  std::vector<std::thread> m_workers;
+};
+
+} // namespace aura
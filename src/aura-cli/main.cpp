@@ -1,13 +1,18 @@
 #include <aura-core/build.h>
+#include <aura-core/metrics.h>
 #include <aura-core/rules_engine.h>
 #include <aura-core/ruleset.h>
 #include <aura-client/aura_client.h>
+#include <aura-core/rest_messages.h>
 #include <system_error>
 #include <cstdio>
 
 #include "windows.h"
 
 #include "aura-core/local_rules_engine.h"
+#include "aura-core/lockstep_rules_engine.h"
+#include "aura-core/relay_link.h"
+#include "aura-core/remote_rules_engine.h"
 #include "aura-cli/cli_display_engine.h"
 
 void launch_local_pvp()
@@ -43,16 +48,60 @@ void launch_online_pvp()
   }
   rest_fn(nullptr, nullptr, &payload);
 #endif
-  auto a = aura::make_aura_client();
-  auto const [error, foo] = a.second.request("/ping", "apnfs");
-  if (error)
+  AURA_ENTER();
+
+  auto [client_error, client] = aura::make_aura_client();
+  if (client_error)
   {
-    AURA_ERROR(error, L"/ping -> %hs", foo.c_str());
+    return;
   }
-  else
+
+  aura::ruleset rs;
+  auto const session = aura::rest::new_session::make_request(client, {rs.mode, "Player", 0});
+  if (auto const e = session.error ? session.error : session.value.error)
   {
-    AURA_LOG(L"/ping -> %hs", foo.c_str());
+    AURA_ERROR(e, L"Couldn't join a session on the server");
+    return;
   }
+  AURA_LOG(L"Joined session %d as player %d against '%hs'", session.value.session_id, session.value.seat + 1,
+    session.value.matched_player_name.c_str());
+
+  aura::remote_rules_engine re{client, session.value.session_id, session.value.seat_token};
+  aura::cli_display_engine de;
+  auto const e = start_game_session(rs, re, de);
+}
+
+void launch_lockstep_pvp()
+{
+  AURA_ENTER();
+
+  auto [client_error, client] = aura::make_aura_client();
+  if (client_error)
+  {
+    return;
+  }
+
+  aura::ruleset rs;
+  rs.mode = aura::game_mode::lockstep;
+  auto const session = aura::rest::new_session::make_request(client, {rs.mode, "Player", 0});
+  if (auto const e = session.error ? session.error : session.value.error)
+  {
+    AURA_ERROR(e, L"Couldn't join a session on the server");
+    return;
+  }
+  AURA_LOG(L"Joined lockstep session %d as player %d against '%hs'", session.value.session_id,
+    session.value.seat + 1, session.value.matched_player_name.c_str());
+
+  // both ends play the game out themselves; the server only relays
+  aura::relay_link link{client, session.value.session_id, session.value.seat, session.value.seat_token};
+  auto const [link_error, seed] = link.connect();
+  if (link_error)
+  {
+    return;
+  }
+  aura::lockstep_rules_engine re{rs, seed, session.value.seat, link};
+  aura::cli_display_engine de;
+  auto const e = start_game_session(rs, re, de);
 }
 
 int wmain(int argc, wchar_t** argv)
@@ -74,6 +123,11 @@ int wmain(int argc, wchar_t** argv)
     launch_online_pvp();
   }
 
+  if (command == L"--lockstep")
+  {
+    launch_lockstep_pvp();
+  }
+
   if (command == L"--launch")
   {
     AURA_ASSERT(argc >= 3);
@@ -82,6 +136,10 @@ int wmain(int argc, wchar_t** argv)
     {
       AURA_LOG(L"Launching local PvP game");
       launch_local_pvp();
+      if (argc >= 4 && std::wstring_view{argv[3]} == L"--metrics")
+      {
+        AURA_PRINT(L"%hs", aura::format_metrics(aura::take_metrics_snapshot()).c_str());
+      }
       return 0;
     }
     else
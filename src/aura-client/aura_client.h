@@ -1,6 +1,7 @@
 #pragma once
 
 #include "aura-core/build.h"
+#include "aura-core/client_transport.h"
 #include "aura_client_native.h"
 #include <utility>
 #include <system_error>
@@ -17,15 +18,16 @@ inline auto to_aura_string8(std::string const& s) noexcept
   return aura_string8{(char*)s.data(), static_cast<int>(s.size())};
 }
 
-struct aura_client
+struct aura_client : public client_transport
 {
   friend std::pair<std::error_code, aura_client> make_aura_client();
 
   aura_client() = default;
 public:
-  constexpr static size_t max_payload_length = 1024;
+  constexpr static size_t max_payload_length = 1 << 16;
 
-  std::pair<std::error_code, std::string> request(std::string const& method, std::string const& parameters)
+  //! GET 'method' if 'parameters' is empty, otherwise POST them as the body
+  std::pair<std::error_code, std::string> request(std::string const& method, std::string const& parameters) override
   {
     AURA_ASSERT(m_client_id);
     std::string payload_s(max_payload_length, '\0');
@@ -37,9 +39,10 @@ public:
     http_result res{};
     if (m_call_fn(m_client_id, &meth, &param, &res, &payload))
     {
+      payload_s.resize(payload.size);
       return { {}, payload_s };
     }
-    return {{}, {}};
+    return {make_error_code(std::errc::connection_refused), {}};
   }
 
   void swap(aura_client& other)
@@ -37,24 +37,32 @@ __declspec(dllexport) bool __stdcall aura_call(
     return false;
   }
 
-  AURA_LOG(L"sending request method:'%hs' parameters:'%hs'", std::string{method->data}.c_str(),
-    std::string{parameters->data}.c_str());
-  auto const response = client_it->second.Get(method->data);
+  AURA_LOG(L"sending request method:'%hs' (%d bytes)", std::string{method->data}.c_str(), parameters->size);
+  auto const response = parameters->size > 0
+    ? client_it->second.Post(method->data, std::string{parameters->data, static_cast<size_t>(parameters->size)},
+        "application/octet-stream")
+    : client_it->second.Get(method->data);
   if (!response)
   {
-    AURA_LOG("request failed..");
+    AURA_LOG(L"request failed..");
     return false;
   }
 
   if (result_out)
   {
-    AURA_LOG("found status '%d'", response->status);
+    AURA_LOG(L"found status '%d'", response->status);
     result_out->status = response->status;
   }
   if (payload_out)
   {
-    AURA_LOG("got back payload '%hs'", response->body.c_str());
-    strcpy_s(payload_out->data, payload_out->size, response->body.c_str());
+    AURA_LOG(L"got back payload (%zu bytes)", response->body.size());
+    if (response->body.size() > static_cast<size_t>(payload_out->size))
+    {
+      AURA_LOG(L"payload does not fit in %d bytes", payload_out->size);
+      return false;
+    }
+    memcpy(payload_out->data, response->body.data(), response->body.size());
+    payload_out->size = static_cast<int>(response->body.size());
   }
   return true;
 }
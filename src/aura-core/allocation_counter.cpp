@@ -0,0 +1,115 @@
+#include "allocation_counter.h"
+#include "build.h"
+#include <cstdlib>
+#include <new>
+
+namespace aura
+{
+
+namespace
+{
+
+// trivially constructible, so the hooks can use it on any thread at any time
+thread_local allocation_counts t_allocations;
+
+} // namespace {}
+
+allocation_counts thread_allocations() noexcept
+{
+  return t_allocations;
+}
+
+void check_allocation_budget(allocation_counts const& counts, std::uint64_t max_allocations, char const* what) noexcept
+{
+  if (counts.allocations > max_allocations)
+  {
+    AURA_LOG_AT(log_level::error, 195, L"%hs allocated %llu times (%llu bytes), over its budget of %llu", what,
+      counts.allocations, counts.bytes, max_allocations);
+    AURA_ASSERT(counts.allocations <= max_allocations);
+  }
+}
+
+} // namespace aura
+
+#ifdef AURA_COUNT_ALLOCATIONS
+
+namespace
+{
+
+void* allocate(std::size_t size) noexcept
+{
+  aura::t_allocations.allocations++;
+  aura::t_allocations.bytes += size;
+  return std::malloc(size ? size : 1);
+}
+
+void* allocate(std::size_t size, std::align_val_t alignment) noexcept
+{
+  aura::t_allocations.allocations++;
+  aura::t_allocations.bytes += size;
+  auto const align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+  return ::_aligned_malloc(size ? size : 1, align);
+#else
+  // aligned_alloc wants a multiple of the alignment
+  return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+}
+
+void* allocate_or_throw(std::size_t size)
+{
+  if (auto* p = allocate(size))
+  {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void* allocate_or_throw(std::size_t size, std::align_val_t alignment)
+{
+  if (auto* p = allocate(size, alignment))
+  {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void release(void* p) noexcept
+{
+  std::free(p);
+}
+
+void release_aligned(void* p) noexcept
+{
+#ifdef _WIN32
+  ::_aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+} // namespace {}
+
+void* operator new(std::size_t size) { return allocate_or_throw(size); }
+void* operator new[](std::size_t size) { return allocate_or_throw(size); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t a) { return allocate_or_throw(size, a); }
+void* operator new[](std::size_t size, std::align_val_t a) { return allocate_or_throw(size, a); }
+void* operator new(std::size_t size, std::align_val_t a, std::nothrow_t const&) noexcept { return allocate(size, a); }
+void* operator new[](std::size_t size, std::align_val_t a, std::nothrow_t const&) noexcept { return allocate(size, a); }
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { release(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete(void* p, std::align_val_t, std::nothrow_t const&) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::align_val_t, std::nothrow_t const&) noexcept { release_aligned(p); }
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocation counting for test builds. Configured with
+// AURA_COUNT_ALLOCATIONS=ON, aura_core replaces the global operator new and
+// delete with versions that count what each thread allocates. In other
+// builds nothing is counted and every count reads zero.
+
+namespace aura
+{
+
+#ifdef AURA_COUNT_ALLOCATIONS
+constexpr bool counting_allocations = true;
+#else
+constexpr bool counting_allocations = false;
+#endif
+
+struct allocation_counts
+{
+  std::uint64_t allocations{0};
+  std::uint64_t bytes{0};
+};
+
+//! Everything the calling thread has allocated so far
+allocation_counts thread_allocations() noexcept;
+
+//! What the calling thread allocates from construction on
+class allocation_scope
+{
+public:
+  allocation_scope() noexcept
+    : m_start{thread_allocations()}
+  {
+  }
+
+  allocation_counts counts() const noexcept
+  {
+    auto const now = thread_allocations();
+    return {now.allocations - m_start.allocations, now.bytes - m_start.bytes};
+  }
+
+private:
+  allocation_counts m_start;
+};
+
+//! Complains when 'counts' goes over 'max_allocations': logs an error and,
+//! in debug builds, asserts. For tests, benchmarks and paths that promise
+//! not to allocate.
+void check_allocation_budget(allocation_counts const& counts, std::uint64_t max_allocations, char const* what) noexcept;
+
+//! Holds the rest of the enclosing scope to at most 'max_allocations'
+class allocation_budget
+{
+public:
+  allocation_budget(std::uint64_t max_allocations, char const* what) noexcept
+    : m_max{max_allocations}
+    , m_what{what}
+  {
+  }
+
+  ~allocation_budget()
+  {
+    if constexpr (counting_allocations)
+    {
+      check_allocation_budget(m_scope.counts(), m_max, m_what);
+    }
+  }
+
+  allocation_budget(allocation_budget const&) = delete;
+  allocation_budget& operator=(allocation_budget const&) = delete;
+
+private:
+  allocation_scope const m_scope;
+  std::uint64_t const m_max;
+  char const* const m_what;
+};
+
+} // namespace aura
@@ -1,26 +1,27 @@
 #pragma once
 
+#include <aura-core/log.h>
+#include <aura-core/trace.h>
 #include <string_view>
 #include <cassert>
 
-struct scope_log_t
-{
-  ~scope_log_t()
-  {
-    wprintf(L"%lc %.*hs(..) \n", 192, static_cast<int>(func.size()), func.data());
-  }
+// Log statements go through the asynchronous logger in log.h: the calling
+// thread only copies the arguments, formatting and output happen on the
+// logger's thread. AURA_PRINT is console output and stays synchronous.
+// AURA_ENTER also opens a trace span (see trace.h) when tracing is on.
 
-  std::string_view func;
-};
+#define AURA_STRINGIZE_(x) #x
+#define AURA_STRINGIZE(x) AURA_STRINGIZE_(x)
 
 #ifndef AURA_ENTER
 # define AURA_ENTER() \
-  wprintf(L"%lc %hs(..) \n", 218, __FUNCTION__); \
-  auto const scopelog ## __LINE__ = scope_log_t{__FUNCTION__}
+  AURA_LOG_AT(::aura::log_level::trace, 218, L"%hs(..) ", __FUNCTION__); \
+  auto const aura_scope_log_ = ::aura::scope_log<::aura::log_enabled(::aura::log_level::trace)>{__FUNCTION__}; \
+  AURA_TRACE_SCOPE(__FUNCTION__)
 #endif
 
 #ifndef AURA_LOG
-#	define AURA_LOG(format, ...) wprintf(L"%lc " format L"\n", 195, ##__VA_ARGS__)
+#	define AURA_LOG(format, ...) AURA_LOG_AT(::aura::log_level::info, 195, format, ##__VA_ARGS__)
 #endif
 
 #ifndef AURA_PRINT
@@ -28,9 +29,10 @@ struct scope_log_t
 #endif
 
 #ifndef AURA_ERROR
-# define AURA_ERROR(error, format, ...) wprintf(L"%lc e (%d, %hs) | %hs | " format L"\n", 195, error.value(), error.category().name(), error.message().c_str(), ##__VA_ARGS__)
+# define AURA_ERROR(ec, format, ...) AURA_LOG_AT(::aura::log_level::error, 195, L"e (%d, %hs) | %hs | " format, \
+  (ec).value(), (ec).category().name(), std::error_code{ec}, ##__VA_ARGS__)
 #endif
 
 #ifndef AURA_ASSERT
-#	define AURA_ASSERT(cond) if (!(cond)) { wprintf(L"%lc%lc " #cond L"\n", 192, 254); assert((cond)); }
+#	define AURA_ASSERT(cond) if (!(cond)) { AURA_LOG_AT(::aura::log_level::error, 192, L"%lc " #cond, 254); ::aura::log_flush(); assert((cond)); }
 #endif
@@ -4,11 +4,10 @@
 #include <aura-core/rules_engine.h>
 #include <aura-core/build.h>
 #include <aura-core/terrain_types.h>
+#include <aura-core/random.h>
 #include <vector>
 #include <system_error>
 #include <algorithm>
-#include <cstdlib>
-#include <ctime>
 #include <unordered_map>
 
 namespace aura
@@ -43,6 +42,28 @@ struct card_preset
   int cid = generate_cid();
 };
 
+//! Creates an in-game card from a preset. Card actions are not registered.
+inline card_info make_card_info(card_preset const& preset, int uid, int cid)
+{
+  card_info info{};
+  info.uid = uid;
+  info.cid = cid;
+  info.health = preset.health;
+  info.starting_health = preset.health;
+  info.starting_strength = preset.strength;
+  info.strength = preset.strength;
+  info.cost = preset.cost;
+  info.name = preset.name;
+  info.traits = preset.traits;
+  info.preferred_terrain = preset.preferred_terrain;
+  info.energy = preset.energy;
+  info.starting_energy = preset.energy;
+  info.description = preset.special_descr;
+  info.action_type = preset.action_type;
+  info.action_targets = preset.action_targets;
+  return info;
+}
+
 struct deck
 {
   std::vector<card_preset> all_cards;
@@ -90,7 +111,7 @@ struct deck
     }
   }
 
-  card_preset draw(int turn, int max_level)
+  card_preset draw(int turn, int max_level, random_engine& rng)
   {
     auto fixed_it = fixed_picks.find(turn);
     if (fixed_it != fixed_picks.end())
@@ -100,12 +121,6 @@ struct deck
       return answer;
     }
 
-    static auto ss = std::invoke([]
-    {
-      srand(time(0));
-      return 0;
-    });
-
     if (remaining_cards.empty())
     {
       reset();
@@ -118,7 +133,7 @@ struct deck
     AURA_ASSERT(!pool.empty());
 
     auto const n = pool.size();
-    auto const i = (rand() % n);
+    auto const i = rng.below(n);
     auto const preset = pool.at(i);
     remove_one(preset.cid);
     return preset;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace aura
+{
+
+//! Request/response channel from a client to the game server.
+//! Implemented by aura_client (http) so that remote_rules_engine does not
+//! depend on how bytes reach the server.
+class client_transport
+{
+public:
+  //! Sends 'body' to the endpoint at 'path' and returns the response body
+  virtual std::pair<std::error_code, std::string> request(std::string const& path, std::string const& body) = 0;
+
+  virtual ~client_transport() = default;
+};
+
+} // namespace aura
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+namespace aura
+{
+
+//! Log-linear (HDR-style) histogram of non-negative integer values.
+//!
+//! Values below 32 get a bucket each; above that every power of two is split
+//! into 16 linear sub-buckets, so any recorded value is reported to within
+//! ~6% over the full 64-bit range using a fixed 976-entry table.
+//! Recording is a handful of integer operations and never allocates.
+class histogram
+{
+public:
+  static constexpr int linear_buckets = 32;
+  static constexpr int sub_buckets = 16;
+  static constexpr int num_buckets = linear_buckets + (64 - 5) * sub_buckets;
+
+  void record(std::uint64_t value, std::uint64_t n = 1) noexcept
+  {
+    m_counts[bucket_index(value)] += n;
+    m_total += n;
+    m_sum += value * n;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  void merge(histogram const& other) noexcept
+  {
+    for (int i = 0; i < num_buckets; ++i)
+    {
+      m_counts[i] += other.m_counts[i];
+    }
+    m_total += other.m_total;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  //! Adds values known only by bucket, e.g. counts gathered elsewhere.
+  //! 'sum', 'min' and 'max' describe the values being added.
+  void record_buckets(std::uint64_t const* counts, std::uint64_t sum, std::uint64_t min, std::uint64_t max) noexcept
+  {
+    for (int i = 0; i < num_buckets; ++i)
+    {
+      m_counts[i] += counts[i];
+      m_total += counts[i];
+    }
+    m_sum += sum;
+    m_min = std::min(m_min, min);
+    m_max = std::max(m_max, max);
+  }
+
+  void reset() noexcept { *this = histogram{}; }
+
+  std::uint64_t count() const noexcept { return m_total; }
+
+  std::uint64_t min() const noexcept { return m_total ? m_min : 0; }
+
+  std::uint64_t max() const noexcept { return m_max; }
+
+  std::uint64_t sum() const noexcept { return m_sum; }
+
+  double mean() const noexcept { return m_total ? static_cast<double>(m_sum) / m_total : 0.0; }
+
+  //! Smallest value such that 'percentile' % of recorded values are <= it.
+  //! Reported as the upper bound of the bucket, clamped to the maximum.
+  std::uint64_t value_at_percentile(double percentile) const noexcept
+  {
+    if (!m_total)
+    {
+      return 0;
+    }
+    auto const wanted = std::max<std::uint64_t>(1,
+      static_cast<std::uint64_t>(static_cast<double>(m_total) * std::clamp(percentile, 0.0, 100.0) / 100.0 + 0.5));
+
+    std::uint64_t seen = 0;
+    for (int i = 0; i < num_buckets; ++i)
+    {
+      seen += m_counts[i];
+      if (seen >= wanted)
+      {
+        return std::min(bucket_upper_bound(i), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  //! Count recorded in bucket 'i'
+  std::uint64_t bucket_count(int i) const noexcept { return m_counts[i]; }
+
+  static int bucket_index(std::uint64_t value) noexcept
+  {
+    if (value < linear_buckets)
+    {
+      return static_cast<int>(value);
+    }
+    auto const msb = most_significant_bit(value);  // >= 5
+    auto const shift = msb - 4;                       // keep the top 5 bits
+    auto const mantissa = static_cast<int>(value >> shift) - sub_buckets;
+    return linear_buckets + (shift - 1) * sub_buckets + mantissa;
+  }
+
+  static std::uint64_t bucket_upper_bound(int index) noexcept
+  {
+    if (index < linear_buckets)
+    {
+      return static_cast<std::uint64_t>(index);
+    }
+    auto const shift = (index - linear_buckets) / sub_buckets + 1;
+    auto const mantissa = static_cast<std::uint64_t>((index - linear_buckets) % sub_buckets + sub_buckets);
+    if (shift >= 59 && mantissa == 2 * sub_buckets - 1)
+    {
+      return std::numeric_limits<std::uint64_t>::max();
+    }
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+private:
+  static int most_significant_bit(std::uint64_t v) noexcept
+  {
+    int n = 0;
+    for (int step = 32; step; step >>= 1)
+    {
+      if (v >> step)
+      {
+        v >>= step;
+        n += step;
+      }
+    }
+    return n;
+  }
+
+  std::array<std::uint64_t, num_buckets> m_counts{};
+  std::uint64_t m_total{0};
+  std::uint64_t m_sum{0};
+  std::uint64_t m_min{std::numeric_limits<std::uint64_t>::max()};
+  std::uint64_t m_max{0};
+};
+
+} // namespace aura
@@ -1,6 +1,15 @@
 #include "aura-core/platform.h"
+#include <cerrno>
 #include <cstdio>
 #include <string>
+#include <ctime>
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 // platform-specific defines
 
@@ -14,12 +23,238 @@ std::string to_utf8_string(std::wstring_view const& view)
     auto const num_chars = 
         snprintf(dummy, 2, "%.*ls", static_cast<int>(view.size()), view.data());
 
+    if (num_chars <= 0)
+    {
+        return {};
+    }
+
     std::string buffer;
     buffer.assign(num_chars, '\0');
 
-    snprintf(buffer.data(), buffer.size(), "%.*ls", static_cast<int>(view.size()), view.data());
+    // + 1 for the terminator snprintf insists on writing
+    snprintf(buffer.data(), buffer.size() + 1, "%.*ls", static_cast<int>(view.size()), view.data());
 
     return buffer;
 }
 
+void write_stdout(std::wstring_view text) noexcept
+{
+    // utf-8 encode in chunks
+    char buffer[16384];
+    size_t n = 0;
+    auto const flush = [&]
+    {
+        for (size_t done = 0; done < n;)
+        {
+            auto const w = ::write(STDOUT_FILENO, buffer + done, n - done);
+            if (w <= 0 && errno != EINTR)
+            {
+                break;
+            }
+            done += w > 0 ? static_cast<size_t>(w) : 0;
+        }
+        n = 0;
+    };
+    for (auto const wc : text)
+    {
+        if (n + 4 > sizeof(buffer))
+        {
+            flush();
+        }
+        auto const c = static_cast<std::uint32_t>(wc);
+        if (c < 0x80)
+        {
+            buffer[n++] = static_cast<char>(c);
+        }
+        else if (c < 0x800)
+        {
+            buffer[n++] = static_cast<char>(0xc0 | (c >> 6));
+            buffer[n++] = static_cast<char>(0x80 | (c & 0x3f));
+        }
+        else if (c < 0x10000)
+        {
+            buffer[n++] = static_cast<char>(0xe0 | (c >> 12));
+            buffer[n++] = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            buffer[n++] = static_cast<char>(0x80 | (c & 0x3f));
+        }
+        else
+        {
+            buffer[n++] = static_cast<char>(0xf0 | ((c >> 18) & 0x07));
+            buffer[n++] = static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+            buffer[n++] = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            buffer[n++] = static_cast<char>(0x80 | (c & 0x3f));
+        }
+    }
+    flush();
+}
+
+std::error_code sync_file(std::FILE* file)
+{
+    if (std::fflush(file) != 0 || ::fdatasync(::fileno(file)) != 0)
+    {
+        return std::error_code{errno, std::system_category()};
+    }
+    return {};
+}
+
+std::error_code sync_directory(std::filesystem::path const& dir)
+{
+    auto const fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+    {
+        return std::error_code{errno, std::system_category()};
+    }
+    auto const result = ::fsync(fd);
+    auto const e = result ? std::error_code{errno, std::system_category()} : std::error_code{};
+    ::close(fd);
+    return e;
+}
+
+std::chrono::nanoseconds thread_cpu_time() noexcept
+{
+    timespec ts{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+}
+
+std::pair<std::error_code, void*> map_shared_memory(std::string const& name, size_t size, bool create)
+{
+    auto const fd = ::shm_open(name.c_str(), create ? O_RDWR | O_CREAT : O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return {std::error_code{errno, std::system_category()}, nullptr};
+    }
+    if (create && ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        auto const e = std::error_code{errno, std::system_category()};
+        ::close(fd);
+        return {e, nullptr};
+    }
+    auto const data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    auto const e = data == MAP_FAILED ? std::error_code{errno, std::system_category()} : std::error_code{};
+    ::close(fd);
+    return {e, e ? nullptr : data};
+}
+
+void unmap_shared_memory(void* data, size_t size) noexcept
+{
+    ::munmap(data, size);
+}
+
+void remove_shared_memory(std::string const& name) noexcept
+{
+    ::shm_unlink(name.c_str());
+}
+
+shared_wakeup::~shared_wakeup() = default;
+
+std::error_code shared_wakeup::open(std::string const&)
+{
+    return {};
+}
+
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout,
+    shared_wakeup const&) noexcept
+{
+    static_assert(sizeof(word) == sizeof(std::uint32_t));
+    timespec const ts{static_cast<time_t>(timeout.count() / 1000), static_cast<long>((timeout.count() % 1000) * 1000000)};
+    // not FUTEX_PRIVATE_FLAG: the word may be shared with another process
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futex_wake(std::atomic<std::uint32_t>& word, shared_wakeup const&) noexcept
+{
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void wait_on_address(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout) noexcept
+{
+    timespec const ts{static_cast<time_t>(timeout.count() / 1000), static_cast<long>((timeout.count() % 1000) * 1000000)};
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+}
+
+void wake_by_address(std::atomic<std::uint32_t>& word) noexcept
+{
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+int current_process_id() noexcept
+{
+    return static_cast<int>(::getpid());
+}
+
+bool is_process_alive(int pid) noexcept
+{
+    return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+}
+
+std::pair<std::error_code, process_usage> get_process_usage(int pid)
+{
+    auto const proc = "/proc/" + std::to_string(pid);
+    auto* stat = std::fopen((proc + "/stat").c_str(), "r");
+    if (!stat)
+    {
+        return {std::error_code{errno, std::system_category()}, {}};
+    }
+    // utime and stime are fields 14 and 15, after the parenthesised name
+    unsigned long long utime = 0, stime = 0;
+    auto const n = std::fscanf(stat, "%*d (%*[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+        &utime, &stime);
+    std::fclose(stat);
+
+    unsigned long long resident_pages = 0;
+    auto* statm = std::fopen((proc + "/statm").c_str(), "r");
+    auto const m = statm ? std::fscanf(statm, "%*u %llu", &resident_pages) : 0;
+    if (statm)
+    {
+        std::fclose(statm);
+    }
+    if (n != 2 || m != 1)
+    {
+        return {make_error_code(std::errc::io_error), {}};
+    }
+
+    static auto const ticks_per_second = ::sysconf(_SC_CLK_TCK);
+    static auto const page_size = ::sysconf(_SC_PAGESIZE);
+    process_usage usage{};
+    usage.cpu_time = std::chrono::nanoseconds{(utime + stime) * 1000000000ull / ticks_per_second};
+    usage.resident_bytes = resident_pages * static_cast<unsigned long long>(page_size);
+    return {{}, usage};
+}
+
+namespace
+{
+
+sigset_t stop_signals() noexcept
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    return set;
+}
+
+} // namespace {}
+
+std::error_code catch_stop_requests()
+{
+    // threads started afterwards inherit the mask, so the signals stay
+    // pending until wait_for_stop_request() takes them
+    auto const set = stop_signals();
+    if (auto const e = ::pthread_sigmask(SIG_BLOCK, &set, nullptr))
+    {
+        return std::error_code{e, std::generic_category()};
+    }
+    return {};
+}
+
+void wait_for_stop_request() noexcept
+{
+    auto const set = stop_signals();
+    int signal = 0;
+    while (::sigwait(&set, &signal) != 0)
+    {
+    }
+}
+
 } // namespace aura
@@ -5,20 +5,137 @@
 #include "aura-core/unit_traits.h"
 #include "aura-core/card_preset.h"
 #include "aura-core/terrain_types.h"
+#include "aura-core/serialization.h"
+#include "aura-core/preset_registry.h"
+#include "aura-core/metrics.h"
+#include "aura-core/allocation_counter.h"
 #include <algorithm>
+#include <chrono>
 #include <optional>
 #include <functional>
-#include <cstdlib>
-#include <ctime>
 
 namespace aura
 {
 
-local_rules_engine::local_rules_engine(ruleset const& rs)
+namespace
+{
+
+//! Bumped whenever the snapshot layout changes
+constexpr int snapshot_format = 1;
+
+metric_counter const g_deck_draws{"aura_deck_draws_total"};
+
+struct action_metrics
+{
+  explicit action_metrics(char const* type)
+    : committed{"aura_actions_total", std::string{"type=\""} + type + "\""}
+    , latency_ns{"aura_action_latency_ns", std::string{"type=\""} + type + "\""}
+#ifdef AURA_COUNT_ALLOCATIONS
+    , allocations{"aura_action_allocations", std::string{"type=\""} + type + "\""}
+    , allocated_bytes{"aura_action_allocated_bytes", std::string{"type=\""} + type + "\""}
+#endif
+  {
+  }
+
+  metric_counter committed;  //!< legal or not
+  metric_histogram latency_ns;
+#ifdef AURA_COUNT_ALLOCATIONS
+  metric_histogram allocations;  //!< per call
+  metric_histogram allocated_bytes;
+#endif
+};
+
+action_metrics const& metrics_for(action_type type)
+{
+  static action_metrics const metrics[] = {action_metrics{"unknown"}, action_metrics{"end_turn"},
+    action_metrics{"forfeit"}, action_metrics{"primary_action"}, action_metrics{"deploy"}, action_metrics{"pick"},
+    action_metrics{"no_action"}};
+  auto const i = static_cast<size_t>(type);
+  return metrics[i < std::size(metrics) ? i : 0];
+}
+
+size_t card_bytes(card_info const& card) noexcept
+{
+  return heap_bytes(card.name) + heap_bytes(card.description) + heap_bytes(card.traits)
+    + heap_bytes(card.preferred_terrain);
+}
+
+size_t cards_bytes(std::vector<card_info> const& cards) noexcept
+{
+  auto n = heap_bytes(cards);
+  for (auto const& card : cards)
+  {
+    n += card_bytes(card);
+  }
+  return n;
+}
+
+size_t preset_bytes(card_preset const& preset) noexcept
+{
+  return heap_bytes(preset.name) + heap_bytes(preset.special_descr) + heap_bytes(preset.traits)
+    + heap_bytes(preset.preferred_terrain);
+}
+
+size_t deck_bytes(deck const& d) noexcept
+{
+  auto n = heap_bytes(d.all_cards) + heap_bytes(d.remaining_cards) + hash_table_bytes(d.fixed_picks);
+  for (auto const& p : d.all_cards)
+  {
+    n += preset_bytes(p);
+  }
+  for (auto const& p : d.remaining_cards)
+  {
+    n += preset_bytes(p);
+  }
+  for (auto const& [turn, p] : d.fixed_picks)
+  {
+    n += preset_bytes(p);
+  }
+  return n;
+}
+
+//! Records a commit_action call on every way out of it
+class action_timer
+{
+public:
+  explicit action_timer(action_type type) noexcept
+    : m_metrics{metrics_for(type)}
+    , m_start{std::chrono::steady_clock::now()}
+  {
+  }
+
+  ~action_timer()
+  {
+#ifdef AURA_COUNT_ALLOCATIONS
+    // before recording, which allocates a thread's histograms the first time
+    auto const counts = m_allocations.counts();
+#endif
+    m_metrics.committed.add();
+    m_metrics.latency_ns.record(static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()));
+#ifdef AURA_COUNT_ALLOCATIONS
+    m_metrics.allocations.record(counts.allocations);
+    m_metrics.allocated_bytes.record(counts.bytes);
+#endif
+  }
+
+private:
+  action_metrics const& m_metrics;
+  std::chrono::steady_clock::time_point const m_start;
+#ifdef AURA_COUNT_ALLOCATIONS
+  allocation_scope const m_allocations;
+#endif
+};
+
+} // namespace {}
+
+local_rules_engine::local_rules_engine(ruleset const& rs, std::uint64_t seed)
   : m_rules{rs}
+  , m_rng{seed}
 {
   {
     player_info player{};
+    player.uid = next_uid();
     player.starting_health = m_rules.challenger_starting_health;
     player.health = m_rules.challenger_starting_health;
     player.starting_mana = m_rules.challenger_starting_mana;
@@ -50,6 +167,7 @@ local_rules_engine::local_rules_engine(ruleset const& rs)
 
   {
     player_info player{};
+    player.uid = next_uid();
     player.starting_health = m_rules.defender_starting_health;
     player.health = m_rules.defender_starting_health;
     player.starting_mana = m_rules.defender_starting_mana;
@@ -94,9 +212,13 @@ local_rules_engine::local_rules_engine(ruleset const& rs)
 # error Oops legal assert is already defined
 #endif
 
+// each site counts the actions it turned down under its own line number
 #define LEGAL_ASSERT(a, msg) \
   if (!(a)) \
   { \
+    static metric_counter const illegal_at_site{"aura_illegal_actions_total", \
+      "site=\"local_rules_engine.cpp:" AURA_STRINGIZE(__LINE__) "\""}; \
+    illegal_at_site.add(); \
     auto const e = make_error_code(rules_error::not_legal); \
     AURA_ERROR(e, msg L" | " #a); \
     return e; \
@@ -155,22 +277,7 @@ card_info* local_rules_engine::find_target(int uid)
 
 card_info local_rules_engine::to_card_info(card_preset const& preset, int cid)
 {
-  card_info info{};
-  info.uid = generate_uid();
-  info.cid = cid;
-  info.health = preset.health;
-  info.starting_health = preset.health;
-  info.starting_strength = preset.strength;
-  info.strength = preset.strength;
-  info.cost = preset.cost;
-  info.name = preset.name;
-  info.traits = preset.traits;
-  info.preferred_terrain = preset.preferred_terrain;
-  info.energy = preset.energy;
-  info.starting_energy = preset.energy;
-  info.description = preset.special_descr;
-  info.action_type = preset.action_type;
-  info.action_targets = preset.action_targets;
+  auto info = make_card_info(preset, next_uid(), cid);
   //info.action_type = std::invoke([&]
   //{
   //  if (!preset.primary)
@@ -210,33 +317,28 @@ card_info local_rules_engine::to_card_info(card_preset const& preset, int cid)
   //  return card_action_targets::both;
   //});
 
+  register_actions(preset, info.uid);
+  return info;
+}
+
+void local_rules_engine::register_actions(card_preset const& preset, int uid)
+{
   if (preset.primary)
   {
-    auto [it, success] = m_primary_actions.emplace(info.uid, preset.primary);
-    AURA_ASSERT(success);
+    m_primary_actions.emplace(uid, preset.primary);
   }
   if (preset.on_deploy)
   {
-    auto [it, success] = m_deploy_actions.emplace(info.uid, preset.on_deploy);
-    AURA_ASSERT(success);
+    m_deploy_actions.emplace(uid, preset.on_deploy);
   }
-
   if (preset.on_death)
   {
-    auto [it, success] = m_death_actions.emplace(info.uid, preset.on_death);
-    AURA_ASSERT(success);
+    m_death_actions.emplace(uid, preset.on_death);
   }
-  return info;
 }
 
 terrain_t local_rules_engine::generate_terrain()
 {
-  static auto ss = std::invoke([]
-  {
-    srand(time(0));
-    return 0;
-  });
-
   terrain_t t;
   for (int i = 0; i < m_rules.num_lanes; ++i)
   {
@@ -244,7 +346,7 @@ terrain_t local_rules_engine::generate_terrain()
     AURA_LOG(L"- Terrain lane %d", i);
     for (int j = 0; j < m_rules.max_lane_height * 2; ++j)
     {
-      auto const n = rand() % static_cast<int>(terrain_types::total);
+      auto const n = static_cast<int>(m_rng.below(static_cast<int>(terrain_types::total)));
       auto const t = static_cast<terrain_types>(n);
       AURA_LOG(L"- - Tile %d = %hs", j, to_string(t).c_str());
       v.emplace_back(t);
@@ -256,35 +358,116 @@ terrain_t local_rules_engine::generate_terrain()
 
 card_info local_rules_engine::generate_card(ruleset const& rs, deck& d, int turn)
 {
-  static auto ss = std::invoke([]
-  {
-    srand(time(0));
-    return 0;
-  });
-
-  auto const& preset = d.draw(turn, rs.draw_limit_multiplier * turn);
+  auto const& preset = d.draw(turn, rs.draw_limit_multiplier * turn, m_rng);
+  g_deck_draws.add();
 
   return to_card_info(preset, 0);
 }
 
 std::wstring local_rules_engine::describe(unit_traits trait) const noexcept
 {
-  switch (trait)
-  {
-  case unit_traits::aerial:  return L"aerial: traverses by air";
-  case unit_traits::structure: return L"structure: good for providing cover and bonuses";
-  case unit_traits::item: return L"item: can be applied to card on board";
-  case unit_traits::twice: return L"can act twice per turn";
-  case unit_traits::thrice: return L"can act three times per turn";
-  case unit_traits::assassin: return L"assassin: can attack same turn as deployment";
-  case unit_traits::long_range: return L"can attack from range (skipping lane obstructions)";
-  case unit_traits::healer: return L"heals friendly units";
-  case unit_traits::infantry: [[fallthrough]];
-  case unit_traits::player: [[fallthrough]];
-  default:
-    return L"";
-  }
-  return L"";
+  return describe_trait(trait);
+}
+
+session_footprint local_rules_engine::memory_footprint() const
+{
+  session_footprint f{};
+  f.engine = sizeof(*this);
+
+  auto const& s = m_session_info;
+  f.players = heap_bytes(s.players);
+  for (auto const& player : s.players)
+  {
+    f.players += card_bytes(player) + heap_bytes(player.name);
+    f.hands += cards_bytes(player.hand);
+    f.lanes += heap_bytes(player.lanes);
+    for (auto const& lane : player.lanes)
+    {
+      f.lanes += cards_bytes(lane);
+    }
+  }
+  f.picks = cards_bytes(s.picks);
+  f.draft_choices = cards_bytes(m_draft_choices);
+  f.effect_maps = hash_table_bytes(m_primary_actions) + hash_table_bytes(m_deploy_actions)
+    + hash_table_bytes(m_death_actions);
+  f.terrain = heap_bytes(s.terrain);
+  for (auto const& lane : s.terrain)
+  {
+    f.terrain += heap_bytes(lane);
+  }
+  f.ruleset = deck_bytes(m_rules.challenger_deck) + deck_bytes(m_rules.defender_deck);
+  return f;
+}
+
+std::string local_rules_engine::snapshot() const
+{
+  return encode_snapshot(m_rules, m_session_info, m_rng.state);
+}
+
+std::string local_rules_engine::snapshot_for_seats(unsigned seats) const
+{
+  auto rules = m_rules;
+  rules.challenger_deck = {};
+  rules.defender_deck = {};
+  return encode_snapshot(rules, redact_for_seats(m_session_info, seats), 0);
+}
+
+std::string local_rules_engine::encode_snapshot(ruleset const& rules, session_info const& session,
+  std::uint64_t rng_state) const
+{
+  byte_writer w;
+  w.write_int(snapshot_format);
+  write(w, rules);
+  write(w, session);
+  w.write_bool(end_of_turn);
+  write(w, m_draft_choices);
+  w.write_bool(m_starting_drafts);
+  w.write_int(static_cast<long long>(rng_state));
+  w.write_int(m_next_uid);
+  return std::move(w.buffer);
+}
+
+std::pair<std::error_code, local_rules_engine> local_rules_engine::restore(std::string_view snapshot)
+{
+  byte_reader r{snapshot};
+  local_rules_engine engine;
+  if (r.read_int() != snapshot_format)
+  {
+    return {make_error_code(std::errc::not_supported), std::move(engine)};
+  }
+
+  read(r, engine.m_rules);
+  read(r, engine.m_session_info);
+  engine.end_of_turn = r.read_bool();
+  read(r, engine.m_draft_choices);
+  engine.m_starting_drafts = r.read_bool();
+  engine.m_rng.state = static_cast<std::uint64_t>(r.read_int());
+  engine.m_next_uid = static_cast<int>(r.read_int());
+  if (auto const e = r.error())
+  {
+    AURA_ERROR(e, L"Failed to restore session snapshot (%zu bytes)", snapshot.size());
+    return {e, std::move(engine)};
+  }
+
+  // card actions are function pointers; look them up again by card name
+  auto const register_card = [&](card_info const& card)
+  {
+    if (auto const* preset = preset_at(preset_index(card.name)))
+    {
+      engine.register_actions(*preset, card.uid);
+    }
+  };
+  for (auto const& player : engine.m_session_info.players)
+  {
+    std::for_each(begin(player.hand), end(player.hand), register_card);
+    for (auto const& lane : player.lanes)
+    {
+      std::for_each(begin(lane), end(lane), register_card);
+    }
+  }
+  std::for_each(begin(engine.m_session_info.picks), end(engine.m_session_info.picks), register_card);
+  std::for_each(begin(engine.m_draft_choices), end(engine.m_draft_choices), register_card);
+  return {{}, std::move(engine)};
 }
 
 std::error_code local_rules_engine::ready_draft_picks()
@@ -362,6 +545,8 @@ void local_rules_engine::add_specials(player_info& player)
 
 void local_rules_engine::apply_terrain_modifiers(int cur_player, int lane_num, int tile_num, card_info& card) const
 {
+  // lanes can outgrow the board; extra units stand on the last tile of their half
+  tile_num = std::min(tile_num, m_rules.max_lane_height - 1);
   auto const h = cur_player ? ((2*m_rules.max_lane_height) - 1 - tile_num) : tile_num;
   auto const& t = m_session_info.terrain[lane_num][h];
 
@@ -417,6 +602,8 @@ void local_rules_engine::apply_all_terrain_modifiers(session_info& sesh) const
 //! Commit a player action
 std::error_code local_rules_engine::commit_action(player_action const& action) 
 {
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  action_timer const timer{action.type};
   switch (action.type)
   {
   case action_type::end_turn:
@@ -556,7 +743,14 @@ std::error_code local_rules_engine::commit_action(player_action const& action)
     {
       return error;
     }
-    
+
+    // before the dead are removed, which frees the cards pointed to
+    AURA_LOG(L"AFTER %ls %cP [%d, %d] (primary) -> %ls %cP [%d, %d]", 
+      card_actor->name.c_str(), card_actor->on_preferred_terrain ? L' ' : L'N',
+      card_actor->strength, card_actor->health,
+      card_target->name.c_str(), card_target->on_preferred_terrain ? L' ' : L'N',
+      card_target->strength, card_target->health);
+
     if (card_target->has_trait(unit_traits::player) && card_target->health <= 0)
     {
       AURA_LOG(L"Player %d has won the game!", m_session_info.current_player);
@@ -576,11 +770,6 @@ std::error_code local_rules_engine::commit_action(player_action const& action)
       apply_all_terrain_modifiers(m_session_info);
     }
 
-    AURA_LOG(L"AFTER %ls %cP [%d, %d] (primary) -> %ls %cP [%d, %d]", 
-      card_actor->name.c_str(), card_actor->on_preferred_terrain ? L' ' : L'N',
-      card_actor->strength, card_actor->health,
-      card_target->name.c_str(), card_target->on_preferred_terrain ? L' ' : L'N',
-      card_target->strength, card_target->health);
     return {};
   }
 
@@ -1,7 +1,14 @@
+#pragma once
+
 #include <aura-core/rules_engine.h>
 #include <aura-core/session_info.h>
 #include <aura-core/ruleset.h>
 #include <aura-core/terrain_types.h>
+#include <aura-core/random.h>
+#include <aura-core/memory_footprint.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace aura
@@ -10,12 +17,15 @@ namespace aura
 class local_rules_engine : public rules_engine
 {
 public:
-  local_rules_engine(ruleset const& rs);
+  //! Games started with the same rules and seed play out identically
+  local_rules_engine(ruleset const& rs, std::uint64_t seed = make_random_seed());
 
   bool is_game_over() const noexcept override { return m_session_info.game_over; }
 
   session_info const& get_session_info() const;
 
+  ruleset const& get_ruleset() const noexcept { return m_rules; }
+
   std::vector<int> get_target_list(int uid) const;
 
   //! Check if a player action is legal
@@ -31,7 +41,35 @@ public:
   std::error_code ready_draft_picks();
   std::error_code trigger_draft_pick();
 
+  //! Serializes the whole engine state, including the ruleset and RNG state
+  std::string snapshot() const;
+
+  //! What a client holding 'seats' (see redact_for_seats) may know, to
+  //! predict its actions with: the session as redact_for_seats() shows it,
+  //! without the decks and the RNG state, which decide every card still to
+  //! come. An engine restored from it plays any action but end_turn, which
+  //! draws.
+  std::string snapshot_for_seats(unsigned seats) const;
+
+  //! Recreates an engine from a snapshot() so it continues exactly where the
+  //! snapshotted engine left off
+  static std::pair<std::error_code, local_rules_engine> restore(std::string_view snapshot);
+
+  //! Walks the engine's state to see how much memory it holds. Costs a few
+  //! microseconds, so callers measure at turn boundaries rather than per action.
+  session_footprint memory_footprint() const;
+
 private:
+  friend struct engine_bench; //!< aura-bench times the private hot paths
+
+  local_rules_engine() = default;
+
+  int next_uid() noexcept { return m_next_uid++; }
+
+  void register_actions(card_preset const& preset, int uid);
+
+  std::string encode_snapshot(ruleset const& rules, session_info const& session, std::uint64_t rng_state) const;
+
   card_info* find_actor(int uid);
   card_info* find_target(int uid);
 
@@ -56,6 +94,9 @@ private:
   std::vector<card_info> m_draft_choices;
   bool                   m_starting_drafts{true};
 
+  random_engine m_rng;
+  int           m_next_uid{1};
+
   //using primary_action_t = std::function<std::error_code(card_info& actor, card_info& target)>;
   // Card uid -> primary action
   //std::unordered_map<int, primary_action_t> m_primary_actions;
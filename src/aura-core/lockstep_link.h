@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace aura
+{
+
+//! Ordered, reliable message channel between the two ends of a lockstep
+//! game, either directly to the peer or through a relay.
+class lockstep_link
+{
+public:
+  virtual std::error_code send(std::string_view message) = 0;
+
+  //! Next message from the peer, if one has arrived; never blocks
+  virtual std::optional<std::string> poll() = 0;
+
+  virtual ~lockstep_link() = default;
+};
+
+//! Both ends of a lockstep game within one process, for self-play and
+//! tests. Not thread safe: both ends are played from the same thread.
+class lockstep_pipe
+{
+public:
+  lockstep_pipe()
+  {
+    m_ends[0].peer = &m_ends[1];
+    m_ends[1].peer = &m_ends[0];
+  }
+
+  lockstep_pipe(lockstep_pipe const&) = delete;
+  lockstep_pipe& operator=(lockstep_pipe const&) = delete;
+
+  //! The end the player in 'seat' plays through
+  lockstep_link& end(int seat) noexcept { return m_ends[seat]; }
+
+private:
+  struct end_point : public lockstep_link
+  {
+    std::error_code send(std::string_view message) override
+    {
+      peer->inbox.emplace_back(message);
+      return {};
+    }
+
+    std::optional<std::string> poll() override
+    {
+      if (inbox.empty())
+      {
+        return std::nullopt;
+      }
+      auto message = std::move(inbox.front());
+      inbox.pop_front();
+      return message;
+    }
+
+    end_point* peer{nullptr};
+    std::deque<std::string> inbox;
+  };
+
+  std::array<end_point, 2> m_ends;
+};
+
+} // namespace aura
@@ -0,0 +1,220 @@
+#include "lockstep_rules_engine.h"
+#include "aura-core/session_digest.h"
+#include "aura-core/serialization.h"
+#include "aura-core/build.h"
+
+namespace aura
+{
+
+#ifdef LEGAL_ASSERT
+# error Oops legal assert is already defined
+#endif
+
+#define LEGAL_ASSERT(a, msg) \
+  if (!(a)) \
+  { \
+    auto const e = make_error_code(rules_error::not_legal); \
+    AURA_ERROR(e, msg L" | " #a); \
+    return e; \
+  }
+
+lockstep_rules_engine::lockstep_rules_engine(ruleset const& rs, std::uint64_t seed, int seat, lockstep_link& link)
+  : m_engine{rs, seed}
+  , m_link{link}
+  , m_seat{seat}
+  , m_initial_digest{m_digest.update(m_engine.get_session_info())}
+{
+  byte_writer w;
+  w.write_int(static_cast<int>(message_kind::hello));
+  w.write_int(static_cast<long long>(m_initial_digest));
+  send(w.buffer);
+}
+
+bool lockstep_rules_engine::is_game_over() const noexcept
+{
+  receive();
+  return m_engine.is_game_over();
+}
+
+session_info const& lockstep_rules_engine::get_session_info() const
+{
+  receive();
+  return m_engine.get_session_info();
+}
+
+std::vector<int> lockstep_rules_engine::get_target_list(int uid) const
+{
+  return m_engine.get_target_list(uid);
+}
+
+std::error_code lockstep_rules_engine::commit_action(player_action const& action)
+{
+  receive();
+  if (m_link_error)
+  {
+    return m_link_error;
+  }
+  if (m_desynced)
+  {
+    return make_error_code(std::errc::state_not_recoverable);
+  }
+  LEGAL_ASSERT(m_engine.get_session_info().current_player == m_seat, L"Waiting for the other player");
+
+  if (auto const e = m_engine.commit_action(action))
+  {
+    return e;
+  }
+
+  byte_writer w;
+  w.write_int(static_cast<int>(message_kind::action));
+  w.write_int(m_next_sent++);
+  write(w, action);
+  if (action.type == action_type::end_turn)
+  {
+    m_chain = chain_hash(m_chain, m_digest.update(m_engine.get_session_info()));
+    w.write_int(static_cast<long long>(m_chain));
+  }
+  send(w.buffer);
+  return {};
+}
+
+card_info lockstep_rules_engine::to_card_info(card_preset const& preset, int cid)
+{
+  return m_engine.to_card_info(preset, cid);
+}
+
+std::error_code lockstep_rules_engine::trigger_pick_action(int num_picks, int num_choices)
+{
+  return m_engine.trigger_pick_action(num_picks, num_choices);
+}
+
+std::wstring lockstep_rules_engine::describe(unit_traits trait) const noexcept
+{
+  return m_engine.describe(trait);
+}
+
+void lockstep_rules_engine::receive() const
+{
+  while (!m_link_error)
+  {
+    auto const message = m_link.poll();
+    if (!message)
+    {
+      return;
+    }
+    handle(*message);
+  }
+}
+
+void lockstep_rules_engine::handle(std::string_view message) const
+{
+  byte_reader r{message};
+  auto const kind = static_cast<message_kind>(r.read_int());
+  switch (kind)
+  {
+  case message_kind::hello:
+  {
+    auto const digest = static_cast<std::uint64_t>(r.read_int());
+    if (!r.failed && digest != m_initial_digest)
+    {
+      desync(-1, L"the games start differently (ruleset or seed mismatch)");
+    }
+    break;
+  }
+
+  case message_kind::action:
+  {
+    auto const sequence = static_cast<int>(r.read_int());
+    player_action action{};
+    read(r, action);
+    if (r.failed || m_desynced)
+    {
+      break;
+    }
+    if (sequence != m_next_received++)
+    {
+      desync(sequence, L"actions arrived out of order");
+      break;
+    }
+    if (m_engine.get_session_info().current_player == m_seat)
+    {
+      desync(sequence, L"the peer acted during our turn");
+      break;
+    }
+    if (auto const e = m_engine.commit_action(action))
+    {
+      AURA_ERROR(e, L"Lockstep: the peer's action %d is illegal here", sequence);
+      desync(sequence, L"the peer's action is illegal here");
+      break;
+    }
+    if (action.type == action_type::end_turn)
+    {
+      m_chain = chain_hash(m_chain, m_digest.update(m_engine.get_session_info()));
+      if (static_cast<std::uint64_t>(r.read_int()) != m_chain)
+      {
+        desync(sequence, L"session digests differ after end of turn");
+      }
+    }
+    break;
+  }
+
+  case message_kind::desync:
+  {
+    auto const sequence = static_cast<int>(r.read_int());
+    session_info theirs{};
+    auto const e = decode_session(r.read_string(), theirs);
+    m_desynced = true;
+    if (e)
+    {
+      AURA_ERROR(e, L"Lockstep: the peer reported a desync at action %d", sequence);
+      break;
+    }
+    m_desync_report = diff_sessions(m_engine.get_session_info(), theirs);
+    AURA_ERROR(make_error_code(std::errc::state_not_recoverable),
+      L"Lockstep: desync at action %d, ours vs peer's:\n%ls", sequence, m_desync_report.c_str());
+    break;
+  }
+
+  default:
+    r.failed = true;
+    break;
+  }
+
+  if (r.failed)
+  {
+    m_link_error = r.error();
+    AURA_ERROR(m_link_error, L"Lockstep: malformed message from the peer");
+  }
+}
+
+void lockstep_rules_engine::send(std::string const& message) const
+{
+  if (auto const e = m_link.send(message))
+  {
+    AURA_ERROR(e, L"Lockstep: cannot reach the peer");
+    m_link_error = e;
+    return;
+  }
+  m_bytes_sent += message.size();
+}
+
+void lockstep_rules_engine::desync(int sequence, wchar_t const* reason) const
+{
+  if (m_desynced)
+  {
+    return;
+  }
+  m_desynced = true;
+  AURA_ERROR(make_error_code(std::errc::state_not_recoverable), L"Lockstep: desync at action %d: %ls", sequence, reason);
+
+  // the peer holds the other half of the diff
+  byte_writer w;
+  w.write_int(static_cast<int>(message_kind::desync));
+  w.write_int(sequence);
+  w.write_string(encode_session(m_engine.get_session_info()));
+  send(w.buffer);
+}
+
+#undef LEGAL_ASSERT
+
+} // namespace aura
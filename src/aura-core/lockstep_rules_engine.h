@@ -0,0 +1,99 @@
+#pragma once
+
+#include <aura-core/rules_engine.h>
+#include <aura-core/local_rules_engine.h>
+#include <aura-core/lockstep_link.h>
+#include <aura-core/player_action.h>
+#include <aura-core/session_digest.h>
+#include <cstdint>
+#include <string>
+
+namespace aura
+{
+
+//! rules_engine for lockstep play: both ends run the same local engine from
+//! the same ruleset and seed, and only exchange the actions of their own
+//! player, a few bytes each.
+//!
+//! Every end_turn carries a chained incremental_digest of the session (see
+//! session_digest.h), which only hashes again what the turn changed. The
+//! receiving end compares it with its own; on a mismatch it sends its
+//! session back so that the other end can log a field by field diff, and
+//! both ends refuse further actions.
+//!
+//! The link is either a lockstep_pipe within the process or a relay_link
+//! through the game server.
+class lockstep_rules_engine : public rules_engine
+{
+public:
+  //! 'seat' is the index of the local player in session_info::players
+  lockstep_rules_engine(ruleset const& rs, std::uint64_t seed, int seat, lockstep_link& link);
+
+  bool is_game_over() const noexcept override;
+
+  //! Applies whatever the peer has sent so far, then returns the session
+  session_info const& get_session_info() const override;
+
+  std::vector<int> get_target_list(int uid) const override;
+
+  //! Commits an action of the local player and sends it to the peer
+  std::error_code commit_action(player_action const&) override;
+
+  card_info to_card_info(card_preset const& preset, int cid) override;
+
+  std::error_code trigger_pick_action(int num_picks, int num_choices = 0) override;
+
+  std::wstring describe(unit_traits trait) const noexcept override;
+
+  int seat() const noexcept { return m_seat; }
+
+  bool is_desynced() const noexcept { return m_desynced; }
+
+  //! Diff logged for the last desync, if this end could produce one
+  std::wstring const& desync_report() const noexcept { return m_desync_report; }
+
+  //! Bytes sent to the peer so far
+  size_t bytes_sent() const noexcept { return m_bytes_sent; }
+
+private:
+  enum class message_kind : int
+  {
+    hello,   //!< digest of the starting session
+    action,  //!< one action; end_turn also carries the chained digest
+    desync   //!< the sender's session after the action whose digest did not match
+  };
+
+  //! Applies the messages the peer has sent so far. Const so that the const
+  //! accessors can catch up; the protocol state below is mutable for it.
+  void receive() const;
+
+  void handle(std::string_view message) const;
+
+  void send(std::string const& message) const;
+
+  //! Reports that our session disagrees with the peer's after 'sequence'
+  void desync(int sequence, wchar_t const* reason) const;
+
+private:
+  mutable local_rules_engine m_engine;
+  lockstep_link& m_link;
+  int const m_seat;
+
+  //! Of our session as of the last end_turn; the peer's turns update it too
+  mutable incremental_digest m_digest;
+
+  std::uint64_t const m_initial_digest;
+
+  //! Running digest over the session at every end_turn
+  mutable std::uint64_t m_chain{0};
+
+  int m_next_sent{0};
+  mutable int m_next_received{0};
+
+  mutable bool m_desynced{false};
+  mutable std::error_code m_link_error;
+  mutable std::wstring m_desync_report;
+  mutable size_t m_bytes_sent{0};
+};
+
+} // namespace aura
@@ -0,0 +1,562 @@
+#include "log.h"
+#include "platform.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace aura
+{
+
+namespace
+{
+
+//! Bytes logged by one thread and not yet written out. Records are a 4-byte
+//! length and the record, padded to 4 bytes; a length of wrap_marker means
+//! the rest of the buffer is unused and the next record is at its start.
+struct log_ring
+{
+  static constexpr size_t capacity = 1 << 18;
+  static constexpr std::uint32_t wrap_marker = 0xffffffff;
+
+  bool push(char const* record, size_t n) noexcept
+  {
+    auto const h = head.load(std::memory_order_relaxed);
+    auto const t = tail.load(std::memory_order_acquire);
+    auto const padded = (n + 3) & ~size_t{3};
+    auto const offset = h % capacity;
+    auto const skip = offset + 4 + padded > capacity ? capacity - offset : 0;
+    if (capacity - (h - t) < skip + 4 + padded)
+    {
+      return false;
+    }
+
+    if (skip)
+    {
+      std::memcpy(data + offset, &wrap_marker, 4);
+    }
+    auto const start = (h + skip) % capacity;
+    auto const length = static_cast<std::uint32_t>(n);
+    std::memcpy(data + start, &length, 4);
+    std::memcpy(data + start + 4, record, n);
+    head.store(h + skip + 4 + padded, std::memory_order_release);
+    return true;
+  }
+
+  size_t used() const noexcept
+  {
+    return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+  }
+
+  //! Calls fn(record, size) for each record pushed so far
+  template <typename Fn>
+  void drain(Fn&& fn)
+  {
+    auto t = tail.load(std::memory_order_relaxed);
+    auto const h = head.load(std::memory_order_acquire);
+    while (t != h)
+    {
+      std::uint32_t length{};
+      std::memcpy(&length, data + t % capacity, 4);
+      if (length == wrap_marker)
+      {
+        t += capacity - t % capacity;
+        continue;
+      }
+      fn(data + t % capacity + 4, static_cast<size_t>(length));
+      t += 4 + ((length + 3) & ~std::uint32_t{3});
+    }
+    tail.store(t, std::memory_order_release);
+  }
+
+  bool empty() const noexcept
+  {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+  }
+
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+  std::atomic<bool> retired{false}; //!< its thread has exited
+  alignas(8) char data[capacity];
+};
+
+//! Reads the arguments of a record back in order
+class arg_reader
+{
+public:
+  arg_reader(char const* data, size_t size) : m_data{data}, m_size{size} {}
+
+  bool next(log_arg& kind) noexcept
+  {
+    if (m_pos >= m_size)
+    {
+      return false;
+    }
+    kind = static_cast<log_arg>(m_data[m_pos++]);
+    return true;
+  }
+
+  template <typename T>
+  T value() noexcept
+  {
+    T v{};
+    if (m_pos + sizeof(T) <= m_size)
+    {
+      std::memcpy(&v, m_data + m_pos, sizeof(T));
+    }
+    m_pos += sizeof(T);
+    return v;
+  }
+
+  //! Strings are stored as a 4-byte length and the characters, unterminated.
+  //! Returns where the characters start and how many there are.
+  template <typename Char>
+  std::pair<char const*, size_t> string() noexcept
+  {
+    auto const n = std::min<size_t>(value<std::uint32_t>(), (m_size - std::min(m_pos, m_size)) / sizeof(Char));
+    auto const* data = m_data + m_pos;
+    m_pos += n * sizeof(Char);
+    return {data, n};
+  }
+
+  template <typename Char>
+  std::basic_string<Char> string_copy() noexcept
+  {
+    auto const [data, n] = string<Char>();
+    std::basic_string<Char> s(n, Char{});
+    std::memcpy(s.data(), data, n * sizeof(Char));
+    return s;
+  }
+
+private:
+  char const* m_data;
+  size_t m_size;
+  size_t m_pos{0};
+};
+
+template <typename T>
+void append_integer(std::wstring& out, T value)
+{
+  char digits[24];
+  auto const end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+  out.append(digits, end);
+}
+
+//! Handles the conversions that make up nearly every log statement (%d, %u,
+//! %llu, %zu, %ls, %hs, %lc without flags or width) without swprintf.
+//! Returns false, consuming nothing, if 'spec' needs the general path.
+bool format_plain(std::wstring& out, std::wstring_view spec, log_arg kind, arg_reader& args)
+{
+  auto const conversion = spec.back();
+  auto const length = spec.substr(1, spec.size() - 2);
+  if (!(length.empty() || length == L"l" || length == L"ll" || length == L"h" || length == L"z"))
+  {
+    return false;
+  }
+
+  switch (conversion)
+  {
+  case L'd':
+  case L'i':
+  case L'u':
+    switch (kind)
+    {
+    case log_arg::i32: append_integer(out, args.value<std::int32_t>()); return true;
+    case log_arg::u32: append_integer(out, args.value<std::uint32_t>()); return true;
+    case log_arg::i64: append_integer(out, args.value<std::int64_t>()); return true;
+    case log_arg::u64: append_integer(out, args.value<std::uint64_t>()); return true;
+    default: return false;
+    }
+
+  case L'c':
+    if (kind != log_arg::i32)
+    {
+      return false;
+    }
+    out += static_cast<wchar_t>(args.value<std::int32_t>());
+    return true;
+
+  case L's':
+    if (kind == log_arg::wstr)
+    {
+      auto const [data, n] = args.string<wchar_t>();
+      auto const at = out.size();
+      out.resize(at + n);
+      std::memcpy(out.data() + at, data, n * sizeof(wchar_t));
+      return true;
+    }
+    if (kind == log_arg::str)
+    {
+      // ascii widens as is; anything else goes through the locale
+      auto copy = args;
+      auto const [data, n] = copy.string<char>();
+      if (std::any_of(data, data + n, [](char c) { return static_cast<unsigned char>(c) > 0x7f; }))
+      {
+        return false;
+      }
+      args = copy;
+      out.append(data, data + n);
+      return true;
+    }
+    return false;
+
+  default:
+    return false;
+  }
+}
+
+//! Formats one conversion of 'spec' with the next argument
+void format_one(std::wstring& out, std::wstring const& spec, log_arg kind, arg_reader& args)
+{
+  wchar_t buffer[512];
+  int n = -1;
+  switch (kind)
+  {
+  case log_arg::i32: n = std::swprintf(buffer, 512, spec.c_str(), args.value<std::int32_t>()); break;
+  case log_arg::u32: n = std::swprintf(buffer, 512, spec.c_str(), args.value<std::uint32_t>()); break;
+  case log_arg::i64: n = std::swprintf(buffer, 512, spec.c_str(), static_cast<long long>(args.value<std::int64_t>())); break;
+  case log_arg::u64: n = std::swprintf(buffer, 512, spec.c_str(), static_cast<unsigned long long>(args.value<std::uint64_t>())); break;
+  case log_arg::f64: n = std::swprintf(buffer, 512, spec.c_str(), args.value<double>()); break;
+  case log_arg::ptr: n = std::swprintf(buffer, 512, spec.c_str(), reinterpret_cast<void*>(args.value<std::uintptr_t>())); break;
+  case log_arg::str: n = std::swprintf(buffer, 512, spec.c_str(), args.string_copy<char>().c_str()); break;
+  case log_arg::wstr: n = std::swprintf(buffer, 512, spec.c_str(), args.string_copy<wchar_t>().c_str()); break;
+  case log_arg::error:
+  {
+    auto const e = args.value<log_error_arg>();
+    n = std::swprintf(buffer, 512, spec.c_str(), e.category ? e.category->message(e.value).c_str() : "");
+    break;
+  }
+  }
+  // swprintf fails rather than truncate; keep what fits
+  out.append(buffer, n >= 0 ? static_cast<size_t>(n) : std::wcslen(buffer));
+}
+
+//! Appends what wprintf would have printed for the site's format and the
+//! record's arguments
+void format_record(std::wstring& out, log_site const& site, arg_reader args)
+{
+  out += site.glyph;
+  out += L' ';
+
+  std::wstring spec;
+  auto const* f = site.format;
+  while (*f)
+  {
+    auto const* literal = f;
+    while (*f && *f != L'%')
+    {
+      ++f;
+    }
+    out.append(literal, f);
+    if (!*f)
+    {
+      break;
+    }
+    if (f[1] == L'%')
+    {
+      out += L'%';
+      f += 2;
+      continue;
+    }
+
+    auto const* spec_begin = f++;
+    auto star = false;
+    while (*f && !std::wcschr(L"diouxXeEfFgGaAcCsSp", *f))
+    {
+      star |= *f == L'*';
+      ++f;
+    }
+    if (!*f)
+    {
+      break;
+    }
+    ++f;
+
+    log_arg kind{};
+    if (!star)
+    {
+      if (!args.next(kind))
+      {
+        out.append(spec_begin, f);
+        continue;
+      }
+      if (format_plain(out, std::wstring_view(spec_begin, static_cast<size_t>(f - spec_begin)), kind, args))
+      {
+        continue;
+      }
+      spec.assign(spec_begin, f);
+    }
+    else
+    {
+      // '*' takes its value from the arguments
+      spec.clear();
+      for (auto const* c = spec_begin; c != f; ++c)
+      {
+        if (*c == L'*')
+        {
+          spec += args.next(kind) ? std::to_wstring(args.value<std::int32_t>()) : L"0";
+        }
+        else
+        {
+          spec += *c;
+        }
+      }
+      if (!args.next(kind))
+      {
+        out += spec;
+        continue;
+      }
+    }
+    format_one(out, spec, kind, args);
+  }
+  out += L'\n';
+}
+
+class logger
+{
+public:
+  logger()
+  {
+    m_thread = std::thread{[this] { write_loop(); }};
+  }
+
+  ~logger()
+  {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+  }
+
+  std::shared_ptr<log_ring> add_ring()
+  {
+    auto ring = std::make_shared<log_ring>();
+    std::lock_guard lock{m_mutex};
+    m_rings.push_back(ring);
+    return ring;
+  }
+
+  //! Asks for a pass before the next timed one; cheap to call repeatedly
+  void wake() noexcept
+  {
+    if (!m_wake_requested.exchange(true, std::memory_order_relaxed))
+    {
+      m_wake.notify_one();
+    }
+  }
+
+  void flush()
+  {
+    std::unique_lock lock{m_mutex};
+    auto const wanted = ++m_flush_requested;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [&] { return m_flush_done >= wanted || m_stop; });
+  }
+
+private:
+  //! A formatted record, as a slice of m_formatted
+  struct line
+  {
+    std::int64_t time;
+    size_t begin;
+    size_t end;
+  };
+
+  void write_loop()
+  {
+    std::unique_lock lock{m_mutex};
+    while (true)
+    {
+      m_wake.wait_for(lock, std::chrono::milliseconds{2}, [&]
+      {
+        return m_stop || m_flush_requested > m_flush_done || m_wake_requested.load(std::memory_order_relaxed);
+      });
+      m_wake_requested.store(false, std::memory_order_relaxed);
+      auto const stop = m_stop;
+      auto const flush_target = m_flush_requested;
+      auto rings = m_rings;
+      lock.unlock();
+
+      write_pass(rings);
+
+      lock.lock();
+      // forget rings whose thread is gone once they are empty
+      m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(), [](auto const& r)
+      {
+        return r->retired.load() && r->empty();
+      }), m_rings.end());
+      m_flush_done = flush_target;
+      m_flushed.notify_all();
+      if (stop)
+      {
+        return;
+      }
+    }
+  }
+
+  void write_pass(std::vector<std::shared_ptr<log_ring>> const& rings)
+  {
+    m_lines.clear();
+    m_formatted.clear();
+    for (auto const& ring : rings)
+    {
+      ring->drain([&](char const* data, size_t size)
+      {
+        log_site const* site{};
+        std::int64_t time{};
+        std::memcpy(&site, data, sizeof(site));
+        std::memcpy(&time, data + sizeof(site), sizeof(time));
+        auto const header = sizeof(site) + sizeof(time);
+        auto const begin = m_formatted.size();
+        format_record(m_formatted, *site, arg_reader{data + header, size - header});
+        m_lines.push_back({time, begin, m_formatted.size()});
+      });
+    }
+    if (m_lines.empty())
+    {
+      return;
+    }
+
+    // console output printed so far goes first
+    std::fflush(stdout);
+    auto const by_time = [](line const& a, line const& b) { return a.time < b.time; };
+    if (std::is_sorted(m_lines.begin(), m_lines.end(), by_time))
+    {
+      write_stdout(m_formatted);
+    }
+    else
+    {
+      // interleave the threads' records as they happened
+      std::stable_sort(m_lines.begin(), m_lines.end(), by_time);
+      m_text.clear();
+      for (auto const& l : m_lines)
+      {
+        m_text.append(m_formatted, l.begin, l.end - l.begin);
+      }
+      write_stdout(m_text);
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_flushed;
+  std::vector<std::shared_ptr<log_ring>> m_rings;
+  std::uint64_t m_flush_requested{0};
+  std::uint64_t m_flush_done{0};
+  std::atomic<bool> m_wake_requested{false};
+  bool m_stop{false};
+
+  // only touched by the writer thread
+  std::vector<line> m_lines;
+  std::wstring m_formatted;
+  std::wstring m_text;
+
+  std::thread m_thread;
+};
+
+enum : int
+{
+  not_started,
+  running,
+  destroyed
+};
+std::atomic<int> g_logger_state{not_started};
+
+logger& get_logger()
+{
+  struct holder
+  {
+    holder() { g_logger_state = running; }
+    ~holder() { g_logger_state = destroyed; }
+    logger instance;
+  };
+  static holder h;
+  return h.instance;
+}
+
+//! The calling thread's ring, registered on first use
+log_ring* thread_ring() noexcept
+{
+  struct owner
+  {
+    std::shared_ptr<log_ring> ring{get_logger().add_ring()};
+    ~owner() { ring->retired = true; }
+  };
+  thread_local owner o;
+  return o.ring.get();
+}
+
+} // namespace {}
+
+log_record::log_record(log_site const& site) noexcept
+{
+  auto const* p = &site;
+  auto const time = static_cast<std::int64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  std::memcpy(m_data, &p, sizeof(p));
+  std::memcpy(m_data + sizeof(p), &time, sizeof(time));
+  m_size = sizeof(p) + sizeof(time);
+}
+
+void log_record::add_string(log_arg kind, void const* s, size_t char_size) noexcept
+{
+  if (m_size + 1 + 4 > max_size)
+  {
+    return;
+  }
+  size_t n = 0;
+  if (s)
+  {
+    n = char_size == 1 ? std::strlen(static_cast<char const*>(s)) : std::wcslen(static_cast<wchar_t const*>(s));
+  }
+  n = std::min(n, (max_size - m_size - 1 - 4) / char_size);
+  auto const length = static_cast<std::uint32_t>(n);
+  m_data[m_size++] = static_cast<char>(kind);
+  std::memcpy(m_data + m_size, &length, 4);
+  m_size += 4;
+  if (n)
+  {
+    std::memcpy(m_data + m_size, s, n * char_size);
+    m_size += n * char_size;
+  }
+}
+
+void log_record::commit() noexcept
+{
+  // records logged during static destruction have nowhere to go
+  if (g_logger_state.load(std::memory_order_relaxed) == destroyed)
+  {
+    return;
+  }
+
+  auto* ring = thread_ring();
+  if (ring->used() > log_ring::capacity / 2)
+  {
+    get_logger().wake();
+  }
+  // a full ring means the writer is behind; wait rather than lose records
+  while (!ring->push(m_data, m_size))
+  {
+    get_logger().wake();
+    std::this_thread::yield();
+  }
+}
+
+void log_flush() noexcept
+{
+  if (g_logger_state.load() == running)
+  {
+    get_logger().flush();
+  }
+}
+
+} // namespace aura
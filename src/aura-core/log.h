@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <system_error>
+#include <type_traits>
+
+// Levels below this are compiled out, arguments and all:
+// 0 trace (AURA_ENTER), 1 debug, 2 info (AURA_LOG), 3 error (AURA_ERROR, AURA_ASSERT),
+// 4 nothing at all
+#ifndef AURA_MIN_LOG_LEVEL
+# define AURA_MIN_LOG_LEVEL 0
+#endif
+
+namespace aura
+{
+
+enum class log_level : int
+{
+  trace,
+  debug,
+  info,
+  error
+};
+
+constexpr bool log_enabled(log_level level) noexcept
+{
+  return static_cast<int>(level) >= AURA_MIN_LOG_LEVEL;
+}
+
+//! Everything about a log statement that is known at compile time. Each
+//! call site has one; its address identifies the statement in the log ring.
+struct log_site
+{
+  log_level level;
+  wchar_t glyph;          //!< printed ahead of the message
+  wchar_t const* format;  //!< printf-style, as for wprintf
+};
+
+//! Type of an argument as stored in a record
+enum class log_arg : std::uint8_t
+{
+  i32,   //!< int and everything that promotes to it
+  u32,
+  i64,
+  u64,
+  f64,
+  str,   //!< char const*, copied
+  wstr,  //!< wchar_t const*, copied
+  ptr,
+  error  //!< std::error_code, printed by %hs as its message
+};
+
+//! How a std::error_code is stored in a record
+struct log_error_arg
+{
+  int value;
+  std::error_category const* category;
+};
+
+//! Builds one record on the stack: the site, a timestamp and the raw
+//! arguments. Strings are copied (and truncated if the record fills up)
+//! since they may not outlive the call.
+class log_record
+{
+public:
+  static constexpr size_t max_size = 1024;
+
+  explicit log_record(log_site const& site) noexcept;
+
+  template <typename T>
+  void add(T const& value) noexcept
+  {
+    if constexpr (std::is_enum_v<T>)
+    {
+      add(static_cast<std::underlying_type_t<T>>(value));
+    }
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+      if constexpr (sizeof(T) <= 4)
+      {
+        put(log_arg::i32, static_cast<std::int32_t>(value));
+      }
+      else
+      {
+        put(log_arg::i64, static_cast<std::int64_t>(value));
+      }
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+      if constexpr (sizeof(T) < 4)
+      {
+        put(log_arg::i32, static_cast<std::int32_t>(value));
+      }
+      else if constexpr (sizeof(T) == 4)
+      {
+        put(log_arg::u32, static_cast<std::uint32_t>(value));
+      }
+      else
+      {
+        put(log_arg::u64, static_cast<std::uint64_t>(value));
+      }
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+      put(log_arg::f64, static_cast<double>(value));
+    }
+    else if constexpr (std::is_same_v<T, std::error_code>)
+    {
+      // categories are static objects; the message is looked up by the
+      // writer, so logging an error doesn't allocate
+      put(log_arg::error, log_error_arg{value.value(), &value.category()});
+    }
+    else if constexpr (std::is_convertible_v<T, char const*>)
+    {
+      add_string(log_arg::str, static_cast<char const*>(value), sizeof(char));
+    }
+    else if constexpr (std::is_convertible_v<T, wchar_t const*>)
+    {
+      add_string(log_arg::wstr, static_cast<wchar_t const*>(value), sizeof(wchar_t));
+    }
+    else
+    {
+      static_assert(std::is_pointer_v<T>, "log arguments must be what wprintf accepts");
+      put(log_arg::ptr, reinterpret_cast<std::uintptr_t>(value));
+    }
+  }
+
+  //! Hands the record to the background writer. Waits for room if the
+  //! writer has fallen a whole ring behind this thread.
+  void commit() noexcept;
+
+private:
+  template <typename T>
+  void put(log_arg kind, T value) noexcept
+  {
+    if (m_size + 1 + sizeof(T) > max_size)
+    {
+      return;
+    }
+    m_data[m_size++] = static_cast<char>(kind);
+    std::memcpy(m_data + m_size, &value, sizeof(T));
+    m_size += sizeof(T);
+  }
+
+  void add_string(log_arg kind, void const* s, size_t char_size) noexcept;
+
+  alignas(8) char m_data[max_size];
+  size_t m_size{0};
+};
+
+template <typename... Args>
+void log_write(log_site const& site, Args const&... args) noexcept
+{
+  log_record r{site};
+  (r.add(args), ...);
+  r.commit();
+}
+
+//! Waits until everything logged so far has been written out
+void log_flush() noexcept;
+
+//! Logs the exit from a scope entered with AURA_ENTER
+template <bool Enabled>
+struct scope_log
+{
+  explicit scope_log(char const*) noexcept {}
+};
+
+template <>
+struct scope_log<true>
+{
+  explicit scope_log(char const* func) noexcept : func{func} {}
+
+  ~scope_log()
+  {
+    static constexpr log_site site{log_level::trace, 192, L"%hs(..) "};
+    log_write(site, func);
+  }
+
+  char const* func;
+};
+
+} // namespace aura
+
+//! Logs at 'level' unless it is compiled out
+#define AURA_LOG_AT(level, glyph, format, ...) \
+  do \
+  { \
+    if constexpr (::aura::log_enabled(level)) \
+    { \
+      static constexpr ::aura::log_site aura_log_site_{level, glyph, format}; \
+      ::aura::log_write(aura_log_site_, ##__VA_ARGS__); \
+    } \
+  } while (false)
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace aura
+{
+
+// Heap bytes held directly by a string or container: what is allocated,
+// not what is in use. Bytes the elements hold themselves are for the
+// caller to add. Hash containers are estimated from their node and bucket
+// counts, since their node layout is up to the library.
+
+template <typename Char>
+size_t heap_bytes(std::basic_string<Char> const& s) noexcept
+{
+  // short strings live inside the object
+  static size_t const inline_capacity = std::basic_string<Char>{}.capacity();
+  return s.capacity() > inline_capacity ? (s.capacity() + 1) * sizeof(Char) : 0;
+}
+
+template <typename T>
+size_t heap_bytes(std::vector<T> const& v) noexcept
+{
+  return v.capacity() * sizeof(T);
+}
+
+template <typename Map>
+size_t hash_table_bytes(Map const& m) noexcept
+{
+  // a node is the value plus a link; buckets are one pointer each
+  return m.size() * (sizeof(typename Map::value_type) + sizeof(void*)) + m.bucket_count() * sizeof(void*);
+}
+
+//! What a session's engine costs in memory, by part
+struct session_footprint
+{
+  size_t engine{0};         //!< the engine object itself
+  size_t players{0};        //!< player records, less their hands and lanes
+  size_t hands{0};
+  size_t lanes{0};
+  size_t picks{0};
+  size_t draft_choices{0};
+  size_t effect_maps{0};    //!< card uid -> primary, deploy and death actions
+  size_t terrain{0};
+  size_t ruleset{0};        //!< the engine's copy of the rules, decks included
+
+  size_t total() const noexcept
+  {
+    return engine + players + hands + lanes + picks + draft_choices + effect_maps + terrain + ruleset;
+  }
+
+  session_footprint& operator+=(session_footprint const& other) noexcept
+  {
+    engine += other.engine;
+    players += other.players;
+    hands += other.hands;
+    lanes += other.lanes;
+    picks += other.picks;
+    draft_choices += other.draft_choices;
+    effect_maps += other.effect_maps;
+    terrain += other.terrain;
+    ruleset += other.ruleset;
+    return *this;
+  }
+
+  session_footprint& operator-=(session_footprint const& other) noexcept
+  {
+    engine -= other.engine;
+    players -= other.players;
+    hands -= other.hands;
+    lanes -= other.lanes;
+    picks -= other.picks;
+    draft_choices -= other.draft_choices;
+    effect_maps -= other.effect_maps;
+    terrain -= other.terrain;
+    ruleset -= other.ruleset;
+    return *this;
+  }
+};
+
+} // namespace aura
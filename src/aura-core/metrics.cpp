@@ -0,0 +1,328 @@
+#include "metrics.h"
+#include "platform.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace aura
+{
+
+namespace
+{
+
+constexpr int max_counters = 512;
+constexpr int max_gauges = 128;
+constexpr int max_histograms = 64;
+
+//! Only the owning thread writes, so a relaxed load and store is enough
+void bump(std::atomic<std::uint64_t>& value, std::uint64_t n) noexcept
+{
+  value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+struct histogram_shard
+{
+  std::atomic<std::uint64_t> counts[histogram::num_buckets]{};
+  std::atomic<std::uint64_t> sum{0};
+  std::atomic<std::uint64_t> min{~0ull};
+  std::atomic<std::uint64_t> max{0};
+
+  void add_to(histogram& h) const noexcept
+  {
+    std::uint64_t c[histogram::num_buckets];
+    for (int i = 0; i < histogram::num_buckets; ++i)
+    {
+      c[i] = counts[i].load(std::memory_order_relaxed);
+    }
+    h.record_buckets(c, sum.load(std::memory_order_relaxed), min.load(std::memory_order_relaxed),
+      max.load(std::memory_order_relaxed));
+  }
+};
+
+struct metric_shard
+{
+  ~metric_shard()
+  {
+    for (auto& h : histograms)
+    {
+      delete h.load();
+    }
+  }
+
+  std::atomic<std::uint64_t> counters[max_counters]{};
+  std::atomic<histogram_shard*> histograms[max_histograms]{};
+};
+
+struct metric_definition
+{
+  char const* name;
+  char label[64];
+  size_t label_size;
+
+  std::string_view label_view() const noexcept { return {label, label_size}; }
+};
+
+struct metric_registry
+{
+  std::mutex mutex;
+  std::vector<metric_definition> counters;
+  std::vector<metric_definition> gauges;
+  std::vector<metric_definition> histograms;
+  std::vector<metric_shard*> shards;
+
+  //! What threads that have exited recorded
+  std::uint64_t retired_counters[max_counters]{};
+  std::vector<histogram> retired_histograms = std::vector<histogram>(max_histograms);
+
+  std::atomic<std::int64_t> gauge_values[max_gauges]{};
+
+  metric_registry()
+  {
+    counters.reserve(max_counters);
+    gauges.reserve(max_gauges);
+    histograms.reserve(max_histograms);
+  }
+
+  int define(std::vector<metric_definition>& defs, int max, char const* name, std::string_view label)
+  {
+    label = label.substr(0, sizeof(metric_definition::label) - 1);
+    std::lock_guard lock{mutex};
+    auto const it = std::find_if(defs.begin(), defs.end(), [&](auto const& d)
+    {
+      return std::strcmp(d.name, name) == 0 && d.label_view() == label;
+    });
+    if (it != defs.end())
+    {
+      return static_cast<int>(it - defs.begin());
+    }
+    if (static_cast<int>(defs.size()) == max)
+    {
+      std::fprintf(stderr, "Too many metrics, dropping %s{%.*s}\n", name, static_cast<int>(label.size()), label.data());
+      return -1;
+    }
+    auto& d = defs.emplace_back();
+    d.name = name;
+    if (!label.empty())
+    {
+      std::memcpy(d.label, label.data(), label.size());
+    }
+    d.label_size = label.size();
+    return static_cast<int>(defs.size() - 1);
+  }
+};
+
+metric_registry& registry()
+{
+  static metric_registry r;
+  return r;
+}
+
+//! Folds a thread's shard into the registry when the thread exits
+struct shard_owner
+{
+  ~shard_owner()
+  {
+    auto& r = registry();
+    std::lock_guard lock{r.mutex};
+    for (int i = 0; i < max_counters; ++i)
+    {
+      r.retired_counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < max_histograms; ++i)
+    {
+      if (auto const* h = shard.histograms[i].load())
+      {
+        h->add_to(r.retired_histograms[i]);
+      }
+    }
+    r.shards.erase(std::find(r.shards.begin(), r.shards.end(), &shard));
+  }
+
+  metric_shard shard;
+};
+
+thread_local metric_shard* t_shard = nullptr;
+
+metric_shard& make_thread_shard()
+{
+  thread_local shard_owner owner;
+  auto& r = registry();
+  std::lock_guard lock{r.mutex};
+  r.shards.push_back(&owner.shard);
+  t_shard = &owner.shard;
+  return owner.shard;
+}
+
+metric_shard& thread_shard() noexcept
+{
+  return t_shard ? *t_shard : make_thread_shard();
+}
+
+histogram_shard* make_histogram_shard(metric_shard& shard, int index)
+{
+  auto* h = new histogram_shard;
+  shard.histograms[index].store(h, std::memory_order_release);
+  return h;
+}
+
+void write_line(std::string& out, std::string const& name, char const* suffix, std::string const& label,
+  char const* extra_label, double value)
+{
+  char buffer[64];
+  out += name;
+  out += suffix;
+  if (!label.empty() || *extra_label)
+  {
+    out += '{';
+    out += label;
+    if (!label.empty() && *extra_label)
+    {
+      out += ',';
+    }
+    out += extra_label;
+    out += '}';
+  }
+  std::snprintf(buffer, sizeof(buffer), " %.17g\n", value);
+  out += buffer;
+}
+
+void write_type(std::string& out, std::string const& name, char const* type, std::string& last_name)
+{
+  // a family's samples are contiguous, so one TYPE line covers every label
+  if (name != last_name)
+  {
+    out += "# TYPE " + name + " " + type + "\n";
+    last_name = name;
+  }
+}
+
+} // namespace {}
+
+metric_counter::metric_counter(char const* name, std::string_view label)
+  : m_index{registry().define(registry().counters, max_counters, name, label)}
+{
+}
+
+void metric_counter::add(std::uint64_t n) const noexcept
+{
+  if (m_index >= 0)
+  {
+    bump(thread_shard().counters[m_index], n);
+  }
+}
+
+metric_gauge::metric_gauge(char const* name, std::string_view label)
+{
+  auto const index = registry().define(registry().gauges, max_gauges, name, label);
+  // an unregistered gauge still needs somewhere to write
+  static std::atomic<std::int64_t> sink{0};
+  m_value = index >= 0 ? &registry().gauge_values[index] : &sink;
+}
+
+metric_histogram::metric_histogram(char const* name, std::string_view label)
+  : m_index{registry().define(registry().histograms, max_histograms, name, label)}
+{
+}
+
+void metric_histogram::record(std::uint64_t value) const noexcept
+{
+  if (m_index < 0)
+  {
+    return;
+  }
+  auto& shard = thread_shard();
+  auto* h = shard.histograms[m_index].load(std::memory_order_relaxed);
+  if (!h)
+  {
+    h = make_histogram_shard(shard, m_index);
+  }
+  bump(h->counts[histogram::bucket_index(value)], 1);
+  bump(h->sum, value);
+  if (value < h->min.load(std::memory_order_relaxed))
+  {
+    h->min.store(value, std::memory_order_relaxed);
+  }
+  if (value > h->max.load(std::memory_order_relaxed))
+  {
+    h->max.store(value, std::memory_order_relaxed);
+  }
+}
+
+metrics_snapshot take_metrics_snapshot()
+{
+  auto& r = registry();
+  metrics_snapshot s;
+  {
+    std::lock_guard lock{r.mutex};
+    for (size_t i = 0; i < r.counters.size(); ++i)
+    {
+      auto total = r.retired_counters[i];
+      for (auto const* shard : r.shards)
+      {
+        total += shard->counters[i].load(std::memory_order_relaxed);
+      }
+      s.counters.push_back({r.counters[i].name, std::string{r.counters[i].label_view()}, static_cast<std::int64_t>(total)});
+    }
+    for (size_t i = 0; i < r.gauges.size(); ++i)
+    {
+      s.gauges.push_back({r.gauges[i].name, std::string{r.gauges[i].label_view()},
+        r.gauge_values[i].load(std::memory_order_relaxed)});
+    }
+    for (size_t i = 0; i < r.histograms.size(); ++i)
+    {
+      metric_distribution d{r.histograms[i].name, std::string{r.histograms[i].label_view()}, r.retired_histograms[i]};
+      for (auto const* shard : r.shards)
+      {
+        if (auto const* h = shard->histograms[i].load(std::memory_order_acquire))
+        {
+          h->add_to(d.values);
+        }
+      }
+      s.histograms.push_back(std::move(d));
+    }
+  }
+
+  if (auto const [error, usage] = get_process_usage(current_process_id()); !error)
+  {
+    s.gauges.push_back({"aura_process_cpu_ns", {}, static_cast<std::int64_t>(usage.cpu_time.count())});
+    s.gauges.push_back({"aura_process_resident_bytes", {}, static_cast<std::int64_t>(usage.resident_bytes)});
+  }
+
+  auto const by_name = [](auto const& a, auto const& b) { return a.name < b.name; };
+  std::stable_sort(s.counters.begin(), s.counters.end(), by_name);
+  std::stable_sort(s.gauges.begin(), s.gauges.end(), by_name);
+  std::stable_sort(s.histograms.begin(), s.histograms.end(), by_name);
+  return s;
+}
+
+std::string format_metrics(metrics_snapshot const& snapshot)
+{
+  std::string out;
+  std::string last_name;
+  for (auto const& c : snapshot.counters)
+  {
+    write_type(out, c.name, "counter", last_name);
+    write_line(out, c.name, "", c.label, "", static_cast<double>(c.value));
+  }
+  for (auto const& g : snapshot.gauges)
+  {
+    write_type(out, g.name, "gauge", last_name);
+    write_line(out, g.name, "", g.label, "", static_cast<double>(g.value));
+  }
+  for (auto const& h : snapshot.histograms)
+  {
+    write_type(out, h.name, "summary", last_name);
+    for (auto const& [quantile, percentile] : {std::pair{"quantile=\"0.5\"", 50.0}, {"quantile=\"0.99\"", 99.0},
+      {"quantile=\"0.999\"", 99.9}, {"quantile=\"1\"", 100.0}})
+    {
+      write_line(out, h.name, "", h.label, quantile, static_cast<double>(h.values.value_at_percentile(percentile)));
+    }
+    write_line(out, h.name, "_sum", h.label, "", static_cast<double>(h.values.sum()));
+    write_line(out, h.name, "_count", h.label, "", static_cast<double>(h.values.count()));
+  }
+  return out;
+}
+
+} // namespace aura
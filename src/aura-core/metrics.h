@@ -0,0 +1,89 @@
+#pragma once
+
+#include <aura-core/histogram.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aura
+{
+
+//! Process-wide metrics, cheap enough to leave on in production.
+//!
+//! Counters and histograms are sharded per thread: recording touches only
+//! the calling thread's shard, with relaxed loads and stores and no lock or
+//! read-modify-write. metrics_snapshot() adds the shards up. Metrics are
+//! normally defined once at namespace scope next to the code they measure.
+//! Defining the same name and label twice yields the same metric.
+//!
+//! Names must outlive the process, e.g. literals. A label is a Prometheus
+//! label set without the braces, e.g. type="deploy", of up to 63 characters.
+//! Defining a metric doesn't allocate once the registry is up, so a static
+//! metric can be defined on a hot path.
+
+class metric_counter
+{
+public:
+  explicit metric_counter(char const* name, std::string_view label = {});
+
+  void add(std::uint64_t n = 1) const noexcept;
+
+private:
+  int m_index;
+};
+
+//! A value that goes up and down, e.g. live sessions. Gauges are rarely
+//! written, so they are a single shared atomic rather than sharded.
+class metric_gauge
+{
+public:
+  explicit metric_gauge(char const* name, std::string_view label = {});
+
+  void set(std::int64_t value) const noexcept { m_value->store(value, std::memory_order_relaxed); }
+
+  void add(std::int64_t n) const noexcept { m_value->fetch_add(n, std::memory_order_relaxed); }
+
+private:
+  std::atomic<std::int64_t>* m_value;
+};
+
+class metric_histogram
+{
+public:
+  explicit metric_histogram(char const* name, std::string_view label = {});
+
+  void record(std::uint64_t value) const noexcept;
+
+private:
+  int m_index;
+};
+
+struct metric_sample
+{
+  std::string name;
+  std::string label;
+  std::int64_t value{};
+};
+
+struct metric_distribution
+{
+  std::string name;
+  std::string label;
+  histogram values;
+};
+
+struct metrics_snapshot
+{
+  std::vector<metric_sample> counters;
+  std::vector<metric_sample> gauges;  //!< includes the process's CPU time and resident memory
+  std::vector<metric_distribution> histograms;
+};
+
+metrics_snapshot take_metrics_snapshot();
+
+//! Prometheus text exposition; histograms are written as summaries
+std::string format_metrics(metrics_snapshot const& snapshot);
+
+} // namespace aura
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
 
 // platform-specific defines
 
@@ -9,4 +17,92 @@ namespace aura
 // to utf8-string
 std::string to_utf8_string(std::wstring_view const& view);
 
+// writes straight to the process's standard output, bypassing stdio (whose
+// wide streams convert a character at a time)
+void write_stdout(std::wstring_view text) noexcept;
+
+// flushes a file's data all the way to the storage device
+std::error_code sync_file(std::FILE* file);
+
+// makes renames and creations in 'dir' durable
+std::error_code sync_directory(std::filesystem::path const& dir);
+
+// CPU time consumed by the calling thread
+std::chrono::nanoseconds thread_cpu_time() noexcept;
+
+// maps the named memory region shared by processes on this host, creating
+// it (zero-filled) if 'create' is set
+std::pair<std::error_code, void*> map_shared_memory(std::string const& name, size_t size, bool create);
+
+void unmap_shared_memory(void* data, size_t size) noexcept;
+
+// forgets the name; processes that mapped the region keep it
+void remove_shared_memory(std::string const& name) noexcept;
+
+// what futex_wait and futex_wake need besides the word to reach another
+// process. Linux keys a futex by the shared page, so there is nothing to
+// open; Windows can't wait on an address across processes and signals a
+// named event instead, which every process sharing the word opens under
+// the same name.
+class shared_wakeup
+{
+public:
+  shared_wakeup() = default;
+  ~shared_wakeup();
+
+  shared_wakeup(shared_wakeup&& other) noexcept : m_handle{std::exchange(other.m_handle, nullptr)} {}
+
+  shared_wakeup& operator=(shared_wakeup&& other) noexcept
+  {
+    std::swap(m_handle, other.m_handle);
+    return *this;
+  }
+
+  shared_wakeup(shared_wakeup const&) = delete;
+  shared_wakeup& operator=(shared_wakeup const&) = delete;
+
+  std::error_code open(std::string const& name);
+
+  void* handle() const noexcept { return m_handle; }
+
+private:
+  void* m_handle{nullptr};
+};
+
+// sleeps while 'word' (which may live in shared memory) still holds
+// 'expected', for up to 'timeout'. May return early.
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout,
+  shared_wakeup const& wakeup) noexcept;
+
+// wakes every futex_wait on 'word', in any process
+void futex_wake(std::atomic<std::uint32_t>& word, shared_wakeup const& wakeup) noexcept;
+
+// futex_wait for a word only threads of this process wait on, which the
+// system can key by address alone
+void wait_on_address(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout) noexcept;
+
+// wakes every wait_on_address on 'word'
+void wake_by_address(std::atomic<std::uint32_t>& word) noexcept;
+
+int current_process_id() noexcept;
+
+bool is_process_alive(int pid) noexcept;
+
+// resources used so far by a process on this host
+struct process_usage
+{
+  std::chrono::nanoseconds cpu_time{};  // user + kernel
+  std::uint64_t resident_bytes{};
+};
+
+std::pair<std::error_code, process_usage> get_process_usage(int pid);
+
+// stops Ctrl+C, SIGTERM and closing the console from ending the process, so
+// wait_for_stop_request() can shut it down cleanly instead. Call before
+// starting any thread.
+std::error_code catch_stop_requests();
+
+// blocks until the process is asked to stop; see catch_stop_requests()
+void wait_for_stop_request() noexcept;
+
 } // namespace aura
@@ -0,0 +1,62 @@
+#include "preset_registry.h"
+#include "aura-core/card_preset_definitions.h"
+#include <unordered_map>
+
+namespace aura
+{
+
+namespace
+{
+
+struct registry
+{
+  std::vector<card_preset const*> all;
+  std::unordered_map<std::wstring_view, int> by_name;
+
+  registry()
+  {
+    for (auto const* list : {&presets, &specials, static_cast<std::vector<card_preset> const*>(&loot)})
+    {
+      for (auto const& p : *list)
+      {
+        by_name.emplace(p.name, static_cast<int>(all.size()));
+        all.emplace_back(&p);
+      }
+    }
+  }
+};
+
+registry const& get_registry()
+{
+  static registry r;
+  return r;
+}
+
+} // namespace {}
+
+int preset_index(std::wstring_view name) noexcept
+{
+  auto const& r = get_registry();
+  if (auto const it = r.by_name.find(name); it != r.by_name.end())
+  {
+    return it->second;
+  }
+  return -1;
+}
+
+card_preset const* preset_at(int index) noexcept
+{
+  auto const& r = get_registry();
+  if (index < 0 || index >= static_cast<int>(r.all.size()))
+  {
+    return nullptr;
+  }
+  return r.all[index];
+}
+
+int num_presets() noexcept
+{
+  return static_cast<int>(get_registry().all.size());
+}
+
+} // namespace aura
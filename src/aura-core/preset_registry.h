@@ -0,0 +1,23 @@
+#pragma once
+
+#include <aura-core/card_preset.h>
+#include <string_view>
+
+namespace aura
+{
+
+//! Stable index of the preset (from presets, specials or loot) with the given
+//! name, or -1 if no preset has that name.
+//!
+//! Preset cids are assigned during static initialization and are not stable
+//! across translation units, so anything that leaves the process (wire
+//! messages, snapshots) refers to presets through this index instead.
+int preset_index(std::wstring_view name) noexcept;
+
+//! Preset at 'index' as returned by preset_index(), or nullptr
+card_preset const* preset_at(int index) noexcept;
+
+//! Total number of presets known to the registry
+int num_presets() noexcept;
+
+} // namespace aura
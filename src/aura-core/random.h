@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace aura
+{
+
+//! splitmix64 generator. Its whole state is a single integer, so it can be
+//! saved with a session and a game replays identically from the same seed.
+struct random_engine
+{
+  std::uint64_t state{};
+
+  std::uint64_t next() noexcept
+  {
+    auto z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  //! Uniform integer in [0, n)
+  std::uint64_t below(std::uint64_t n) noexcept
+  {
+    return n ? next() % n : 0;
+  }
+};
+
+//! Non-deterministic seed for games that don't ask for a specific one
+inline std::uint64_t make_random_seed()
+{
+  std::random_device rd;
+  auto const t = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  return (static_cast<std::uint64_t>(rd()) << 32) ^ rd() ^ t;
+}
+
+} // namespace aura
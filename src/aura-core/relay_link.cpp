@@ -0,0 +1,81 @@
+#include "relay_link.h"
+#include "aura-core/build.h"
+#include "aura-core/serialization.h"
+#include "aura-core/rest_messages.h"
+
+namespace aura
+{
+
+relay_link::relay_link(client_transport& transport, int session_id, int seat, std::uint64_t seat_token,
+  std::chrono::milliseconds poll_interval)
+  : m_transport{transport}
+  , m_session_id{session_id}
+  , m_seat{seat}
+  , m_seat_token{seat_token}
+  , m_poll_interval{poll_interval}
+{
+}
+
+std::pair<std::error_code, std::uint64_t> relay_link::connect()
+{
+  auto const e = exchange({});
+  return {e, m_seed};
+}
+
+std::error_code relay_link::send(std::string_view message)
+{
+  byte_writer w;
+  w.write_string(message);
+  return exchange(std::move(w.buffer));
+}
+
+std::optional<std::string> relay_link::poll()
+{
+  if (m_inbox.empty() && std::chrono::steady_clock::now() - m_last_exchange >= m_poll_interval)
+  {
+    exchange({});
+  }
+  if (m_inbox.empty())
+  {
+    return std::nullopt;
+  }
+  auto message = std::move(m_inbox.front());
+  m_inbox.pop_front();
+  return message;
+}
+
+std::error_code relay_link::exchange(std::string messages)
+{
+  // the stream can't be picked up again past a failed request
+  if (m_error)
+  {
+    return m_error;
+  }
+  m_last_exchange = std::chrono::steady_clock::now();
+  auto const response = rest::relay_lockstep::make_request(m_transport,
+    {m_session_id, m_seat_token, m_seat, m_taken, std::move(messages)});
+  if (auto const e = response.error ? response.error : response.value.error)
+  {
+    AURA_ERROR(e, L"Session %d: the server did not relay for seat %d", m_session_id, m_seat);
+    m_error = e;
+    return e;
+  }
+
+  m_seed = response.value.seed;
+  byte_reader r{response.value.messages};
+  while (!r.at_end())
+  {
+    auto message = r.read_string();
+    if (r.failed)
+    {
+      m_error = r.error();
+      AURA_ERROR(m_error, L"Session %d: malformed messages from the relay", m_session_id);
+      return m_error;
+    }
+    m_inbox.push_back(std::move(message));
+  }
+  m_taken += response.value.messages.size();
+  return {};
+}
+
+} // namespace aura
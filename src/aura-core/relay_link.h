@@ -0,0 +1,58 @@
+#pragma once
+
+#include <aura-core/client_transport.h>
+#include <aura-core/lockstep_link.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace aura
+{
+
+//! lockstep_link through the game server, for the two seats of a
+//! game_mode::lockstep session. Messages go out with rest::relay_lockstep
+//! as they are sent; the server keeps them until the peer asks. Every
+//! request also picks up what the peer sent, and poll() asks on its own
+//! once 'poll_interval' has passed since the last request.
+//!
+//! To be used from one thread, like the lockstep_rules_engine on top of it.
+class relay_link : public lockstep_link
+{
+public:
+  //! 'seat' and 'seat_token' are the ones new_session handed out
+  relay_link(client_transport& transport, int session_id, int seat, std::uint64_t seat_token,
+    std::chrono::milliseconds poll_interval = std::chrono::milliseconds{200});
+
+  //! Asks the server for the seed both ends start the game from
+  std::pair<std::error_code, std::uint64_t> connect();
+
+  std::error_code send(std::string_view message) override;
+
+  std::optional<std::string> poll() override;
+
+private:
+  //! Sends 'messages' and takes whatever the peer sent since last time
+  std::error_code exchange(std::string messages);
+
+  client_transport& m_transport;
+  int const m_session_id;
+  int const m_seat;
+  std::uint64_t const m_seat_token;
+  std::chrono::milliseconds const m_poll_interval;
+
+  std::uint64_t m_seed{0};
+
+  //! Bytes of our stream on the server read so far
+  std::uint64_t m_taken{0};
+
+  std::deque<std::string> m_inbox;
+  std::chrono::steady_clock::time_point m_last_exchange{};
+  std::error_code m_error;
+};
+
+} // namespace aura
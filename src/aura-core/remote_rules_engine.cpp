@@ -0,0 +1,310 @@
+#include "remote_rules_engine.h"
+#include "aura-core/card_preset.h"
+#include "aura-core/build.h"
+#include "aura-core/session_digest.h"
+#include "aura-core/rest_messages.h"
+#include <algorithm>
+#include <chrono>
+
+namespace aura
+{
+
+namespace {
+
+//! How often an idle engine asks the server whether the session moved on
+constexpr auto poll_interval = std::chrono::milliseconds{200};
+
+} // namespace {}
+
+remote_rules_engine::remote_rules_engine(client_transport& transport, int session_id, std::uint64_t seat_token)
+  : m_transport{transport}
+  , m_session_id{session_id}
+  , m_seat_token{seat_token}
+{
+  if (auto const e = resync())
+  {
+    AURA_ERROR(e, L"Couldn't fetch session %d from the server", session_id);
+    m_deferred_error = e;
+  }
+  m_sender = std::thread{[this] { send_loop(); }};
+}
+
+remote_rules_engine::~remote_rules_engine()
+{
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  if (m_sender.joinable())
+  {
+    m_sender.join();
+  }
+}
+
+bool remote_rules_engine::is_game_over() const noexcept
+{
+  std::lock_guard lock{m_mutex};
+  return m_predicted && m_predicted->is_game_over();
+}
+
+session_info const& remote_rules_engine::get_session_info() const
+{
+  std::lock_guard lock{m_mutex};
+  if (m_predicted && m_view_generation != m_generation)
+  {
+    m_view = redact_for_seats(m_predicted->get_session_info(), m_seats);
+    m_view_generation = m_generation;
+  }
+  return m_view;
+}
+
+std::vector<int> remote_rules_engine::get_target_list(int uid) const
+{
+  std::lock_guard lock{m_mutex};
+  return m_predicted ? m_predicted->get_target_list(uid) : std::vector<int>{};
+}
+
+std::error_code remote_rules_engine::commit_action(player_action const& action)
+{
+  std::unique_lock lock{m_mutex};
+  m_cv.wait(lock, [&] { return m_stop || !m_awaiting_server; });
+  if (auto const e = std::exchange(m_deferred_error, {}))
+  {
+    // the action was chosen from a state that the server never reached
+    return e;
+  }
+  if (!m_predicted)
+  {
+    return make_error_code(std::errc::not_connected);
+  }
+
+  if (!can_predict(action))
+  {
+    if (m_predicted->is_game_over())
+    {
+      return make_error_code(rules_error::not_legal);
+    }
+    m_unconfirmed.push_back({action, 0, false});
+    m_awaiting_server = true;
+    lock.unlock();
+    m_cv.notify_all();
+    return {};
+  }
+
+  // the server runs the same engine from the same state, so what it rejects
+  // is rejected here without a round trip
+  if (auto const e = m_predicted->commit_action(action))
+  {
+    return e;
+  }
+  ++m_generation;
+  m_unconfirmed.push_back({action, hash_session(redact_for_seats(m_predicted->get_session_info(), m_seats)), true});
+  lock.unlock();
+  m_cv.notify_all();
+  return {};
+}
+
+card_info remote_rules_engine::to_card_info(card_preset const& preset, int cid)
+{
+  return make_card_info(preset, generate_uid(), cid);
+}
+
+std::error_code remote_rules_engine::trigger_pick_action(int /*num_picks*/, int /*num_choices*/)
+{
+  return make_error_code(std::errc::operation_not_supported);
+}
+
+std::wstring remote_rules_engine::describe(unit_traits trait) const noexcept
+{
+  return describe_trait(trait);
+}
+
+void remote_rules_engine::sync() const
+{
+  std::unique_lock lock{m_mutex};
+  m_cv.wait(lock, [&] { return m_stop || (m_unconfirmed.empty() && !m_awaiting_server); });
+}
+
+int remote_rules_engine::version() const noexcept
+{
+  std::lock_guard lock{m_mutex};
+  return m_version;
+}
+
+int remote_rules_engine::num_resyncs() const noexcept
+{
+  std::lock_guard lock{m_mutex};
+  return m_num_resyncs;
+}
+
+bool remote_rules_engine::can_predict(player_action const& action) noexcept
+{
+  return action.type != action_type::end_turn;
+}
+
+std::error_code remote_rules_engine::resync()
+{
+  auto response = std::invoke([&]
+  {
+    std::lock_guard lock{m_transport_mutex};
+    return rest::get_session_info::make_request(m_transport, {m_session_id, m_seat_token, true});
+  });
+  if (auto const e = response.error ? response.error : response.value.error)
+  {
+    return e;
+  }
+
+  auto [restore_error, engine] = local_rules_engine::restore(response.value.snapshot);
+  if (restore_error)
+  {
+    return restore_error;
+  }
+
+  std::lock_guard lock{m_mutex};
+  if (m_predicted && !m_awaiting_server)
+  {
+    ++m_num_resyncs;
+  }
+  m_predicted = std::make_unique<local_rules_engine>(std::move(engine));
+  m_seats = response.value.seats;
+  m_awaiting_server = false;
+  m_diverged = false;
+  m_version = response.value.version;
+  ++m_generation;
+  if (!m_unconfirmed.empty())
+  {
+    // committed while the request was out, against the old prediction
+    m_unconfirmed.clear();
+    if (!m_deferred_error)
+    {
+      m_deferred_error = make_error_code(std::errc::operation_canceled);
+    }
+  }
+  m_cv.notify_all();
+  return {};
+}
+
+void remote_rules_engine::poll()
+{
+  auto const response = std::invoke([&]
+  {
+    std::lock_guard lock{m_transport_mutex};
+    return rest::get_session_info::make_request(m_transport, {m_session_id, m_seat_token, false});
+  });
+  if (response.error || response.value.error)
+  {
+    return;
+  }
+
+  auto const stale = std::invoke([&]
+  {
+    std::lock_guard lock{m_mutex};
+    return !m_predicted || m_diverged || m_awaiting_server || response.value.version != m_version;
+  });
+  if (stale)
+  {
+    if (auto const e = resync())
+    {
+      AURA_ERROR(e, L"Couldn't fetch session %d from the server", m_session_id);
+    }
+  }
+}
+
+void remote_rules_engine::send_loop()
+{
+  std::unique_lock lock{m_mutex};
+  while (true)
+  {
+    auto const has_pending = m_cv.wait_for(lock, poll_interval, [&] { return m_stop || !m_unconfirmed.empty(); });
+    if (m_stop)
+    {
+      return;
+    }
+    if (!has_pending)
+    {
+      lock.unlock();
+      poll();
+      lock.lock();
+      continue;
+    }
+
+    rest::commit_action::in batch{m_session_id, m_seat_token, {}};
+    batch.actions.reserve(m_unconfirmed.size());
+    for (auto const& p : m_unconfirmed)
+    {
+      batch.actions.push_back(p.action);
+    }
+    m_num_in_flight = batch.actions.size();
+    lock.unlock();
+
+    auto response = std::invoke([&]
+    {
+      std::lock_guard transport_lock{m_transport_mutex};
+      return rest::commit_action::make_request(m_transport, batch);
+    });
+
+    lock.lock();
+    auto const n = std::exchange(m_num_in_flight, 0);
+    auto const& out = response.value;
+    auto const& last = m_unconfirmed[n - 1];
+    // an action that couldn't be predicted has no digest, but the version
+    // still tells whether anybody else moved the session in between
+    if (!response.error && !out.error && out.num_applied == static_cast<int>(n)
+      && out.version == m_version + out.num_applied
+      && (!last.predicted || hash_session(out.session) == last.digest))
+    {
+      auto const predicted = last.predicted;
+      m_unconfirmed.erase(m_unconfirmed.begin(), m_unconfirmed.begin() + static_cast<std::ptrdiff_t>(n));
+      m_version = out.version;
+      if (!predicted)
+      {
+        // commit_action() waits until the server's state after it replaces
+        // the prediction
+        lock.unlock();
+        auto const e = resync();
+        lock.lock();
+        if (e)
+        {
+          AURA_ERROR(e, L"Couldn't fetch session %d from the server", m_session_id);
+          m_deferred_error = e;
+          m_awaiting_server = false;
+          m_diverged = true;
+        }
+      }
+      m_cv.notify_all();
+      continue;
+    }
+
+    if (response.error)
+    {
+      AURA_ERROR(response.error, L"Failed to send %zu action(s) to session %d", n, m_session_id);
+      m_deferred_error = response.error;
+    }
+    else if (out.error)
+    {
+      AURA_ERROR(out.error, L"Server rejected action %d of %zu", out.num_applied + 1, n);
+      m_deferred_error = out.error;
+    }
+    else
+    {
+      // someone else moved the session between our batches
+      m_deferred_error = make_error_code(std::errc::operation_canceled);
+      AURA_ERROR(m_deferred_error, L"Session %d diverged from the prediction at version %d", m_session_id,
+        out.version);
+    }
+    m_unconfirmed.clear();
+    m_awaiting_server = false;
+    m_diverged = true;
+    lock.unlock();
+
+    if (auto const e = resync())
+    {
+      AURA_ERROR(e, L"Couldn't fetch session %d from the server", m_session_id);
+    }
+    lock.lock();
+    m_cv.notify_all();
+  }
+}
+
+} // namespace aura
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <aura-core/rules_engine.h>
+#include <aura-core/local_rules_engine.h>
+#include <aura-core/session_info.h>
+#include <aura-core/player_action.h>
+#include <aura-core/client_transport.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aura
+{
+
+//! rules_engine backed by a session hosted on the game server.
+//!
+//! The engine predicts: it holds a local_rules_engine restored from the
+//! server's snapshot of the session and applies every committed action to
+//! it at once, so nothing the caller does waits for a round trip. A sender
+//! thread ships the actions committed so far to the server as a single
+//! batch and checks that the server ended up in the same state as the
+//! prediction. While nothing is queued it polls the server, so changes
+//! made by others (the opponent, timeouts) replace the prediction.
+//!
+//! The server only shows the seats of our token (see redact_for_seats) and
+//! keeps the decks and RNG to itself, so end_turn, which draws, can't be
+//! predicted. It is sent like any other action, but the prediction stays
+//! where it was until the server's state after it comes back, and the next
+//! commit_action() waits for that.
+//!
+//! If the server rejects a queued action or disagrees with the prediction,
+//! the remaining queue is dropped, the prediction is replaced by the
+//! server's state and the next call to commit_action() returns the error.
+//!
+//! The rules_engine interface is to be used from one thread.
+class remote_rules_engine : public rules_engine
+{
+public:
+  //! Fetches the session; failures are returned by the first commit_action().
+  //! 'seat_token' is the one new_session handed out.
+  remote_rules_engine(client_transport& transport, int session_id, std::uint64_t seat_token);
+
+  ~remote_rules_engine();
+
+  remote_rules_engine(remote_rules_engine const&) = delete;
+  remote_rules_engine& operator=(remote_rules_engine const&) = delete;
+
+  bool is_game_over() const noexcept override;
+
+  //! The predicted session. The reference is to a copy owned by the
+  //! caller's thread, which stays unchanged until the next call to
+  //! get_session_info().
+  session_info const& get_session_info() const override;
+
+  std::vector<int> get_target_list(int uid) const override;
+
+  //! Applies the action to the prediction and queues it for the server
+  std::error_code commit_action(player_action const&) override;
+
+  //! Cards made on the client are display-only; their actions run on the server
+  card_info to_card_info(card_preset const& preset, int cid) override;
+
+  //! Picks are triggered by the server only
+  std::error_code trigger_pick_action(int num_picks, int num_choices = 0) override;
+
+  std::wstring describe(unit_traits trait) const noexcept override;
+
+  //! Blocks until every action committed so far has been answered and the
+  //! prediction has caught up with them
+  void sync() const;
+
+  int session_id() const noexcept { return m_session_id; }
+
+  //! Number of actions the server has confirmed
+  int version() const noexcept;
+
+  //! Number of times the prediction was replaced by the server's state
+  int num_resyncs() const noexcept;
+
+private:
+  //! An action applied to the prediction but not yet confirmed
+  struct predicted_action
+  {
+    player_action action;
+
+    //! hash_session() of the prediction once the action was applied, as
+    //! the server shows it to us
+    std::uint64_t digest;
+
+    //! False if the prediction couldn't play the action (see above), so the
+    //! server's state after it is taken instead
+    bool predicted;
+  };
+
+  //! Whether the prediction can play 'action' without the decks and RNG
+  static bool can_predict(player_action const& action) noexcept;
+
+  //! Replaces the prediction with the server's current state
+  std::error_code resync();
+
+  //! Resyncs if the server's version moved on without us
+  void poll();
+
+  void send_loop();
+
+private:
+  client_transport& m_transport;
+  int const m_session_id;
+  std::uint64_t const m_seat_token;
+
+  //! Guards use of m_transport, which need not be thread-safe
+  mutable std::mutex m_transport_mutex;
+
+  mutable std::mutex m_mutex;
+  mutable std::condition_variable m_cv;
+
+  //! Null until the session could be fetched
+  std::unique_ptr<local_rules_engine> m_predicted;
+
+  //! Seats our token holds, as the server reported them
+  unsigned m_seats{0};
+
+  //! Set from sending an action that couldn't be predicted until the
+  //! server's state after it replaces the prediction
+  bool m_awaiting_server{false};
+
+  //! Bumped whenever m_predicted changes
+  std::uint64_t m_generation{0};
+
+  //! Set when the server didn't confirm the prediction, until a resync
+  //! replaces it
+  bool m_diverged{false};
+
+  //! Version of the last state confirmed by the server
+  int m_version{0};
+
+  //! Oldest first; the first m_num_in_flight have been sent
+  std::vector<predicted_action> m_unconfirmed;
+  size_t m_num_in_flight{0};
+
+  //! Rejection (or transport failure) to report on the next commit_action()
+  std::error_code m_deferred_error;
+
+  int m_num_resyncs{0};
+
+  //! What get_session_info() handed out, and the generation it was copied at
+  mutable session_info m_view;
+  mutable std::uint64_t m_view_generation{~std::uint64_t{0}};
+
+  bool m_stop{false};
+  std::thread m_sender;
+};
+
+} // namespace aura
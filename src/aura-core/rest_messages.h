@@ -0,0 +1,399 @@
+#pragma once
+
+#include <aura-core/ruleset.h>
+#include <aura-core/serialization.h>
+#include <aura-core/client_transport.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aura
+{
+
+namespace rest
+{
+
+// Messages between clients and aura_server. The server handles them in
+// aura-server/requests.h; clients send them with make_request().
+
+template <typename T>
+struct server_response
+{
+  std::error_code error;
+  T value;
+};
+
+//! Sends a request over 'transport' and decodes the server's reply
+template <typename Request>
+server_response<typename Request::out> make_request(client_transport& transport, typename Request::in const& info_in)
+{
+  auto const [error, body] = transport.request(Request::path, Request::to_string(info_in));
+  if (error)
+  {
+    return {error, {}};
+  }
+  auto [decode_error, out] = Request::to_out(body);
+  return {decode_error, std::move(out)};
+}
+
+template <typename T>
+std::pair<std::error_code, T> decode_message(std::string const& s) noexcept
+{
+  byte_reader r{s};
+  T t{};
+  read(r, t);
+  return {r.error(), std::move(t)};
+}
+
+template <typename T>
+std::string encode_message(T const& t) noexcept
+{
+  byte_writer w;
+  write(w, t);
+  return std::move(w.buffer);
+}
+
+// POST
+struct new_session
+{
+  static constexpr char const* path = "/new_session";
+
+  struct in
+  {
+    game_mode mode;
+    std::string player_name;
+    int rating; //!< used to pair players of similar skill
+  };
+
+  struct out
+  {
+    std::error_code error;
+    int session_id; //!< unique identifier for this session
+    int seat;       //!< index of this player in session_info::players
+    std::uint64_t seat_token; //!< sent with every request that acts for the seat
+    std::string matched_player_name;
+  };
+
+  static std::string to_string(in const& i) noexcept { return encode_message(i); }
+  static std::string to_string(out const& o) noexcept { return encode_message(o); }
+
+  static std::pair<std::error_code, in> to_in(std::string const& s) noexcept { return decode_message<in>(s); }
+  static std::pair<std::error_code, out> to_out(std::string const& s) noexcept { return decode_message<out>(s); }
+
+  //! Called by client
+  static server_response<out> make_request(client_transport& t, in const& info_in)
+  {
+    return rest::make_request<new_session>(t, info_in);
+  }
+};
+
+// GET
+struct get_session_info
+{
+  static constexpr char const* path = "/get_session_info";
+
+  struct in
+  {
+    int session_id;
+    std::uint64_t seat_token; //!< from new_session
+    bool with_snapshot{false};
+  };
+
+  //! Only what the seats of 'seat_token' may see; see redact_for_seats
+  struct out
+  {
+    std::error_code error;
+    int version;    //!< number of actions the server has applied to the session
+    unsigned seats; //!< bit i is set if the token holds seat i
+    session_info session;
+
+    //! local_rules_engine::snapshot_for_seats() at 'version' if the request
+    //! asked for it, so the client can predict what its actions will do
+    std::string snapshot;
+  };
+
+  static std::string to_string(in const& i) noexcept { return encode_message(i); }
+  static std::string to_string(out const& o) noexcept { return encode_message(o); }
+
+  static std::pair<std::error_code, in> to_in(std::string const& s) noexcept { return decode_message<in>(s); }
+  static std::pair<std::error_code, out> to_out(std::string const& s) noexcept { return decode_message<out>(s); }
+
+  //! Called by client
+  static server_response<out> make_request(client_transport& t, in const& info_in)
+  {
+    return rest::make_request<get_session_info>(t, info_in);
+  }
+};
+
+// POST
+struct commit_action
+{
+  static constexpr char const* path = "/commit_action";
+
+  //! A batch of actions applied in order; the server stops at the first
+  //! action that is not legal.
+  struct in
+  {
+    int session_id;
+    std::uint64_t seat_token; //!< from new_session; the seat must be the one to move
+    std::vector<player_action> actions;
+  };
+
+  struct out
+  {
+    std::error_code error; //!< error of the first rejected action (if any)
+    int num_applied;       //!< # of actions from the batch that were applied
+    int version;
+    session_info session;  //!< as the sender's seats may see it; see redact_for_seats
+  };
+
+  static std::string to_string(in const& i) noexcept { return encode_message(i); }
+  static std::string to_string(out const& o) noexcept { return encode_message(o); }
+
+  static std::pair<std::error_code, in> to_in(std::string const& s) noexcept { return decode_message<in>(s); }
+  static std::pair<std::error_code, out> to_out(std::string const& s) noexcept { return decode_message<out>(s); }
+
+  //! Called by client
+  static server_response<out> make_request(client_transport& t, in const& info_in)
+  {
+    return rest::make_request<commit_action>(t, info_in);
+  }
+};
+
+// GET
+struct get_target_list
+{
+  static constexpr char const* path = "/get_target_list";
+
+  struct in
+  {
+    int session_id;
+    std::uint64_t seat_token; //!< from new_session
+    int uid;
+  };
+
+  struct out
+  {
+    std::error_code error;
+    std::vector<int> targets;
+  };
+
+  static std::string to_string(in const& i) noexcept { return encode_message(i); }
+  static std::string to_string(out const& o) noexcept { return encode_message(o); }
+
+  static std::pair<std::error_code, in> to_in(std::string const& s) noexcept { return decode_message<in>(s); }
+  static std::pair<std::error_code, out> to_out(std::string const& s) noexcept { return decode_message<out>(s); }
+
+  //! Called by client
+  static server_response<out> make_request(client_transport& t, in const& info_in)
+  {
+    return rest::make_request<get_target_list>(t, info_in);
+  }
+};
+
+// POST
+struct relay_lockstep
+{
+  static constexpr char const* path = "/relay_lockstep";
+
+  //! Messages of a lockstep game on their way to the other seat. Each seat
+  //! reads the messages for it as one stream and says how far it got, so
+  //! the server can drop what was taken.
+  struct in
+  {
+    int session_id;
+    std::uint64_t seat_token; //!< from new_session
+    int seat;
+    std::uint64_t taken;      //!< bytes of the stream for 'seat' read so far
+    std::string messages;     //!< for the other seat, each one written with byte_writer::write_string
+  };
+
+  struct out
+  {
+    std::error_code error;
+    std::uint64_t seed;       //!< both ends start their engines from it
+    std::string messages;     //!< the stream for 'seat' from 'taken' on
+  };
+
+  static std::string to_string(in const& i) noexcept { return encode_message(i); }
+  static std::string to_string(out const& o) noexcept { return encode_message(o); }
+
+  static std::pair<std::error_code, in> to_in(std::string const& s) noexcept { return decode_message<in>(s); }
+  static std::pair<std::error_code, out> to_out(std::string const& s) noexcept { return decode_message<out>(s); }
+
+  //! Called by client
+  static server_response<out> make_request(client_transport& t, in const& info_in)
+  {
+    return rest::make_request<relay_lockstep>(t, info_in);
+  }
+};
+
+inline void write(byte_writer& w, new_session::in const& i)
+{
+  w.write_int(static_cast<int>(i.mode));
+  w.write_string(i.player_name);
+  w.write_int(i.rating);
+}
+
+inline void read(byte_reader& r, new_session::in& i)
+{
+  i.mode = static_cast<game_mode>(r.read_int());
+  i.player_name = r.read_string();
+  i.rating = static_cast<int>(r.read_int());
+}
+
+inline void write(byte_writer& w, new_session::out const& o)
+{
+  aura::write(w, o.error);
+  w.write_int(o.session_id);
+  w.write_int(o.seat);
+  w.write_int(static_cast<long long>(o.seat_token));
+  w.write_string(o.matched_player_name);
+}
+
+inline void read(byte_reader& r, new_session::out& o)
+{
+  aura::read(r, o.error);
+  o.session_id = static_cast<int>(r.read_int());
+  o.seat = static_cast<int>(r.read_int());
+  o.seat_token = static_cast<std::uint64_t>(r.read_int());
+  o.matched_player_name = r.read_string();
+}
+
+inline void write(byte_writer& w, get_session_info::in const& i)
+{
+  w.write_int(i.session_id);
+  w.write_int(static_cast<long long>(i.seat_token));
+  w.write_bool(i.with_snapshot);
+}
+
+inline void read(byte_reader& r, get_session_info::in& i)
+{
+  i.session_id = static_cast<int>(r.read_int());
+  i.seat_token = static_cast<std::uint64_t>(r.read_int());
+  i.with_snapshot = r.read_bool();
+}
+
+inline void write(byte_writer& w, get_session_info::out const& o)
+{
+  aura::write(w, o.error);
+  w.write_int(o.version);
+  w.write_int(o.seats);
+  aura::write(w, o.session);
+  w.write_string(o.snapshot);
+}
+
+inline void read(byte_reader& r, get_session_info::out& o)
+{
+  aura::read(r, o.error);
+  o.version = static_cast<int>(r.read_int());
+  o.seats = static_cast<unsigned>(r.read_int());
+  aura::read(r, o.session);
+  o.snapshot = r.read_string();
+}
+
+inline void write(byte_writer& w, commit_action::in const& i)
+{
+  w.write_int(i.session_id);
+  w.write_int(static_cast<long long>(i.seat_token));
+  aura::write(w, i.actions);
+}
+
+inline void read(byte_reader& r, commit_action::in& i)
+{
+  i.session_id = static_cast<int>(r.read_int());
+  i.seat_token = static_cast<std::uint64_t>(r.read_int());
+  aura::read(r, i.actions);
+}
+
+inline void write(byte_writer& w, commit_action::out const& o)
+{
+  aura::write(w, o.error);
+  w.write_int(o.num_applied);
+  w.write_int(o.version);
+  aura::write(w, o.session);
+}
+
+inline void read(byte_reader& r, commit_action::out& o)
+{
+  aura::read(r, o.error);
+  o.num_applied = static_cast<int>(r.read_int());
+  o.version = static_cast<int>(r.read_int());
+  aura::read(r, o.session);
+}
+
+inline void write(byte_writer& w, get_target_list::in const& i)
+{
+  w.write_int(i.session_id);
+  w.write_int(static_cast<long long>(i.seat_token));
+  w.write_int(i.uid);
+}
+
+inline void read(byte_reader& r, get_target_list::in& i)
+{
+  i.session_id = static_cast<int>(r.read_int());
+  i.seat_token = static_cast<std::uint64_t>(r.read_int());
+  i.uid = static_cast<int>(r.read_int());
+}
+
+inline void write(byte_writer& w, get_target_list::out const& o)
+{
+  aura::write(w, o.error);
+  w.write_int(static_cast<long long>(o.targets.size()));
+  for (auto const t : o.targets)
+  {
+    w.write_int(t);
+  }
+}
+
+inline void read(byte_reader& r, get_target_list::out& o)
+{
+  aura::read(r, o.error);
+  auto const n = r.read_int();
+  if (n < 0 || static_cast<size_t>(n) > r.buffer.size() - r.pos)
+  {
+    r.failed = true;
+    return;
+  }
+  o.targets.resize(static_cast<size_t>(n));
+  for (auto& t : o.targets)
+  {
+    t = static_cast<int>(r.read_int());
+  }
+}
+
+inline void write(byte_writer& w, relay_lockstep::in const& i)
+{
+  w.write_int(i.session_id);
+  w.write_int(static_cast<long long>(i.seat_token));
+  w.write_int(i.seat);
+  w.write_int(static_cast<long long>(i.taken));
+  w.write_string(i.messages);
+}
+
+inline void read(byte_reader& r, relay_lockstep::in& i)
+{
+  i.session_id = static_cast<int>(r.read_int());
+  i.seat_token = static_cast<std::uint64_t>(r.read_int());
+  i.seat = static_cast<int>(r.read_int());
+  i.taken = static_cast<std::uint64_t>(r.read_int());
+  i.messages = r.read_string();
+}
+
+inline void write(byte_writer& w, relay_lockstep::out const& o)
+{
+  aura::write(w, o.error);
+  w.write_int(static_cast<long long>(o.seed));
+  w.write_string(o.messages);
+}
+
+inline void read(byte_reader& r, relay_lockstep::out& o)
+{
+  aura::read(r, o.error);
+  o.seed = static_cast<std::uint64_t>(r.read_int());
+  o.messages = r.read_string();
+}
+
+} // namespace rest
+
+} // namespace aura
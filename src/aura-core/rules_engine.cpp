@@ -27,6 +27,26 @@ std::error_code make_error_code(rules_error e) noexcept
   return std::error_code{static_cast<int>(e), cat};
 }
 
+std::wstring describe_trait(unit_traits trait) noexcept
+{
+  switch (trait)
+  {
+  case unit_traits::aerial:  return L"aerial: traverses by air";
+  case unit_traits::structure: return L"structure: good for providing cover and bonuses";
+  case unit_traits::item: return L"item: can be applied to card on board";
+  case unit_traits::twice: return L"can act twice per turn";
+  case unit_traits::thrice: return L"can act three times per turn";
+  case unit_traits::assassin: return L"assassin: can attack same turn as deployment";
+  case unit_traits::long_range: return L"can attack from range (skipping lane obstructions)";
+  case unit_traits::healer: return L"heals friendly units";
+  case unit_traits::infantry: [[fallthrough]];
+  case unit_traits::player: [[fallthrough]];
+  default:
+    return L"";
+  }
+  return L"";
+}
+
 std::error_code start_game_session(ruleset const& rules, rules_engine& engine,
                                    display_engine& display) {
   display.clear_board();
@@ -30,6 +30,9 @@ enum class rules_error : int
 
 std::error_code make_error_code(rules_error e) noexcept;
 
+//! Human-readable description of a unit trait
+std::wstring describe_trait(unit_traits trait) noexcept;
+
 class rules_engine
 {
 public:
@@ -9,7 +9,8 @@ namespace aura
 enum class game_mode : int
 {
   PvP,
-  PvC
+  PvC,
+  lockstep  //!< PvP that both clients play out themselves; the server only relays their actions
 };
 
 struct ruleset
@@ -0,0 +1,451 @@
+#include "serialization.h"
+#include "aura-core/preset_registry.h"
+#include "aura-core/rules_engine.h"
+#include "aura-core/build.h"
+#include "aura-core/ruleset.h"
+#include <cstdint>
+#include <cstring>
+
+namespace aura
+{
+
+namespace
+{
+
+enum class error_category_id : int
+{
+  none,
+  rules,
+  generic,
+  system
+};
+
+void write_card_fields(byte_writer& w, card_info const& card)
+{
+  w.write_int(card.uid);
+  w.write_int(card.cid);
+  w.write_int(card.health);
+  w.write_int(card.starting_health);
+  w.write_int(card.strength);
+  w.write_int(card.starting_strength);
+  w.write_int(card.cost);
+  w.write_int(card.energy);
+  w.write_int(card.starting_energy);
+  w.write_int(card.fight_back);
+  w.write_bool(card.is_visible);
+  w.write_bool(card.on_preferred_terrain);
+  w.write_int(static_cast<int>(card.current_terrain));
+}
+
+void read_card_fields(byte_reader& r, card_info& card)
+{
+  card.uid = static_cast<int>(r.read_int());
+  card.cid = static_cast<int>(r.read_int());
+  card.health = static_cast<int>(r.read_int());
+  card.starting_health = static_cast<int>(r.read_int());
+  card.strength = static_cast<int>(r.read_int());
+  card.starting_strength = static_cast<int>(r.read_int());
+  card.cost = static_cast<int>(r.read_int());
+  card.energy = static_cast<int>(r.read_int());
+  card.starting_energy = static_cast<int>(r.read_int());
+  card.fight_back = static_cast<int>(r.read_int());
+  card.is_visible = r.read_bool();
+  card.on_preferred_terrain = r.read_bool();
+  card.current_terrain = static_cast<terrain_types>(r.read_int());
+}
+
+} // namespace {}
+
+void byte_writer::write_int(long long value)
+{
+  auto v = (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63);
+  while (v >= 0x80)
+  {
+    buffer.push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  buffer.push_back(static_cast<char>(v));
+}
+
+void byte_writer::write_float(float f)
+{
+  std::uint32_t bits{};
+  std::memcpy(&bits, &f, sizeof(bits));
+  write_int(bits);
+}
+
+void byte_writer::write_string(std::string_view s)
+{
+  write_int(static_cast<long long>(s.size()));
+  buffer.append(s.data(), s.size());
+}
+
+void byte_writer::write_wstring(std::wstring_view s)
+{
+  write_int(static_cast<long long>(s.size()));
+  for (auto const c : s)
+  {
+    write_int(static_cast<long long>(c));
+  }
+}
+
+long long byte_reader::read_int()
+{
+  unsigned long long v{};
+  for (int shift = 0; !failed; shift += 7)
+  {
+    if (at_end() || shift > 63)
+    {
+      failed = true;
+      return 0;
+    }
+    auto const byte = static_cast<unsigned char>(buffer[pos++]);
+    v |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+    {
+      return static_cast<long long>(v >> 1) ^ -static_cast<long long>(v & 1);
+    }
+  }
+  return 0;
+}
+
+bool byte_reader::read_bool()
+{
+  if (failed || at_end())
+  {
+    failed = true;
+    return false;
+  }
+  return buffer[pos++] != 0;
+}
+
+float byte_reader::read_float()
+{
+  auto const bits = static_cast<std::uint32_t>(read_int());
+  float f{};
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+std::string byte_reader::read_string()
+{
+  auto const n = read_int();
+  if (failed || n < 0 || static_cast<size_t>(n) > buffer.size() - pos)
+  {
+    failed = true;
+    return {};
+  }
+  std::string s{buffer.substr(pos, static_cast<size_t>(n))};
+  pos += static_cast<size_t>(n);
+  return s;
+}
+
+std::wstring byte_reader::read_wstring()
+{
+  auto const n = read_int();
+  if (failed || n < 0 || static_cast<size_t>(n) > buffer.size() - pos)
+  {
+    failed = true;
+    return {};
+  }
+  std::wstring s;
+  s.reserve(static_cast<size_t>(n));
+  for (long long i = 0; i < n && !failed; ++i)
+  {
+    s.push_back(static_cast<wchar_t>(read_int()));
+  }
+  return s;
+}
+
+std::error_code byte_reader::error() const noexcept
+{
+  return failed ? make_error_code(std::errc::bad_message) : std::error_code{};
+}
+
+void write(byte_writer& w, std::error_code const& e)
+{
+  auto const category = std::invoke([&]
+  {
+    if (!e)
+    {
+      return error_category_id::none;
+    }
+    if (e.category() == make_error_code(rules_error::not_legal).category())
+    {
+      return error_category_id::rules;
+    }
+    if (e.category() == std::generic_category())
+    {
+      return error_category_id::generic;
+    }
+    return error_category_id::system;
+  });
+  w.write_int(static_cast<int>(category));
+  w.write_int(e.value());
+}
+
+void read(byte_reader& r, std::error_code& e)
+{
+  auto const category = static_cast<error_category_id>(r.read_int());
+  auto const value = static_cast<int>(r.read_int());
+  switch (category)
+  {
+  case error_category_id::none: e = {}; return;
+  case error_category_id::rules: e = make_error_code(static_cast<rules_error>(value)); return;
+  case error_category_id::generic: e = std::error_code{value, std::generic_category()}; return;
+  case error_category_id::system: e = std::error_code{value, std::system_category()}; return;
+  }
+  r.failed = true;
+}
+
+void write(byte_writer& w, terrain_types t)
+{
+  w.write_int(static_cast<int>(t));
+}
+
+void read(byte_reader& r, terrain_types& t)
+{
+  t = static_cast<terrain_types>(r.read_int());
+}
+
+void write(byte_writer& w, unit_traits t)
+{
+  w.write_int(static_cast<int>(t));
+}
+
+void read(byte_reader& r, unit_traits& t)
+{
+  t = static_cast<unit_traits>(r.read_int());
+}
+
+void write(byte_writer& w, player_action const& action)
+{
+  w.write_int(static_cast<int>(action.type));
+  w.write_int(action.target1);
+  w.write_int(action.target2);
+}
+
+void read(byte_reader& r, player_action& action)
+{
+  action.type = static_cast<action_type>(r.read_int());
+  action.target1 = static_cast<int>(r.read_int());
+  action.target2 = static_cast<int>(r.read_int());
+}
+
+void write(byte_writer& w, card_info const& card)
+{
+  // Cards made from a known preset only carry their preset index; the static
+  // text, traits and terrain preferences are restored from the preset.
+  auto const index = preset_index(card.name);
+  w.write_int(index);
+  if (index < 0)
+  {
+    w.write_wstring(card.name);
+    w.write_wstring(card.description);
+    write(w, card.traits);
+    write(w, card.preferred_terrain);
+    w.write_int(static_cast<int>(card.action_type));
+    w.write_int(static_cast<int>(card.action_targets));
+  }
+  write_card_fields(w, card);
+}
+
+void read(byte_reader& r, card_info& card)
+{
+  auto const index = static_cast<int>(r.read_int());
+  if (index < 0)
+  {
+    card.name = r.read_wstring();
+    card.description = r.read_wstring();
+    read(r, card.traits);
+    read(r, card.preferred_terrain);
+    card.action_type = static_cast<card_action_type>(r.read_int());
+    card.action_targets = static_cast<card_action_targets>(r.read_int());
+  }
+  else if (auto const* preset = preset_at(index))
+  {
+    card.name = preset->name;
+    card.description = preset->special_descr;
+    card.traits = preset->traits;
+    card.preferred_terrain = preset->preferred_terrain;
+    card.action_type = preset->action_type;
+    card.action_targets = preset->action_targets;
+  }
+  else
+  {
+    r.failed = true;
+    return;
+  }
+  read_card_fields(r, card);
+}
+
+void write(byte_writer& w, player_info const& player)
+{
+  write(w, static_cast<card_info const&>(player));
+  w.write_int(player.num_draws_per_turn);
+  w.write_int(player.picks_available);
+  w.write_int(player.mana);
+  w.write_int(player.starting_mana);
+  w.write_string(player.name);
+  write(w, player.hand);
+  write(w, player.lanes);
+}
+
+void read(byte_reader& r, player_info& player)
+{
+  read(r, static_cast<card_info&>(player));
+  player.num_draws_per_turn = static_cast<int>(r.read_int());
+  player.picks_available = static_cast<int>(r.read_int());
+  player.mana = static_cast<int>(r.read_int());
+  player.starting_mana = static_cast<int>(r.read_int());
+  player.name = r.read_string();
+  read(r, player.hand);
+  read(r, player.lanes);
+}
+
+void write(byte_writer& w, session_info const& session)
+{
+  w.write_int(session.turn);
+  w.write_int(session.current_player);
+  w.write_bool(session.game_over);
+  write(w, session.players);
+  write(w, session.picks);
+  write(w, session.terrain);
+}
+
+void read(byte_reader& r, session_info& session)
+{
+  session.turn = static_cast<int>(r.read_int());
+  session.current_player = static_cast<int>(r.read_int());
+  session.game_over = r.read_bool();
+  read(r, session.players);
+  read(r, session.picks);
+  read(r, session.terrain);
+}
+
+void write(byte_writer& w, card_preset const& preset)
+{
+  // presets are static data, except for the per-process card identifier
+  w.write_int(preset_index(preset.name));
+  w.write_int(preset.cid);
+}
+
+void read(byte_reader& r, card_preset& preset)
+{
+  auto const* known = preset_at(static_cast<int>(r.read_int()));
+  if (!known)
+  {
+    r.failed = true;
+    return;
+  }
+  preset = *known;
+  preset.cid = static_cast<int>(r.read_int());
+}
+
+void write(byte_writer& w, deck const& d)
+{
+  write(w, d.all_cards);
+  write(w, d.remaining_cards);
+  w.write_int(static_cast<long long>(d.fixed_picks.size()));
+  for (auto const& [turn, preset] : d.fixed_picks)
+  {
+    w.write_int(turn);
+    write(w, preset);
+  }
+}
+
+void read(byte_reader& r, deck& d)
+{
+  read(r, d.all_cards);
+  read(r, d.remaining_cards);
+  auto const num_fixed = r.read_int();
+  d.fixed_picks.clear();
+  for (long long i = 0; i < num_fixed && !r.failed; ++i)
+  {
+    auto const turn = static_cast<int>(r.read_int());
+    card_preset preset{};
+    read(r, preset);
+    d.fixed_picks.emplace(turn, std::move(preset));
+  }
+}
+
+void write(byte_writer& w, ruleset const& rules)
+{
+  w.write_int(static_cast<int>(rules.mode));
+  w.write_int(rules.num_lanes);
+  w.write_int(rules.num_players);
+  w.write_int(rules.max_lane_height);
+  w.write_int(rules.challenger_starting_health);
+  w.write_int(rules.defender_starting_health);
+  w.write_int(rules.challenger_starting_mana);
+  w.write_int(rules.defender_starting_mana);
+  w.write_int(rules.max_starting_mana);
+  w.write_int(rules.mana_natural_increment);
+  w.write_int(rules.challenger_starting_cards);
+  w.write_int(rules.defender_starting_cards);
+  w.write_bool(rules.stagger_turns);
+  w.write_bool(rules.accumulate_mana);
+  w.write_bool(rules.enable_hero_specials);
+  w.write_float(rules.draw_limit_multiplier);
+  w.write_int(rules.challenger_starts_with_n_forts);
+  w.write_int(rules.defender_starts_with_n_forts);
+  w.write_int(rules.num_draws_per_turn);
+  w.write_int(rules.num_pick_choices_multiplier);
+  write(w, rules.challenger_deck);
+  write(w, rules.defender_deck);
+  w.write_int(rules.preferred_terrain_health_bonus);
+  w.write_int(rules.preferred_terrain_strength_bonus);
+  w.write_bool(rules.use_draft_deck);
+  w.write_int(rules.num_draft_choices);
+}
+
+void read(byte_reader& r, ruleset& rules)
+{
+  rules.mode = static_cast<game_mode>(r.read_int());
+  rules.num_lanes = static_cast<int>(r.read_int());
+  rules.num_players = static_cast<int>(r.read_int());
+  rules.max_lane_height = static_cast<int>(r.read_int());
+  rules.challenger_starting_health = static_cast<int>(r.read_int());
+  rules.defender_starting_health = static_cast<int>(r.read_int());
+  rules.challenger_starting_mana = static_cast<int>(r.read_int());
+  rules.defender_starting_mana = static_cast<int>(r.read_int());
+  rules.max_starting_mana = static_cast<int>(r.read_int());
+  rules.mana_natural_increment = static_cast<int>(r.read_int());
+  rules.challenger_starting_cards = static_cast<int>(r.read_int());
+  rules.defender_starting_cards = static_cast<int>(r.read_int());
+  rules.stagger_turns = r.read_bool();
+  rules.accumulate_mana = r.read_bool();
+  rules.enable_hero_specials = r.read_bool();
+  rules.draw_limit_multiplier = r.read_float();
+  rules.challenger_starts_with_n_forts = static_cast<int>(r.read_int());
+  rules.defender_starts_with_n_forts = static_cast<int>(r.read_int());
+  rules.num_draws_per_turn = static_cast<int>(r.read_int());
+  rules.num_pick_choices_multiplier = static_cast<int>(r.read_int());
+  read(r, rules.challenger_deck);
+  read(r, rules.defender_deck);
+  rules.preferred_terrain_health_bonus = static_cast<int>(r.read_int());
+  rules.preferred_terrain_strength_bonus = static_cast<int>(r.read_int());
+  rules.use_draft_deck = r.read_bool();
+  rules.num_draft_choices = static_cast<int>(r.read_int());
+}
+
+std::string encode_session(session_info const& session)
+{
+  byte_writer w;
+  write(w, session);
+  return std::move(w.buffer);
+}
+
+std::error_code decode_session(std::string_view data, session_info& session)
+{
+  byte_reader r{data};
+  read(r, session);
+  if (auto const e = r.error())
+  {
+    AURA_ERROR(e, L"Failed to decode session (%zu bytes)", data.size());
+    return e;
+  }
+  return {};
+}
+
+} // namespace aura
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <aura-core/session_info.h>
+#include <aura-core/player_action.h>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace aura
+{
+
+struct card_preset;
+struct deck;
+struct ruleset;
+
+//! Appends values to a compact binary buffer.
+//! Integers are written as zig-zag varints, so the small values that make up
+//! most of a session take a single byte.
+struct byte_writer
+{
+  std::string buffer;
+
+  void write_int(long long value);
+
+  void write_bool(bool b) { buffer.push_back(b ? 1 : 0); }
+
+  void write_float(float f);
+
+  void write_string(std::string_view s);
+
+  void write_wstring(std::wstring_view s);
+};
+
+//! Reads values written by byte_writer. Reading past the end or reading
+//! malformed data sets 'failed' and yields zeroes from then on.
+struct byte_reader
+{
+  std::string_view buffer;
+  size_t pos{0};
+  bool failed{false};
+
+  explicit byte_reader(std::string_view b) : buffer{b} {}
+
+  long long read_int();
+
+  bool read_bool();
+
+  float read_float();
+
+  std::string read_string();
+
+  std::wstring read_wstring();
+
+  bool at_end() const noexcept { return pos >= buffer.size(); }
+
+  std::error_code error() const noexcept;
+};
+
+void write(byte_writer& w, std::error_code const& e);
+void write(byte_writer& w, terrain_types t);
+void write(byte_writer& w, unit_traits t);
+void write(byte_writer& w, player_action const& action);
+void write(byte_writer& w, card_info const& card);
+void write(byte_writer& w, player_info const& player);
+void write(byte_writer& w, session_info const& session);
+void write(byte_writer& w, card_preset const& preset);
+void write(byte_writer& w, deck const& d);
+void write(byte_writer& w, ruleset const& rules);
+
+void read(byte_reader& r, std::error_code& e);
+void read(byte_reader& r, terrain_types& t);
+void read(byte_reader& r, unit_traits& t);
+void read(byte_reader& r, player_action& action);
+void read(byte_reader& r, card_info& card);
+void read(byte_reader& r, player_info& player);
+void read(byte_reader& r, session_info& session);
+void read(byte_reader& r, card_preset& preset);
+void read(byte_reader& r, deck& d);
+void read(byte_reader& r, ruleset& rules);
+
+template <typename T>
+void write(byte_writer& w, std::vector<T> const& v)
+{
+  w.write_int(static_cast<long long>(v.size()));
+  for (auto const& item : v)
+  {
+    write(w, item);
+  }
+}
+
+template <typename T>
+void read(byte_reader& r, std::vector<T>& v)
+{
+  auto const n = r.read_int();
+  // every element takes at least one byte, which bounds bogus sizes
+  if (n < 0 || static_cast<size_t>(n) > r.buffer.size() - r.pos)
+  {
+    r.failed = true;
+    return;
+  }
+  v.clear();
+  v.resize(static_cast<size_t>(n));
+  for (auto& item : v)
+  {
+    read(r, item);
+  }
+}
+
+//! Encodes a session into its compact binary form
+std::string encode_session(session_info const& session);
+
+//! Decodes a session produced by encode_session()
+std::error_code decode_session(std::string_view data, session_info& session);
+
+} // namespace aura
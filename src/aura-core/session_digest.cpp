@@ -0,0 +1,315 @@
+#include "session_digest.h"
+#include <algorithm>
+
+namespace aura
+{
+
+namespace
+{
+
+//! The fields of a card that change in play, packed four to a word
+std::array<std::uint64_t, 3> pack_stats(card_info const& card) noexcept
+{
+  return {
+    (static_cast<std::uint64_t>(card.health & 0xffff) << 48)
+      | (static_cast<std::uint64_t>(card.starting_health & 0xffff) << 32)
+      | (static_cast<std::uint64_t>(card.strength & 0xffff) << 16)
+      | static_cast<std::uint64_t>(card.starting_strength & 0xffff),
+    (static_cast<std::uint64_t>(card.cost & 0xffff) << 48)
+      | (static_cast<std::uint64_t>(card.energy & 0xffff) << 32)
+      | (static_cast<std::uint64_t>(card.starting_energy & 0xffff) << 16)
+      | static_cast<std::uint64_t>(card.fight_back & 0xffff),
+    (static_cast<std::uint64_t>(card.is_visible) << 48)
+      | (static_cast<std::uint64_t>(card.on_preferred_terrain) << 32)
+      | static_cast<std::uint64_t>(card.current_terrain)};
+}
+
+struct hasher
+{
+  std::uint64_t h{0x6a09e667f3bcc909ull};
+
+  void add(std::uint64_t v) noexcept
+  {
+    h = chain_hash(h, v);
+  }
+
+  void add(card_info const& card) noexcept
+  {
+    add(static_cast<std::uint64_t>(card.uid));
+    add(static_cast<std::uint64_t>(card.cid));
+    for (auto const w : pack_stats(card))
+    {
+      add(w);
+    }
+    for (auto const t : card.traits)
+    {
+      add(static_cast<std::uint64_t>(t));
+    }
+  }
+
+  void add(std::vector<card_info> const& cards) noexcept
+  {
+    add(cards.size());
+    for (auto const& card : cards)
+    {
+      add(card);
+    }
+  }
+};
+
+//! A card as the slot of an incremental_digest; the traits are folded into
+//! one word
+std::array<std::uint64_t, 6> card_slot(card_info const& card) noexcept
+{
+  std::uint64_t traits = 0;
+  for (auto const t : card.traits)
+  {
+    traits = ((traits << 5) | (traits >> 59)) ^ (static_cast<std::uint64_t>(t) + 1);
+  }
+  auto const stats = pack_stats(card);
+  return {(static_cast<std::uint64_t>(static_cast<std::uint32_t>(card.uid)) << 32)
+    | static_cast<std::uint32_t>(card.cid), stats[0], stats[1], stats[2], traits, 0};
+}
+
+class differ
+{
+public:
+  explicit differ(int max_lines) : m_lines_left{max_lines} {}
+
+  template <typename T>
+  void field(std::wstring const& path, T const& a, T const& b)
+  {
+    if (!(a == b))
+    {
+      line(path + L": " + to_wstring(a) + L" vs " + to_wstring(b));
+    }
+  }
+
+  void cards(std::wstring const& path, std::vector<card_info> const& a, std::vector<card_info> const& b)
+  {
+    field(path + L".size", a.size(), b.size());
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i)
+    {
+      card(path + L"[" + std::to_wstring(i) + L"]", a[i], b[i]);
+    }
+  }
+
+  void card(std::wstring const& path, card_info const& a, card_info const& b)
+  {
+    if (a.name != b.name)
+    {
+      line(path + L": " + a.name + L" vs " + b.name);
+      return;
+    }
+    auto const p = path + L"(" + a.name + L")";
+    field(p + L".uid", a.uid, b.uid);
+    field(p + L".cid", a.cid, b.cid);
+    field(p + L".health", a.health, b.health);
+    field(p + L".starting_health", a.starting_health, b.starting_health);
+    field(p + L".strength", a.strength, b.strength);
+    field(p + L".starting_strength", a.starting_strength, b.starting_strength);
+    field(p + L".cost", a.cost, b.cost);
+    field(p + L".energy", a.energy, b.energy);
+    field(p + L".starting_energy", a.starting_energy, b.starting_energy);
+    field(p + L".fight_back", a.fight_back, b.fight_back);
+    field(p + L".is_visible", a.is_visible, b.is_visible);
+    field(p + L".on_preferred_terrain", a.on_preferred_terrain, b.on_preferred_terrain);
+    field(p + L".current_terrain", static_cast<int>(a.current_terrain), static_cast<int>(b.current_terrain));
+    field(p + L".traits.size", a.traits.size(), b.traits.size());
+  }
+
+  std::wstring result() const
+  {
+    return m_out;
+  }
+
+private:
+  static std::wstring to_wstring(bool v) { return v ? L"true" : L"false"; }
+
+  template <typename T>
+  static std::wstring to_wstring(T const& v) { return std::to_wstring(v); }
+
+  void line(std::wstring const& text)
+  {
+    if (m_lines_left-- > 0)
+    {
+      m_out += text;
+      m_out += L'\n';
+    }
+    else if (m_lines_left == -1)
+    {
+      m_out += L"...\n";
+    }
+  }
+
+  std::wstring m_out;
+  int m_lines_left;
+};
+
+} // namespace {}
+
+std::uint64_t hash_session(session_info const& session) noexcept
+{
+  hasher h;
+  h.add(static_cast<std::uint64_t>(session.turn));
+  h.add(static_cast<std::uint64_t>(session.current_player));
+  h.add(static_cast<std::uint64_t>(session.game_over));
+  for (auto const& player : session.players)
+  {
+    h.add(player);
+    h.add(static_cast<std::uint64_t>(player.mana));
+    h.add(static_cast<std::uint64_t>(player.starting_mana));
+    h.add(static_cast<std::uint64_t>(player.picks_available));
+    h.add(static_cast<std::uint64_t>(player.num_draws_per_turn));
+    h.add(player.hand);
+    h.add(player.lanes.size());
+    for (auto const& lane : player.lanes)
+    {
+      h.add(lane);
+    }
+  }
+  h.add(session.picks);
+  for (auto const& lane : session.terrain)
+  {
+    for (auto const t : lane)
+    {
+      h.add(static_cast<std::uint64_t>(t));
+    }
+  }
+  return h.h;
+}
+
+std::uint64_t incremental_digest::update(session_info const& session)
+{
+  // the sections are visited in a fixed order and each hash covers the
+  // section and the slot's position in it, so moving a card is a change
+  // like any other
+  size_t section = 0;
+  auto const fill = [&](std::vector<card_info> const& cards)
+  {
+    for (size_t i = 0; i < cards.size(); ++i)
+    {
+      put(section, i, card_slot(cards[i]));
+    }
+    trim(section++, cards.size());
+  };
+
+  put(section, 0, {static_cast<std::uint64_t>(session.turn), static_cast<std::uint64_t>(session.current_player),
+    static_cast<std::uint64_t>(session.game_over), session.players.size(), session.picks.size(),
+    session.terrain.size()});
+  trim(section++, 1);
+  for (auto const& lane : session.terrain)
+  {
+    put(section, 0, {lane.size(), 0, 0, 0, 0, 0});
+    for (size_t i = 0; i < lane.size(); ++i)
+    {
+      put(section, i + 1, {static_cast<std::uint64_t>(lane[i]), 0, 0, 0, 0, 0});
+    }
+    trim(section++, lane.size() + 1);
+  }
+  for (auto const& player : session.players)
+  {
+    auto key = card_slot(player);
+    key[5] = (static_cast<std::uint64_t>(player.mana & 0xffff) << 48)
+      | (static_cast<std::uint64_t>(player.starting_mana & 0xffff) << 32)
+      | (static_cast<std::uint64_t>(player.picks_available & 0xffff) << 16)
+      | static_cast<std::uint64_t>(player.num_draws_per_turn & 0xffff);
+    put(section, 0, key);
+    put(section, 1, {player.hand.size(), player.lanes.size(), 0, 0, 0, 0});
+    trim(section++, 2);
+    fill(player.hand);
+    for (auto const& lane : player.lanes)
+    {
+      fill(lane);
+    }
+  }
+  fill(session.picks);
+
+  for (size_t i = section; i < m_sections.size(); ++i)
+  {
+    trim(i, 0);
+  }
+  m_sections.resize(section);
+  return m_sum;
+}
+
+void incremental_digest::put(size_t section, size_t index, slot_key const& key)
+{
+  if (section == m_sections.size())
+  {
+    m_sections.emplace_back();
+  }
+  auto& slots = m_sections[section];
+  if (index < slots.size() && slots[index].key == key)
+  {
+    return;
+  }
+  std::uint64_t hash = chain_hash(chain_hash(0x510e527fade682d1ull, section), index);
+  for (auto const w : key)
+  {
+    hash = chain_hash(hash, w);
+  }
+  if (index == slots.size())
+  {
+    slots.push_back({key, hash});
+  }
+  else
+  {
+    m_sum -= slots[index].hash;
+    slots[index] = {key, hash};
+  }
+  m_sum += hash;
+}
+
+void incremental_digest::trim(size_t section, size_t length)
+{
+  if (section == m_sections.size())
+  {
+    m_sections.emplace_back();
+  }
+  auto& slots = m_sections[section];
+  for (size_t i = length; i < slots.size(); ++i)
+  {
+    m_sum -= slots[i].hash;
+  }
+  slots.resize(std::min(length, slots.size()));
+}
+
+std::wstring diff_sessions(session_info const& a, session_info const& b, int max_lines)
+{
+  differ d{max_lines};
+  d.field(L"turn", a.turn, b.turn);
+  d.field(L"current_player", a.current_player, b.current_player);
+  d.field(L"game_over", a.game_over, b.game_over);
+  d.field(L"players.size", a.players.size(), b.players.size());
+  for (size_t p = 0; p < std::min(a.players.size(), b.players.size()); ++p)
+  {
+    auto const& pa = a.players[p];
+    auto const& pb = b.players[p];
+    auto const path = L"players[" + std::to_wstring(p) + L"]";
+    d.card(path, pa, pb);
+    d.field(path + L".mana", pa.mana, pb.mana);
+    d.field(path + L".starting_mana", pa.starting_mana, pb.starting_mana);
+    d.field(path + L".picks_available", pa.picks_available, pb.picks_available);
+    d.field(path + L".num_draws_per_turn", pa.num_draws_per_turn, pb.num_draws_per_turn);
+    d.cards(path + L".hand", pa.hand, pb.hand);
+    d.field(path + L".lanes.size", pa.lanes.size(), pb.lanes.size());
+    for (size_t l = 0; l < std::min(pa.lanes.size(), pb.lanes.size()); ++l)
+    {
+      d.cards(path + L".lanes[" + std::to_wstring(l) + L"]", pa.lanes[l], pb.lanes[l]);
+    }
+  }
+  d.cards(L"picks", a.picks, b.picks);
+  d.field(L"terrain.size", a.terrain.size(), b.terrain.size());
+  for (size_t l = 0; l < std::min(a.terrain.size(), b.terrain.size()); ++l)
+  {
+    for (size_t t = 0; t < std::min(a.terrain[l].size(), b.terrain[l].size()); ++t)
+    {
+      d.field(L"terrain[" + std::to_wstring(l) + L"][" + std::to_wstring(t) + L"]",
+        static_cast<int>(a.terrain[l][t]), static_cast<int>(b.terrain[l][t]));
+    }
+  }
+  return d.result();
+}
+
+} // namespace aura
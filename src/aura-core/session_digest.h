@@ -0,0 +1,69 @@
+#pragma once
+
+#include <aura-core/session_info.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aura
+{
+
+//! 64-bit digest of everything in a session that affects play. Two engines
+//! that agree on the digest almost certainly hold the same game. Runs over
+//! the session in place, without allocating.
+std::uint64_t hash_session(session_info const& session) noexcept;
+
+//! Folds a per-turn digest into a running one, so a single value tells
+//! whether two games agreed on every turn so far
+inline std::uint64_t chain_hash(std::uint64_t chain, std::uint64_t digest) noexcept
+{
+  auto z = chain ^ (digest + 0x9e3779b97f4a7c15ull + (chain << 6) + (chain >> 2));
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+//! Digest of a session that is updated as the session changes, for when
+//! every turn needs one. The session is cut into slots: one per card, per
+//! player and per terrain tile. Each slot keeps its packed contents and
+//! their hash, and the digest is the sum of the hashes, so update() only
+//! hashes again the slots whose contents changed and swaps them into the
+//! sum. Every hand, lane, terrain lane and the picks number their slots on
+//! their own, so a card drawn or a pick taken doesn't move the slots of
+//! the rest of the session. Its values are not those of hash_session(); both ends
+//! of a comparison have to use the same kind.
+class incremental_digest
+{
+public:
+  //! Brings the digest up to date with 'session' and returns it; the same
+  //! session always gives the same digest, whatever came before it
+  std::uint64_t update(session_info const& session);
+
+  std::uint64_t value() const noexcept { return m_sum; }
+
+private:
+  using slot_key = std::array<std::uint64_t, 6>;
+
+  struct slot
+  {
+    slot_key key;
+    std::uint64_t hash;
+  };
+
+  //! Puts 'key' into slot 'index' of 'section', which is at most one past
+  //! its last slot
+  void put(size_t section, size_t index, slot_key const& key);
+
+  //! Drops the slots of 'section' from 'length' on
+  void trim(size_t section, size_t length);
+
+  std::vector<std::vector<slot>> m_sections;
+  std::uint64_t m_sum{0};
+};
+
+//! Human-readable list of the fields in which two sessions differ, one per
+//! line, at most 'max_lines' of them. Empty if they are the same.
+std::wstring diff_sessions(session_info const& a, session_info const& b, int max_lines = 64);
+
+} // namespace aura
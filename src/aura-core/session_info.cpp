@@ -1,6 +1,7 @@
 #include "session_info.h"
 #include "card_preset.h"
 #include "ruleset.h"
+#include <atomic>
 #include <cstdlib>
 #include <ctime>
 
@@ -9,7 +10,8 @@ namespace aura
 
 int generate_uid()
 {
-  static int uid_counter{0};
+  // decoding a session makes players, on whichever thread received it
+  static std::atomic<int> uid_counter{0};
   return uid_counter++;
 }
 
@@ -111,4 +113,32 @@ bool session_info::is_front_of_lane(int uid) const noexcept
   return false;
 }
 
+session_info redact_for_seats(session_info info, unsigned seats)
+{
+  auto const hide = [](std::vector<card_info>& cards)
+  {
+    auto const n = cards.size();
+    cards.assign(n, card_info{});
+    for (auto& card : cards)
+    {
+      card.uid = 0;
+      card.is_visible = false;
+    }
+  };
+
+  auto const holds = [&](int seat) { return seat >= 0 && seat < 32 && (seats >> seat) & 1u; };
+  for (size_t i = 0; i < info.players.size(); ++i)
+  {
+    if (!holds(static_cast<int>(i)))
+    {
+      hide(info.players[i].hand);
+    }
+  }
+  if (!holds(info.current_player))
+  {
+    hide(info.picks);
+  }
+  return info;
+}
+
 } // namespace aura
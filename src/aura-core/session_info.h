@@ -32,7 +32,7 @@ struct card_info
 
   bool is_visible{true}; //!< this unit can be targetted for an action
   bool on_preferred_terrain{false}; //!< whether this unit is standing on preferred terrain or not
-  terrain_types current_terrain;
+  terrain_types current_terrain{terrain_types::plains};
 
   std::wstring name;
   std::wstring description;
@@ -185,6 +185,12 @@ struct session_info
   bool is_front_of_lane(int uid) const noexcept;
 };
 
+//! What the holder of 'seats' may see of a session, bit i standing for
+//! seat i: the hands of the other seats, and the picks unless the player to
+//! move is one of 'seats', are replaced by hidden cards, so only their count
+//! shows. Spectators hold no seat.
+session_info redact_for_seats(session_info info, unsigned seats);
+
 struct rules_engine;
 using card_action_t = std::error_code(*)(rules_engine& re, session_info& session, card_info& actor, card_info& target);
 
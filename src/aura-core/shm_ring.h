@@ -0,0 +1,285 @@
+#pragma once
+
+#include <aura-core/platform.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+# include <immintrin.h>
+#endif
+
+namespace aura
+{
+
+//! Fixed-size unit of a shm_ring. A message spans as many frames as it
+//! needs; a player_action request fits in one.
+struct shm_frame
+{
+  static constexpr size_t size = 256;
+  static constexpr size_t capacity = size - 8;
+
+  std::uint32_t length;  //!< bytes of 'data' in use
+  std::uint32_t last;    //!< nonzero on the final frame of a message
+  char data[capacity];
+};
+static_assert(sizeof(shm_frame) == shm_frame::size);
+
+//! A process's handles on the wakeups of one shm_ring, opened under the
+//! ring's name by both processes; see shared_wakeup
+struct shm_ring_wakeups
+{
+  shared_wakeup head;  //!< the consumer sleeps on head
+  shared_wakeup tail;  //!< the producer sleeps on tail
+
+  std::error_code open(std::string const& name)
+  {
+    if (auto const e = head.open(name + "-head"))
+    {
+      return e;
+    }
+    return tail.open(name + "-tail");
+  }
+};
+
+//! Single-producer single-consumer ring of frames that lives in memory
+//! shared by two processes. head and tail double as futex words, so a side
+//! that found nothing to do after spinning briefly can sleep until the
+//! other moves them; each process passes its shm_ring_wakeups along. Wakes
+//! are only issued while somebody sleeps, so the fast path makes no system
+//! calls.
+struct shm_ring
+{
+  static constexpr std::uint32_t num_frames = 64;
+
+  //! How long a side polls before going to sleep
+  static constexpr std::chrono::microseconds spin_time{50};
+
+  //! Queues 'message', waiting for room until 'deadline'
+  std::error_code send(std::string_view message, std::chrono::steady_clock::time_point deadline,
+    shm_ring_wakeups const& wakeups)
+  {
+    auto h = head.load(std::memory_order_relaxed);
+    do
+    {
+      while (h - tail.load(std::memory_order_acquire) == num_frames)
+      {
+        if (!wait(tail, h - num_frames, producer_sleeping, wakeups.tail, deadline))
+        {
+          return make_error_code(std::errc::timed_out);
+        }
+      }
+
+      auto& f = frames[h % num_frames];
+      auto const n = std::min(message.size(), shm_frame::capacity);
+      std::memcpy(f.data, message.data(), n);
+      f.length = static_cast<std::uint32_t>(n);
+      message.remove_prefix(n);
+      f.last = message.empty() ? 1 : 0;
+      head.store(++h, std::memory_order_release);
+      notify(head, consumer_sleeping, wakeups.head);
+    } while (!message.empty());
+    return {};
+  }
+
+  //! Appends frames to 'message' until one completes it. Returns timed_out
+  //! at 'deadline' with a partial message kept in 'message' for the next call.
+  std::error_code receive(std::string& message, std::chrono::steady_clock::time_point deadline,
+    shm_ring_wakeups const& wakeups)
+  {
+    auto t = tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+      while (head.load(std::memory_order_acquire) == t)
+      {
+        if (!wait(head, t, consumer_sleeping, wakeups.head, deadline))
+        {
+          return make_error_code(std::errc::timed_out);
+        }
+      }
+
+      auto const& f = frames[t % num_frames];
+      auto const last = f.last != 0;
+      message.append(f.data, std::min<size_t>(f.length, shm_frame::capacity));
+      tail.store(++t, std::memory_order_release);
+      notify(tail, producer_sleeping, wakeups.tail);
+      if (last)
+      {
+        return {};
+      }
+    }
+  }
+
+  void reset() noexcept
+  {
+    head.store(0);
+    tail.store(0);
+  }
+
+  alignas(64) std::atomic<std::uint32_t> head;
+  std::atomic<std::uint32_t> consumer_sleeping;
+  alignas(64) std::atomic<std::uint32_t> tail;
+  std::atomic<std::uint32_t> producer_sleeping;
+  alignas(64) shm_frame frames[num_frames];
+
+private:
+  static void cpu_relax() noexcept
+  {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  //! Waits for 'word' to move away from 'seen'; false at 'deadline'
+  static bool wait(std::atomic<std::uint32_t>& word, std::uint32_t seen, std::atomic<std::uint32_t>& sleeping,
+    shared_wakeup const& wakeup, std::chrono::steady_clock::time_point deadline)
+  {
+    // on a single core the other side cannot run while we spin
+    static bool const can_spin = std::thread::hardware_concurrency() > 1;
+    auto const spin_until = std::min(deadline, std::chrono::steady_clock::now() + spin_time);
+    while (can_spin)
+    {
+      for (int i = 0; i < 64; ++i)
+      {
+        if (word.load(std::memory_order_acquire) != seen)
+        {
+          return true;
+        }
+        cpu_relax();
+      }
+      if (std::chrono::steady_clock::now() >= spin_until)
+      {
+        break;
+      }
+    }
+
+    // announce the sleep before the final check; pairs with notify()
+    sleeping.fetch_add(1);
+    auto moved = false;
+    while (!(moved = word.load() != seen))
+    {
+      auto const now = std::chrono::steady_clock::now();
+      if (now >= deadline)
+      {
+        break;
+      }
+      auto const left = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+      futex_wait(word, seen, std::min(left, std::chrono::milliseconds{100}), wakeup);
+    }
+    sleeping.fetch_sub(1);
+    return moved;
+  }
+
+  static void notify(std::atomic<std::uint32_t>& word, std::atomic<std::uint32_t>& sleeping,
+    shared_wakeup const& wakeup) noexcept
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed))
+    {
+      futex_wake(word, wakeup);
+    }
+  }
+};
+
+//! One client's pair of rings
+struct shm_channel
+{
+  //! Low bits of 'state'
+  enum : std::uint32_t
+  {
+    free,
+    claimed,
+    abandoned,  //!< the client gave up on the rings; the server frees the channel
+    status_mask = 3
+  };
+
+  //! Added to 'state' each time the server frees the channel, so a client
+  //! still holding it from before can tell it has lost it
+  static constexpr std::uint32_t generation_step = status_mask + 1;
+
+  //! Claims a free channel for a client; 'held' is the state to pass to
+  //! release() and to compare with 'state' while using the channel
+  bool try_claim(std::uint32_t& held) noexcept
+  {
+    auto s = state.load();
+    held = (s & ~status_mask) | claimed;
+    return (s & status_mask) == free && state.compare_exchange_strong(s, held);
+  }
+
+  //! Leaves the channel claimed as 'held' either free or abandoned; false
+  //! if the server has freed it in the meantime
+  bool release(std::uint32_t held, std::uint32_t status) noexcept
+  {
+    return state.compare_exchange_strong(held, (held & ~status_mask) | status);
+  }
+
+  //! Server side: empties the rings and frees the channel for the next
+  //! generation of clients
+  void recycle() noexcept
+  {
+    requests.reset();
+    responses.reset();
+    owner_pid.store(0);
+    state.store(((state.load() & ~status_mask) + generation_step) | free);
+  }
+
+  alignas(64) std::atomic<std::uint32_t> state;  //!< status and generation
+  std::atomic<std::int32_t> owner_pid;
+  shm_ring requests;
+  shm_ring responses;
+};
+
+//! A process's wakeups for the rings of channel 'index' of the region
+//! published as 'region'
+struct shm_channel_wakeups
+{
+  shm_ring_wakeups requests;
+  shm_ring_wakeups responses;
+
+  std::error_code open(std::string const& region, std::uint32_t index)
+  {
+    auto const name = region + "-" + std::to_string(index);
+    if (auto const e = requests.open(name + "-requests"))
+    {
+      return e;
+    }
+    return responses.open(name + "-responses");
+  }
+};
+
+//! Layout of the region a server publishes under its name
+struct shm_region
+{
+  static constexpr std::uint32_t magic_value = 0x61757261; // "aura"
+  static constexpr std::uint32_t layout_version = 2;
+
+  std::atomic<std::uint32_t> magic;
+  std::uint32_t version;
+  std::uint32_t num_channels;
+  std::uint32_t frame_size;
+
+  shm_channel* channels() noexcept
+  {
+    return reinterpret_cast<shm_channel*>(reinterpret_cast<char*>(this) + channels_offset);
+  }
+
+  static constexpr size_t channels_offset = 64;
+
+  static constexpr size_t size_for(std::uint32_t num_channels) noexcept
+  {
+    return channels_offset + sizeof(shm_channel) * num_channels;
+  }
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shm rings need address-free atomics");
+
+} // namespace aura
@@ -0,0 +1,138 @@
+#include "shm_transport.h"
+#include "aura-core/build.h"
+#include "aura-core/serialization.h"
+
+namespace aura
+{
+
+std::string encode_shm_request(std::string_view path, std::string_view body)
+{
+  byte_writer w;
+  w.write_string(path);
+  w.buffer.append(body);
+  return std::move(w.buffer);
+}
+
+std::pair<std::error_code, std::pair<std::string, std::string_view>> decode_shm_request(std::string_view message)
+{
+  byte_reader r{message};
+  auto path = r.read_string();
+  if (r.failed)
+  {
+    return {r.error(), {}};
+  }
+  return {{}, {std::move(path), message.substr(r.pos)}};
+}
+
+shm_transport::shm_transport(void* region, size_t region_size, shm_channel& channel, shm_channel_wakeups&& wakeups,
+  std::uint32_t held, std::chrono::milliseconds timeout)
+  : m_region{region}
+  , m_region_size{region_size}
+  , m_channel{channel}
+  , m_wakeups{std::move(wakeups)}
+  , m_held{held}
+  , m_timeout{timeout}
+{
+}
+
+shm_transport::~shm_transport()
+{
+  // a broken channel was handed back to the server already
+  if (!m_broken)
+  {
+    m_channel.owner_pid.store(0);
+    m_channel.release(m_held, shm_channel::free);
+  }
+  unmap_shared_memory(m_region, m_region_size);
+}
+
+std::pair<std::error_code, std::string> shm_transport::request(std::string const& path, std::string const& body)
+{
+  if (!m_broken && m_channel.state.load() != m_held)
+  {
+    // the server freed the channel, most likely after we stopped reading
+    m_broken = true;
+  }
+  if (m_broken)
+  {
+    return {make_error_code(std::errc::connection_aborted), {}};
+  }
+
+  auto const deadline = std::chrono::steady_clock::now() + m_timeout;
+  std::string response;
+  auto e = m_channel.requests.send(encode_shm_request(path, body), deadline, m_wakeups.requests);
+  if (!e)
+  {
+    e = m_channel.responses.receive(response, deadline, m_wakeups.responses);
+  }
+  if (e)
+  {
+    // the rings are out of step with the server now; it resets them and
+    // frees the channel once it sees it abandoned
+    m_broken = true;
+    m_channel.release(m_held, shm_channel::abandoned);
+    AURA_ERROR(e, L"No response to %hs over shared memory", path.c_str());
+    return {e, {}};
+  }
+  return {{}, std::move(response)};
+}
+
+std::pair<std::error_code, std::unique_ptr<shm_transport>> make_shm_transport(std::string const& name,
+  std::chrono::milliseconds timeout)
+{
+  // map the header first to learn how large the region is
+  auto const [header_error, header] = map_shared_memory(name, shm_region::channels_offset, false);
+  if (header_error)
+  {
+    AURA_ERROR(header_error, L"No aura_server publishes '%hs' on this host", name.c_str());
+    return {header_error, nullptr};
+  }
+  auto const* h = static_cast<shm_region const*>(header);
+  auto const valid = h->magic.load() == shm_region::magic_value && h->version == shm_region::layout_version
+    && h->frame_size == shm_frame::size;
+  auto const num_channels = h->num_channels;
+  unmap_shared_memory(header, shm_region::channels_offset);
+  if (!valid)
+  {
+    auto const e = make_error_code(std::errc::protocol_error);
+    AURA_ERROR(e, L"'%hs' has an incompatible layout", name.c_str());
+    return {e, nullptr};
+  }
+
+  auto const size = shm_region::size_for(num_channels);
+  auto const [error, data] = map_shared_memory(name, size, false);
+  if (error)
+  {
+    AURA_ERROR(error, L"Cannot map '%hs'", name.c_str());
+    return {error, nullptr};
+  }
+
+  auto* region = static_cast<shm_region*>(data);
+  for (std::uint32_t i = 0; i < num_channels; ++i)
+  {
+    auto& channel = region->channels()[i];
+    std::uint32_t held = 0;
+    if (!channel.try_claim(held))
+    {
+      continue;
+    }
+    shm_channel_wakeups wakeups;
+    if (auto const e = wakeups.open(name, i))
+    {
+      channel.release(held, shm_channel::free);
+      unmap_shared_memory(data, size);
+      AURA_ERROR(e, L"Cannot open the wakeups of channel %u of '%hs'", i, name.c_str());
+      return {e, nullptr};
+    }
+    channel.owner_pid.store(current_process_id());
+    return {std::error_code{},
+      std::unique_ptr<shm_transport>{new shm_transport{data, size, channel, std::move(wakeups), held, timeout}}};
+  }
+
+  unmap_shared_memory(data, size);
+  auto const e = make_error_code(std::errc::connection_refused);
+  AURA_ERROR(e, L"All %u channels of '%hs' are taken", num_channels, name.c_str());
+  return {e, nullptr};
+}
+
+} // namespace aura
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <aura-core/client_transport.h>
+#include <aura-core/shm_ring.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace aura
+{
+
+//! Name under which aura_server publishes its shared-memory channels
+constexpr char const* default_shm_name = "/aura-server";
+
+//! client_transport for processes on the server's host, typically bots.
+//!
+//! The transport claims one channel of the region the server published and
+//! exchanges requests and responses through its rings, so a round trip
+//! costs a few microseconds and, while both sides are busy, no system
+//! calls. A request is the path followed by the body; see shm_server.
+class shm_transport : public client_transport
+{
+public:
+  ~shm_transport() override;
+
+  shm_transport(shm_transport const&) = delete;
+  shm_transport& operator=(shm_transport const&) = delete;
+
+  std::pair<std::error_code, std::string> request(std::string const& path, std::string const& body) override;
+
+private:
+  friend std::pair<std::error_code, std::unique_ptr<shm_transport>> make_shm_transport(std::string const&,
+    std::chrono::milliseconds);
+
+  shm_transport(void* region, size_t region_size, shm_channel& channel, shm_channel_wakeups&& wakeups,
+    std::uint32_t held, std::chrono::milliseconds timeout);
+
+  void* m_region;
+  size_t m_region_size;
+  shm_channel& m_channel;
+  shm_channel_wakeups m_wakeups;
+  std::uint32_t const m_held;  //!< channel state while it is ours; see shm_channel::try_claim()
+  std::chrono::milliseconds m_timeout;
+  bool m_broken{false};
+};
+
+//! Connects to the server publishing 'name'. Requests the server does not
+//! answer within 'timeout' fail with timed_out and break the transport,
+//! which hands its channel back to the server to be reset for another
+//! client.
+std::pair<std::error_code, std::unique_ptr<shm_transport>> make_shm_transport(std::string const& name = default_shm_name,
+  std::chrono::milliseconds timeout = std::chrono::seconds(5));
+
+//! Encodes a request as the server expects it
+std::string encode_shm_request(std::string_view path, std::string_view body);
+
+//! Splits a request back into path and body
+std::pair<std::error_code, std::pair<std::string, std::string_view>> decode_shm_request(std::string_view message);
+
+} // namespace aura
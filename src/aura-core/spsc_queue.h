@@ -0,0 +1,82 @@
+#pragma once
+
+#include <aura-core/platform.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace aura
+{
+
+//! Bounded queue from one producer thread to one consumer thread of the same
+//! process. Pushing never waits: a full queue refuses the value. The
+//! consumer can sleep until something arrives; the producer only makes a
+//! system call to wake it while it sleeps.
+template <typename T, std::uint32_t N>
+class spsc_queue
+{
+  static_assert(N && !(N & (N - 1)), "the capacity must be a power of two");
+
+public:
+  //! Producer: queues 'value'; false if the queue is full
+  bool try_push(T value)
+  {
+    auto const h = m_head.load(std::memory_order_relaxed);
+    if (h - m_tail.load(std::memory_order_acquire) == N)
+    {
+      return false;
+    }
+    m_items[h % N] = std::move(value);
+    m_head.store(h + 1, std::memory_order_release);
+
+    // pairs with the sleeper announcing itself in pop()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_consumer_sleeping.load(std::memory_order_relaxed))
+    {
+      wake_by_address(m_head);
+    }
+    return true;
+  }
+
+  //! Consumer: takes the oldest value, if there is one
+  std::optional<T> try_pop()
+  {
+    auto const t = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) == t)
+    {
+      return std::nullopt;
+    }
+    auto value = std::move(m_items[t % N]);
+    m_tail.store(t + 1, std::memory_order_release);
+    return value;
+  }
+
+  //! Consumer: takes the oldest value, sleeping until there is one
+  T pop()
+  {
+    while (true)
+    {
+      if (auto value = try_pop())
+      {
+        return std::move(*value);
+      }
+      auto const seen = m_tail.load(std::memory_order_relaxed);
+      m_consumer_sleeping.store(1);
+      if (m_head.load() == seen)
+      {
+        wait_on_address(m_head, seen, std::chrono::milliseconds{100});
+      }
+      m_consumer_sleeping.store(0);
+    }
+  }
+
+private:
+  T m_items[N]{};
+  alignas(64) std::atomic<std::uint32_t> m_head{0};
+  std::atomic<std::uint32_t> m_consumer_sleeping{0};
+  alignas(64) std::atomic<std::uint32_t> m_tail{0};
+};
+
+} // namespace aura
@@ -0,0 +1,264 @@
+#include "trace.h"
+#include "platform.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# include <intrin.h>
+# define AURA_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+# define AURA_HAS_TSC 1
+#endif
+
+namespace aura
+{
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace
+{
+
+struct trace_event
+{
+  char const* name;
+  std::uint64_t begin;
+  std::uint64_t end;
+};
+
+//! Spans of one thread. Only that thread writes; trace_dump() reads the
+//! events published through 'count'.
+struct trace_buffer
+{
+  static constexpr size_t chunk_size = 4096;
+  static constexpr size_t max_chunks = 256; //!< ~1M spans per thread per trace
+
+  ~trace_buffer()
+  {
+    for (auto& c : chunks)
+    {
+      delete[] c.load();
+    }
+  }
+
+  void record(trace_event const& e, std::uint32_t current_generation) noexcept
+  {
+    if (generation.load(std::memory_order_relaxed) != current_generation)
+    {
+      count.store(0, std::memory_order_relaxed);
+      generation.store(current_generation, std::memory_order_release);
+    }
+
+    auto const n = count.load(std::memory_order_relaxed);
+    if (n == chunk_size * max_chunks)
+    {
+      return;
+    }
+    auto* chunk = chunks[n / chunk_size].load(std::memory_order_relaxed);
+    if (!chunk)
+    {
+      chunk = new (std::nothrow) trace_event[chunk_size];
+      if (!chunk)
+      {
+        return;
+      }
+      chunks[n / chunk_size].store(chunk, std::memory_order_release);
+    }
+    chunk[n % chunk_size] = e;
+    count.store(n + 1, std::memory_order_release);
+  }
+
+  std::atomic<trace_event*> chunks[max_chunks]{};
+  std::atomic<size_t> count{0};
+  std::atomic<std::uint32_t> generation{0};
+  std::atomic<char const*> name{nullptr};
+  int tid{0};
+};
+
+struct trace_state
+{
+  std::mutex mutex;
+  std::vector<std::shared_ptr<trace_buffer>> buffers; //!< kept after their thread exits
+  int next_tid{1};
+
+  std::atomic<std::uint32_t> generation{0};
+
+  //! Pairs of counter and clock readings that convert ticks to time
+  std::uint64_t start_ticks{0};
+  std::chrono::steady_clock::time_point start_time;
+};
+
+trace_state& state()
+{
+  static trace_state s;
+  return s;
+}
+
+trace_buffer& thread_buffer()
+{
+  thread_local std::shared_ptr<trace_buffer> buffer = []
+  {
+    auto b = std::make_shared<trace_buffer>();
+    auto& s = state();
+    std::lock_guard lock{s.mutex};
+    b->tid = s.next_tid++;
+    s.buffers.push_back(b);
+    return b;
+  }();
+  return *buffer;
+}
+
+void write_json_string(std::FILE* f, char const* s)
+{
+  std::fputc('"', f);
+  for (; *s; ++s)
+  {
+    if (*s == '"' || *s == '\\')
+    {
+      std::fputc('\\', f);
+    }
+    std::fputc(static_cast<unsigned char>(*s) < 0x20 ? ' ' : *s, f);
+  }
+  std::fputc('"', f);
+}
+
+//! Honours AURA_TRACE for the whole run
+struct trace_from_environment
+{
+  trace_from_environment()
+  {
+    if (auto const* path = std::getenv("AURA_TRACE"); path && *path)
+    {
+      m_path = path;
+      trace_start();
+    }
+  }
+
+  ~trace_from_environment()
+  {
+    if (!m_path.empty())
+    {
+      trace_stop();
+      trace_dump(m_path);
+    }
+  }
+
+  std::string m_path;
+};
+
+trace_from_environment g_trace_from_environment;
+
+} // namespace {}
+
+std::uint64_t trace_now() noexcept
+{
+#ifdef AURA_HAS_TSC
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+void trace_start()
+{
+  auto& s = state();
+  {
+    std::lock_guard lock{s.mutex};
+    s.start_time = std::chrono::steady_clock::now();
+    s.start_ticks = trace_now();
+    // buffers reset themselves when they see the new generation
+    s.generation.fetch_add(1);
+  }
+  g_trace_enabled = true;
+}
+
+void trace_stop() noexcept
+{
+  g_trace_enabled = false;
+}
+
+void trace_set_thread_name(char const* name) noexcept
+{
+  thread_buffer().name.store(name, std::memory_order_release);
+}
+
+void trace_record(char const* name, std::uint64_t begin, std::uint64_t end) noexcept
+{
+  thread_buffer().record(trace_event{name, begin, end}, state().generation.load(std::memory_order_relaxed));
+}
+
+std::error_code trace_dump(std::filesystem::path const& path)
+{
+  auto& s = state();
+  std::vector<std::shared_ptr<trace_buffer>> buffers;
+  std::uint64_t start_ticks{};
+  std::chrono::steady_clock::time_point start_time;
+  std::uint32_t generation{};
+  {
+    std::lock_guard lock{s.mutex};
+    buffers = s.buffers;
+    start_ticks = s.start_ticks;
+    start_time = s.start_time;
+    generation = s.generation.load();
+  }
+
+  // calibrate the counter against the clock over the whole trace
+  auto const elapsed_ticks = static_cast<double>(trace_now() - start_ticks);
+  auto const elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+  auto const us_per_tick = elapsed_ticks > 0 ? elapsed_us / elapsed_ticks : 0.0;
+
+  auto* f = std::fopen(path.string().c_str(), "w");
+  if (!f)
+  {
+    return std::error_code{errno, std::generic_category()};
+  }
+
+  auto const pid = current_process_id();
+  std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  auto first = true;
+  for (auto const& b : buffers)
+  {
+    if (b->generation.load(std::memory_order_acquire) != generation)
+    {
+      continue;
+    }
+    if (auto const* name = b->name.load(std::memory_order_acquire))
+    {
+      std::fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+        first ? "" : ",\n", pid, b->tid);
+      write_json_string(f, name);
+      std::fprintf(f, "}}");
+      first = false;
+    }
+
+    auto const n = b->count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i)
+    {
+      auto const& e = b->chunks[i / trace_buffer::chunk_size].load(std::memory_order_acquire)[i % trace_buffer::chunk_size];
+      if (e.begin < start_ticks)
+      {
+        continue;
+      }
+      std::fprintf(f, "%s{\"ph\":\"X\",\"name\":", first ? "" : ",\n");
+      write_json_string(f, e.name);
+      std::fprintf(f, ",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", pid, b->tid,
+        static_cast<double>(e.begin - start_ticks) * us_per_tick, static_cast<double>(e.end - e.begin) * us_per_tick);
+      first = false;
+    }
+  }
+  std::fprintf(f, "\n]}\n");
+  auto const failed = std::ferror(f) != 0;
+  std::fclose(f);
+  if (failed)
+  {
+    return make_error_code(std::errc::io_error);
+  }
+  return {};
+}
+
+} // namespace aura
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+
+namespace aura
+{
+
+//! Span tracing for AURA_ENTER and AURA_TRACE_SCOPE.
+//!
+//! While tracing is on, each span's name and begin/end timestamps (the CPU
+//! timestamp counter where there is one) go into a buffer owned by the
+//! calling thread. trace_dump() writes everything recorded since
+//! trace_start() as Chrome trace-event JSON, which Perfetto and
+//! chrome://tracing load directly. Off, a span costs a relaxed load.
+//!
+//! Setting AURA_TRACE=<file> in the environment traces the whole run and
+//! dumps it to <file> at exit.
+
+extern std::atomic<bool> g_trace_enabled;
+
+inline bool trace_enabled() noexcept
+{
+  return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+//! Starts a new trace, forgetting spans recorded before
+void trace_start();
+
+void trace_stop() noexcept;
+
+std::error_code trace_dump(std::filesystem::path const& path);
+
+//! Names the calling thread in traces. 'name' must outlive the trace,
+//! typically a string literal.
+void trace_set_thread_name(char const* name) noexcept;
+
+std::uint64_t trace_now() noexcept;
+
+void trace_record(char const* name, std::uint64_t begin, std::uint64_t end) noexcept;
+
+class trace_span
+{
+public:
+  //! 'name' must outlive the trace, e.g. __FUNCTION__ or a literal
+  explicit trace_span(char const* name) noexcept
+    : m_name{trace_enabled() ? name : nullptr}
+    , m_begin{m_name ? trace_now() : 0}
+  {
+  }
+
+  ~trace_span()
+  {
+    if (m_name)
+    {
+      trace_record(m_name, m_begin, trace_now());
+    }
+  }
+
+  trace_span(trace_span const&) = delete;
+  trace_span& operator=(trace_span const&) = delete;
+
+private:
+  char const* const m_name;
+  std::uint64_t const m_begin;
+};
+
+} // namespace aura
+
+//! Traces the rest of the enclosing scope as a span named 'name'
+#define AURA_TRACE_SCOPE(name) ::aura::trace_span const aura_trace_span_{name}
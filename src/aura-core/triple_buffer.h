@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace aura
+{
+
+//! Hands the latest of a stream of values from one producer thread to one
+//! consumer thread. Neither side ever waits: the producer writes into a
+//! slot of its own and swaps it with the middle one, the consumer swaps
+//! its slot with the middle one when that holds something newer. Values
+//! the consumer was too slow to take are overwritten, by the producer.
+template <typename T>
+class triple_buffer
+{
+public:
+  //! Producer: makes 'value' the latest
+  void publish(T value)
+  {
+    m_slots[m_back] = std::move(value);
+    m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) & index_mask;
+  }
+
+  //! Consumer: takes the latest value if one was published since the last
+  //! call; false if latest() is still the newest
+  bool update()
+  {
+    if (!(m_middle.load(std::memory_order_relaxed) & fresh))
+    {
+      return false;
+    }
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index_mask;
+    return true;
+  }
+
+  //! Consumer: the value taken by the last successful update()
+  T const& latest() const noexcept
+  {
+    return m_slots[m_front];
+  }
+
+private:
+  static constexpr unsigned index_mask = 3;
+  static constexpr unsigned fresh = 4;  //!< the middle slot hasn't been taken
+
+  T m_slots[3]{};
+  alignas(64) std::atomic<unsigned> m_middle{1};
+  alignas(64) unsigned m_back{2};   //!< producer only
+  alignas(64) unsigned m_front{0};  //!< consumer only
+};
+
+} // namespace aura
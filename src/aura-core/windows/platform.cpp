@@ -1,5 +1,10 @@
 #include "aura-core/platform.h"
+#include <cerrno>
+#include <cstdint>
 #include <cstdio>
+#include <io.h>
+#include <windows.h>
+#include <psapi.h>
 
 // platform-specific defines
 
@@ -13,12 +18,217 @@ std::string to_utf8_string(std::wstring_view const& view)
     auto const num_chars = 
         snprintf(dummy, 2, "%.*ls", static_cast<int>(view.size()), view.data());
 
+    if (num_chars <= 0)
+    {
+        return {};
+    }
+
     std::string buffer;
     buffer.assign(num_chars, '\0');
 
-    snprintf(buffer.data(), buffer.size(), "%.*ls", static_cast<int>(view.size()), view.data());
+    // + 1 for the terminator snprintf insists on writing
+    snprintf(buffer.data(), buffer.size() + 1, "%.*ls", static_cast<int>(view.size()), view.data());
 
     return buffer;
 }
 
+void write_stdout(std::wstring_view text) noexcept
+{
+    auto const out = ::GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode{};
+    if (::GetConsoleMode(out, &mode))
+    {
+        DWORD written{};
+        ::WriteConsoleW(out, text.data(), static_cast<DWORD>(text.size()), &written, nullptr);
+        return;
+    }
+
+    // redirected: utf-8
+    auto const n = ::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+    std::string bytes(static_cast<size_t>(n), '\0');
+    ::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), bytes.data(), n, nullptr, nullptr);
+    DWORD written{};
+    ::WriteFile(out, bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr);
+}
+
+std::error_code sync_file(std::FILE* file)
+{
+    if (std::fflush(file) != 0 || ::_commit(::_fileno(file)) != 0)
+    {
+        return std::error_code{errno, std::generic_category()};
+    }
+    return {};
+}
+
+std::error_code sync_directory(std::filesystem::path const&)
+{
+    // NTFS journals metadata; directories cannot be flushed on their own
+    return {};
+}
+
+std::chrono::nanoseconds thread_cpu_time() noexcept
+{
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    ::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user);
+    auto const to_100ns = [](FILETIME const& t)
+    {
+        return (static_cast<std::uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return std::chrono::nanoseconds{(to_100ns(kernel) + to_100ns(user)) * 100};
+}
+
+std::pair<std::error_code, void*> map_shared_memory(std::string const& name, size_t size, bool create)
+{
+    auto const wname = std::wstring(L"Local\\") + std::wstring(name.begin(), name.end());
+    auto const mapping = create
+        ? ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32), static_cast<DWORD>(size), wname.c_str())
+        : ::OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wname.c_str());
+    if (!mapping)
+    {
+        return {std::error_code{static_cast<int>(::GetLastError()), std::system_category()}, nullptr};
+    }
+    auto const data = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    auto const e = data ? std::error_code{} : std::error_code{static_cast<int>(::GetLastError()), std::system_category()};
+    // the view keeps the mapping alive
+    ::CloseHandle(mapping);
+    return {e, data};
+}
+
+void unmap_shared_memory(void* data, size_t) noexcept
+{
+    ::UnmapViewOfFile(data);
+}
+
+void remove_shared_memory(std::string const&) noexcept
+{
+    // mappings go away with their last view
+}
+
+shared_wakeup::~shared_wakeup()
+{
+    if (m_handle)
+    {
+        ::CloseHandle(m_handle);
+    }
+}
+
+std::error_code shared_wakeup::open(std::string const& name)
+{
+    // a word has one sleeper at most, so an auto-reset event will do; one
+    // set while nobody waits lets the next wait return at once, which
+    // futex_wait allows
+    auto const wname = std::wstring(L"Local\\") + std::wstring(name.begin(), name.end());
+    auto const event = ::CreateEventW(nullptr, FALSE, FALSE, wname.c_str());
+    if (!event)
+    {
+        return std::error_code{static_cast<int>(::GetLastError()), std::system_category()};
+    }
+    if (m_handle)
+    {
+        ::CloseHandle(m_handle);
+    }
+    m_handle = event;
+    return {};
+}
+
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout,
+    shared_wakeup const& wakeup) noexcept
+{
+    // WaitOnAddress only works within a process
+    if (word.load() == expected)
+    {
+        ::WaitForSingleObject(wakeup.handle(), static_cast<DWORD>(timeout.count()));
+    }
+}
+
+void futex_wake(std::atomic<std::uint32_t>&, shared_wakeup const& wakeup) noexcept
+{
+    ::SetEvent(wakeup.handle());
+}
+
+void wait_on_address(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout) noexcept
+{
+    ::WaitOnAddress(&word, &expected, sizeof(expected), static_cast<DWORD>(timeout.count()));
+}
+
+void wake_by_address(std::atomic<std::uint32_t>& word) noexcept
+{
+    ::WakeByAddressAll(&word);
+}
+
+int current_process_id() noexcept
+{
+    return static_cast<int>(::GetCurrentProcessId());
+}
+
+bool is_process_alive(int pid) noexcept
+{
+    auto const process = ::OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+    if (!process)
+    {
+        return ::GetLastError() != ERROR_INVALID_PARAMETER;
+    }
+    auto const alive = ::WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    ::CloseHandle(process);
+    return alive;
+}
+
+std::pair<std::error_code, process_usage> get_process_usage(int pid)
+{
+    auto const process = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+    if (!process)
+    {
+        return {std::error_code{static_cast<int>(::GetLastError()), std::system_category()}, {}};
+    }
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    PROCESS_MEMORY_COUNTERS memory{};
+    auto const ok = ::GetProcessTimes(process, &creation, &exit, &kernel, &user)
+        && ::K32GetProcessMemoryInfo(process, &memory, sizeof(memory));
+    auto const e = ok ? std::error_code{} : std::error_code{static_cast<int>(::GetLastError()), std::system_category()};
+    ::CloseHandle(process);
+    if (e)
+    {
+        return {e, {}};
+    }
+
+    auto const to_100ns = [](FILETIME const& t)
+    {
+        return (static_cast<std::uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    process_usage usage{};
+    usage.cpu_time = std::chrono::nanoseconds{(to_100ns(kernel) + to_100ns(user)) * 100};
+    usage.resident_bytes = memory.WorkingSetSize;
+    return {{}, usage};
+}
+
+namespace
+{
+
+// signalled by the console handler, which runs on a thread of its own
+HANDLE stop_event = nullptr;
+
+BOOL WINAPI on_console_event(DWORD) noexcept
+{
+    ::SetEvent(stop_event);
+    return TRUE;
+}
+
+} // namespace {}
+
+std::error_code catch_stop_requests()
+{
+    stop_event = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!stop_event || !::SetConsoleCtrlHandler(on_console_event, TRUE))
+    {
+        return std::error_code{static_cast<int>(::GetLastError()), std::system_category()};
+    }
+    return {};
+}
+
+void wait_for_stop_request() noexcept
+{
+    ::WaitForSingleObject(stop_event, INFINITE);
+}
+
 } // namespace aura
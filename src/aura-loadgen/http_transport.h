@@ -0,0 +1,35 @@
+#pragma once
+
+#include <aura-core/client_transport.h>
+#include <cpp-httplib/httplib.h>
+#include <string>
+
+namespace aura
+{
+
+//! client_transport over a keep-alive http connection to aura_server
+class http_transport : public client_transport
+{
+public:
+  http_transport(std::string const& host, int port)
+    : m_client{host, port}
+  {
+    m_client.set_keep_alive(true);
+    m_client.set_read_timeout(30, 0);
+  }
+
+  std::pair<std::error_code, std::string> request(std::string const& path, std::string const& body) override
+  {
+    auto const res = m_client.Post(path.c_str(), body, "application/octet-stream");
+    if (!res || res->status != 200)
+    {
+      return {make_error_code(std::errc::connection_refused), {}};
+    }
+    return {{}, res->body};
+  }
+
+private:
+  httplib::Client m_client;
+};
+
+} // namespace aura
@@ -0,0 +1,227 @@
+#include "load_client.h"
+#include <aura-core/rest_messages.h>
+#include <algorithm>
+#include <utility>
+
+namespace aura
+{
+
+namespace
+{
+
+//! Makes 'Request' and records its latency under 'e', counted from 'since'
+//! if the request was due before it could be sent. 'since' moves on to the
+//! response, as a request that follows it goes out straight away.
+template <typename Request>
+rest::server_response<typename Request::out> timed(load_endpoint e, client_transport& transport,
+  typename Request::in const& in, load_stats& stats, std::chrono::steady_clock::time_point& since)
+{
+  since = std::min(since, std::chrono::steady_clock::now());
+  auto response = rest::make_request<Request>(transport, in);
+  auto const end = std::chrono::steady_clock::now();
+  auto const us = std::chrono::duration_cast<std::chrono::microseconds>(end - std::exchange(since, end));
+  stats.latency_us[static_cast<int>(e)].record(static_cast<std::uint64_t>(us.count()));
+  if (response.error)
+  {
+    stats.errors[static_cast<int>(e)]++;
+  }
+  return response;
+}
+
+} // namespace {}
+
+char const* to_string(load_endpoint e) noexcept
+{
+  switch (e)
+  {
+  case load_endpoint::new_session: return rest::new_session::path;
+  case load_endpoint::get_session_info: return rest::get_session_info::path;
+  case load_endpoint::commit_action: return rest::commit_action::path;
+  case load_endpoint::get_target_list: return rest::get_target_list::path;
+  default: return "?";
+  }
+}
+
+void load_stats::merge(load_stats const& other) noexcept
+{
+  for (int i = 0; i < static_cast<int>(load_endpoint::count); ++i)
+  {
+    latency_us[i].merge(other.latency_us[i]);
+    errors[i] += other.errors[i];
+  }
+  games_finished += other.games_finished;
+  games_forfeited += other.games_forfeited;
+}
+
+std::uint64_t load_stats::num_requests() const noexcept
+{
+  std::uint64_t n = 0;
+  for (auto const& h : latency_us)
+  {
+    n += h.count();
+  }
+  return n;
+}
+
+load_client::load_client(int id, load_client_config const& config, std::uint64_t seed)
+  : m_id{id}
+  , m_config{config}
+  , m_rng{seed}
+{
+}
+
+std::chrono::steady_clock::time_point load_client::step(client_transport& transport, load_stats& stats,
+  time_point due)
+{
+  // what the client wants next is timed from when this step's requests
+  // came back
+  auto const next = [](std::chrono::milliseconds delay = {}) { return std::chrono::steady_clock::now() + delay; };
+  auto since = due;
+  if (!m_in_game)
+  {
+    // blocks until the matchmaker pairs us with another client
+    auto const r = timed<rest::new_session>(load_endpoint::new_session, transport,
+      {game_mode::PvP, "load" + std::to_string(m_id), 1500}, stats, since);
+    if (r.error || r.value.error)
+    {
+      return next(m_config.poll_interval);
+    }
+    m_session_id = r.value.session_id;
+    m_seat = r.value.seat;
+    m_seat_token = r.value.seat_token;
+    m_in_game = true;
+    m_fresh = false;
+    return next();
+  }
+
+  if (!m_fresh)
+  {
+    auto r = timed<rest::get_session_info>(load_endpoint::get_session_info, transport,
+      {m_session_id, m_seat_token}, stats, since);
+    if (r.error || r.value.error)
+    {
+      // the session is gone, e.g. forfeited by its turn timer
+      m_in_game = !r.value.error;
+      return next(m_config.poll_interval);
+    }
+    m_session = std::move(r.value.session);
+  }
+
+  if (m_session.game_over)
+  {
+    stats.games_finished++;
+    m_in_game = false;
+    return next();
+  }
+  if (m_session.current_player != m_seat)
+  {
+    m_fresh = false;
+    return next(m_config.poll_interval);
+  }
+
+  auto action = choose(transport, stats, since);
+  if (m_session.turn > m_config.max_turns)
+  {
+    action = {action_type::forfeit, 0, 0};
+    stats.games_forfeited++;
+  }
+
+  auto r = timed<rest::commit_action>(load_endpoint::commit_action, transport, {m_session_id, m_seat_token, {action}},
+    stats, since);
+  if (r.error)
+  {
+    m_fresh = false;
+    return next(m_config.poll_interval);
+  }
+  if (r.value.num_applied == 0)
+  {
+    // the server knows better; don't try that card again this turn
+    m_tried.push_back(action.target1);
+  }
+  m_session = std::move(r.value.session);
+  m_fresh = true;
+  return next();
+}
+
+player_action load_client::choose(client_transport& transport, load_stats& stats, time_point& since)
+{
+  if (m_tried_turn != m_session.turn)
+  {
+    m_tried.clear();
+    m_tried_turn = m_session.turn;
+  }
+
+  auto const& me = m_session.players[m_seat];
+  auto const num_lanes = static_cast<int>(me.lanes.size());
+  auto const random = m_config.policy == load_policy::random;
+
+  if (!m_session.picks.empty() && me.picks_available > 0)
+  {
+    auto best = m_session.picks.begin();
+    if (random)
+    {
+      best += static_cast<std::ptrdiff_t>(m_rng.below(m_session.picks.size()));
+    }
+    else
+    {
+      best = std::max_element(m_session.picks.begin(), m_session.picks.end(),
+        [](auto const& a, auto const& b) { return a.cost < b.cost; });
+    }
+    return {action_type::pick, best->uid, best->uid};
+  }
+
+  std::vector<card_info const*> deployable;
+  for (auto const& card : me.hand)
+  {
+    if (card.cost <= me.mana && !card.has_trait(unit_traits::item) && !tried(card.uid))
+    {
+      deployable.push_back(&card);
+    }
+  }
+  if (!deployable.empty() && num_lanes > 0 && (!random || m_rng.below(3) != 0))
+  {
+    auto const* card = deployable[m_rng.below(deployable.size())];
+    auto lane = static_cast<int>(m_rng.below(static_cast<std::uint64_t>(num_lanes)));
+    if (!random)
+    {
+      card = *std::max_element(deployable.begin(), deployable.end(),
+        [](auto const* a, auto const* b) { return a->cost < b->cost; });
+      lane = static_cast<int>(std::min_element(me.lanes.begin(), me.lanes.end(),
+        [](auto const& a, auto const& b) { return a.size() < b.size(); }) - me.lanes.begin());
+    }
+    return {action_type::deploy, card->uid, lane + 1};
+  }
+
+  for (auto const& lane : me.lanes)
+  {
+    for (auto const& card : lane)
+    {
+      if (card.energy <= 0 || card.action_type == card_action_type::none || tried(card.uid))
+      {
+        continue;
+      }
+      m_tried.push_back(card.uid);
+      if (random && m_rng.below(2) == 0)
+      {
+        continue;
+      }
+
+      auto const r = timed<rest::get_target_list>(load_endpoint::get_target_list, transport,
+        {m_session_id, m_seat_token, card.uid}, stats, since);
+      if (!r.error && !r.value.error && !r.value.targets.empty())
+      {
+        auto const& targets = r.value.targets;
+        return {action_type::primary_action, card.uid, random ? targets[m_rng.below(targets.size())] : targets.front()};
+      }
+    }
+  }
+
+  return {action_type::end_turn, 0, 0};
+}
+
+bool load_client::tried(int uid) const
+{
+  return std::find(m_tried.begin(), m_tried.end(), uid) != m_tried.end();
+}
+
+} // namespace aura
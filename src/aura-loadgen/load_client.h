@@ -0,0 +1,94 @@
+#pragma once
+
+#include <aura-core/client_transport.h>
+#include <aura-core/histogram.h>
+#include <aura-core/random.h>
+#include <aura-core/session_info.h>
+#include <aura-core/player_action.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aura
+{
+
+enum class load_policy
+{
+  random, //!< any action that looks possible
+  greedy  //!< best pick, most expensive deploy, attack whenever a unit can
+};
+
+enum class load_endpoint : int
+{
+  new_session,
+  get_session_info,
+  commit_action,
+  get_target_list,
+  count
+};
+
+char const* to_string(load_endpoint e) noexcept;
+
+struct load_client_config
+{
+  load_policy policy{load_policy::random};
+
+  //! Games still running after this many turns are forfeited
+  int max_turns{60};
+
+  //! How often a client waiting for its opponent asks for the session
+  std::chrono::milliseconds poll_interval{50};
+};
+
+//! What a group of clients measured; merged across workers for reports
+struct load_stats
+{
+  //! From when a client was due to make a request to its response, so time
+  //! spent queued behind the other clients on a connection counts
+  histogram latency_us[static_cast<int>(load_endpoint::count)];
+  std::uint64_t errors[static_cast<int>(load_endpoint::count)]{};
+  std::uint64_t games_finished{};
+  std::uint64_t games_forfeited{};
+
+  void merge(load_stats const& other) noexcept;
+
+  std::uint64_t num_requests() const noexcept;
+};
+
+//! A synthetic player. It joins a game, plays it to the end through the
+//! rest:: requests, and joins the next one.
+class load_client
+{
+public:
+  load_client(int id, load_client_config const& config, std::uint64_t seed);
+
+  //! Makes the client's next request over 'transport', which it was 'due'
+  //! to make, and returns when it wants to make the one after
+  std::chrono::steady_clock::time_point step(client_transport& transport, load_stats& stats,
+    std::chrono::steady_clock::time_point due);
+
+private:
+  using time_point = std::chrono::steady_clock::time_point;
+
+  player_action choose(client_transport& transport, load_stats& stats, time_point& since);
+
+  bool tried(int uid) const;
+
+  int const m_id;
+  load_client_config const& m_config;
+  random_engine m_rng;
+
+  int m_session_id{0};
+  int m_seat{0};
+  std::uint64_t m_seat_token{0};
+  bool m_in_game{false};
+  bool m_fresh{false}; //!< m_session is the server's latest
+  session_info m_session;
+
+  //! Cards whose action was already tried this turn
+  std::vector<int> m_tried;
+  int m_tried_turn{-1};
+};
+
+} // namespace aura
@@ -0,0 +1,293 @@
+#include "load_client.h"
+#include "http_transport.h"
+#include <aura-core/build.h>
+#include <aura-core/platform.h>
+#include <aura-core/shm_transport.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct loadgen_options
+{
+  int num_clients{1000};
+  int num_workers{64}; //!< connections to the server; each drives a share of the clients
+  std::chrono::seconds duration{30};
+  aura::load_client_config client;
+  std::string host{"localhost"};
+  int port{1234};
+  bool use_shm{false};
+  int server_pid{0};      //!< sampled for CPU and RSS if set
+  std::string hgrm_path;  //!< percentile distributions are written here if set
+};
+
+//! Deltas published by the workers, collected by the reporter
+struct shared_stats
+{
+  std::mutex mutex;
+  aura::load_stats pending;
+};
+
+//! Drives the clients of 'worker' over 'transport', or over http if null
+void run_worker(loadgen_options const& options, int worker, std::unique_ptr<aura::client_transport> transport,
+  shared_stats& shared, std::atomic<bool> const& stop)
+{
+  if (!transport)
+  {
+    transport = std::make_unique<aura::http_transport>(options.host, options.port);
+  }
+
+  std::vector<aura::load_client> clients;
+  std::vector<std::chrono::steady_clock::time_point> due;
+  for (int id = worker; id < options.num_clients; id += options.num_workers)
+  {
+    clients.emplace_back(id, options.client, static_cast<std::uint64_t>(id) * 0x9e3779b97f4a7c15ull + 1);
+    due.emplace_back(std::chrono::steady_clock::now());
+  }
+  if (clients.empty())
+  {
+    return;
+  }
+
+  auto local = std::make_unique<aura::load_stats>();
+  auto next_publish = std::chrono::steady_clock::now();
+  while (!stop)
+  {
+    auto const now = std::chrono::steady_clock::now();
+    if (now >= next_publish)
+    {
+      std::lock_guard lock{shared.mutex};
+      shared.pending.merge(*local);
+      *local = aura::load_stats{};
+      next_publish = now + std::chrono::milliseconds{250};
+    }
+
+    auto const i = static_cast<size_t>(std::min_element(due.begin(), due.end()) - due.begin());
+    if (due[i] > now)
+    {
+      std::this_thread::sleep_until(std::min(due[i], next_publish));
+      continue;
+    }
+    // a client stepped late, behind the others on this connection, counts
+    // the delay in its latency
+    due[i] = clients[i].step(*transport, *local, due[i]);
+  }
+
+  std::lock_guard lock{shared.mutex};
+  shared.pending.merge(*local);
+}
+
+void write_hgrm(std::string const& path, aura::load_stats const& stats)
+{
+  auto* f = std::fopen(path.c_str(), "w");
+  if (!f)
+  {
+    AURA_ERROR(std::error_code(errno, std::generic_category()), L"Cannot write %hs", path.c_str());
+    return;
+  }
+  for (int e = 0; e < static_cast<int>(aura::load_endpoint::count); ++e)
+  {
+    auto const& h = stats.latency_us[e];
+    std::fprintf(f, "# %s (us)\n%12s %14s %10s %14s\n\n", aura::to_string(static_cast<aura::load_endpoint>(e)),
+      "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    std::uint64_t seen = 0;
+    for (int i = 0; i < aura::histogram::num_buckets && seen < h.count(); ++i)
+    {
+      if (!h.bucket_count(i))
+      {
+        continue;
+      }
+      seen += h.bucket_count(i);
+      auto const p = static_cast<double>(seen) / static_cast<double>(h.count());
+      auto const value = std::min(aura::histogram::bucket_upper_bound(i), h.max());
+      if (p < 1.0)
+      {
+        std::fprintf(f, "%12.3f %14.12f %10llu %14.2f\n", static_cast<double>(value), p,
+          static_cast<unsigned long long>(seen), 1.0 / (1.0 - p));
+      }
+      else
+      {
+        std::fprintf(f, "%12.3f %14.12f %10llu\n", static_cast<double>(value), p, static_cast<unsigned long long>(seen));
+      }
+    }
+    std::fprintf(f, "#[Mean = %12.3f, Max = %12.3f, Total count = %12llu]\n\n", h.mean(), static_cast<double>(h.max()),
+      static_cast<unsigned long long>(h.count()));
+  }
+  std::fclose(f);
+}
+
+} // namespace {}
+
+int wmain(int argc, wchar_t** argv)
+{
+  loadgen_options options{};
+  for (int i = 1; i < argc; ++i)
+  {
+    auto const option = std::wstring_view{argv[i]};
+    auto const value = [&] { return i + 1 < argc ? std::wstring{argv[++i]} : std::wstring{L"0"}; };
+    auto const narrow = [&] { return aura::to_utf8_string(value()); };
+    if (option == L"--clients")
+    {
+      options.num_clients = std::stoi(value());
+    }
+    else if (option == L"--workers")
+    {
+      options.num_workers = std::stoi(value());
+    }
+    else if (option == L"--duration")
+    {
+      options.duration = std::chrono::seconds{std::stoi(value())};
+    }
+    else if (option == L"--policy")
+    {
+      options.client.policy = value() == L"greedy" ? aura::load_policy::greedy : aura::load_policy::random;
+    }
+    else if (option == L"--max-turns")
+    {
+      options.client.max_turns = std::stoi(value());
+    }
+    else if (option == L"--host")
+    {
+      options.host = narrow();
+    }
+    else if (option == L"--port")
+    {
+      options.port = std::stoi(value());
+    }
+    else if (option == L"--shm")
+    {
+      options.use_shm = true;
+    }
+    else if (option == L"--server-pid")
+    {
+      options.server_pid = std::stoi(value());
+    }
+    else if (option == L"--hgrm")
+    {
+      options.hgrm_path = narrow();
+    }
+  }
+  // a worker blocks in new_session until another worker's client joins
+  options.num_workers = std::max(2, std::min(options.num_workers, options.num_clients));
+
+  // the server has a fixed number of shared-memory channels and every worker
+  // holds one, so claim them before reporting how many connections there are
+  std::vector<std::unique_ptr<aura::client_transport>> transports(options.num_workers);
+  if (options.use_shm)
+  {
+    int num_connected = 0;
+    for (; num_connected < options.num_workers; ++num_connected)
+    {
+      auto [error, t] = aura::make_shm_transport();
+      if (error)
+      {
+        break;
+      }
+      transports[num_connected] = std::move(t);
+    }
+    if (num_connected < 2)
+    {
+      AURA_PRINT(L"Only %d shared-memory channels are free, at least 2 are needed\n", num_connected);
+      return 1;
+    }
+    if (num_connected < options.num_workers)
+    {
+      AURA_PRINT(L"Only %d of %d shared-memory channels are free, running %d workers\n", num_connected,
+        options.num_workers, num_connected);
+      options.num_workers = num_connected;
+      transports.resize(num_connected);
+    }
+  }
+
+  AURA_PRINT(L"%d clients on %d %hs connections for %llds, %hs policy\n", options.num_clients, options.num_workers,
+    options.use_shm ? "shared-memory" : "http", static_cast<long long>(options.duration.count()),
+    options.client.policy == aura::load_policy::greedy ? "greedy" : "random");
+  AURA_PRINT(L"Up to %d clients share a connection and take turns on it; latency counts from when a client was due "
+    L"to send, including its wait for the others\n", (options.num_clients + options.num_workers - 1) / options.num_workers);
+
+  shared_stats shared;
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> workers;
+  for (int w = 0; w < options.num_workers; ++w)
+  {
+    workers.emplace_back([&, w] { run_worker(options, w, std::move(transports[w]), shared, stop); });
+  }
+
+  // one line per second: throughput, commit latency and how the server is doing
+  aura::load_stats total;
+  auto const start = std::chrono::steady_clock::now();
+  auto last = start;
+  auto last_usage = aura::process_usage{};
+  if (options.server_pid)
+  {
+    last_usage = aura::get_process_usage(options.server_pid).second;
+  }
+  AURA_PRINT(L"%6ls %10ls %8ls %12ls %12ls %10ls %10ls\n", L"t(s)", L"req/s", L"games", L"commit p50", L"commit p99",
+    L"server cpu", L"server rss");
+  while (last - start < options.duration)
+  {
+    std::this_thread::sleep_until(last + std::chrono::seconds{1});
+    auto const now = std::chrono::steady_clock::now();
+    aura::load_stats interval;
+    {
+      std::lock_guard lock{shared.mutex};
+      std::swap(interval, shared.pending);
+    }
+    total.merge(interval);
+
+    auto const seconds = std::chrono::duration<double>(now - last).count();
+    auto const& commits = interval.latency_us[static_cast<int>(aura::load_endpoint::commit_action)];
+    double cpu_percent = 0.0;
+    double rss_mb = 0.0;
+    if (options.server_pid)
+    {
+      if (auto const [error, usage] = aura::get_process_usage(options.server_pid); !error)
+      {
+        cpu_percent = 100.0 * std::chrono::duration<double>(usage.cpu_time - last_usage.cpu_time).count() / seconds;
+        rss_mb = static_cast<double>(usage.resident_bytes) / (1024.0 * 1024.0);
+        last_usage = usage;
+      }
+    }
+    AURA_PRINT(L"%6.0f %10.0f %8llu %10lluus %10lluus %9.0f%% %8.1fMB\n",
+      std::chrono::duration<double>(now - start).count(), static_cast<double>(interval.num_requests()) / seconds,
+      static_cast<unsigned long long>(total.games_finished), static_cast<unsigned long long>(commits.value_at_percentile(50.0)),
+      static_cast<unsigned long long>(commits.value_at_percentile(99.0)), cpu_percent, rss_mb);
+    last = now;
+  }
+
+  stop = true;
+  for (auto& w : workers)
+  {
+    w.join();
+  }
+  total.merge(shared.pending);
+
+  auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  AURA_PRINT(L"\n%-18hs %10ls %8ls %8ls %8ls %8ls %8ls %8ls\n", "endpoint (us)", L"requests", L"req/s", L"errors", L"p50",
+    L"p99", L"p999", L"max");
+  for (int e = 0; e < static_cast<int>(aura::load_endpoint::count); ++e)
+  {
+    auto const& h = total.latency_us[e];
+    AURA_PRINT(L"%-18hs %10llu %8.0f %8llu %8llu %8llu %8llu %8llu\n", aura::to_string(static_cast<aura::load_endpoint>(e)),
+      static_cast<unsigned long long>(h.count()), static_cast<double>(h.count()) / elapsed,
+      static_cast<unsigned long long>(total.errors[e]), static_cast<unsigned long long>(h.value_at_percentile(50.0)),
+      static_cast<unsigned long long>(h.value_at_percentile(99.0)),
+      static_cast<unsigned long long>(h.value_at_percentile(99.9)), static_cast<unsigned long long>(h.max()));
+  }
+  AURA_PRINT(L"games finished: %llu (%llu forfeited at the turn limit), %.0f requests/s overall\n",
+    static_cast<unsigned long long>(total.games_finished), static_cast<unsigned long long>(total.games_forfeited),
+    static_cast<double>(total.num_requests()) / elapsed);
+
+  if (!options.hgrm_path.empty())
+  {
+    write_hgrm(options.hgrm_path, total);
+  }
+  return 0;
+}
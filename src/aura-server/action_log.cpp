@@ -0,0 +1,533 @@
+#include "action_log.h"
+#include <aura-core/build.h>
+#include <aura-core/platform.h>
+#include <aura-core/serialization.h>
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+namespace aura
+{
+
+namespace
+{
+
+// A segment record is [length][payload][checksum] where the payload is the
+// record kind and the session, then for an action the session version and
+// the action, and for a snapshot the snapshot file. A snapshot file is
+// [version][length-prefixed snapshot][checksum].
+
+enum class record_kind : int
+{
+  action,
+  snapshot,
+  remove
+};
+
+std::uint32_t checksum(std::string_view data) noexcept
+{
+  // FNV-1a
+  std::uint32_t h = 2166136261u;
+  for (auto const c : data)
+  {
+    h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+  }
+  return h;
+}
+
+void write_checksum(byte_writer& w, std::string_view data)
+{
+  auto const h = checksum(data);
+  for (int i = 0; i < 4; ++i)
+  {
+    w.buffer.push_back(static_cast<char>((h >> (8 * i)) & 0xff));
+  }
+}
+
+bool read_checksum(byte_reader& r, std::string_view data)
+{
+  if (r.failed || r.buffer.size() - r.pos < 4)
+  {
+    r.failed = true;
+    return false;
+  }
+  std::uint32_t h{};
+  for (int i = 0; i < 4; ++i)
+  {
+    h |= static_cast<std::uint32_t>(static_cast<unsigned char>(r.buffer[r.pos++])) << (8 * i);
+  }
+  return h == checksum(data);
+}
+
+std::string encode_record(record_kind kind, int session_id, std::string_view body)
+{
+  byte_writer payload;
+  payload.write_int(static_cast<int>(kind));
+  payload.write_int(session_id);
+  payload.buffer += body;
+
+  byte_writer record;
+  record.write_int(static_cast<long long>(payload.buffer.size()));
+  record.buffer += payload.buffer;
+  write_checksum(record, payload.buffer);
+  return std::move(record.buffer);
+}
+
+//! Reads a snapshot file into 's'; false if it is damaged
+bool read_snapshot(std::string_view data, recovered_session& s)
+{
+  byte_reader snap{data};
+  s.version = static_cast<int>(snap.read_int());
+  s.snapshot = snap.read_string();
+  return read_checksum(snap, data.substr(0, snap.pos));
+}
+
+std::string read_file(std::filesystem::path const& path)
+{
+  std::ifstream in{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+//! Numbers of the segments in 'directory', oldest first
+std::vector<std::uint64_t> list_segments(std::filesystem::path const& directory)
+{
+  std::vector<std::uint64_t> segments;
+  std::error_code e;
+  for (auto const& entry : std::filesystem::directory_iterator{directory, e})
+  {
+    if (entry.path().extension() != ".seg")
+    {
+      continue;
+    }
+    try
+    {
+      segments.push_back(std::stoull(entry.path().stem().string()));
+    }
+    catch (std::exception const&)
+    {
+    }
+  }
+  std::sort(segments.begin(), segments.end());
+  return segments;
+}
+
+} // namespace {}
+
+action_log::action_log(action_log_config const& config)
+  : m_config{config}
+{
+  std::error_code e;
+  std::filesystem::create_directories(m_config.directory, e);
+  if (e)
+  {
+    AURA_ERROR(e, L"Failed to create action log directory %ls", m_config.directory.wstring().c_str());
+    m_error = e;
+  }
+  // a previous process's segments stay readable until the first rotation
+  if (auto const segments = list_segments(m_config.directory); !segments.empty())
+  {
+    m_oldest_segment = segments.front();
+    m_segment = segments.back() + 1;
+  }
+  m_thread = std::thread{[this] { flush_loop(); }};
+}
+
+action_log::~action_log()
+{
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+  if (m_segment_file)
+  {
+    std::fclose(m_segment_file);
+  }
+}
+
+action_log::ticket action_log::append(int session_id, int version, player_action const& action)
+{
+  byte_writer body;
+  body.write_int(version);
+  write(body, action);
+  auto const record = encode_record(record_kind::action, session_id, body.buffer);
+
+  std::lock_guard lock{m_mutex};
+  m_pending[session_id].records += record;
+  m_stats.num_records++;
+  m_wake.notify_one();
+  return ++m_last_queued;
+}
+
+action_log::ticket action_log::snapshot(int session_id, int version, std::string data)
+{
+  byte_writer payload;
+  payload.write_int(version);
+  payload.write_string(data);
+  write_checksum(payload, payload.buffer);
+
+  std::lock_guard lock{m_mutex};
+  auto& pending = m_pending[session_id];
+  // the snapshot already contains the effect of every queued record
+  pending.records.clear();
+  pending.snapshot = std::move(payload.buffer);
+  pending.remove = false;
+  m_stats.num_snapshots++;
+  m_wake.notify_one();
+  return ++m_last_queued;
+}
+
+action_log::ticket action_log::remove(int session_id)
+{
+  std::lock_guard lock{m_mutex};
+  auto& pending = m_pending[session_id];
+  pending = pending_writes{};
+  pending.remove = true;
+  m_wake.notify_one();
+  return ++m_last_queued;
+}
+
+std::error_code action_log::wait_durable(ticket t)
+{
+  std::unique_lock lock{m_mutex};
+  m_durable.wait(lock, [&] { return m_last_durable >= t; });
+  return m_error;
+}
+
+action_log_stats action_log::stats() const
+{
+  std::lock_guard lock{m_mutex};
+  return m_stats;
+}
+
+void action_log::flush_loop()
+{
+  trace_set_thread_name("action log");
+  std::unordered_map<int, pending_writes> batch;
+  std::unique_lock lock{m_mutex};
+  while (true)
+  {
+    m_wake.wait(lock, [&] { return m_stop || !m_pending.empty(); });
+    if (m_pending.empty())
+    {
+      return;
+    }
+
+    // everything queued while the previous batch was syncing goes out together
+    batch.swap(m_pending);
+    auto const batch_end = m_last_queued;
+    lock.unlock();
+
+    auto const e = flush(batch);
+    batch.clear();
+
+    lock.lock();
+    if (e && !m_error)
+    {
+      m_error = e;
+    }
+    m_stats.num_syncs++;
+    m_last_durable = batch_end;
+    m_durable.notify_all();
+  }
+}
+
+std::error_code action_log::flush(std::unordered_map<int, pending_writes>& batch)
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  // the segment holds every session of the batch, so a failure to write or
+  // sync it fails all of them
+  auto const fail = [&](std::error_code const& e)
+  {
+    for (auto const& [session_id, pending] : batch)
+    {
+      AURA_ERROR(e, L"Action log write failed for session %d", session_id);
+    }
+    abandon_segment();
+    return e;
+  };
+
+  std::string records;
+  for (auto const& [session_id, pending] : batch)
+  {
+    if (pending.remove)
+    {
+      records += encode_record(record_kind::remove, session_id, {});
+      continue;
+    }
+    if (!pending.snapshot.empty())
+    {
+      records += encode_record(record_kind::snapshot, session_id, pending.snapshot);
+    }
+    records += pending.records;
+  }
+
+  auto const created = !m_segment_file;
+  if (created)
+  {
+    m_segment_file = std::fopen(segment_path(m_segment).string().c_str(), "wb");
+    if (!m_segment_file)
+    {
+      return fail(std::error_code{errno, std::generic_category()});
+    }
+    m_segment_size = 0;
+    std::lock_guard lock{m_mutex};
+    m_stats.num_segments++;
+  }
+  if (std::fwrite(records.data(), 1, records.size(), m_segment_file) != records.size())
+  {
+    return fail(std::error_code{errno, std::generic_category()});
+  }
+  if (auto const e = sync_file(m_segment_file))
+  {
+    return fail(e);
+  }
+  if (created)
+  {
+    if (auto const e = sync_directory(m_config.directory))
+    {
+      return fail(e);
+    }
+  }
+  m_segment_size += records.size();
+
+  // the batch is durable; the snapshot files only save recovery from
+  // reading this segment
+  for (auto const& [session_id, pending] : batch)
+  {
+    if (pending.remove)
+    {
+      m_segment_uses.erase(session_id);
+      std::error_code ignored;
+      std::filesystem::remove(snapshot_path(session_id), ignored);
+      continue;
+    }
+
+    auto& use = m_segment_uses[session_id];
+    if (!pending.snapshot.empty())
+    {
+      use = segment_use{m_segment, 0, false};
+      if (auto const e = write_snapshot(session_id, pending.snapshot))
+      {
+        // the segment keeps the snapshot until the next one is written
+        AURA_ERROR(e, L"Failed to write the snapshot file of session %d", session_id);
+        use.snapshot_failed = true;
+      }
+    }
+    if (!pending.records.empty() && !use.first_record)
+    {
+      use.first_record = m_segment;
+    }
+  }
+
+  if (m_segment_size >= m_config.segment_bytes)
+  {
+    rotate();
+  }
+  return {};
+}
+
+void action_log::rotate()
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  std::fclose(m_segment_file);
+  m_segment_file = nullptr;
+  auto const next = m_segment + 1;
+
+  // once its snapshot file is durable, a session only needs the segments
+  // holding its actions after that snapshot
+  auto oldest_needed = next;
+  for (auto& [session_id, use] : m_segment_uses)
+  {
+    if (use.snapshot && !use.snapshot_failed)
+    {
+      auto* file = std::fopen(snapshot_path(session_id).string().c_str(), "ab");
+      auto const e = file ? sync_file(file) : std::error_code{errno, std::generic_category()};
+      if (file)
+      {
+        std::fclose(file);
+      }
+      if (e)
+      {
+        AURA_ERROR(e, L"Failed to sync the snapshot file of session %d", session_id);
+      }
+      else
+      {
+        use.snapshot = 0;
+      }
+    }
+    for (auto const segment : {use.snapshot, use.first_record})
+    {
+      if (segment)
+      {
+        oldest_needed = std::min(oldest_needed, segment);
+      }
+    }
+  }
+
+  // renamed and deleted snapshot files must be durable before the segments
+  // behind them go
+  if (auto const e = sync_directory(m_config.directory))
+  {
+    AURA_ERROR(e, L"Failed to sync action log directory %ls", m_config.directory.wstring().c_str());
+    oldest_needed = m_oldest_segment;
+  }
+  for (; m_oldest_segment < oldest_needed; ++m_oldest_segment)
+  {
+    std::error_code ignored;
+    std::filesystem::remove(segment_path(m_oldest_segment), ignored);
+  }
+  m_segment = next;
+}
+
+void action_log::abandon_segment()
+{
+  if (m_segment_file)
+  {
+    std::fclose(m_segment_file);
+    m_segment_file = nullptr;
+    ++m_segment;
+  }
+}
+
+std::error_code action_log::write_snapshot(int session_id, std::string const& data)
+{
+  auto const path = snapshot_path(session_id);
+  auto tmp_path = path;
+  tmp_path += ".tmp";
+
+  auto* file = std::fopen(tmp_path.string().c_str(), "wb");
+  if (!file)
+  {
+    return std::error_code{errno, std::generic_category()};
+  }
+  std::error_code e;
+  if (std::fwrite(data.data(), 1, data.size(), file) != data.size())
+  {
+    e = std::error_code{errno, std::generic_category()};
+  }
+  std::fclose(file);
+  if (!e)
+  {
+    std::filesystem::rename(tmp_path, path, e);
+  }
+  return e;
+}
+
+std::vector<recovered_session> action_log::recover() const
+{
+  std::map<int, recovered_session> found;
+  std::error_code e;
+  for (auto const& entry : std::filesystem::directory_iterator{m_config.directory, e})
+  {
+    if (entry.path().extension() != ".snap")
+    {
+      continue;
+    }
+
+    recovered_session s{};
+    try
+    {
+      s.session_id = std::stoi(entry.path().stem().string());
+    }
+    catch (std::exception const&)
+    {
+      continue;
+    }
+    // a damaged file may still be covered by a snapshot in a segment
+    if (!read_snapshot(read_file(entry.path()), s))
+    {
+      AURA_ERROR(make_error_code(std::errc::bad_message), L"Corrupt snapshot file for session %d", s.session_id);
+      continue;
+    }
+    found[s.session_id] = std::move(s);
+  }
+
+  // the segments may still hold records the snapshot files already cover if
+  // the server stopped before they were deleted
+  for (auto const segment : list_segments(m_config.directory))
+  {
+    auto const data = read_file(segment_path(segment));
+    byte_reader log{data};
+    size_t intact = 0;
+    while (!log.at_end())
+    {
+      auto const length = log.read_int();
+      if (log.failed || length < 0 || static_cast<size_t>(length) > log.buffer.size() - log.pos)
+      {
+        break;
+      }
+      auto const payload_data = log.buffer.substr(log.pos, static_cast<size_t>(length));
+      log.pos += static_cast<size_t>(length);
+      if (!read_checksum(log, payload_data))
+      {
+        break;
+      }
+      intact = log.pos;
+
+      byte_reader payload{payload_data};
+      auto const kind = static_cast<record_kind>(payload.read_int());
+      auto const session_id = static_cast<int>(payload.read_int());
+      auto const it = found.find(session_id);
+      if (kind == record_kind::remove)
+      {
+        if (it != found.end())
+        {
+          found.erase(it);
+        }
+      }
+      else if (kind == record_kind::snapshot)
+      {
+        recovered_session s{session_id};
+        if (read_snapshot(payload_data.substr(payload.pos), s) && (it == found.end() || s.version >= it->second.version))
+        {
+          found[session_id] = std::move(s);
+        }
+      }
+      else if (it != found.end())
+      {
+        auto& s = it->second;
+        auto const version = static_cast<int>(payload.read_int());
+        player_action action{};
+        read(payload, action);
+        // one that doesn't follow on is covered by the snapshot, or follows
+        // a gap nothing after can bridge
+        if (!payload.failed && version == s.version + static_cast<int>(s.actions.size()) + 1)
+        {
+          s.actions.emplace_back(action);
+        }
+      }
+    }
+
+    if (intact != data.size())
+    {
+      AURA_LOG(L"Segment %llu: dropped a torn tail after byte %zu", static_cast<unsigned long long>(segment), intact);
+    }
+  }
+
+  std::vector<recovered_session> sessions;
+  sessions.reserve(found.size());
+  for (auto& [session_id, s] : found)
+  {
+    sessions.emplace_back(std::move(s));
+  }
+  return sessions;
+}
+
+std::filesystem::path action_log::segment_path(std::uint64_t segment) const
+{
+  return m_config.directory / (std::to_string(segment) + ".seg");
+}
+
+std::filesystem::path action_log::snapshot_path(int session_id) const
+{
+  return m_config.directory / (std::to_string(session_id) + ".snap");
+}
+
+} // namespace aura
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <aura-core/player_action.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace aura
+{
+
+struct action_log_config
+{
+  //! Where the log segments and per-session snapshot files live
+  std::filesystem::path directory{"sessions"};
+
+  //! Actions between two snapshots of a session. Recovery replays at most
+  //! this many actions per session.
+  int snapshot_interval{32};
+
+  //! A segment this large is closed and the next one started; segments no
+  //! session needs any more are deleted then
+  std::uint64_t segment_bytes{64u << 20};
+};
+
+//! What recover() found on disk for one session
+struct recovered_session
+{
+  int session_id{};
+
+  //! Version of the session in 'snapshot'
+  int version{};
+
+  //! local_rules_engine::snapshot() at 'version'
+  std::string snapshot;
+
+  //! Actions accepted after the snapshot, oldest first
+  std::vector<player_action> actions;
+};
+
+struct action_log_stats
+{
+  std::uint64_t num_records{};
+  std::uint64_t num_snapshots{};
+  std::uint64_t num_syncs{};     //!< group commits; each one fsyncs the current segment once
+  std::uint64_t num_segments{};  //!< segments started
+};
+
+//! Write-ahead log of the actions accepted by each hosted session.
+//!
+//! The records of every session go to one append-only segment file,
+//! '<n>.seg'. Callers queue records without blocking; a single flusher
+//! thread writes everything queued since its last pass to the segment and
+//! syncs it once, so one fsync commits the batch of every session in it.
+//!
+//! Snapshots are committed through the segment too, then written to the
+//! session's '<id>.snap' without a sync of their own. When a segment is full
+//! the snapshot files written meanwhile are synced and the next segment
+//! started; older segments that hold nothing a session needs past its
+//! snapshot file are deleted. Recovery reads the snapshot files, then the
+//! segments left, so it replays at most about snapshot_interval actions per
+//! session. Segments a previous process left are deleted at the first
+//! rotation, so recover() and snapshots of the sessions it found go first.
+class action_log
+{
+public:
+  //! Identifies a queued write; see wait_durable()
+  using ticket = std::uint64_t;
+
+  explicit action_log(action_log_config const& config);
+
+  //! Flushes everything still queued
+  ~action_log();
+
+  action_log(action_log const&) = delete;
+  action_log& operator=(action_log const&) = delete;
+
+  //! Queues an action that moved 'session_id' to 'version'
+  ticket append(int session_id, int version, player_action const& action);
+
+  //! Queues a snapshot of 'session_id' at 'version'
+  ticket snapshot(int session_id, int version, std::string data);
+
+  //! Queues deletion of a session, e.g. once its game is over
+  ticket remove(int session_id);
+
+  //! Blocks until 't' and everything queued before it is on disk.
+  //! Returns the first write error the log ran into, if any.
+  std::error_code wait_durable(ticket t);
+
+  //! Reads back every session left in the log directory. A torn record at
+  //! the end of a segment (a crash mid-write) ends what is read of it.
+  std::vector<recovered_session> recover() const;
+
+  int snapshot_interval() const noexcept { return m_config.snapshot_interval; }
+
+  action_log_stats stats() const;
+
+private:
+  struct pending_writes
+  {
+    std::string records;
+    std::string snapshot; //!< encoded snapshot file, empty if none queued
+    bool remove{false};
+  };
+
+  //! Segments a session's recovery still reads from, 0 for none
+  struct segment_use
+  {
+    std::uint64_t snapshot{0};     //!< holds a snapshot its file may not have durably
+    std::uint64_t first_record{0}; //!< holds its first action after the snapshot
+    bool snapshot_failed{false};   //!< its snapshot file could not be written
+  };
+
+  void flush_loop();
+
+  std::error_code flush(std::unordered_map<int, pending_writes>& batch);
+
+  //! Syncs the snapshot files, starts the next segment and deletes the ones
+  //! no session needs any more
+  void rotate();
+
+  //! Closes the segment after a failed write, so the next batch doesn't
+  //! land behind a torn record
+  void abandon_segment();
+
+  //! Replaces a session's snapshot file, without syncing it
+  std::error_code write_snapshot(int session_id, std::string const& data);
+
+  std::filesystem::path segment_path(std::uint64_t segment) const;
+  std::filesystem::path snapshot_path(int session_id) const;
+
+  action_log_config const m_config;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_durable;
+  std::unordered_map<int, pending_writes> m_pending;
+  ticket m_last_queued{0};
+  ticket m_last_durable{0};
+  std::error_code m_error;
+  action_log_stats m_stats;
+  bool m_stop{false};
+
+  // only touched by the flusher thread
+  std::FILE* m_segment_file{nullptr};
+  std::uint64_t m_segment{1};        //!< number of the segment written to
+  std::uint64_t m_segment_size{0};
+  std::uint64_t m_oldest_segment{1}; //!< oldest segment still on disk
+  std::unordered_map<int, segment_use> m_segment_uses;
+
+  std::thread m_thread;
+};
+
+} // namespace aura
@@ -0,0 +1,231 @@
+#include "matchmaker.h"
+#include "session_manager.h"
+#include <aura-core/build.h>
+#include <algorithm>
+
+namespace aura
+{
+
+namespace
+{
+
+constexpr int num_game_modes = static_cast<int>(game_mode::lockstep) + 1;
+
+} // namespace {}
+
+matchmaker::matchmaker(session_manager& sessions, matchmaker_config const& config)
+  : m_sessions{sessions}
+  , m_config{config}
+  , m_waiting(num_game_modes)
+{
+  for (int i = 0; i < num_game_modes; ++i)
+  {
+    m_queues.emplace_back(std::make_unique<mpsc_queue<ticket>>(m_config.queue_capacity));
+  }
+  m_thread = std::thread{[this] { match_loop(); }};
+}
+
+matchmaker::~matchmaker()
+{
+  m_stop = true;
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+}
+
+matchmaker::ticket_handle matchmaker::join(std::string player_name, game_mode mode, int rating)
+{
+  ticket t{std::move(player_name), rating, std::chrono::steady_clock::now(), {}, std::make_shared<ticket_state>()};
+  ticket_handle handle{t.result.get_future(), t.state};
+
+  if (mode == game_mode::PvC)
+  {
+    t.state->paired = true;
+    auto const id = m_sessions.create_session(mode);
+    t.result.set_value(match_result{{}, id, 0, m_sessions.seat_token(id, 0), "Computer"});
+    return handle;
+  }
+
+  auto& queue = *m_queues[static_cast<int>(mode)];
+  if (!queue.try_push(t))
+  {
+    m_num_rejected.fetch_add(1, std::memory_order_relaxed);
+    auto const e = make_error_code(std::errc::resource_unavailable_try_again);
+    AURA_ERROR(e, L"Matchmaking queue is full (%zu players)", queue.capacity());
+    t.result.set_value(match_result{e, 0, 0, 0, {}});
+    return handle;
+  }
+
+  auto const depth = queue.size_approx();
+  auto peak = m_peak_queue_depth.load(std::memory_order_relaxed);
+  while (depth > peak && !m_peak_queue_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+  {
+  }
+  return handle;
+}
+
+bool matchmaker::cancel(ticket_handle& t)
+{
+  std::lock_guard lock{m_claim_mutex};
+  if (t.state->paired)
+  {
+    return false;
+  }
+  // the matcher answers the ticket on its next pass
+  t.state->cancelled = true;
+  return true;
+}
+
+match_result matchmaker::wait(ticket_handle& t)
+{
+  if (t.result.wait_for(m_config.join_timeout) != std::future_status::ready && cancel(t))
+  {
+    return match_result{make_error_code(std::errc::timed_out), 0, 0, 0, {}};
+  }
+  return t.result.get();
+}
+
+matchmaker_stats matchmaker::stats() const
+{
+  matchmaker_stats s{};
+  for (auto const& q : m_queues)
+  {
+    s.queue_depth += q->size_approx();
+  }
+  s.peak_queue_depth = m_peak_queue_depth.load(std::memory_order_relaxed);
+  s.num_rejected = m_num_rejected.load(std::memory_order_relaxed);
+
+  std::lock_guard lock{m_stats_mutex};
+  s.waiting = m_num_waiting;
+  s.num_matches = m_num_matches;
+  s.time_to_match_us = m_time_to_match_us;
+  s.num_cancelled = m_num_cancelled;
+  return s;
+}
+
+void matchmaker::match_loop()
+{
+  trace_set_thread_name("matchmaker");
+  while (!m_stop)
+  {
+    auto const next_pass = std::chrono::steady_clock::now() + m_config.match_interval;
+    match_pass();
+    std::this_thread::sleep_until(next_pass);
+  }
+
+  // nobody will pair the remaining players
+  for (auto& waiting : m_waiting)
+  {
+    for (auto& t : waiting)
+    {
+      t.result.set_value(match_result{make_error_code(std::errc::operation_canceled), 0, 0, 0, {}});
+    }
+  }
+}
+
+void matchmaker::match_pass()
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  auto const now = std::chrono::steady_clock::now();
+  size_t num_waiting = 0;
+
+  for (int mode = 0; mode < num_game_modes; ++mode)
+  {
+    auto& waiting = m_waiting[mode];
+    while (auto t = m_queues[mode]->try_pop())
+    {
+      waiting.emplace_back(std::move(*t));
+    }
+
+    std::lock_guard claim_lock{m_claim_mutex};
+    drop_cancelled(waiting);
+
+    if (waiting.size() >= 2)
+    {
+      // with ratings sorted, the best partner for a player is a neighbour
+      std::stable_sort(begin(waiting), end(waiting), [](auto const& a, auto const& b)
+      {
+        return a.rating < b.rating;
+      });
+
+      std::vector<ticket> unmatched;
+      size_t i = 0;
+      for (; i + 1 < waiting.size(); ++i)
+      {
+        auto& a = waiting[i];
+        auto& b = waiting[i + 1];
+
+        if (m_config.rating_band > 0)
+        {
+          auto const waited = std::chrono::duration_cast<std::chrono::seconds>(now - std::min(a.enqueued, b.enqueued));
+          auto const band = m_config.rating_band + static_cast<int>(waited.count()) * m_config.rating_band_growth_per_second;
+          if (b.rating - a.rating > band)
+          {
+            unmatched.emplace_back(std::move(a));
+            continue;
+          }
+        }
+
+        pair(a, b, static_cast<game_mode>(mode));
+        ++i;
+      }
+      if (i < waiting.size())
+      {
+        unmatched.emplace_back(std::move(waiting[i]));
+      }
+      waiting = std::move(unmatched);
+    }
+    num_waiting += waiting.size();
+  }
+
+  std::lock_guard lock{m_stats_mutex};
+  m_num_waiting = num_waiting;
+}
+
+void matchmaker::drop_cancelled(std::vector<ticket>& waiting)
+{
+  auto const cancelled = std::stable_partition(begin(waiting), end(waiting), [](auto const& t)
+  {
+    return !t.state->cancelled;
+  });
+  if (cancelled == end(waiting))
+  {
+    return;
+  }
+  for (auto it = cancelled; it != end(waiting); ++it)
+  {
+    it->result.set_value(match_result{make_error_code(std::errc::operation_canceled), 0, 0, 0, {}});
+  }
+  {
+    std::lock_guard lock{m_stats_mutex};
+    m_num_cancelled += static_cast<std::uint64_t>(end(waiting) - cancelled);
+  }
+  waiting.erase(cancelled, end(waiting));
+}
+
+void matchmaker::pair(ticket& a, ticket& b, game_mode mode)
+{
+  // the player who waited longest moves first
+  auto* first = a.enqueued <= b.enqueued ? &a : &b;
+  auto* second = first == &a ? &b : &a;
+
+  auto const id = m_sessions.create_session(mode);
+  auto const now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard lock{m_stats_mutex};
+    m_num_matches++;
+    for (auto const* t : {first, second})
+    {
+      m_time_to_match_us.record(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - t->enqueued).count()));
+    }
+  }
+
+  first->state->paired = true;
+  second->state->paired = true;
+  first->result.set_value(match_result{{}, id, 0, m_sessions.seat_token(id, 0), second->player_name});
+  second->result.set_value(match_result{{}, id, 1, m_sessions.seat_token(id, 1), first->player_name});
+}
+
+} // namespace aura
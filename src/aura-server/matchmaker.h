@@ -0,0 +1,154 @@
+#pragma once
+
+#include <aura-core/ruleset.h>
+#include <aura-core/histogram.h>
+#include <aura-server/mpsc_queue.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace aura
+{
+
+class session_manager;
+
+struct matchmaker_config
+{
+  //! How often queued players are drained and paired
+  std::chrono::milliseconds match_interval{20};
+
+  //! Max rating difference between paired players; 0 ignores ratings
+  int rating_band{0};
+
+  //! How much the band grows for every second a player has waited
+  int rating_band_growth_per_second{50};
+
+  //! Capacity of each per-game-mode join queue
+  size_t queue_capacity{1 << 14};
+
+  //! How long wait() lets a player wait for an opponent. Stays below the
+  //! clients' 5 s read timeout, so nobody is paired after their request
+  //! has given up.
+  std::chrono::milliseconds join_timeout{4000};
+};
+
+//! Whether a queued ticket was paired or cancelled; guarded by the
+//! matchmaker's claim mutex
+struct ticket_state
+{
+  bool paired{false};
+  bool cancelled{false};
+};
+
+struct match_result
+{
+  std::error_code error;
+  int session_id{};
+  int seat{}; //!< index of the joining player in session_info::players
+  std::uint64_t seat_token{}; //!< proves the seat; see hosted_session
+  std::string opponent_name;
+};
+
+struct matchmaker_stats
+{
+  size_t queue_depth{};      //!< joins not yet seen by the matcher
+  size_t peak_queue_depth{};
+  size_t waiting{};          //!< players drained but not yet paired
+  std::uint64_t num_matches{};
+  std::uint64_t num_rejected{}; //!< joins refused because a queue was full
+  std::uint64_t num_cancelled{}; //!< players who left before being paired
+
+  //! Time from join() to being paired, in microseconds
+  histogram time_to_match_us;
+};
+
+//! Pairs players waiting for a game.
+//!
+//! join() pushes a ticket on the lock-free queue for its game mode and
+//! returns immediately. A single matcher thread drains all queues every
+//! match_interval, pairs compatible players in one pass and creates their
+//! session on the least-loaded shard. PvC joins get a session right away.
+class matchmaker
+{
+public:
+  explicit matchmaker(session_manager& sessions, matchmaker_config const& config = {});
+
+  ~matchmaker();
+
+  matchmaker(matchmaker const&) = delete;
+  matchmaker& operator=(matchmaker const&) = delete;
+
+  //! A player's place in a queue
+  struct ticket_handle
+  {
+    //! Satisfied once the player is paired or has left the queue
+    std::future<match_result> result;
+
+    std::shared_ptr<ticket_state> state;
+  };
+
+  //! Queues a player
+  ticket_handle join(std::string player_name, game_mode mode, int rating = 0);
+
+  //! Takes a player out of the queue unless they have been paired already;
+  //! the result then fails with operation_canceled. False if too late.
+  bool cancel(ticket_handle& t);
+
+  //! Waits up to join_timeout for the player to be paired and cancels the
+  //! ticket if they weren't, which fails with timed_out
+  match_result wait(ticket_handle& t);
+
+  matchmaker_stats stats() const;
+
+private:
+  struct ticket
+  {
+    std::string player_name;
+    int rating{};
+    std::chrono::steady_clock::time_point enqueued;
+    std::promise<match_result> result;
+    std::shared_ptr<ticket_state> state;
+  };
+
+  //! Answers the tickets cancelled since the last pass and drops them from
+  //! 'waiting'. Call with m_claim_mutex locked.
+  void drop_cancelled(std::vector<ticket>& waiting);
+
+  void match_loop();
+
+  //! Drains the queues and pairs as many waiting players as possible
+  void match_pass();
+
+  void pair(ticket& a, ticket& b, game_mode mode);
+
+  session_manager& m_sessions;
+  matchmaker_config const m_config;
+
+  //! One queue (and waiting list) per game_mode
+  std::vector<std::unique_ptr<mpsc_queue<ticket>>> m_queues;
+  std::vector<std::vector<ticket>> m_waiting;
+
+  std::atomic<size_t> m_peak_queue_depth{0};
+  std::atomic<std::uint64_t> m_num_rejected{0};
+
+  //! Orders pairing against cancel(), so a ticket is either paired or
+  //! cancelled, never both
+  std::mutex m_claim_mutex;
+  std::uint64_t m_num_cancelled{0};
+
+  mutable std::mutex m_stats_mutex;
+  std::uint64_t m_num_matches{0};
+  size_t m_num_waiting{0};
+  histogram m_time_to_match_us;
+
+  std::atomic<bool> m_stop{false};
+  std::thread m_thread;
+};
+
+} // namespace aura
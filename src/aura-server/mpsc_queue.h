@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace aura
+{
+
+//! Bounded lock-free multi-producer queue (Vyukov's ring with per-slot
+//! sequence numbers). Any number of threads may push; pops must come from a
+//! single consumer thread. Push fails instead of blocking when full.
+template <typename T>
+class mpsc_queue
+{
+public:
+  //! 'capacity' is rounded up to a power of two
+  explicit mpsc_queue(size_t capacity)
+  {
+    size_t n = 2;
+    while (n < capacity)
+    {
+      n <<= 1;
+    }
+    m_mask = n - 1;
+    m_slots = std::make_unique<slot[]>(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpsc_queue(mpsc_queue const&) = delete;
+  mpsc_queue& operator=(mpsc_queue const&) = delete;
+
+  //! Returns false (leaving 'value' untouched) if the queue is full
+  bool try_push(T& value)
+  {
+    auto pos = m_tail.load(std::memory_order_relaxed);
+    slot* s{};
+    while (true)
+    {
+      s = &m_slots[pos & m_mask];
+      auto const seq = s->sequence.load(std::memory_order_acquire);
+      auto const diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0)
+      {
+        if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+    s->value.emplace(std::move(value));
+    s->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! Consumer only
+  std::optional<T> try_pop()
+  {
+    auto& s = m_slots[m_head & m_mask];
+    auto const seq = s.sequence.load(std::memory_order_acquire);
+    if (static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(m_head + 1) < 0)
+    {
+      return std::nullopt;
+    }
+    std::optional<T> value{std::move(*s.value)};
+    s.value.reset();
+    s.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+    ++m_head;
+    m_head_published.store(m_head, std::memory_order_relaxed);
+    return value;
+  }
+
+  //! Approximate number of queued items; safe to call from any thread
+  size_t size_approx() const noexcept
+  {
+    auto const tail = m_tail.load(std::memory_order_relaxed);
+    auto const head = m_head_published.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  size_t capacity() const noexcept { return m_mask + 1; }
+
+private:
+  struct slot
+  {
+    std::atomic<size_t> sequence;
+    std::optional<T> value;
+  };
+
+  std::unique_ptr<slot[]> m_slots;
+  size_t m_mask{};
+
+  alignas(64) std::atomic<size_t> m_tail{0};
+
+  alignas(64) size_t m_head{0};
+  std::atomic<size_t> m_head_published{0};
+};
+
+} // namespace aura
@@ -0,0 +1,193 @@
+#include "requests.h"
+#include "session_manager.h"
+#include "matchmaker.h"
+#include <aura-core/build.h>
+
+namespace aura
+{
+
+namespace rest
+{
+
+std::string handle_request(new_session, matchmaker& matcher, std::string const& info_in)
+{
+  auto const [error, in] = new_session::to_in(info_in);
+  if (error)
+  {
+    AURA_ERROR(error, L"new_session: malformed request");
+    return new_session::to_string(new_session::out{error, 0, 0, 0, {}});
+  }
+
+  // a client that gave up on its request must not be paired with anybody
+  auto ticket = matcher.join(in.player_name, in.mode, in.rating);
+  auto const match = matcher.wait(ticket);
+  return new_session::to_string(
+    new_session::out{match.error, match.session_id, match.seat, match.seat_token, match.opponent_name});
+}
+
+std::string handle_request(get_session_info, session_manager& sessions, std::string const& info_in)
+{
+  auto const [error, in] = get_session_info::to_in(info_in);
+  if (error)
+  {
+    AURA_ERROR(error, L"get_session_info: malformed request");
+    return get_session_info::to_string(get_session_info::out{error, 0, 0, {}, {}});
+  }
+
+  get_session_info::out result{};
+  auto const e = sessions.with_session(in.session_id, [&](hosted_session& s)
+  {
+    // the full session and its snapshot would show the opponent's hand and
+    // every card still to be drawn
+    result.seats = s.seats_of(in.seat_token);
+    if (!result.seats)
+    {
+      result.error = make_error_code(std::errc::permission_denied);
+      AURA_ERROR(result.error, L"get_session_info: session %d, the sender holds no seat", s.id);
+      return;
+    }
+    result.version = s.version;
+    result.session = redact_for_seats(s.engine->get_session_info(), result.seats);
+    if (in.with_snapshot)
+    {
+      result.snapshot = s.engine->snapshot_for_seats(result.seats);
+    }
+  });
+  if (e)
+  {
+    result.error = e;
+  }
+  return get_session_info::to_string(result);
+}
+
+std::string handle_request(commit_action, session_manager& sessions, std::string const& info_in)
+{
+  auto const [error, in] = commit_action::to_in(info_in);
+  if (error)
+  {
+    AURA_ERROR(error, L"commit_action: malformed request");
+    return commit_action::to_string(commit_action::out{error, 0, 0, {}});
+  }
+
+  commit_action::out result{};
+  action_log::ticket logged{0};
+  auto const e = sessions.with_session(in.session_id, [&](hosted_session& s)
+  {
+    for (auto const& action : in.actions)
+    {
+      // the turn may pass to the other seat within the batch
+      if (!s.holds_seat(in.seat_token, s.engine->get_session_info().current_player))
+      {
+        result.error = make_error_code(std::errc::permission_denied);
+        AURA_ERROR(result.error, L"commit_action: session %d, the sender is not the player to move", s.id);
+        break;
+      }
+      if (auto const action_error = s.engine->commit_action(action))
+      {
+        result.error = action_error;
+        break;
+      }
+      logged = sessions.record_action(s, action);
+      result.num_applied++;
+    }
+    result.version = s.version;
+    result.session = redact_for_seats(s.engine->get_session_info(), s.seats_of(in.seat_token));
+  });
+
+  if (e)
+  {
+    result.error = e;
+  }
+
+  // only acknowledge actions that would survive a crash; the session lock is
+  // released so other requests share the same sync
+  if (auto const log_error = sessions.wait_durable(logged); log_error && !result.error)
+  {
+    AURA_ERROR(log_error, L"commit_action: session %d is not durable", in.session_id);
+    result.error = log_error;
+  }
+  return commit_action::to_string(result);
+}
+
+std::string handle_request(get_target_list, session_manager& sessions, std::string const& info_in)
+{
+  auto const [error, in] = get_target_list::to_in(info_in);
+  if (error)
+  {
+    AURA_ERROR(error, L"get_target_list: malformed request");
+    return get_target_list::to_string(get_target_list::out{error, {}});
+  }
+
+  get_target_list::out result{};
+  auto const e = sessions.with_session(in.session_id, [&](hosted_session& s)
+  {
+    if (!s.holds_any_seat(in.seat_token))
+    {
+      result.error = make_error_code(std::errc::permission_denied);
+      return;
+    }
+    result.targets = s.engine->get_target_list(in.uid);
+  });
+  if (e)
+  {
+    result.error = e;
+  }
+  return get_target_list::to_string(result);
+}
+
+std::string handle_request(relay_lockstep, session_manager& sessions, std::string const& info_in)
+{
+  auto const [error, in] = relay_lockstep::to_in(info_in);
+  if (error)
+  {
+    AURA_ERROR(error, L"relay_lockstep: malformed request");
+    return relay_lockstep::to_string(relay_lockstep::out{error, 0, {}});
+  }
+
+  relay_lockstep::out result{};
+  auto const e = sessions.with_session(in.session_id, [&](hosted_session& s)
+  {
+    if (!s.relayed || !s.holds_seat(in.seat_token, in.seat))
+    {
+      result.error = make_error_code(std::errc::permission_denied);
+      AURA_ERROR(result.error, L"relay_lockstep: session %d does not relay for the sender", s.id);
+      return;
+    }
+
+    // a broken message would stop the peer from reading any past it
+    byte_reader r{in.messages};
+    while (!r.at_end() && !r.failed)
+    {
+      r.read_string();
+    }
+    if (r.failed)
+    {
+      result.error = r.error();
+      AURA_ERROR(result.error, L"relay_lockstep: session %d, malformed messages", s.id);
+      return;
+    }
+
+    auto& inbox = s.relay[in.seat];
+    if (in.taken < inbox.taken || in.taken - inbox.taken > inbox.stream.size())
+    {
+      result.error = make_error_code(std::errc::invalid_argument);
+      AURA_ERROR(result.error, L"relay_lockstep: session %d, seat %d lost its place in the stream", s.id, in.seat);
+      return;
+    }
+    inbox.stream.erase(0, static_cast<size_t>(in.taken - inbox.taken));
+    inbox.taken = in.taken;
+    s.relay[1 - in.seat].stream += in.messages;
+
+    result.seed = s.relay_seed;
+    result.messages = inbox.stream;
+  });
+  if (e)
+  {
+    result.error = e;
+  }
+  return relay_lockstep::to_string(result);
+}
+
+} // namespace rest
+
+} // namespace aura
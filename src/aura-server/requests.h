@@ -1,98 +1,32 @@
 #pragma once
 
-#include <aura-core/ruleset.h>
+#include <aura-core/rest_messages.h>
 #include <string>
 
 namespace aura
 {
 
-namespace rest
-{
-
-template <typename T>
-struct server_response
-{
-
-};
-
-// POST
-struct new_session
-{
-  struct in
-  {
-    game_mode mode; 
-  };
-
-  struct out
-  {
-    int session_id; //!< unique identifier for this session
-    std::string matched_player_name;
-  };
-
-  static std::string to_string(in const&) noexcept;
-  static std::string to_string(out const&) noexcept;
-
-  static std::pair<std::error_code, in> to_in(std::string const&) noexcept;
-  static std::pair<std::error_code, out> to_out(std::string const&) noexcept;
+class session_manager;
+class matchmaker;
 
-  //! Called by client
-  static server_response<out> make_request(in const& info_in);
-
-  //! Called by server
-  static std::string handle_request(std::string const& info_in);
-};
-
-// GET
-struct get_session_info
+namespace rest
 {
-  struct in
-  {
-    int session_id;
-  };
-
-  struct out
-  {
-    session_info session;
-  };
-
-  static std::string to_string(in const&) noexcept;
-  static std::string to_string(out const&) noexcept;
 
-  static std::pair<std::error_code, in> to_in(std::string const&) noexcept;
-  static std::pair<std::error_code, out> to_out(std::string const&) noexcept;
-
-  //! Called by client
-  static server_response<out> make_request(in const& info_in);
-
-  //! Called by server
-  static std::string handle_request(std::string const& info_in);
-};
-
-// POST
-struct commit_action
-{
-  struct in
-  {
-    player_action action;
-  };
+// Server side of the requests in aura-core/rest_messages.h; each takes the
+// request's encoded 'in' and returns its encoded 'out'. The first argument
+// only picks the request.
 
-  struct out
-  {
-    std::error_code error;
-  };
+//! Blocks until the player has been matched, or fails with timed_out once
+//! matchmaker_config::join_timeout has passed
+std::string handle_request(new_session, matchmaker& matcher, std::string const& info_in);
 
-  static std::string to_string(in const&) noexcept;
-  static std::string to_string(out const&) noexcept;
+std::string handle_request(get_session_info, session_manager& sessions, std::string const& info_in);
 
-  static std::pair<std::error_code, in> to_in(std::string const&) noexcept;
-  static std::pair<std::error_code, out> to_out(std::string const&) noexcept;
+std::string handle_request(commit_action, session_manager& sessions, std::string const& info_in);
 
-  //! Called by client
-  static server_response<out> make_request(in const& info_in);
+std::string handle_request(get_target_list, session_manager& sessions, std::string const& info_in);
 
-  //! Called by server
-  static std::string handle_request(std::string const& info_in);
-};
+std::string handle_request(relay_lockstep, session_manager& sessions, std::string const& info_in);
 
 } // namespace rest
 
@@ -1,17 +1,296 @@
 #include <aura-core/build.h>
+#include <aura-core/metrics.h>
+#include <aura-server/requests.h>
+#include <aura-server/session_manager.h>
+#include <aura-server/matchmaker.h>
+#include <aura-server/action_log.h>
+#include <aura-server/spectator_hub.h>
+#include <aura-server/spectator_socket.h>
+#include <aura-server/shm_server.h>
 #include <cpp-httplib/httplib.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
 
-int wmain(int argc, wchar_t const* args)
+namespace
 {
+
+template <typename Request, typename Context>
+void add_route(httplib::Server& server, Context& context)
+{
+  server.Post(Request::path, [&context](auto const& req, auto& response)
+  {
+    AURA_TRACE_SCOPE(Request::path);
+    response.set_content(aura::rest::handle_request(Request{}, context, req.body), "application/octet-stream");
+  });
+}
+
+template <typename Request, typename Context>
+void add_shm_route(aura::shm_server& server, Context& context)
+{
+  server.add_route(Request::path, [&context](std::string const& body)
+  {
+    AURA_TRACE_SCOPE(Request::path);
+    return aura::rest::handle_request(Request{}, context, body);
+  });
+}
+
+//! Average engine memory per session in memory, by part
+void print_footprint(aura::session_manager_stats const& s)
+{
+  auto const n = std::max<size_t>(1, s.num_sessions - s.num_hibernated);
+  auto const& f = s.footprint;
+  AURA_PRINT(L"bytes per session: %zu (engine %zu, players %zu, hands %zu, lanes %zu, picks %zu, drafts %zu, "
+    L"effects %zu, terrain %zu, ruleset %zu), p99 %llu, peak total %zu\n", f.total() / n, f.engine / n,
+    f.players / n, f.hands / n, f.lanes / n, f.picks / n, f.draft_choices / n, f.effect_maps / n, f.terrain / n,
+    f.ruleset / n, static_cast<unsigned long long>(s.session_bytes.value_at_percentile(99.0)), s.peak_bytes);
+}
+
+//! Joins 'num_joins' synthetic players from several threads at once and
+//! reports how the matchmaker coped
+int run_matchmaker_burst(int num_joins)
+{
+  aura::session_manager sessions{aura::ruleset{}};
+  aura::matchmaker_config config{};
+  config.rating_band = 100;
+  aura::matchmaker matcher{sessions, config};
+
+  auto const num_threads = std::max(2u, std::thread::hardware_concurrency());
+  std::vector<std::vector<std::future<aura::match_result>>> results(num_threads);
+
+  auto const start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (unsigned t = 0; t < num_threads; ++t)
+  {
+    producers.emplace_back([&, t]
+    {
+      std::mt19937 rng{t};
+      std::normal_distribution<> rating{1500.0, 200.0};
+      for (int i = t; i < num_joins; i += num_threads)
+      {
+        results[t].emplace_back(matcher.join("bot" + std::to_string(i), aura::game_mode::PvP,
+          static_cast<int>(rating(rng))).result);
+      }
+    });
+  }
+  for (auto& p : producers)
+  {
+    p.join();
+  }
+
+  int num_failed = 0;
+  for (auto& thread_results : results)
+  {
+    for (auto& r : thread_results)
+    {
+      // an odd player out (or one nobody is close to) never gets a match
+      if (r.wait_for(std::chrono::seconds(5)) != std::future_status::ready || r.get().error)
+      {
+        ++num_failed;
+      }
+    }
+  }
+  auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  auto const s = matcher.stats();
+  AURA_PRINT(L"joins: %d, matched players: %llu, unmatched: %d, rejected: %llu\n", num_joins,
+    2 * s.num_matches, num_failed, s.num_rejected);
+  AURA_PRINT(L"peak queue depth: %zu, still waiting: %zu, sessions: %zu on %d shards\n",
+    s.peak_queue_depth, s.waiting, sessions.size(), sessions.num_shards());
+  AURA_PRINT(L"matches/sec: %.0f\n", s.num_matches / elapsed);
+  AURA_PRINT(L"time to match (us): mean %.0f, p50 %llu, p99 %llu, p999 %llu, max %llu\n",
+    s.time_to_match_us.mean(), s.time_to_match_us.value_at_percentile(50.0),
+    s.time_to_match_us.value_at_percentile(99.0), s.time_to_match_us.value_at_percentile(99.9),
+    s.time_to_match_us.max());
+  print_footprint(sessions.stats());
+  return 0;
+}
+
+//! Rebuilds the sessions a previous server process left in the action log
+void recover_sessions(aura::session_manager& sessions, aura::action_log& log)
+{
+  auto const start = std::chrono::steady_clock::now();
+  size_t num_sessions = 0;
+  size_t num_actions = 0;
+  for (auto& r : log.recover())
+  {
+    aura::seat_tokens tokens{};
+    std::string snapshot;
+    if (auto const e = aura::decode_session_record(r.snapshot, tokens, snapshot))
+    {
+      AURA_ERROR(e, L"Cannot recover session %d", r.session_id);
+      continue;
+    }
+    auto [error, engine] = aura::local_rules_engine::restore(snapshot);
+    if (error)
+    {
+      AURA_ERROR(error, L"Cannot recover session %d", r.session_id);
+      continue;
+    }
+
+    auto version = r.version;
+    for (auto const& action : r.actions)
+    {
+      if (auto const e = engine.commit_action(action))
+      {
+        AURA_ERROR(e, L"Session %d: replay stopped at version %d", r.session_id, version);
+        break;
+      }
+      ++version;
+    }
+    num_actions += static_cast<size_t>(version - r.version);
+    sessions.adopt_session(r.session_id, tokens, std::move(engine), version);
+    ++num_sessions;
+  }
+
+  auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  AURA_LOG(L"Recovered %zu sessions (%zu replayed actions) in %.1f ms", num_sessions, num_actions, elapsed);
+}
+
+} // namespace {}
+
+int wmain(int argc, wchar_t** argv)
+{
+  if (argc >= 3 && std::wstring_view{argv[1]} == L"--matchmaker-burst")
+  {
+    return run_matchmaker_burst(std::stoi(argv[2]));
+  }
+  if (argc >= 4 && std::wstring_view{argv[1]} == L"--spectator-bench")
+  {
+    return aura::run_spectator_benchmark(std::stoi(argv[2]), std::stoi(argv[3]));
+  }
+
+  aura::action_log_config log_config{};
+  aura::hibernation_config hibernation{};
+  aura::session_timers_config timers{};
+  aura::spectator_config spectators{};
+  aura::shm_server_config shm{};
+  std::filesystem::path trace_path;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    auto const option = std::wstring_view{argv[i]};
+    if (option == L"--log-dir")
+    {
+      log_config.directory = argv[i + 1];
+    }
+    else if (option == L"--hibernate-after")
+    {
+      hibernation.idle_timeout = std::chrono::seconds{std::stoi(argv[i + 1])};
+    }
+    else if (option == L"--turn-timeout")
+    {
+      timers.turn_timeout = std::chrono::seconds{std::stoi(argv[i + 1])};
+    }
+    else if (option == L"--spectator-delay")
+    {
+      spectators.delay = std::chrono::seconds{std::stoi(argv[i + 1])};
+    }
+    else if (option == L"--shm-channels")
+    {
+      shm.num_channels = std::stoi(argv[i + 1]);
+    }
+    else if (option == L"--trace")
+    {
+      trace_path = argv[i + 1];
+    }
+  }
+
+  // Ctrl+C and SIGTERM stop the server below, so the action log is closed
+  // and the trace written rather than lost
+  if (auto const e = aura::catch_stop_requests())
+  {
+    AURA_ERROR(e, L"Cannot catch stop requests; stopping the process will lose the trace");
+  }
+
+  if (!trace_path.empty())
+  {
+    aura::trace_start();
+  }
+
   httplib::Server server;
+  aura::session_manager sessions{aura::ruleset{}};
+  aura::action_log log{log_config};
+  aura::spectator_hub hub{spectators};
+  sessions.set_action_log(log);
+  sessions.set_spectators(hub);
+  // recovered games are timed like any other, or one abandoned across the
+  // restart would never time out
+  sessions.enable_hibernation(hibernation);
+  sessions.enable_timers(timers);
+  recover_sessions(sessions, log);
+  aura::matchmaker matcher{sessions};
+
+  std::atomic<bool> stop{false};
+  std::thread ticker{[&]
+  {
+    aura::trace_set_thread_name("timers");
+    auto next = std::chrono::steady_clock::now();
+    while (!stop)
+    {
+      next += aura::session_manager::timer_tick;
+      std::this_thread::sleep_until(next);
+      sessions.tick();
+    }
+  }};
 
   server.Get("/ping", [](auto const& req, auto& response)
   {
     AURA_LOG(L"Got request!!");
     response.set_content("Hello", "text/plain");
   });
+
+  server.Get("/metrics", [](auto const& req, auto& response)
+  {
+    response.set_content(aura::format_metrics(aura::take_metrics_snapshot()), "text/plain; version=0.0.4");
+  });
+
+  add_route<aura::rest::new_session>(server, matcher);
+  add_route<aura::rest::get_session_info>(server, sessions);
+  add_route<aura::rest::commit_action>(server, sessions);
+  add_route<aura::rest::get_target_list>(server, sessions);
+  add_route<aura::rest::relay_lockstep>(server, sessions);
+
+  aura::spectator_listener spectator_listener{sessions, 1235};
+
+  // same-host bots skip the network stack
+  aura::shm_server shm_server{shm};
+  add_shm_route<aura::rest::new_session>(shm_server, matcher);
+  add_shm_route<aura::rest::get_session_info>(shm_server, sessions);
+  add_shm_route<aura::rest::commit_action>(shm_server, sessions);
+  add_shm_route<aura::rest::get_target_list>(shm_server, sessions);
+  add_shm_route<aura::rest::relay_lockstep>(shm_server, sessions);
+  if (shm.num_channels > 0)
+  {
+    shm_server.start();
+  }
+
+  // blocks for the life of the process, so it isn't joined; if listen()
+  // fails the process ends with it still waiting
+  std::thread{[&server]
+  {
+    aura::trace_set_thread_name("stop");
+    aura::wait_for_stop_request();
+    AURA_LOG(L"Stopping");
+    server.stop();
+  }}.detach();
+
   AURA_LOG(L"Started listening on localhost:1234");
 
   server.listen("localhost", 1234);
+
+  stop = true;
+  ticker.join();
+
+  if (!trace_path.empty())
+  {
+    aura::trace_stop();
+    if (auto const e = aura::trace_dump(trace_path))
+    {
+      AURA_ERROR(e, L"Cannot write trace to %ls", trace_path.c_str());
+    }
+  }
   return 0;
 }
@@ -0,0 +1,627 @@
+#include "session_manager.h"
+#include <aura-core/build.h>
+#include <aura-core/metrics.h>
+#include <aura-core/random.h>
+#include <aura-core/serialization.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace aura
+{
+
+namespace
+{
+
+//! Across every session_manager in the process
+metric_gauge const g_sessions{"aura_sessions"};
+metric_gauge const g_hibernated_sessions{"aura_sessions_hibernated"};
+
+struct footprint_metrics
+{
+  explicit footprint_metrics(char const* part)
+    : bytes{"aura_session_bytes", std::string{"part=\""} + part + "\""}
+  {
+  }
+
+  metric_gauge bytes;
+};
+
+footprint_metrics const g_footprint[] = {footprint_metrics{"engine"}, footprint_metrics{"players"},
+  footprint_metrics{"hands"}, footprint_metrics{"lanes"}, footprint_metrics{"picks"},
+  footprint_metrics{"draft_choices"}, footprint_metrics{"effect_maps"}, footprint_metrics{"terrain"},
+  footprint_metrics{"ruleset"}};
+metric_gauge const g_peak_session_bytes{"aura_session_bytes_peak"};
+metric_histogram const g_bytes_per_session{"aura_bytes_per_session"};
+
+//! Moves the gauges by the change in one session's footprint
+void add_to_gauges(session_footprint const& f, std::int64_t sign)
+{
+  size_t const parts[] = {f.engine, f.players, f.hands, f.lanes, f.picks, f.draft_choices, f.effect_maps, f.terrain,
+    f.ruleset};
+  for (size_t i = 0; i < std::size(parts); ++i)
+  {
+    g_footprint[i].bytes.add(sign * static_cast<std::int64_t>(parts[i]));
+  }
+}
+
+//! What the action log keeps of a locked session
+std::string session_record(hosted_session const& s)
+{
+  return encode_session_record(s.tokens, s.engine->snapshot());
+}
+
+} // namespace {}
+
+seat_tokens make_seat_tokens(game_mode mode)
+{
+  seat_tokens tokens{};
+  for (auto& t : tokens)
+  {
+    // never 0, which stands for no token
+    do
+    {
+      t = make_random_seed();
+    } while (!t);
+  }
+  if (mode == game_mode::PvC)
+  {
+    tokens[1] = tokens[0];
+  }
+  return tokens;
+}
+
+std::string encode_session_record(seat_tokens const& tokens, std::string_view engine_snapshot)
+{
+  byte_writer w;
+  for (auto const t : tokens)
+  {
+    w.write_int(static_cast<long long>(t));
+  }
+  w.write_string(engine_snapshot);
+  return std::move(w.buffer);
+}
+
+std::error_code decode_session_record(std::string_view record, seat_tokens& tokens, std::string& engine_snapshot)
+{
+  byte_reader r{record};
+  for (auto& t : tokens)
+  {
+    t = static_cast<std::uint64_t>(r.read_int());
+  }
+  engine_snapshot = r.read_string();
+  return r.error();
+}
+
+session_manager::session_manager(ruleset const& rules, int num_shards)
+  : m_rules{rules}
+{
+  if (num_shards <= 0)
+  {
+    num_shards = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  for (int i = 0; i < num_shards; ++i)
+  {
+    m_shards.emplace_back(std::make_unique<session_shard>());
+  }
+}
+
+session_manager::~session_manager()
+{
+  g_sessions.add(-static_cast<std::int64_t>(size()));
+  g_hibernated_sessions.add(-static_cast<std::int64_t>(m_num_hibernated.load()));
+  add_to_gauges(m_footprint, -1);
+}
+
+int session_manager::create_session(game_mode mode)
+{
+  return create_session_on(least_loaded_shard(), mode);
+}
+
+int session_manager::create_session_on(int shard_index, game_mode mode)
+{
+  AURA_ASSERT(shard_index >= 0 && shard_index < num_shards());
+  auto rules = m_rules;
+  rules.mode = mode;
+
+  auto& shard = *m_shards[shard_index];
+  int id{};
+  {
+    std::lock_guard lock{shard.mutex};
+    id = (shard.next_local_id++ * num_shards()) + shard_index;
+  }
+
+  // nobody knows the new id yet, so the session is set up without the lock
+  auto session = std::make_shared<hosted_session>(id, rules);
+  if (m_log)
+  {
+    m_log->snapshot(id, session->version, session_record(*session));
+  }
+
+  auto& s = *session;
+  {
+    std::lock_guard lock{shard.mutex};
+    shard.sessions.emplace(id, std::move(session));
+    shard.load.fetch_add(1, std::memory_order_relaxed);
+    g_sessions.add(1);
+    AURA_LOG(L"Created session %d on shard %d, Shard sessions = %zu", id, shard_index, shard.sessions.size());
+  }
+
+  std::lock_guard lock{s.mutex};
+  measure(s);
+  update_turn_timer(s);
+  touch(s);
+  return id;
+}
+
+void session_manager::adopt_session(int session_id, seat_tokens const& tokens, local_rules_engine&& engine,
+  int version)
+{
+  AURA_ASSERT(session_id > 0);
+  auto const shard_index = shard_of(session_id);
+  auto& shard = *m_shards[shard_index];
+  auto session = std::make_shared<hosted_session>(session_id, tokens, std::move(engine), version);
+  auto& s = *session;
+  {
+    std::lock_guard lock{shard.mutex};
+    // ids created from now on must not collide with the adopted one
+    shard.next_local_id = std::max(shard.next_local_id, session_id / num_shards() + 1);
+    if (!shard.sessions.emplace(session_id, std::move(session)).second)
+    {
+      AURA_ERROR(make_error_code(std::errc::file_exists), L"Session %d is already hosted", session_id);
+      return;
+    }
+    shard.load.fetch_add(1, std::memory_order_relaxed);
+    g_sessions.add(1);
+  }
+  AURA_LOG(L"Recovered session %d at version %d on shard %d", session_id, version, shard_index);
+
+  std::lock_guard lock{s.mutex};
+  // start a clean log behind the replayed state
+  if (m_log)
+  {
+    m_log->snapshot(session_id, version, session_record(s));
+  }
+  measure(s);
+  update_turn_timer(s);
+  touch(s);
+}
+
+std::uint64_t session_manager::seat_token(int session_id, int seat) const
+{
+  auto const s = find(session_id);
+  return s && seat >= 0 && seat < static_cast<int>(s->tokens.size()) ? s->tokens[seat] : 0;
+}
+
+std::error_code session_manager::add_spectator(int session_id, std::unique_ptr<spectator_connection> connection)
+{
+  auto const session = find(session_id);
+  if (!m_spectators || !session)
+  {
+    return make_error_code(std::errc::invalid_argument);
+  }
+
+  // watching doesn't count as activity, so the session is not touched
+  std::lock_guard lock{session->mutex};
+  if (session->dropped)
+  {
+    return make_error_code(std::errc::invalid_argument);
+  }
+  if (auto const e = rehydrate(*session))
+  {
+    return e;
+  }
+  m_spectators->add(session_id, std::move(connection));
+  m_spectators->publish(session_id, session->version, session->engine->get_session_info());
+  return {};
+}
+
+action_log::ticket session_manager::record_action(hosted_session& s, player_action const& action)
+{
+  s.version++;
+  if (action.type == action_type::end_turn || s.engine->is_game_over())
+  {
+    measure(s);
+  }
+  update_turn_timer(s);
+  if (m_spectators)
+  {
+    m_spectators->publish(s.id, s.version, s.engine->get_session_info());
+  }
+  if (!m_log)
+  {
+    return 0;
+  }
+  if (s.engine->is_game_over())
+  {
+    return m_log->remove(s.id);
+  }
+  if (s.version % m_log->snapshot_interval() == 0)
+  {
+    return m_log->snapshot(s.id, s.version, session_record(s));
+  }
+  return m_log->append(s.id, s.version, action);
+}
+
+std::error_code session_manager::wait_durable(action_log::ticket t)
+{
+  return m_log ? m_log->wait_durable(t) : std::error_code{};
+}
+
+int session_manager::least_loaded_shard() const noexcept
+{
+  auto best = 0;
+  for (int i = 1; i < num_shards(); ++i)
+  {
+    if (shard_load(i) < shard_load(best))
+    {
+      best = i;
+    }
+  }
+  return best;
+}
+
+void session_manager::enable_hibernation(hibernation_config const& config)
+{
+  std::error_code e;
+  std::filesystem::remove_all(config.directory, e);
+  std::filesystem::create_directories(config.directory, e);
+  if (e)
+  {
+    AURA_ERROR(e, L"Cannot use %ls for hibernated sessions", config.directory.wstring().c_str());
+    return;
+  }
+  m_hibernation = config;
+  arm_hosted_sessions();
+}
+
+void session_manager::enable_timers(session_timers_config const& config)
+{
+  m_timers = config;
+  arm_hosted_sessions();
+}
+
+void session_manager::arm_hosted_sessions()
+{
+  // arm() takes the shard lock under the session's, so not the other way round
+  std::vector<std::shared_ptr<hosted_session>> hosted;
+  for (auto const& shard : m_shards)
+  {
+    std::lock_guard lock{shard->mutex};
+    for (auto const& [id, session] : shard->sessions)
+    {
+      hosted.push_back(session);
+    }
+  }
+  for (auto const& s : hosted)
+  {
+    std::lock_guard lock{s->mutex};
+    if (s->dropped)
+    {
+      continue;
+    }
+    if (s->engine)
+    {
+      update_turn_timer(*s);
+    }
+    touch(*s);
+  }
+}
+
+void session_manager::tick()
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  auto const now = now_tick();
+  std::vector<expired_timer> expired;
+  for (auto const& shard : m_shards)
+  {
+    expired.clear();
+    {
+      std::lock_guard lock{shard->mutex};
+      shard->timers.advance(now, [&](wheel_timer& t)
+      {
+        auto const& timer = static_cast<session_timer const&>(t);
+        expired.emplace_back(expired_timer{timer.session_id, timer.kind, timer.generation});
+      });
+    }
+
+    // the shard lock is released: handling a timer takes the session lock
+    for (auto const& t : expired)
+    {
+      fire(t);
+    }
+  }
+}
+
+void session_manager::fire(expired_timer const& t)
+{
+  auto const session = find(t.session_id);
+  if (!session)
+  {
+    return;
+  }
+  auto& s = *session;
+  std::lock_guard lock{s.mutex};
+  if (s.dropped || s.timer(t.kind).generation != t.generation)
+  {
+    // dropped, or re-armed after it expired
+    return;
+  }
+
+  if (t.kind == session_timer_kind::expire)
+  {
+    AURA_LOG(L"Session %d is %hs, dropping it", s.id, s.relayed ? "abandoned" : "finished");
+    drop(s);
+    return;
+  }
+
+  if (t.kind == session_timer_kind::idle)
+  {
+    if (s.engine)
+    {
+      hibernate(s);
+    }
+    return;
+  }
+  if (s.relayed)
+  {
+    return;
+  }
+
+  if (rehydrate(s))
+  {
+    return;
+  }
+  AURA_LOG(L"Session %d: %hs timed out for player %d", s.id,
+    t.kind == session_timer_kind::turn ? "turn" : "reconnect", s.engine->get_session_info().current_player);
+  auto const commit = [&](player_action const& action)
+  {
+    auto const e = s.engine->commit_action(action);
+    if (!e)
+    {
+      record_action(s, action);
+    }
+    return e;
+  };
+
+  // a player whose turn can't be ended for them loses it, so the session
+  // doesn't sit unattended with no timer left to move it on
+  if (t.kind != session_timer_kind::turn || commit({action_type::end_turn, 0, 0}))
+  {
+    if (auto const e = commit({action_type::forfeit, 0, 0}))
+    {
+      AURA_ERROR(e, L"Session %d: the player to move could not be timed out", s.id);
+    }
+  }
+
+  // the timer fired and is disarmed; arm it for whoever is to move now even
+  // if the timeout didn't change the turn
+  s.timed_turn = -1;
+  update_turn_timer(s);
+}
+
+void session_manager::touch(hosted_session& s)
+{
+  auto const game_over = !s.engine || s.engine->is_game_over();
+  if (m_timers && !game_over && !s.relayed)
+  {
+    arm(s, session_timer_kind::reconnect, m_timers->reconnect_grace);
+  }
+  if (m_timers && s.relayed)
+  {
+    // the players don't tell the server when their game ends, so it ends
+    // when they stop relaying
+    arm(s, session_timer_kind::expire, m_timers->reconnect_grace);
+  }
+  if (m_hibernation)
+  {
+    arm(s, session_timer_kind::idle, m_hibernation->idle_timeout);
+  }
+}
+
+void session_manager::update_turn_timer(hosted_session& s)
+{
+  if (!m_timers || s.relayed)
+  {
+    return;
+  }
+
+  auto const& info = s.engine->get_session_info();
+  if (info.game_over)
+  {
+    cancel(s, session_timer_kind::turn);
+    cancel(s, session_timer_kind::reconnect);
+    arm(s, session_timer_kind::expire, m_timers->finished_grace);
+    return;
+  }
+  if (info.turn != s.timed_turn || info.current_player != s.timed_player)
+  {
+    s.timed_turn = info.turn;
+    s.timed_player = info.current_player;
+    arm(s, session_timer_kind::turn, m_timers->turn_timeout);
+  }
+}
+
+void session_manager::arm(hosted_session& s, session_timer_kind kind, std::chrono::milliseconds timeout)
+{
+  auto& timer = s.timer(kind);
+  auto const deadline = now_tick() + static_cast<std::uint64_t>(timeout / timer_tick);
+  auto& shard = *m_shards[shard_of(s.id)];
+  std::lock_guard lock{shard.mutex};
+  timer.generation++;
+  shard.timers.arm(timer, deadline);
+}
+
+void session_manager::cancel(hosted_session& s, session_timer_kind kind)
+{
+  auto& shard = *m_shards[shard_of(s.id)];
+  std::lock_guard lock{shard.mutex};
+  s.timer(kind).generation++;
+  shard.timers.cancel(s.timer(kind));
+}
+
+std::uint64_t session_manager::now_tick() const noexcept
+{
+  return static_cast<std::uint64_t>((std::chrono::steady_clock::now() - m_epoch) / timer_tick);
+}
+
+std::error_code session_manager::hibernate(hosted_session& s)
+{
+  auto const data = s.engine->snapshot();
+  std::ofstream out{hibernation_path(s.id), std::ios::binary | std::ios::trunc};
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  out.close();
+  if (!out)
+  {
+    auto const e = make_error_code(std::errc::io_error);
+    AURA_ERROR(e, L"Failed to hibernate session %d", s.id);
+    return e;
+  }
+
+  s.engine.reset();
+  measure(s);
+  m_num_hibernated.fetch_add(1, std::memory_order_relaxed);
+  g_hibernated_sessions.add(1);
+  std::lock_guard lock{m_stats_mutex};
+  m_num_hibernations++;
+  return {};
+}
+
+std::error_code session_manager::rehydrate(hosted_session& s)
+{
+  if (s.engine)
+  {
+    return {};
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+  auto const path = hibernation_path(s.id);
+  std::string data;
+  {
+    std::ifstream in{path, std::ios::binary};
+    data.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+  }
+
+  auto [error, engine] = local_rules_engine::restore(data);
+  if (error)
+  {
+    AURA_ERROR(error, L"Failed to rehydrate session %d", s.id);
+    return error;
+  }
+  s.engine = std::make_unique<local_rules_engine>(std::move(engine));
+  measure(s);
+  std::error_code ignored;
+  std::filesystem::remove(path, ignored);
+
+  m_num_hibernated.fetch_sub(1, std::memory_order_relaxed);
+  g_hibernated_sessions.add(-1);
+  auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  std::lock_guard lock{m_stats_mutex};
+  m_num_rehydrations++;
+  m_rehydrate_us.record(static_cast<std::uint64_t>(elapsed.count()));
+  return {};
+}
+
+void session_manager::drop(hosted_session& s)
+{
+  for (int i = 0; i < static_cast<int>(session_timer_kind::count); ++i)
+  {
+    cancel(s, static_cast<session_timer_kind>(i));
+  }
+  if (s.engine)
+  {
+    s.engine.reset();
+  }
+  else
+  {
+    std::error_code ignored;
+    std::filesystem::remove(hibernation_path(s.id), ignored);
+    m_num_hibernated.fetch_sub(1, std::memory_order_relaxed);
+    g_hibernated_sessions.add(-1);
+  }
+  measure(s);
+
+  // a finished game left the log when it ended
+  if (m_log && s.relayed)
+  {
+    m_log->remove(s.id);
+  }
+
+  s.dropped = true;
+  auto& shard = *m_shards[shard_of(s.id)];
+  std::lock_guard lock{shard.mutex};
+  shard.sessions.erase(s.id);
+  shard.load.fetch_sub(1, std::memory_order_relaxed);
+  g_sessions.add(-1);
+}
+
+std::filesystem::path session_manager::hibernation_path(int session_id) const
+{
+  return m_hibernation->directory / (std::to_string(session_id) + ".hib");
+}
+
+session_manager_stats session_manager::stats() const
+{
+  session_manager_stats s{};
+  s.num_sessions = size();
+  s.num_hibernated = m_num_hibernated.load(std::memory_order_relaxed);
+
+  std::lock_guard lock{m_stats_mutex};
+  s.num_hibernations = m_num_hibernations;
+  s.num_rehydrations = m_num_rehydrations;
+  s.rehydrate_us = m_rehydrate_us;
+  s.footprint = m_footprint;
+  s.peak_bytes = m_peak_bytes;
+  s.session_bytes = m_session_bytes;
+  return s;
+}
+
+void session_manager::measure(hosted_session& s)
+{
+  auto const now = s.engine ? s.engine->memory_footprint() : session_footprint{};
+  add_to_gauges(s.footprint, -1);
+  add_to_gauges(now, 1);
+  if (s.engine)
+  {
+    g_bytes_per_session.record(now.total());
+  }
+
+  std::lock_guard lock{m_stats_mutex};
+  m_footprint -= s.footprint;
+  m_footprint += now;
+  m_peak_bytes = std::max(m_peak_bytes, m_footprint.total());
+  g_peak_session_bytes.set(static_cast<std::int64_t>(m_peak_bytes));
+  if (s.engine)
+  {
+    m_session_bytes.record(now.total());
+  }
+  s.footprint = now;
+}
+
+std::shared_ptr<hosted_session> session_manager::find(int session_id) const
+{
+  if (session_id <= 0)
+  {
+    return nullptr;
+  }
+  auto const& shard = *m_shards[shard_of(session_id)];
+  std::lock_guard lock{shard.mutex};
+  if (auto const it = shard.sessions.find(session_id); it != shard.sessions.end())
+  {
+    return it->second;
+  }
+  return nullptr;
+}
+
+size_t session_manager::size() const
+{
+  size_t n = 0;
+  for (auto const& shard : m_shards)
+  {
+    n += static_cast<size_t>(shard->load.load(std::memory_order_relaxed));
+  }
+  return n;
+}
+
+} // namespace aura
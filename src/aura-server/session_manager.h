@@ -0,0 +1,383 @@
+#pragma once
+
+#include <aura-core/local_rules_engine.h>
+#include <aura-core/ruleset.h>
+#include <aura-core/histogram.h>
+#include <aura-server/action_log.h>
+#include <aura-server/spectator_hub.h>
+#include <aura-server/timing_wheel.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace aura
+{
+
+enum class session_timer_kind : int
+{
+  turn,       //!< the player to move runs out of time
+  reconnect,  //!< nobody has talked to the session for too long
+  idle,       //!< the session can be hibernated
+  expire,     //!< the session is over and is dropped
+  count
+};
+
+//! Secrets a session's players prove their seat with, one per seat
+using seat_tokens = std::array<std::uint64_t, 2>;
+
+//! Draws the tokens of a new session. In PvC both seats share one: there is
+//! no computer player on the server, so the human's client plays both.
+seat_tokens make_seat_tokens(game_mode mode);
+
+//! What the action log keeps of a session: its seat tokens, so players can
+//! carry on after a restart, and local_rules_engine::snapshot()
+std::string encode_session_record(seat_tokens const& tokens, std::string_view engine_snapshot);
+
+std::error_code decode_session_record(std::string_view record, seat_tokens& tokens, std::string& engine_snapshot);
+
+struct session_timer : wheel_timer
+{
+  int session_id{};
+  session_timer_kind kind{};
+
+  //! Bumped whenever the timer is armed, so an expiry that raced with a
+  //! re-arm can be recognized as stale
+  std::uint64_t generation{0};
+};
+
+//! Lockstep messages on their way to one seat; see rest::relay_lockstep
+struct relay_mailbox
+{
+  //! Messages the seat has not taken yet, each one written with
+  //! byte_writer::write_string
+  std::string stream;
+
+  //! Bytes relayed to the seat before 'stream'
+  std::uint64_t taken{0};
+};
+
+//! A game session hosted by the server
+struct hosted_session
+{
+  explicit hosted_session(int session_id, ruleset const& rs)
+    : id{session_id}
+    , tokens{make_seat_tokens(rs.mode)}
+    , relayed{rs.mode == game_mode::lockstep}
+    , engine{std::make_unique<local_rules_engine>(rs)}
+  {
+    init_timers();
+  }
+
+  hosted_session(int session_id, seat_tokens const& t, local_rules_engine&& e, int v)
+    : id{session_id}
+    , tokens{t}
+    , relayed{e.get_ruleset().mode == game_mode::lockstep}
+    , engine{std::make_unique<local_rules_engine>(std::move(e))}
+    , version{v}
+  {
+    init_timers();
+  }
+
+  void init_timers() noexcept
+  {
+    for (int i = 0; i < static_cast<int>(session_timer_kind::count); ++i)
+    {
+      timers[i].session_id = id;
+      timers[i].kind = static_cast<session_timer_kind>(i);
+    }
+  }
+
+  session_timer& timer(session_timer_kind kind) noexcept { return timers[static_cast<int>(kind)]; }
+
+  //! Whether 'token' was handed out for 'seat'
+  bool holds_seat(std::uint64_t token, int seat) const noexcept
+  {
+    return seat >= 0 && seat < static_cast<int>(tokens.size()) && tokens[seat] == token;
+  }
+
+  bool holds_any_seat(std::uint64_t token) const noexcept
+  {
+    return holds_seat(token, 0) || holds_seat(token, 1);
+  }
+
+  //! Seats 'token' was handed out for, bit i standing for seat i; both in PvC
+  unsigned seats_of(std::uint64_t token) const noexcept
+  {
+    return (holds_seat(token, 0) ? 1u : 0u) | (holds_seat(token, 1) ? 2u : 0u);
+  }
+
+  int id;
+
+  //! Set at creation and never changed, so they can be read without the lock
+  seat_tokens const tokens;
+
+  //! The players run the game themselves and the server only passes their
+  //! messages on, so 'engine' never moves and only the expire timer runs
+  //! for it
+  bool const relayed;
+
+  //! What both ends of a relayed game seed their engines with
+  std::uint64_t const relay_seed{make_random_seed()};
+
+  //! Serializes requests against the same session
+  std::mutex mutex;
+
+  //! Null while the session is hibernated; with_session() brings it back
+  std::unique_ptr<local_rules_engine> engine;
+
+  //! Number of actions applied to the session so far
+  int version{0};
+
+  //! Linked into the wheel of the session's shard
+  std::array<session_timer, static_cast<int>(session_timer_kind::count)> timers;
+
+  //! Turn and player the turn timer was armed for
+  int timed_turn{-1};
+  int timed_player{-1};
+
+  //! Engine memory as last measured; empty while hibernated
+  session_footprint footprint;
+
+  //! Messages relayed to each seat, kept until the seat has taken them;
+  //! they don't outlive the process
+  std::array<relay_mailbox, 2> relay;
+
+  //! Set once the session is no longer hosted; whoever found it before
+  //! treats it as gone
+  bool dropped{false};
+};
+
+struct session_timers_config
+{
+  //! A player who doesn't end their turn in time has it ended for them
+  std::chrono::seconds turn_timeout{90};
+
+  //! A session nobody has sent a request to for this long is forfeited by
+  //! the player to move. A relayed session, whose end the server can't see,
+  //! is dropped instead.
+  std::chrono::seconds reconnect_grace{300};
+
+  //! A finished game stays for this long so both players can fetch the
+  //! result, then it is dropped
+  std::chrono::seconds finished_grace{30};
+};
+
+struct hibernation_config
+{
+  //! Where hibernated sessions are written
+  std::filesystem::path directory{"hibernated"};
+
+  //! Sessions without requests for this long are moved to disk
+  std::chrono::seconds idle_timeout{120};
+};
+
+struct session_manager_stats
+{
+  size_t num_sessions{};
+  size_t num_hibernated{};
+  std::uint64_t num_hibernations{};
+  std::uint64_t num_rehydrations{};
+
+  //! Time to bring a hibernated session back, in microseconds
+  histogram rehydrate_us;
+
+  //! Memory of the engines in memory, by part, as of their last measurement
+  //! (at creation and after every turn)
+  session_footprint footprint;
+
+  //! The most 'footprint' has added up to
+  size_t peak_bytes{};
+
+  //! Footprint of one session, sampled at each measurement
+  histogram session_bytes;
+};
+
+//! A partition of the hosted sessions with its own lock
+struct session_shard
+{
+  mutable std::mutex mutex;
+
+  //! Shared with the requests that found a session, so dropping it doesn't
+  //! pull it from under them
+  std::unordered_map<int, std::shared_ptr<hosted_session>> sessions;
+  int next_local_id{1};
+
+  //! Number of sessions in this shard, readable without the lock
+  std::atomic<int> load{0};
+
+  //! Timers of the sessions in this shard
+  timing_wheel timers;
+};
+
+//! Owns every session hosted by this server process.
+//! Sessions are spread over shards so that lookups on different shards do not
+//! contend; a session's shard is encoded in its identifier.
+class session_manager
+{
+public:
+  //! 'num_shards' of 0 picks one shard per hardware thread
+  explicit session_manager(ruleset const& rules, int num_shards = 0);
+
+  ~session_manager();
+
+  //! Creates a new session on the least-loaded shard and returns its identifier
+  int create_session(game_mode mode);
+
+  //! Creates a new session on 'shard' and returns its identifier
+  int create_session_on(int shard, game_mode mode);
+
+  //! Hosts a session recovered from the action log under its old identifier
+  void adopt_session(int session_id, seat_tokens const& tokens, local_rules_engine&& engine, int version);
+
+  //! The token of 'seat' in a session; 0 if there is no such session
+  std::uint64_t seat_token(int session_id, int seat) const;
+
+  //! Makes every session write accepted actions to 'log'. Call before
+  //! serving requests.
+  void set_action_log(action_log& log) noexcept { m_log = &log; }
+
+  //! Publishes every new session version to the spectators in 'hub'
+  void set_spectators(spectator_hub& hub) noexcept { m_spectators = &hub; }
+
+  //! Lets 'connection' watch a session, starting from its current state
+  std::error_code add_spectator(int session_id, std::unique_ptr<spectator_connection> connection);
+
+  //! Counts an action 's' has just accepted and queues it in the action log,
+  //! or a snapshot every snapshot_interval actions, and publishes the new
+  //! version to spectators. Call with 's' locked.
+  action_log::ticket record_action(hosted_session& s, player_action const& action);
+
+  //! Blocks until the records up to 't' are durable
+  std::error_code wait_durable(action_log::ticket t);
+
+  //! Runs 'fn' with the session locked, rehydrating it first if it was
+  //! hibernated. Returns std::errc::invalid_argument if there is no such
+  //! session.
+  template <typename Fn>
+  std::error_code with_session(int session_id, Fn const& fn)
+  {
+    auto const session = find(session_id);
+    if (!session)
+    {
+      return make_error_code(std::errc::invalid_argument);
+    }
+    std::lock_guard lock{session->mutex};
+    if (session->dropped)
+    {
+      return make_error_code(std::errc::invalid_argument);
+    }
+    if (auto const e = rehydrate(*session))
+    {
+      return e;
+    }
+    fn(*session);
+    touch(*session);
+    return {};
+  }
+
+  //! Moves sessions idle for longer than the configured timeout to disk and
+  //! frees their engine. Leftovers from a previous process in the directory
+  //! are discarded; the action log is what survives restarts. Sessions
+  //! hosted already, e.g. recovered ones, start idling now. Call before
+  //! serving requests.
+  void enable_hibernation(hibernation_config const& config);
+
+  //! Arms turn and reconnect timers on every session, including those
+  //! hosted already, and drops finished and abandoned relayed sessions.
+  //! Call before serving requests.
+  void enable_timers(session_timers_config const& config);
+
+  //! Length of a timer tick
+  static constexpr std::chrono::milliseconds timer_tick{10};
+
+  //! Advances the timing wheel of every shard to now and handles the expired
+  //! timers. Timeouts are applied as ordinary actions. Call every timer_tick.
+  void tick();
+
+  session_manager_stats stats() const;
+
+  int least_loaded_shard() const noexcept;
+
+  int shard_of(int session_id) const noexcept { return session_id % num_shards(); }
+
+  int num_shards() const noexcept { return static_cast<int>(m_shards.size()); }
+
+  //! Number of sessions on 'shard'
+  int shard_load(int shard) const noexcept { return m_shards[shard]->load.load(std::memory_order_relaxed); }
+
+  size_t size() const;
+
+private:
+  std::shared_ptr<hosted_session> find(int session_id) const;
+
+  //! Arms the timers of every hosted session for the current configuration
+  void arm_hosted_sessions();
+
+  //! Writes a locked session to disk and frees its engine
+  std::error_code hibernate(hosted_session& s);
+
+  //! Reloads a locked session's engine if it was hibernated
+  std::error_code rehydrate(hosted_session& s);
+
+  //! Stops hosting a locked session: cancels its timers, deletes its
+  //! hibernation file and takes it out of its shard
+  void drop(hosted_session& s);
+
+  std::filesystem::path hibernation_path(int session_id) const;
+
+  //! Re-measures the engine memory of a locked session
+  void measure(hosted_session& s);
+
+  struct expired_timer
+  {
+    int session_id;
+    session_timer_kind kind;
+    std::uint64_t generation;
+  };
+
+  //! Re-arms the reconnect, idle and, for relayed sessions, expire timers of
+  //! a locked session after a request
+  void touch(hosted_session& s);
+
+  //! Re-arms the turn timer of a locked session if the player to move
+  //! changed, or arms its expire timer once the game is over
+  void update_turn_timer(hosted_session& s);
+
+  void arm(hosted_session& s, session_timer_kind kind, std::chrono::milliseconds timeout);
+  void cancel(hosted_session& s, session_timer_kind kind);
+
+  void fire(expired_timer const& t);
+
+  std::uint64_t now_tick() const noexcept;
+
+  ruleset m_rules;
+
+  action_log* m_log{nullptr};
+  spectator_hub* m_spectators{nullptr};
+
+  std::optional<hibernation_config> m_hibernation;
+  std::optional<session_timers_config> m_timers;
+  std::chrono::steady_clock::time_point const m_epoch{std::chrono::steady_clock::now()};
+
+  mutable std::mutex m_stats_mutex;
+  std::atomic<size_t> m_num_hibernated{0};
+  std::uint64_t m_num_hibernations{0};
+  std::uint64_t m_num_rehydrations{0};
+  histogram m_rehydrate_us;
+  session_footprint m_footprint;
+  size_t m_peak_bytes{0};
+  histogram m_session_bytes;
+
+  std::vector<std::unique_ptr<session_shard>> m_shards;
+};
+
+} // namespace aura
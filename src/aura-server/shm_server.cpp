@@ -0,0 +1,165 @@
+#include "shm_server.h"
+#include <aura-core/build.h>
+
+namespace aura
+{
+
+namespace
+{
+
+//! Also how long shutdown may take
+constexpr auto poll_interval = std::chrono::milliseconds{100};
+
+//! A client that stops reading its responses loses the channel. No
+//! shorter than the clients' own timeout, which has run out by then.
+constexpr auto response_timeout = std::chrono::seconds{5};
+
+} // namespace {}
+
+shm_server::shm_server(shm_server_config const& config)
+  : m_config{config}
+{
+}
+
+shm_server::~shm_server()
+{
+  m_stop = true;
+  for (auto& t : m_threads)
+  {
+    t.join();
+  }
+  if (m_region)
+  {
+    remove_shared_memory(m_config.name);
+    unmap_shared_memory(m_region, m_region_size);
+  }
+}
+
+void shm_server::add_route(std::string const& path, handler h)
+{
+  m_routes.emplace(path, std::move(h));
+}
+
+std::error_code shm_server::start()
+{
+  // a previous server may have died without removing its region
+  remove_shared_memory(m_config.name);
+
+  auto const num_channels = static_cast<std::uint32_t>(m_config.num_channels);
+  m_region_size = shm_region::size_for(num_channels);
+  auto const [error, data] = map_shared_memory(m_config.name, m_region_size, true);
+  if (error)
+  {
+    AURA_ERROR(error, L"Cannot publish '%hs' for shared-memory clients", m_config.name.c_str());
+    return error;
+  }
+  m_region = data;
+
+  // opened before any channel is served, so the vector doesn't move
+  m_wakeups.resize(num_channels);
+  for (std::uint32_t i = 0; i < num_channels; ++i)
+  {
+    if (auto const e = m_wakeups[i].open(m_config.name, i))
+    {
+      AURA_ERROR(e, L"Cannot open the wakeups of channel %u of '%hs'", i, m_config.name.c_str());
+      return e;
+    }
+  }
+
+  auto* region = static_cast<shm_region*>(data);
+  region->version = shm_region::layout_version;
+  region->num_channels = num_channels;
+  region->frame_size = shm_frame::size;
+  for (std::uint32_t i = 0; i < num_channels; ++i)
+  {
+    auto& channel = region->channels()[i];
+    channel.state.store(shm_channel::free);
+    channel.owner_pid.store(0);
+    channel.requests.reset();
+    channel.responses.reset();
+    m_threads.emplace_back([this, &channel, &wakeups = m_wakeups[i]] { serve(channel, wakeups); });
+  }
+  // clients check the magic last
+  region->magic.store(shm_region::magic_value);
+
+  AURA_LOG(L"Serving %u shared-memory channels at '%hs'", num_channels, m_config.name.c_str());
+  return {};
+}
+
+void shm_server::serve(shm_channel& channel, shm_channel_wakeups const& wakeups)
+{
+  trace_set_thread_name("shm channel");
+  std::string message;
+  while (!m_stop)
+  {
+    if (channel.requests.receive(message, std::chrono::steady_clock::now() + poll_interval, wakeups.requests))
+    {
+      reclaim_if_abandoned(channel, message);
+      continue;
+    }
+
+    auto const response = dispatch(message);
+    message.clear();
+    if ((channel.state.load() & shm_channel::status_mask) == shm_channel::abandoned)
+    {
+      // the client timed out while the request was handled
+      free_channel(channel, message);
+      continue;
+    }
+    if (auto const e = channel.responses.send(response, std::chrono::steady_clock::now() + response_timeout,
+      wakeups.responses))
+    {
+      // part of the response is in the ring, so the channel is of no use
+      // to anyone until it is reset
+      AURA_ERROR(e, L"Shared-memory client %d stopped reading, freeing its channel", channel.owner_pid.load());
+      free_channel(channel, message);
+    }
+  }
+}
+
+std::string shm_server::dispatch(std::string_view message) const
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  auto const [error, request] = decode_shm_request(message);
+  if (error)
+  {
+    AURA_ERROR(error, L"Malformed shared-memory request");
+    return {};
+  }
+
+  auto const& [path, body] = request;
+  auto const it = m_routes.find(path);
+  if (it == m_routes.end())
+  {
+    AURA_ERROR(make_error_code(std::errc::invalid_argument), L"No shared-memory route for %hs", path.c_str());
+    return {};
+  }
+  return it->second(std::string{body});
+}
+
+void shm_server::reclaim_if_abandoned(shm_channel& channel, std::string& partial)
+{
+  auto const status = channel.state.load() & shm_channel::status_mask;
+  auto const pid = channel.owner_pid.load();
+  if (status == shm_channel::abandoned)
+  {
+    AURA_LOG(L"Shared-memory client %d gave up on its channel, freeing it", pid);
+  }
+  else if (status == shm_channel::claimed && pid != 0 && !is_process_alive(pid))
+  {
+    AURA_LOG(L"Shared-memory client %d is gone, freeing its channel", pid);
+  }
+  else
+  {
+    return;
+  }
+  free_channel(channel, partial);
+}
+
+void shm_server::free_channel(shm_channel& channel, std::string& partial)
+{
+  partial.clear();
+  channel.recycle();
+}
+
+} // namespace aura
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <aura-core/shm_ring.h>
+#include <aura-core/shm_transport.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace aura
+{
+
+struct shm_server_config
+{
+  std::string name{default_shm_name};
+
+  //! Clients that can be connected at once; each gets a serving thread,
+  //! which sleeps in the kernel while its client is quiet. A thread of its
+  //! own lets a handler block, as new_session does while matching.
+  int num_channels{16};
+};
+
+//! Serves the rest:: requests of same-host clients (see shm_transport)
+//! from a shared-memory region, next to the http server.
+class shm_server
+{
+public:
+  //! Returns the response body for a request body
+  using handler = std::function<std::string(std::string const& body)>;
+
+  explicit shm_server(shm_server_config const& config = {});
+
+  ~shm_server();
+
+  shm_server(shm_server const&) = delete;
+  shm_server& operator=(shm_server const&) = delete;
+
+  //! Routes must all be added before start()
+  void add_route(std::string const& path, handler h);
+
+  //! Publishes the region and starts serving
+  std::error_code start();
+
+private:
+  void serve(shm_channel& channel, shm_channel_wakeups const& wakeups);
+
+  std::string dispatch(std::string_view message) const;
+
+  //! Frees the channel of a client that gave up on it or died while
+  //! connected
+  void reclaim_if_abandoned(shm_channel& channel, std::string& partial);
+
+  //! Resets both rings and frees the channel; a client still holding it
+  //! sees the generation change and stops using it
+  void free_channel(shm_channel& channel, std::string& partial);
+
+  shm_server_config const m_config;
+  std::unordered_map<std::string, handler> m_routes;
+  void* m_region{nullptr};
+  size_t m_region_size{0};
+  std::vector<shm_channel_wakeups> m_wakeups;
+  std::atomic<bool> m_stop{false};
+  std::vector<std::thread> m_threads;
+};
+
+} // namespace aura
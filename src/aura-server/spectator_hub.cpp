@@ -0,0 +1,237 @@
+#include "spectator_hub.h"
+#include <aura-core/build.h>
+#include <aura-core/platform.h>
+#include <aura-core/serialization.h>
+#include <algorithm>
+
+namespace aura
+{
+
+namespace
+{
+
+//! A frame is a 4-byte little-endian payload length followed by the payload:
+//! the session version and the redacted session_info.
+shared_frame encode_frame(int version, session_info const& view)
+{
+  byte_writer w;
+  w.buffer.assign(4, '\0');
+  w.write_int(version);
+  write(w, view);
+
+  auto const length = static_cast<std::uint32_t>(w.buffer.size() - 4);
+  for (int i = 0; i < 4; ++i)
+  {
+    w.buffer[i] = static_cast<char>((length >> (8 * i)) & 0xff);
+  }
+  return std::make_shared<std::string const>(std::move(w.buffer));
+}
+
+} // namespace {}
+
+spectator_hub::spectator_hub(spectator_config const& config)
+  : m_config{config}
+{
+  m_thread = std::thread{[this] { fanout_loop(); }};
+}
+
+spectator_hub::~spectator_hub()
+{
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+}
+
+void spectator_hub::add(int session_id, std::unique_ptr<spectator_connection> connection)
+{
+  std::lock_guard lock{m_mutex};
+  if (m_channels[session_id].num_spectators++ == 0)
+  {
+    m_num_watched.fetch_add(1, std::memory_order_relaxed);
+  }
+  m_joining.emplace_back(session_id, std::move(connection));
+  m_wake.notify_one();
+}
+
+bool spectator_hub::is_watched(int session_id) const
+{
+  if (m_num_watched.load(std::memory_order_relaxed) == 0)
+  {
+    return false;
+  }
+  std::lock_guard lock{m_mutex};
+  auto const it = m_channels.find(session_id);
+  return it != m_channels.end() && it->second.num_spectators > 0;
+}
+
+void spectator_hub::publish(int session_id, int version, session_info const& info)
+{
+  if (!is_watched(session_id))
+  {
+    return;
+  }
+
+  // encoded once, outside the lock, however many spectators there are
+  auto const cpu_start = thread_cpu_time();
+  auto frame = encode_frame(version, redact_for_seats(info, 0));
+  auto const cpu = thread_cpu_time() - cpu_start;
+
+  std::lock_guard lock{m_mutex};
+  auto& ch = m_channels[session_id];
+  if (version <= ch.last_version)
+  {
+    return;
+  }
+  ch.last_version = version;
+  m_stats.num_frames++;
+  m_stats.bytes_encoded += frame->size();
+  m_stats.encode_cpu += cpu;
+  ch.delayed.emplace_back(delayed_frame{std::chrono::steady_clock::now() + m_config.delay, std::move(frame)});
+}
+
+spectator_stats spectator_hub::stats() const
+{
+  std::lock_guard lock{m_mutex};
+  auto s = m_stats;
+  for (auto const& [id, ch] : m_channels)
+  {
+    s.num_spectators += static_cast<size_t>(ch.num_spectators);
+  }
+  return s;
+}
+
+void spectator_hub::fanout_loop()
+{
+  trace_set_thread_name("spectator fan-out");
+  std::unique_lock lock{m_mutex};
+  while (!m_stop)
+  {
+    m_wake.wait_for(lock, m_config.fanout_interval);
+    lock.unlock();
+    fanout();
+    lock.lock();
+  }
+}
+
+void spectator_hub::fanout()
+{
+  AURA_TRACE_SCOPE(__FUNCTION__);
+  auto const cpu_start = thread_cpu_time();
+  auto const now = std::chrono::steady_clock::now();
+
+  decltype(m_joining) joining;
+  std::vector<std::pair<int, shared_frame>> released;
+  {
+    std::lock_guard lock{m_mutex};
+    joining.swap(m_joining);
+    for (auto& [id, ch] : m_channels)
+    {
+      while (!ch.delayed.empty() && ch.delayed.front().release <= now)
+      {
+        released.emplace_back(id, std::move(ch.delayed.front().frame));
+        ch.delayed.pop_front();
+      }
+    }
+  }
+
+  for (auto& [id, connection] : joining)
+  {
+    auto& a = m_audiences[id];
+    auto& s = a.spectators.emplace_back(spectator{std::move(connection), {}, 0});
+    if (a.latest)
+    {
+      s.outbox.emplace_back(a.latest);
+    }
+  }
+
+  std::uint64_t num_deliveries = 0;
+  std::uint64_t num_skipped = 0;
+  for (auto& [id, frame] : released)
+  {
+    auto const it = m_audiences.find(id);
+    if (it == m_audiences.end())
+    {
+      continue;
+    }
+    auto& a = it->second;
+    a.latest = frame;
+    for (auto& s : a.spectators)
+    {
+      s.outbox.emplace_back(frame);
+      ++num_deliveries;
+      if (s.outbox.size() > m_config.max_backlog)
+      {
+        // keep a partly sent frame so the stream stays well-formed
+        auto const first = s.offset ? 1 : 0;
+        auto const skip = s.outbox.size() - m_config.max_backlog;
+        s.outbox.erase(s.outbox.begin() + first, s.outbox.begin() + first + static_cast<std::ptrdiff_t>(skip));
+        num_skipped += skip;
+      }
+    }
+  }
+
+  std::uint64_t num_sends = 0;
+  std::uint64_t bytes_sent = 0;
+  std::vector<std::pair<int, int>> dropped; // session id, # of spectators
+  for (auto& [id, a] : m_audiences)
+  {
+    auto const before = a.spectators.size();
+    a.spectators.erase(std::remove_if(a.spectators.begin(), a.spectators.end(), [&](spectator& s)
+    {
+      if (s.outbox.empty())
+      {
+        return false;
+      }
+      auto const [error, n] = s.connection->send(s.outbox, s.offset);
+      ++num_sends;
+      bytes_sent += n;
+      if (error)
+      {
+        return true;
+      }
+
+      // pop whatever went out completely
+      auto sent = s.offset + n;
+      size_t done = 0;
+      while (done < s.outbox.size() && sent >= s.outbox[done]->size())
+      {
+        sent -= s.outbox[done]->size();
+        ++done;
+      }
+      s.outbox.erase(s.outbox.begin(), s.outbox.begin() + static_cast<std::ptrdiff_t>(done));
+      s.offset = sent;
+      return false;
+    }), a.spectators.end());
+
+    if (a.spectators.size() != before)
+    {
+      dropped.emplace_back(id, static_cast<int>(before - a.spectators.size()));
+    }
+  }
+
+  std::lock_guard lock{m_mutex};
+  for (auto const& [id, n] : dropped)
+  {
+    auto& ch = m_channels[id];
+    ch.num_spectators -= n;
+    if (ch.num_spectators == 0)
+    {
+      m_num_watched.fetch_sub(1, std::memory_order_relaxed);
+      m_channels.erase(id);
+      m_audiences.erase(id);
+    }
+  }
+  m_stats.num_deliveries += num_deliveries;
+  m_stats.num_skipped += num_skipped;
+  m_stats.num_sends += num_sends;
+  m_stats.bytes_sent += bytes_sent;
+  m_stats.fanout_cpu += thread_cpu_time() - cpu_start;
+}
+
+} // namespace aura
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <aura-core/session_info.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aura
+{
+
+//! An encoded spectator update. It is immutable once published and shared
+//! by every spectator of the session.
+using shared_frame = std::shared_ptr<std::string const>;
+
+//! Transport to one spectator
+class spectator_connection
+{
+public:
+  virtual ~spectator_connection() = default;
+
+  //! Writes as much of 'frames' as it can without blocking, starting
+  //! 'offset' bytes into the first frame, straight from the frames' memory.
+  //! Returns the number of bytes written; an error drops the spectator.
+  virtual std::pair<std::error_code, size_t> send(std::vector<shared_frame> const& frames, size_t offset) = 0;
+};
+
+struct spectator_config
+{
+  //! How far behind the live game spectators are kept
+  std::chrono::milliseconds delay{std::chrono::seconds(30)};
+
+  //! How often released updates are pushed to spectators
+  std::chrono::milliseconds fanout_interval{10};
+
+  //! Updates a slow spectator may fall behind by before it skips to the
+  //! latest one. Every update is a complete view, so skipping loses nothing.
+  size_t max_backlog{4};
+};
+
+struct spectator_stats
+{
+  size_t num_spectators{};
+  std::uint64_t num_frames{};      //!< updates encoded, one per watched session version
+  std::uint64_t bytes_encoded{};
+  std::uint64_t num_deliveries{};  //!< updates handed to a spectator
+  std::uint64_t num_skipped{};     //!< updates a slow spectator skipped
+  std::uint64_t num_sends{};       //!< send() calls, each covering every frame a spectator is owed
+  std::uint64_t bytes_sent{};
+  std::chrono::nanoseconds encode_cpu{};  //!< CPU spent encoding updates
+  std::chrono::nanoseconds fanout_cpu{};  //!< CPU spent by the fan-out thread
+};
+
+//! Fans session updates out to spectators.
+//!
+//! Each new version of a watched session is redacted for a viewer holding no
+//! seat (see redact_for_seats) and encoded once into a shared_frame. Frames
+//! are held back for the configured delay, then a fan-out thread queues the
+//! same frame for every spectator of the session and writes each
+//! spectator's queue with a single scatter/gather send.
+//! Spectators joining late start from the latest released frame.
+class spectator_hub
+{
+public:
+  explicit spectator_hub(spectator_config const& config = {});
+
+  ~spectator_hub();
+
+  spectator_hub(spectator_hub const&) = delete;
+  spectator_hub& operator=(spectator_hub const&) = delete;
+
+  //! Starts sending 'session_id' to 'connection'
+  void add(int session_id, std::unique_ptr<spectator_connection> connection);
+
+  //! Whether anybody watches 'session_id'; cheap when nobody watches anything
+  bool is_watched(int session_id) const;
+
+  //! Queues the view of 'session_id' at 'version'. Versions that were
+  //! already published are ignored.
+  void publish(int session_id, int version, session_info const& info);
+
+  spectator_stats stats() const;
+
+private:
+  struct delayed_frame
+  {
+    std::chrono::steady_clock::time_point release;
+    shared_frame frame;
+  };
+
+  //! Shared with publishers, guarded by m_mutex
+  struct channel
+  {
+    int num_spectators{0};
+    int last_version{-1};
+    std::deque<delayed_frame> delayed;
+  };
+
+  struct spectator
+  {
+    std::unique_ptr<spectator_connection> connection;
+    std::vector<shared_frame> outbox;
+    size_t offset{0}; //!< bytes of outbox.front() already sent
+  };
+
+  //! Owned by the fan-out thread
+  struct audience
+  {
+    shared_frame latest;
+    std::vector<spectator> spectators;
+  };
+
+  void fanout_loop();
+
+  void fanout();
+
+  spectator_config const m_config;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::unordered_map<int, channel> m_channels;
+  std::vector<std::pair<int, std::unique_ptr<spectator_connection>>> m_joining;
+  std::atomic<int> m_num_watched{0};
+  spectator_stats m_stats;
+  bool m_stop{false};
+
+  std::unordered_map<int, audience> m_audiences;
+
+  std::thread m_thread;
+};
+
+} // namespace aura
@@ -0,0 +1,320 @@
+#include "spectator_socket.h"
+#include "session_manager.h"
+#include <aura-core/build.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+# include <winsock2.h>
+# include <ws2tcpip.h>
+#else
+# include <arpa/inet.h>
+# include <fcntl.h>
+# include <netinet/in.h>
+# include <poll.h>
+# include <sys/socket.h>
+# include <sys/uio.h>
+# include <unistd.h>
+#endif
+
+namespace aura
+{
+
+namespace
+{
+
+#ifdef _WIN32
+using io_buffer = WSABUF;
+constexpr size_t max_buffers = 64;
+
+std::error_code last_socket_error() { return {::WSAGetLastError(), std::system_category()}; }
+bool would_block() { return ::WSAGetLastError() == WSAEWOULDBLOCK; }
+void close_socket(native_socket s) { ::closesocket(static_cast<SOCKET>(s)); }
+
+void set_non_blocking(native_socket s)
+{
+  u_long on = 1;
+  ::ioctlsocket(static_cast<SOCKET>(s), FIONBIO, &on);
+}
+
+io_buffer make_buffer(char const* data, size_t size)
+{
+  return io_buffer{static_cast<ULONG>(size), const_cast<char*>(data)};
+}
+#else
+using io_buffer = iovec;
+constexpr size_t max_buffers = 64; // well below IOV_MAX
+
+std::error_code last_socket_error() { return {errno, std::system_category()}; }
+bool would_block() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+void close_socket(native_socket s) { ::close(static_cast<int>(s)); }
+
+void set_non_blocking(native_socket s)
+{
+  auto const fd = static_cast<int>(s);
+  ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+io_buffer make_buffer(char const* data, size_t size)
+{
+  return io_buffer{const_cast<char*>(data), size};
+}
+#endif
+
+class socket_spectator : public spectator_connection
+{
+public:
+  explicit socket_spectator(native_socket s)
+    : m_socket{s}
+  {
+    set_non_blocking(m_socket);
+  }
+
+  ~socket_spectator() override
+  {
+    close_socket(m_socket);
+  }
+
+  std::pair<std::error_code, size_t> send(std::vector<shared_frame> const& frames, size_t offset) override
+  {
+    // point the buffers at the shared frames instead of copying them out
+    m_buffers.clear();
+    for (auto const& frame : frames)
+    {
+      if (m_buffers.size() == max_buffers)
+      {
+        break;
+      }
+      m_buffers.emplace_back(make_buffer(frame->data() + offset, frame->size() - offset));
+      offset = 0;
+    }
+
+#ifdef _WIN32
+    DWORD n = 0;
+    if (::WSASend(static_cast<SOCKET>(m_socket), m_buffers.data(), static_cast<DWORD>(m_buffers.size()), &n, 0,
+      nullptr, nullptr) != 0)
+#else
+    msghdr msg{};
+    msg.msg_iov = m_buffers.data();
+    msg.msg_iovlen = m_buffers.size();
+# ifdef MSG_NOSIGNAL
+    auto const n = ::sendmsg(static_cast<int>(m_socket), &msg, MSG_NOSIGNAL);
+# else
+    auto const n = ::sendmsg(static_cast<int>(m_socket), &msg, 0);
+# endif
+    if (n < 0)
+#endif
+    {
+      if (would_block())
+      {
+        return {{}, 0};
+      }
+      return {last_socket_error(), 0};
+    }
+    return {{}, static_cast<size_t>(n)};
+  }
+
+private:
+  native_socket m_socket;
+  std::vector<io_buffer> m_buffers;
+};
+
+} // namespace {}
+
+std::unique_ptr<spectator_connection> make_socket_spectator(native_socket s)
+{
+  return std::make_unique<socket_spectator>(s);
+}
+
+spectator_listener::spectator_listener(session_manager& sessions, int port)
+  : m_sessions{sessions}
+{
+  auto const s = static_cast<native_socket>(::socket(AF_INET, SOCK_STREAM, 0));
+  int const on = 1;
+  ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&on), sizeof(on));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<unsigned short>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(s, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0 || ::listen(s, 128) != 0)
+  {
+    AURA_ERROR(last_socket_error(), L"Cannot listen for spectators on port %d", port);
+    close_socket(s);
+    return;
+  }
+
+  m_socket = s;
+  m_thread = std::thread{[this] { accept_loop(); }};
+  AURA_LOG(L"Accepting spectators on localhost:%d", port);
+}
+
+spectator_listener::~spectator_listener()
+{
+  m_stop = true;
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+  if (m_socket != -1)
+  {
+    close_socket(m_socket);
+  }
+}
+
+void spectator_listener::accept_loop()
+{
+  while (!m_stop)
+  {
+#ifdef _WIN32
+    WSAPOLLFD pfd{static_cast<SOCKET>(m_socket), POLLIN, 0};
+    if (::WSAPoll(&pfd, 1, 100) <= 0)
+#else
+    pollfd pfd{static_cast<int>(m_socket), POLLIN, 0};
+    if (::poll(&pfd, 1, 100) <= 0)
+#endif
+    {
+      continue;
+    }
+
+    auto const client = static_cast<native_socket>(::accept(m_socket, nullptr, nullptr));
+    if (client < 0)
+    {
+      continue;
+    }
+
+    // the session id is tiny; a spectator that can't send it promptly is dropped
+#ifdef _WIN32
+    DWORD const timeout = 1000;
+#else
+    timeval const timeout{1, 0};
+#endif
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char const*>(&timeout), sizeof(timeout));
+    unsigned char id_bytes[4]{};
+    if (::recv(client, reinterpret_cast<char*>(id_bytes), 4, MSG_WAITALL) != 4)
+    {
+      close_socket(client);
+      continue;
+    }
+    auto const session_id = static_cast<int>(id_bytes[0] | (id_bytes[1] << 8) | (id_bytes[2] << 16)
+      | (static_cast<unsigned>(id_bytes[3]) << 24));
+
+    if (auto const e = m_sessions.add_spectator(session_id, make_socket_spectator(client)))
+    {
+      AURA_ERROR(e, L"Spectator asked for unknown session %d", session_id);
+    }
+  }
+}
+
+int run_spectator_benchmark(int num_spectators, int num_updates)
+{
+  std::atomic<std::uint64_t> bytes_received{0};
+  std::vector<std::thread> readers;
+  spectator_stats s{};
+  {
+    spectator_config config{};
+    config.delay = std::chrono::milliseconds{0};
+    config.fanout_interval = std::chrono::milliseconds{1};
+    spectator_hub hub{config};
+    session_manager sessions{ruleset{}, 1};
+    sessions.set_spectators(hub);
+    auto const id = sessions.create_session(game_mode::PvP);
+
+    // spectators connect through a real loopback listener
+    auto const listener = static_cast<native_socket>(::socket(AF_INET, SOCK_STREAM, 0));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    ::bind(listener, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr));
+    ::listen(listener, 1024);
+    ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+
+    for (int i = 0; i < num_spectators; ++i)
+    {
+      auto const client = static_cast<native_socket>(::socket(AF_INET, SOCK_STREAM, 0));
+      ::connect(client, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr));
+      auto const server_side = static_cast<native_socket>(::accept(listener, nullptr, nullptr));
+      sessions.add_spectator(id, make_socket_spectator(server_side));
+
+      readers.emplace_back([client, &bytes_received]
+      {
+        char buffer[1 << 14];
+        while (true)
+        {
+          auto const n = ::recv(client, buffer, sizeof(buffer), 0);
+          if (n <= 0)
+          {
+            break;
+          }
+          bytes_received.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+        }
+        close_socket(client);
+      });
+    }
+    close_socket(listener);
+
+    // a steady stream of versions, roughly one per fan-out pass
+    std::mt19937 rng{1};
+    int applied = 0;
+    for (int i = 0; applied < num_updates && i < num_updates * 20; ++i)
+    {
+      sessions.with_session(id, [&](hosted_session& session)
+      {
+        auto const& info = session.engine->get_session_info();
+        auto const& player = info.players[info.current_player];
+        player_action action{action_type::end_turn, 0, 0};
+        if (!info.picks.empty() && player.picks_available)
+        {
+          action = {action_type::pick, info.picks[rng() % info.picks.size()].uid, 0};
+        }
+        else if (!player.hand.empty() && rng() % 2)
+        {
+          action = {action_type::deploy, player.hand[rng() % player.hand.size()].uid, static_cast<int>(1 + rng() % 4)};
+        }
+        if (!session.engine->commit_action(action))
+        {
+          sessions.record_action(session, action);
+          ++applied;
+        }
+      });
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    // wait for the last frames to reach every spectator
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+      s = hub.stats();
+      if (s.num_deliveries >= s.num_frames * num_spectators && s.bytes_sent == bytes_received.load())
+      {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    s = hub.stats();
+  }
+
+  // the hub closed its end of every connection
+  for (auto& r : readers)
+  {
+    r.join();
+  }
+
+  auto const deliveries = std::max<std::uint64_t>(1, s.num_deliveries);
+  AURA_PRINT(L"spectators: %d, updates: %llu (%.0f bytes each), deliveries: %llu, skipped: %llu\n", num_spectators,
+    static_cast<unsigned long long>(s.num_frames),
+    static_cast<double>(s.bytes_encoded) / std::max<std::uint64_t>(1, s.num_frames),
+    static_cast<unsigned long long>(s.num_deliveries), static_cast<unsigned long long>(s.num_skipped));
+  AURA_PRINT(L"encode: %.1f us per update (once per version)\n",
+    std::chrono::duration<double, std::micro>(s.encode_cpu).count() / std::max<std::uint64_t>(1, s.num_frames));
+  AURA_PRINT(L"fan-out: %.0f ns CPU per spectator per update, %.2f sends per delivery, %llu bytes sent, %llu received\n",
+    static_cast<double>(s.fanout_cpu.count()) / deliveries, static_cast<double>(s.num_sends) / deliveries,
+    static_cast<unsigned long long>(s.bytes_sent), static_cast<unsigned long long>(bytes_received.load()));
+  return 0;
+}
+
+} // namespace aura
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <aura-server/spectator_hub.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace aura
+{
+
+class session_manager;
+
+//! Native socket handle (a file descriptor, or a SOCKET on Windows)
+using native_socket = std::intptr_t;
+
+//! Wraps a connected stream socket, which it makes non-blocking and owns.
+//! Frames go out with one vectored write, without being copied.
+std::unique_ptr<spectator_connection> make_socket_spectator(native_socket s);
+
+//! Accepts spectators on a TCP port. A spectator connects and sends the
+//! 4-byte little-endian id of the session to watch; from then on it
+//! receives frames as described in spectator_hub.
+class spectator_listener
+{
+public:
+  spectator_listener(session_manager& sessions, int port);
+
+  ~spectator_listener();
+
+  spectator_listener(spectator_listener const&) = delete;
+  spectator_listener& operator=(spectator_listener const&) = delete;
+
+private:
+  void accept_loop();
+
+  session_manager& m_sessions;
+  native_socket m_socket{-1};
+  std::atomic<bool> m_stop{false};
+  std::thread m_thread;
+};
+
+//! Localhost benchmark: 'num_spectators' TCP spectators watch one session
+//! while 'num_updates' actions are applied to it. Reports the CPU spent per
+//! spectator per update.
+int run_spectator_benchmark(int num_spectators, int num_updates);
+
+} // namespace aura
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace aura
+{
+
+//! Intrusive timer node; embed it in whatever the timer belongs to.
+//! A timer must stay at the same address while it is armed.
+struct wheel_timer
+{
+  wheel_timer() = default;
+  wheel_timer(wheel_timer const&) = delete;
+  wheel_timer& operator=(wheel_timer const&) = delete;
+
+  //! Tick at which the timer fires
+  std::uint64_t deadline{0};
+
+  bool armed() const noexcept { return prev != nullptr; }
+
+private:
+  friend class timing_wheel;
+  wheel_timer* prev{nullptr};
+  wheel_timer* next{nullptr};
+};
+
+//! Hierarchical timing wheel (Varghese & Lauck) with four levels of 64 slots.
+//!
+//! Timers live in the slot of the coarsest level at which their deadline and
+//! the current tick still differ, and move one level down each time the
+//! wheel reaches their slot, so arm and cancel are O(1) and each tick only
+//! looks at the slots it passes. Deadlines further out than 64^4 ticks are
+//! clamped. Not thread-safe.
+class timing_wheel
+{
+public:
+  static constexpr int slot_bits = 6;
+  static constexpr int num_slots = 1 << slot_bits;
+  static constexpr int num_levels = 4;
+  static constexpr std::uint64_t max_span = (std::uint64_t{1} << (slot_bits * num_levels)) - 1;
+
+  explicit timing_wheel(std::uint64_t now = 0) noexcept
+    : m_now{now}
+  {
+    for (auto& level : m_slots)
+    {
+      for (auto& slot : level)
+      {
+        slot.prev = slot.next = &slot;
+      }
+    }
+  }
+
+  timing_wheel(timing_wheel const&) = delete;
+  timing_wheel& operator=(timing_wheel const&) = delete;
+
+  //! (Re)arms 't' to fire once the wheel reaches tick 'deadline'. Deadlines
+  //! in the past fire on the next advance().
+  void arm(wheel_timer& t, std::uint64_t deadline) noexcept
+  {
+    cancel(t);
+    t.deadline = std::clamp(deadline, m_now + 1, m_now + max_span);
+    link(t);
+    ++m_size;
+  }
+
+  void cancel(wheel_timer& t) noexcept
+  {
+    if (t.armed())
+    {
+      unlink(t);
+      --m_size;
+    }
+  }
+
+  //! Moves the wheel to tick 'now', calling on_expire(wheel_timer&) for every
+  //! timer whose deadline has passed. Expired timers are disarmed before the
+  //! call, so the callback may arm them again.
+  template <typename Fn>
+  void advance(std::uint64_t now, Fn&& on_expire)
+  {
+    if (m_size == 0)
+    {
+      m_now = std::max(m_now, now);
+      return;
+    }
+
+    while (m_now < now)
+    {
+      ++m_now;
+
+      // bring down the timers of every level whose slot was just entered,
+      // coarsest first so they can cascade through several levels
+      for (int level = num_levels - 1; level > 0; --level)
+      {
+        if ((m_now & ((std::uint64_t{1} << (slot_bits * level)) - 1)) == 0)
+        {
+          cascade(m_slots[level][slot_index(m_now, level)]);
+        }
+      }
+
+      auto& slot = m_slots[0][slot_index(m_now, 0)];
+      while (slot.next != &slot)
+      {
+        auto& t = *slot.next;
+        unlink(t);
+        --m_size;
+        on_expire(t);
+      }
+    }
+  }
+
+  std::uint64_t now() const noexcept { return m_now; }
+
+  //! Number of armed timers
+  size_t size() const noexcept { return m_size; }
+
+private:
+  static int slot_index(std::uint64_t tick, int level) noexcept
+  {
+    return static_cast<int>((tick >> (slot_bits * level)) & (num_slots - 1));
+  }
+
+  void link(wheel_timer& t) noexcept
+  {
+    // the highest bit in which deadline and now differ picks the level
+    auto const diff = t.deadline ^ m_now;
+    int level = 0;
+    while (level + 1 < num_levels && (diff >> (slot_bits * (level + 1))) != 0)
+    {
+      ++level;
+    }
+
+    auto& slot = m_slots[level][slot_index(t.deadline, level)];
+    t.prev = slot.prev;
+    t.next = &slot;
+    slot.prev->next = &t;
+    slot.prev = &t;
+  }
+
+  static void unlink(wheel_timer& t) noexcept
+  {
+    t.prev->next = t.next;
+    t.next->prev = t.prev;
+    t.prev = t.next = nullptr;
+  }
+
+  void cascade(wheel_timer& slot) noexcept
+  {
+    while (slot.next != &slot)
+    {
+      auto& t = *slot.next;
+      unlink(t);
+      link(t);
+    }
+  }
+
+  wheel_timer m_slots[num_levels][num_slots];
+  std::uint64_t m_now;
+  size_t m_size{0};
+};
+
+} // namespace aura
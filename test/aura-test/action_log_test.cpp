@@ -0,0 +1,277 @@
+#include "test.h"
+#include "test_games.h"
+#include <aura-core/session_digest.h>
+#include <aura-server/action_log.h>
+#include <fstream>
+#include <iterator>
+
+namespace aura
+{
+
+namespace {
+
+struct logged_game
+{
+  local_rules_engine engine{ruleset{}, 5};
+  std::vector<player_action> actions;
+};
+
+//! Plays a game, logging it the way session_manager does: a snapshot at
+//! version 0, then every accepted action
+logged_game play_logged(action_log& log, int session_id, int num_actions)
+{
+  logged_game g;
+  log.snapshot(session_id, 0, g.engine.snapshot());
+  test::bot b{5};
+  g.actions = test::play(g.engine, b, num_actions);
+  action_log::ticket last{};
+  for (size_t i = 0; i < g.actions.size(); ++i)
+  {
+    last = log.append(session_id, static_cast<int>(i + 1), g.actions[i]);
+  }
+  AURA_CHECK(!log.wait_durable(last));
+  return g;
+}
+
+//! Replays a recovered session onto its snapshot
+local_rules_engine replay(recovered_session const& s)
+{
+  auto [e, engine] = local_rules_engine::restore(s.snapshot);
+  AURA_CHECK(!e);
+  for (auto const& action : s.actions)
+  {
+    AURA_CHECK(!engine.commit_action(action));
+  }
+  return std::move(engine);
+}
+
+std::string read_bytes(std::filesystem::path const& p)
+{
+  std::ifstream in{p, std::ios::binary};
+  return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+void write_bytes(std::filesystem::path const& p, std::string const& data)
+{
+  std::ofstream out{p, std::ios::binary | std::ios::trunc};
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+} // namespace {}
+
+AURA_TEST(action_log_replays_to_the_same_session)
+{
+  test::scratch_directory dir{"replay"};
+  logged_game g;
+  {
+    action_log log{{dir.path(), 1000}};
+    g = play_logged(log, 1, 150);
+  }
+  AURA_REQUIRE(g.actions.size() > 20);
+
+  action_log log{{dir.path(), 1000}};
+  auto const sessions = log.recover();
+  AURA_REQUIRE(sessions.size() == 1);
+  AURA_CHECK(sessions[0].session_id == 1);
+  AURA_CHECK(sessions[0].version == 0);
+  AURA_CHECK(sessions[0].actions.size() == g.actions.size());
+
+  auto const replayed = replay(sessions[0]);
+  AURA_CHECK(hash_session(replayed.get_session_info()) == hash_session(g.engine.get_session_info()));
+  AURA_CHECK(replayed.snapshot() == g.engine.snapshot());
+}
+
+AURA_TEST(action_log_snapshot_supersedes_earlier_records)
+{
+  test::scratch_directory dir{"supersede"};
+  logged_game g;
+  {
+    action_log log{{dir.path(), 1000}};
+    g = play_logged(log, 2, 60);
+    auto const version = static_cast<int>(g.actions.size());
+    log.snapshot(2, version, g.engine.snapshot());
+
+    test::bot b{9};
+    auto const more = test::play(g.engine, b, 10);
+    action_log::ticket last{};
+    for (size_t i = 0; i < more.size(); ++i)
+    {
+      last = log.append(2, version + static_cast<int>(i + 1), more[i]);
+    }
+    AURA_CHECK(!log.wait_durable(last));
+    g.actions = more;
+  }
+
+  auto const sessions = action_log{{dir.path(), 1000}}.recover();
+  AURA_REQUIRE(sessions.size() == 1);
+  AURA_CHECK(sessions[0].actions.size() == g.actions.size());
+  AURA_CHECK(replay(sessions[0]).snapshot() == g.engine.snapshot());
+}
+
+AURA_TEST(action_log_drops_torn_tail)
+{
+  test::scratch_directory dir{"torn"};
+  logged_game g;
+  {
+    action_log log{{dir.path(), 1000}};
+    g = play_logged(log, 3, 80);
+  }
+  AURA_REQUIRE(g.actions.size() > 2);
+
+  // a crash in the middle of writing the last record
+  auto const log_file = dir.path() / "1.seg";
+  auto data = read_bytes(log_file);
+  data.resize(data.size() - 2);
+  write_bytes(log_file, data);
+
+  auto const sessions = action_log{{dir.path(), 1000}}.recover();
+  AURA_REQUIRE(sessions.size() == 1);
+  AURA_REQUIRE(sessions[0].actions.size() == g.actions.size() - 1);
+  for (size_t i = 0; i < sessions[0].actions.size(); ++i)
+  {
+    AURA_CHECK(sessions[0].actions[i].type == g.actions[i].type);
+    AURA_CHECK(sessions[0].actions[i].target1 == g.actions[i].target1);
+    AURA_CHECK(sessions[0].actions[i].target2 == g.actions[i].target2);
+  }
+  // what is left replays cleanly
+  replay(sessions[0]);
+}
+
+AURA_TEST(action_log_stops_at_corrupt_record)
+{
+  test::scratch_directory dir{"corrupt"};
+  logged_game g;
+  {
+    action_log log{{dir.path(), 1000}};
+    g = play_logged(log, 4, 80);
+  }
+  AURA_REQUIRE(g.actions.size() > 10);
+
+  // flip a bit a few records from the end of the segment; replay keeps the
+  // records before the damaged one and nothing after it
+  auto const log_file = dir.path() / "1.seg";
+  auto data = read_bytes(log_file);
+  data[data.size() - 40] ^= 0x10;
+  write_bytes(log_file, data);
+
+  auto const sessions = action_log{{dir.path(), 1000}}.recover();
+  AURA_REQUIRE(sessions.size() == 1);
+  AURA_CHECK(sessions[0].actions.size() < g.actions.size());
+  AURA_CHECK(sessions[0].actions.size() > 0);
+  replay(sessions[0]);
+}
+
+AURA_TEST(action_log_recovers_snapshot_from_segment)
+{
+  test::scratch_directory dir{"segment-snap"};
+  logged_game g;
+  {
+    action_log log{{dir.path(), 1000}};
+    g = play_logged(log, 9, 20);
+  }
+
+  // a snapshot file isn't synced until its segment is full, so a crash can
+  // leave it damaged; the segment still has the snapshot
+  auto const snap_file = dir.path() / "9.snap";
+  auto data = read_bytes(snap_file);
+  data[data.size() / 2] ^= 0x01;
+  write_bytes(snap_file, data);
+
+  auto const sessions = action_log{{dir.path(), 1000}}.recover();
+  AURA_REQUIRE(sessions.size() == 1);
+  AURA_CHECK(replay(sessions[0]).snapshot() == g.engine.snapshot());
+}
+
+AURA_TEST(action_log_skips_corrupt_snapshot)
+{
+  test::scratch_directory dir{"corrupt-snap"};
+  {
+    // every batch fills a segment, so once a snapshot file is synced the
+    // segment holding the snapshot is deleted and the file is all there is
+    action_log log{{dir.path(), 1000, 1}};
+    local_rules_engine engine{ruleset{}, 5};
+    AURA_CHECK(!log.wait_durable(log.snapshot(5, 0, engine.snapshot())));
+    AURA_CHECK(!log.wait_durable(log.snapshot(6, 0, engine.snapshot())));
+  }
+
+  auto const snap_file = dir.path() / "5.snap";
+  auto data = read_bytes(snap_file);
+  data[data.size() / 2] ^= 0x01;
+  write_bytes(snap_file, data);
+
+  auto const sessions = action_log{{dir.path(), 1000}}.recover();
+  AURA_REQUIRE(sessions.size() == 1);
+  AURA_CHECK(sessions[0].session_id == 6);
+}
+
+AURA_TEST(action_log_remove_deletes_session)
+{
+  test::scratch_directory dir{"remove"};
+  {
+    action_log log{{dir.path(), 1000}};
+    play_logged(log, 7, 20);
+    AURA_CHECK(!log.wait_durable(log.remove(7)));
+  }
+  action_log log{{dir.path(), 1000}};
+  AURA_CHECK(log.recover().empty());
+}
+
+AURA_TEST(action_log_shares_one_segment)
+{
+  test::scratch_directory dir{"shared"};
+  action_log log{{dir.path(), 1000}};
+  action_log::ticket last{};
+  for (int session_id = 1; session_id <= 20; ++session_id)
+  {
+    local_rules_engine engine{ruleset{}, 5};
+    log.snapshot(session_id, 0, engine.snapshot());
+    last = log.append(session_id, 1, {action_type::end_turn, 0, 0});
+  }
+  AURA_CHECK(!log.wait_durable(last));
+
+  // one file and one sync per batch, however many sessions it holds
+  AURA_CHECK(log.stats().num_segments == 1);
+  AURA_CHECK(std::filesystem::exists(dir.path() / "1.seg"));
+  AURA_CHECK(!std::filesystem::exists(dir.path() / "2.seg"));
+  AURA_CHECK(log.recover().size() == 20);
+}
+
+AURA_TEST(action_log_deletes_segments_no_session_needs)
+{
+  test::scratch_directory dir{"retire"};
+  local_rules_engine engine{ruleset{}, 5};
+  {
+    action_log log{{dir.path(), 10, 1}};
+    AURA_CHECK(!log.wait_durable(log.snapshot(8, 0, engine.snapshot())));
+    test::bot b{5};
+    auto const actions = test::play(engine, b, 80);
+    AURA_REQUIRE(actions.size() > 20);
+
+    // each action goes out in its own batch and fills its own segment
+    local_rules_engine replayed{ruleset{}, 5};
+    for (size_t i = 0; i < actions.size(); ++i)
+    {
+      AURA_REQUIRE(!replayed.commit_action(actions[i]));
+      auto const version = static_cast<int>(i + 1);
+      auto const t = version % log.snapshot_interval() == 0 ? log.snapshot(8, version, replayed.snapshot())
+        : log.append(8, version, actions[i]);
+      AURA_CHECK(!log.wait_durable(t));
+    }
+    AURA_CHECK(log.stats().num_segments == actions.size() + 1);
+  }
+
+  // only the segments behind the last durable snapshot file are left
+  size_t num_segments = 0;
+  for (auto const& entry : std::filesystem::directory_iterator{dir.path()})
+  {
+    num_segments += entry.path().extension() == ".seg" ? 1 : 0;
+  }
+  AURA_CHECK(num_segments <= 10);
+
+  auto const sessions = action_log{{dir.path(), 10}}.recover();
+  AURA_REQUIRE(sessions.size() == 1);
+  AURA_CHECK(sessions[0].actions.size() < 10);
+  AURA_CHECK(hash_session(replay(sessions[0]).get_session_info()) == hash_session(engine.get_session_info()));
+}
+
+} // namespace aura
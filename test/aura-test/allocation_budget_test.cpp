@@ -0,0 +1,87 @@
+#include "test.h"
+#include <aura-core/allocation_counter.h>
+#include <aura-core/local_rules_engine.h>
+#include <aura-core/player_action.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace aura
+{
+
+namespace {
+
+//! A mix of legal and illegal choices, like a careless bot
+player_action careless_action(session_info const& info, std::mt19937& rng)
+{
+  auto const& player = info.players[info.current_player];
+  auto const& other = info.players[1 - info.current_player];
+  if (!info.picks.empty() && player.picks_available && rng() % 4)
+  {
+    return {action_type::pick, info.picks[rng() % info.picks.size()].uid, 0};
+  }
+  if (rng() % 8 == 0)
+  {
+    // out of turn or a card that was never offered
+    return {action_type::pick, -1, 0};
+  }
+  if (!player.hand.empty() && rng() % 3)
+  {
+    return {action_type::deploy, player.hand[rng() % player.hand.size()].uid, static_cast<int>(rng() % 5)};
+  }
+  if (rng() % 2)
+  {
+    auto const& lane = player.lanes[rng() % player.lanes.size()];
+    auto const& target_lane = other.lanes[rng() % other.lanes.size()];
+    return {action_type::primary_action, lane.empty() ? 0 : lane.back().uid,
+      target_lane.empty() ? other.uid : target_lane.back().uid};
+  }
+  return {action_type::end_turn, 0, 0};
+}
+
+} // namespace {}
+
+//! Turning an action down is held to no allocations at all; legal actions
+//! still copy the cards they create. Only checked in builds configured
+//! with AURA_COUNT_ALLOCATIONS=ON.
+AURA_TEST(rejected_actions_do_not_allocate)
+{
+  if constexpr (!counting_allocations)
+  {
+    std::printf("  allocations aren't counted in this build, skipped\n");
+    return;
+  }
+
+  constexpr int num_games = 20;
+  std::uint64_t rejected[static_cast<int>(action_type::no_action) + 1]{};
+  std::uint64_t worst[static_cast<int>(action_type::no_action) + 1]{};
+  // the first game warms up the thread's logger and metrics, whose
+  // one-time allocations would otherwise count
+  for (int game = 0; game <= num_games; ++game)
+  {
+    local_rules_engine engine{ruleset{}, static_cast<std::uint64_t>(game)};
+    std::mt19937 rng{static_cast<unsigned>(game)};
+    for (int i = 0; i < 5000 && !engine.is_game_over(); ++i)
+    {
+      auto const action = careless_action(engine.get_session_info(), rng);
+      allocation_scope const scope;
+      auto const legal = !engine.commit_action(action);
+      auto const counts = scope.counts();
+      if (game == 0 || legal)
+      {
+        continue;
+      }
+      auto const type = static_cast<int>(action.type);
+      rejected[type]++;
+      worst[type] = std::max(worst[type], counts.allocations);
+    }
+  }
+
+  for (auto const type : {action_type::pick, action_type::deploy, action_type::primary_action})
+  {
+    AURA_CHECK(rejected[static_cast<int>(type)] > 0);
+    AURA_CHECK(worst[static_cast<int>(type)] == 0);
+  }
+}
+
+} // namespace aura
@@ -0,0 +1,107 @@
+#include "test.h"
+#include <aura-core/spsc_queue.h>
+#include <aura-core/triple_buffer.h>
+#include <thread>
+
+namespace aura
+{
+
+AURA_TEST(spsc_queue_refuses_when_full)
+{
+  spsc_queue<int, 4> q;
+  AURA_CHECK(!q.try_pop());
+  for (int i = 0; i < 4; ++i)
+  {
+    AURA_CHECK(q.try_push(i));
+  }
+  AURA_CHECK(!q.try_push(4));
+  AURA_CHECK(q.try_pop() == 0);
+  AURA_CHECK(q.try_push(4));
+  for (int i = 1; i <= 4; ++i)
+  {
+    AURA_CHECK(q.try_pop() == i);
+  }
+  AURA_CHECK(!q.try_pop());
+}
+
+AURA_TEST(spsc_queue_hands_over_in_order)
+{
+  constexpr int count = 200'000;
+  spsc_queue<int, 64> q;
+  std::thread producer{[&]
+  {
+    for (int i = 1; i <= count; ++i)
+    {
+      while (!q.try_push(i))
+      {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  // pop() sleeps whenever the producer falls behind
+  int expected = 1;
+  for (int i = 0; i < count; ++i)
+  {
+    if (q.pop() != expected++)
+    {
+      AURA_CHECK(!"out of order");
+      break;
+    }
+  }
+  producer.join();
+  AURA_CHECK(expected == count + 1);
+}
+
+AURA_TEST(triple_buffer_takes_latest)
+{
+  triple_buffer<int> b;
+  AURA_CHECK(!b.update());
+  b.publish(1);
+  b.publish(2);
+  AURA_CHECK(b.update());
+  AURA_CHECK(b.latest() == 2);
+  AURA_CHECK(!b.update());
+  AURA_CHECK(b.latest() == 2);
+  b.publish(3);
+  AURA_CHECK(b.update());
+  AURA_CHECK(b.latest() == 3);
+}
+
+AURA_TEST(triple_buffer_across_threads)
+{
+  constexpr int count = 200'000;
+  struct value
+  {
+    int n{0};
+    int check{0};  //!< torn if it doesn't match 'n'
+  };
+
+  triple_buffer<value> b;
+  std::thread producer{[&]
+  {
+    for (int i = 1; i <= count; ++i)
+    {
+      b.publish({i, -i});
+    }
+  }};
+
+  // the consumer only ever moves forward, sees whole values, and ends on
+  // the last one published
+  int last = 0;
+  bool ok = true;
+  while (last != count)
+  {
+    if (b.update())
+    {
+      auto const v = b.latest();
+      ok = ok && v.n > last && v.check == -v.n;
+      last = v.n;
+    }
+  }
+  producer.join();
+  AURA_CHECK(ok);
+  AURA_CHECK(!b.update());
+}
+
+} // namespace aura
@@ -0,0 +1,55 @@
+#include "test.h"
+#include "test_games.h"
+#include <aura-core/session_digest.h>
+
+namespace aura
+{
+
+AURA_TEST(engine_restores_to_the_same_game)
+{
+  for (std::uint64_t seed = 1; seed <= 8; ++seed)
+  {
+    local_rules_engine engine{ruleset{}, seed};
+    test::bot b{seed};
+    test::play(engine, b, 40 + 20 * static_cast<int>(seed));
+
+    auto const snap = engine.snapshot();
+    auto [e, restored] = local_rules_engine::restore(snap);
+    AURA_REQUIRE(!e);
+    AURA_CHECK(restored.snapshot() == snap);
+    AURA_CHECK(hash_session(restored.get_session_info()) == hash_session(engine.get_session_info()));
+
+    // the RNG and uid counters came along: both play on identically,
+    // including the cards and picks drawn from here on
+    test::bot b1{seed + 100};
+    test::bot b2{seed + 100};
+    for (int i = 0; i < 200 && !engine.is_game_over(); ++i)
+    {
+      auto const action = b1.next(engine.get_session_info());
+      AURA_REQUIRE(b2.next(restored.get_session_info()).type == action.type);
+      AURA_CHECK(engine.commit_action(action) == restored.commit_action(action));
+      AURA_REQUIRE(hash_session(restored.get_session_info()) == hash_session(engine.get_session_info()));
+    }
+    AURA_CHECK(restored.is_game_over() == engine.is_game_over());
+    AURA_CHECK(restored.snapshot() == engine.snapshot());
+  }
+}
+
+AURA_TEST(engine_rejects_damaged_snapshot)
+{
+  local_rules_engine engine{ruleset{}, 11};
+  test::bot b{11};
+  test::play(engine, b, 50);
+  auto const snap = engine.snapshot();
+
+  AURA_CHECK(local_rules_engine::restore({}).first);
+  AURA_CHECK(local_rules_engine::restore(std::string_view{snap}.substr(0, snap.size() / 2)).first);
+  AURA_CHECK(local_rules_engine::restore(std::string_view{snap}.substr(0, snap.size() - 1)).first);
+
+  // a snapshot from a format this build doesn't know
+  auto other_format = snap;
+  other_format[0] = 0x7e;
+  AURA_CHECK(local_rules_engine::restore(other_format).first);
+}
+
+} // namespace aura
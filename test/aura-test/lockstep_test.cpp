@@ -0,0 +1,152 @@
+#include "test.h"
+#include "test_games.h"
+#include <aura-core/lockstep_rules_engine.h>
+#include <aura-core/relay_link.h>
+#include <aura-core/session_digest.h>
+#include <aura-core/shm_transport.h>
+#include <aura-server/requests.h>
+#include <aura-server/session_manager.h>
+#include <aura-server/shm_server.h>
+#include <chrono>
+
+namespace aura
+{
+
+namespace {
+
+//! Lets 'b' play both ends until the game ends or they fall out of step;
+//! returns the number of actions accepted
+int play_both(lockstep_rules_engine& first, lockstep_rules_engine& second, test::bot& b, int num_actions)
+{
+  int accepted = 0;
+  for (int i = 0; i < num_actions && !first.is_game_over() && !first.is_desynced() && !second.is_desynced(); ++i)
+  {
+    auto& end = first.get_session_info().current_player == first.seat() ? first : second;
+    if (!end.commit_action(b.next(end.get_session_info())))
+    {
+      ++accepted;
+    }
+  }
+  // the other end takes in the last action
+  second.get_session_info();
+  return accepted;
+}
+
+} // namespace {}
+
+AURA_TEST(incremental_digest_matches_a_fresh_one)
+{
+  local_rules_engine engine{ruleset{}, 3};
+  test::bot b{3};
+  incremental_digest running;
+  auto last = running.update(engine.get_session_info());
+  int changes = 0;
+  for (int i = 0; i < 400 && !engine.is_game_over(); ++i)
+  {
+    if (engine.commit_action(b.next(engine.get_session_info())))
+    {
+      continue;
+    }
+    auto const digest = running.update(engine.get_session_info());
+    AURA_REQUIRE(digest == incremental_digest{}.update(engine.get_session_info()));
+    changes += digest != last ? 1 : 0;
+    last = digest;
+  }
+  AURA_CHECK(changes > 0);
+}
+
+AURA_TEST(lockstep_self_play_stays_in_step)
+{
+  lockstep_pipe pipe;
+  lockstep_rules_engine first{ruleset{}, 17, 0, pipe.end(0)};
+  lockstep_rules_engine second{ruleset{}, 17, 1, pipe.end(1)};
+  test::bot b{17};
+  auto const accepted = play_both(first, second, b, 20000);
+
+  AURA_CHECK(first.is_game_over() && second.is_game_over());
+  AURA_CHECK(!first.is_desynced() && !second.is_desynced());
+  AURA_CHECK(hash_session(first.get_session_info()) == hash_session(second.get_session_info()));
+
+  // the actions and a digest per turn, never the session
+  auto const bytes = first.bytes_sent() + second.bytes_sent();
+  AURA_REQUIRE(accepted > 0);
+  AURA_CHECK(bytes < static_cast<size_t>(accepted) * 8);
+}
+
+AURA_TEST(lockstep_reports_a_desync)
+{
+  lockstep_pipe pipe;
+  lockstep_rules_engine first{ruleset{}, 4, 0, pipe.end(0)};
+  lockstep_rules_engine second{ruleset{}, 4, 1, pipe.end(1)};
+  test::bot b{4};
+  play_both(first, second, b, 60);
+  AURA_REQUIRE(!first.is_desynced() && !second.is_desynced());
+
+  // a change the peer never hears of
+  first.trigger_pick_action(1);
+  play_both(first, second, b, 200);
+
+  AURA_CHECK(first.is_desynced() && second.is_desynced());
+  AURA_CHECK(!first.desync_report().empty() || !second.desync_report().empty());
+  AURA_CHECK(first.commit_action({action_type::end_turn, 0, 0}));
+
+  // different seeds part ways before the first action
+  lockstep_pipe other;
+  lockstep_rules_engine a{ruleset{}, 1, 0, other.end(0)};
+  lockstep_rules_engine c{ruleset{}, 2, 1, other.end(1)};
+  a.get_session_info();
+  c.get_session_info();
+  AURA_CHECK(a.is_desynced() && c.is_desynced());
+}
+
+AURA_TEST(lockstep_game_relayed_by_the_server)
+{
+  auto const name = "/aura-test-relay-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+  session_manager sessions{ruleset{}, 1};
+  shm_server shm{{name, 1}};
+  shm.add_route(rest::relay_lockstep::path, [&](std::string const& body)
+  {
+    return rest::handle_request(rest::relay_lockstep{}, sessions, body);
+  });
+  AURA_REQUIRE(!shm.start());
+  auto [transport_error, transport] = make_shm_transport(name);
+  AURA_REQUIRE(!transport_error);
+
+  // only lockstep sessions relay
+  auto const pvp = sessions.create_session(game_mode::PvP);
+  relay_link refused{*transport, pvp, 0, sessions.seat_token(pvp, 0)};
+  AURA_CHECK(refused.connect().first);
+
+  ruleset rs;
+  rs.mode = game_mode::lockstep;
+  auto const id = sessions.create_session(rs.mode);
+  relay_link first_link{*transport, id, 0, sessions.seat_token(id, 0), std::chrono::milliseconds{0}};
+  relay_link second_link{*transport, id, 1, sessions.seat_token(id, 1), std::chrono::milliseconds{0}};
+  auto const [first_error, first_seed] = first_link.connect();
+  auto const [second_error, second_seed] = second_link.connect();
+  AURA_REQUIRE(!first_error && !second_error);
+  AURA_REQUIRE(first_seed == second_seed);
+
+  // a seat can't speak for the other one
+  relay_link impostor{*transport, id, 1, sessions.seat_token(id, 0)};
+  AURA_CHECK(impostor.connect().first);
+
+  lockstep_rules_engine first{rs, first_seed, 0, first_link};
+  lockstep_rules_engine second{rs, second_seed, 1, second_link};
+  test::bot b{9};
+  play_both(first, second, b, 20000);
+  AURA_CHECK(first.is_game_over() && second.is_game_over());
+  AURA_CHECK(!first.is_desynced() && !second.is_desynced());
+  AURA_CHECK(hash_session(first.get_session_info()) == hash_session(second.get_session_info()));
+
+  // the server passed the messages on without playing them, and drops
+  // them once the seats say they took them
+  AURA_CHECK(!first_link.connect().first && !second_link.connect().first);
+  sessions.with_session(id, [&](hosted_session& s)
+  {
+    AURA_CHECK(s.version == 0);
+    AURA_CHECK(s.relay[0].stream.empty() && s.relay[1].stream.empty());
+  });
+}
+
+} // namespace aura
@@ -0,0 +1,50 @@
+#include "test.h"
+#include <cstring>
+
+namespace aura::test
+{
+
+namespace {
+
+int g_failures = 0;
+
+} // namespace {}
+
+std::vector<test_case>& registry()
+{
+  static std::vector<test_case> cases;
+  return cases;
+}
+
+void fail(char const* file, int line, char const* expr)
+{
+  ++g_failures;
+  std::fprintf(stderr, "  %s:%d: check failed: %s\n", file, line, expr);
+}
+
+} // namespace aura::test
+
+//! aura_test [filter]: runs every test case whose name contains 'filter'
+int main(int argc, char** argv)
+{
+  using namespace aura::test;
+
+  auto const filter = argc > 1 ? argv[1] : "";
+  int num_run = 0;
+  int num_failed = 0;
+  for (auto const& t : registry())
+  {
+    if (!std::strstr(t.name, filter))
+    {
+      continue;
+    }
+    auto const before = g_failures;
+    t.fn();
+    ++num_run;
+    auto const ok = g_failures == before;
+    num_failed += ok ? 0 : 1;
+    std::printf("[%s] %s\n", ok ? " ok " : "FAIL", t.name);
+  }
+  std::printf("%d of %d test cases passed\n", num_run - num_failed, num_run);
+  return num_failed ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+#include "test.h"
+#include "test_games.h"
+#include <aura-core/remote_rules_engine.h>
+#include <aura-core/session_digest.h>
+#include <aura-core/shm_transport.h>
+#include <aura-server/requests.h>
+#include <aura-server/session_manager.h>
+#include <aura-server/shm_server.h>
+#include <chrono>
+#include <thread>
+
+namespace aura
+{
+
+namespace {
+
+//! A server for the rest:: requests on its same-host transport, the way
+//! aura_server serves them next to http
+struct local_server
+{
+  local_server()
+    : name{"/aura-test-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())}
+    , sessions{ruleset{}, 1}
+    , shm{{name, 2}}
+  {
+    shm.add_route(rest::get_session_info::path, [this](std::string const& body)
+    {
+      return rest::handle_request(rest::get_session_info{}, sessions, body);
+    });
+    shm.add_route(rest::commit_action::path, [this](std::string const& body)
+    {
+      return rest::handle_request(rest::commit_action{}, sessions, body);
+    });
+  }
+
+  std::string const name;
+  session_manager sessions;
+  shm_server shm;
+};
+
+//! Plays one action of 'b' on the server's side of a session, as the
+//! opponent would
+void play_on_server(session_manager& sessions, int session_id, test::bot& b)
+{
+  sessions.with_session(session_id, [&](hosted_session& s)
+  {
+    for (int i = 0; i < 20; ++i)
+    {
+      auto const action = b.next(s.engine->get_session_info());
+      if (!s.engine->commit_action(action))
+      {
+        sessions.record_action(s, action);
+        return;
+      }
+    }
+  });
+}
+
+std::uint64_t server_digest(session_manager& sessions, int session_id)
+{
+  std::uint64_t digest{};
+  sessions.with_session(session_id, [&](hosted_session& s)
+  {
+    digest = hash_session(s.engine->get_session_info());
+  });
+  return digest;
+}
+
+} // namespace {}
+
+AURA_TEST(remote_engine_predicts_and_confirms)
+{
+  local_server server;
+  AURA_REQUIRE(!server.shm.start());
+  auto& sessions = server.sessions;
+
+  auto [transport_error, transport] = make_shm_transport(server.name);
+  AURA_REQUIRE(!transport_error);
+
+  // in PvC the client plays both seats
+  auto const id = sessions.create_session(game_mode::PvC);
+  remote_rules_engine remote{*transport, id, sessions.seat_token(id, 0)};
+
+  // a local engine from the same snapshot plays along as the reference
+  std::string snapshot;
+  sessions.with_session(id, [&](hosted_session& s) { snapshot = s.engine->snapshot(); });
+  auto [restore_error, reference] = local_rules_engine::restore(snapshot);
+  AURA_REQUIRE(!restore_error);
+
+  test::bot b{21};
+  int accepted = 0;
+  for (int i = 0; i < 300 && !remote.is_game_over(); ++i)
+  {
+    auto const action = b.next(remote.get_session_info());
+    auto const e = remote.commit_action(action);
+    AURA_REQUIRE(e == reference.commit_action(action));
+    accepted += e ? 0 : 1;
+
+    // the action shows up at once, without waiting for the server, unless it
+    // drew cards the client can't know
+    if (action.type == action_type::end_turn)
+    {
+      remote.sync();
+    }
+    AURA_REQUIRE(hash_session(remote.get_session_info()) == hash_session(reference.get_session_info()));
+  }
+  AURA_CHECK(accepted > 0);
+
+  remote.sync();
+  AURA_CHECK(remote.version() == accepted);
+  AURA_CHECK(remote.num_resyncs() == 0);
+  AURA_CHECK(server_digest(sessions, id) == hash_session(reference.get_session_info()));
+}
+
+AURA_TEST(remote_engine_follows_changes_made_by_others)
+{
+  local_server server;
+  AURA_REQUIRE(!server.shm.start());
+  auto& sessions = server.sessions;
+
+  auto [transport_error, transport] = make_shm_transport(server.name);
+  AURA_REQUIRE(!transport_error);
+
+  // in PvC the client plays both seats
+  auto const id = sessions.create_session(game_mode::PvC);
+  remote_rules_engine remote{*transport, id, sessions.seat_token(id, 0)};
+
+  // the other player moves on the server directly
+  test::bot other{5};
+  for (int i = 0; i < 10; ++i)
+  {
+    play_on_server(sessions, id, other);
+  }
+  auto const expected = server_digest(sessions, id);
+  AURA_REQUIRE(expected != hash_session(remote.get_session_info()));
+
+  // the idle engine picks the change up in the background
+  auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+  while (hash_session(remote.get_session_info()) != expected && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+  AURA_CHECK(hash_session(remote.get_session_info()) == expected);
+  AURA_CHECK(remote.num_resyncs() == 1);
+
+  // an action committed against a state the server has left is reported,
+  // and the prediction goes back to what the server holds. end_turn is
+  // always accepted here, and only the server's version shows it was late.
+  play_on_server(sessions, id, other);
+  AURA_CHECK(!remote.commit_action({action_type::end_turn, 0, 0}));
+  remote.sync();
+
+  auto const deadline2 = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+  while (hash_session(remote.get_session_info()) != server_digest(sessions, id)
+    && std::chrono::steady_clock::now() < deadline2)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+  AURA_CHECK(hash_session(remote.get_session_info()) == server_digest(sessions, id));
+  AURA_CHECK(remote.commit_action({action_type::no_action, 0, 0}));
+}
+
+AURA_TEST(session_info_is_only_shown_to_its_seats)
+{
+  session_manager sessions{ruleset{}, 1};
+  auto const id = sessions.create_session(game_mode::PvP);
+  auto const request = [&](std::uint64_t token)
+  {
+    auto const body = rest::handle_request(rest::get_session_info{}, sessions,
+      rest::get_session_info::to_string({id, token, true}));
+    return rest::get_session_info::to_out(body).second;
+  };
+
+  AURA_CHECK(request(0).error == std::errc::permission_denied);
+
+  auto const out = request(sessions.seat_token(id, 1));
+  AURA_REQUIRE(!out.error);
+  AURA_CHECK(out.seats == 2u);
+  AURA_REQUIRE(out.session.players.size() == 2);
+  for (auto const& card : out.session.players[0].hand)
+  {
+    AURA_CHECK(card.uid == 0 && !card.is_visible);
+  }
+  sessions.with_session(id, [&](hosted_session& s)
+  {
+    AURA_CHECK(out.session.players[1].hand.size() == s.engine->get_session_info().players[1].hand.size());
+  });
+
+  // the snapshot can't tell what will be drawn
+  auto const [restore_error, engine] = local_rules_engine::restore(out.snapshot);
+  AURA_REQUIRE(!restore_error);
+  AURA_CHECK(engine.get_ruleset().challenger_deck.all_cards.empty());
+  AURA_CHECK(engine.get_ruleset().defender_deck.all_cards.empty());
+  AURA_CHECK(hash_session(engine.get_session_info()) == hash_session(out.session));
+}
+
+AURA_TEST(remote_engines_play_pvp_from_their_own_seats)
+{
+  local_server server;
+  AURA_REQUIRE(!server.shm.start());
+  auto& sessions = server.sessions;
+
+  // a transport serves one engine at a time
+  auto [first_error, first_transport] = make_shm_transport(server.name);
+  auto [second_error, second_transport] = make_shm_transport(server.name);
+  AURA_REQUIRE(!first_error && !second_error);
+
+  auto const id = sessions.create_session(game_mode::PvP);
+  remote_rules_engine first{*first_transport, id, sessions.seat_token(id, 0)};
+  remote_rules_engine second{*second_transport, id, sessions.seat_token(id, 1)};
+
+  // waits for an engine to poll the server, which it does every 200ms
+  auto const wait_until = [](auto const& done)
+  {
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (!done() && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    }
+    return done();
+  };
+
+  test::bot b{13};
+  int num_turns = 0;
+  for (int i = 0; i < 500 && num_turns < 4; ++i)
+  {
+    int seat = 0;
+    bool game_over = false;
+    sessions.with_session(id, [&](hosted_session& s)
+    {
+      seat = s.engine->get_session_info().current_player;
+      game_over = s.engine->is_game_over();
+    });
+    if (game_over)
+    {
+      break;
+    }
+    auto& mover = seat == 0 ? first : second;
+    AURA_REQUIRE(wait_until([&] { return mover.get_session_info().current_player == seat; }));
+
+    auto const action = b.next(mover.get_session_info());
+    if (!mover.commit_action(action) && action.type == action_type::end_turn)
+    {
+      ++num_turns;
+    }
+    mover.sync();
+
+    // neither end sees the other's hand
+    for (auto const& card : mover.get_session_info().players[1 - seat].hand)
+    {
+      AURA_REQUIRE(card.uid == 0 && !card.is_visible);
+    }
+  }
+  AURA_CHECK(num_turns > 0);
+
+  // both ends agree with the server once they catch up
+  auto const caught_up = [&]
+  {
+    std::uint64_t expected[2]{};
+    sessions.with_session(id, [&](hosted_session& s)
+    {
+      expected[0] = hash_session(redact_for_seats(s.engine->get_session_info(), 1u));
+      expected[1] = hash_session(redact_for_seats(s.engine->get_session_info(), 2u));
+    });
+    return hash_session(first.get_session_info()) == expected[0]
+      && hash_session(second.get_session_info()) == expected[1];
+  };
+  AURA_CHECK(wait_until(caught_up));
+}
+
+} // namespace aura
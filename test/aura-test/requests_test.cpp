@@ -0,0 +1,129 @@
+#include "test.h"
+#include "test_games.h"
+#include <aura-server/matchmaker.h>
+#include <aura-server/requests.h>
+#include <aura-server/session_manager.h>
+
+namespace aura
+{
+
+namespace {
+
+rest::commit_action::out commit(session_manager& sessions, int session_id, std::uint64_t token,
+  std::vector<player_action> actions)
+{
+  auto const body = rest::handle_request(rest::commit_action{}, sessions,
+    rest::commit_action::to_string({session_id, token, std::move(actions)}));
+  return rest::commit_action::to_out(body).second;
+}
+
+} // namespace {}
+
+AURA_TEST(commit_action_needs_the_seat_to_move)
+{
+  session_manager sessions{ruleset{}, 1};
+  auto const id = sessions.create_session(game_mode::PvP);
+  auto const tokens = std::array{sessions.seat_token(id, 0), sessions.seat_token(id, 1)};
+  AURA_REQUIRE(tokens[0] && tokens[1] && tokens[0] != tokens[1]);
+
+  int to_move{};
+  sessions.with_session(id, [&](hosted_session& s) { to_move = s.engine->get_session_info().current_player; });
+  auto const waiting = 1 - to_move;
+
+  // neither the other seat nor a made-up token may act
+  for (auto const token : {tokens[waiting], tokens[waiting] ^ 1, std::uint64_t{0}})
+  {
+    auto const out = commit(sessions, id, token, {{action_type::forfeit, 0, 0}});
+    AURA_CHECK(out.error == std::errc::permission_denied);
+    AURA_CHECK(out.num_applied == 0);
+    AURA_CHECK(!out.session.game_over);
+  }
+
+  auto const out = commit(sessions, id, tokens[to_move], {{action_type::forfeit, 0, 0}});
+  AURA_CHECK(!out.error);
+  AURA_CHECK(out.num_applied == 1);
+  AURA_CHECK(out.session.game_over);
+}
+
+AURA_TEST(commit_action_stops_when_the_turn_passes)
+{
+  session_manager sessions{ruleset{}, 1};
+  auto const id = sessions.create_session(game_mode::PvP);
+
+  // the seat to move plays until it has ended its turn; the rest of the
+  // batch belongs to the other seat and is refused
+  int to_move{};
+  int moves_next{};
+  std::vector<player_action> batch;
+  sessions.with_session(id, [&](hosted_session& s)
+  {
+    to_move = s.engine->get_session_info().current_player;
+    auto copy = *s.engine;
+    test::bot b{3};
+    while (!copy.is_game_over() && copy.get_session_info().current_player == to_move && batch.size() < 100)
+    {
+      auto const action = b.next(copy.get_session_info());
+      if (!copy.commit_action(action))
+      {
+        batch.push_back(action);
+      }
+    }
+    moves_next = copy.get_session_info().current_player;
+  });
+  AURA_REQUIRE(moves_next != to_move);
+  auto const num_own = batch.size();
+  batch.push_back({action_type::end_turn, 0, 0});
+
+  auto const out = commit(sessions, id, sessions.seat_token(id, to_move), batch);
+  AURA_CHECK(out.num_applied == static_cast<int>(num_own));
+  AURA_CHECK(out.error == std::errc::permission_denied);
+}
+
+AURA_TEST(seat_tokens_survive_the_action_log)
+{
+  auto const tokens = make_seat_tokens(game_mode::PvP);
+  auto const record = encode_session_record(tokens, "engine snapshot");
+
+  seat_tokens decoded{};
+  std::string snapshot;
+  AURA_REQUIRE(!decode_session_record(record, decoded, snapshot));
+  AURA_CHECK(decoded == tokens);
+  AURA_CHECK(snapshot == "engine snapshot");
+  AURA_CHECK(decode_session_record(std::string_view{record}.substr(0, record.size() - 3), decoded, snapshot));
+
+  auto const pvc = make_seat_tokens(game_mode::PvC);
+  AURA_CHECK(pvc[0] == pvc[1]);
+}
+
+AURA_TEST(matchmaker_drops_players_who_gave_up)
+{
+  session_manager sessions{ruleset{}, 1};
+  matchmaker_config config{};
+  config.match_interval = std::chrono::milliseconds{5};
+  config.join_timeout = std::chrono::milliseconds{50};
+  matchmaker matcher{sessions, config};
+
+  // alone in the queue until the wait times out
+  auto ghost = matcher.join("ghost", game_mode::PvP);
+  auto const timed_out = matcher.wait(ghost);
+  AURA_CHECK(timed_out.error == std::errc::timed_out);
+
+  // the next two players get each other, not the ghost
+  auto a = matcher.join("a", game_mode::PvP);
+  auto b = matcher.join("b", game_mode::PvP);
+  auto const ra = matcher.wait(a);
+  auto const rb = matcher.wait(b);
+  AURA_REQUIRE(!ra.error && !rb.error);
+  AURA_CHECK(ra.opponent_name == "b");
+  AURA_CHECK(rb.opponent_name == "a");
+  AURA_CHECK(ra.session_id == rb.session_id);
+  AURA_CHECK(ra.seat != rb.seat);
+  AURA_CHECK(ra.seat_token == sessions.seat_token(ra.session_id, ra.seat));
+  AURA_CHECK(rb.seat_token == sessions.seat_token(rb.session_id, rb.seat));
+  AURA_CHECK(matcher.stats().num_cancelled == 1);
+
+  // once paired, it is too late to cancel
+  AURA_CHECK(!matcher.cancel(a));
+}
+
+} // namespace aura
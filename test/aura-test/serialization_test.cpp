@@ -0,0 +1,128 @@
+#include "test.h"
+#include "test_games.h"
+#include <aura-core/serialization.h>
+#include <aura-core/session_digest.h>
+#include <aura-core/rest_messages.h>
+#include <climits>
+
+namespace aura
+{
+
+namespace {
+
+local_rules_engine make_played_engine()
+{
+  local_rules_engine engine{ruleset{}, 3};
+  test::bot b{3};
+  test::play(engine, b, 200);
+  return engine;
+}
+
+} // namespace {}
+
+AURA_TEST(varints_round_trip)
+{
+  long long const values[] = {0, 1, -1, 63, -64, 64, -65, 127, 128, 300, -300,
+    INT_MAX, INT_MIN, LLONG_MAX, LLONG_MIN};
+
+  byte_writer w;
+  for (auto const v : values)
+  {
+    w.write_int(v);
+  }
+  // zig-zag keeps small magnitudes of either sign in one byte
+  AURA_CHECK(w.buffer[0] == 0 && w.buffer[1] == 2 && w.buffer[2] == 1);
+
+  byte_reader r{w.buffer};
+  for (auto const v : values)
+  {
+    AURA_CHECK(r.read_int() == v);
+  }
+  AURA_CHECK(r.at_end());
+  AURA_CHECK(!r.error());
+}
+
+AURA_TEST(strings_and_floats_round_trip)
+{
+  byte_writer w;
+  w.write_string("");
+  w.write_string("player one");
+  w.write_wstring(L"Fireball é");
+  w.write_float(-2.5f);
+  w.write_bool(true);
+
+  byte_reader r{w.buffer};
+  AURA_CHECK(r.read_string().empty());
+  AURA_CHECK(r.read_string() == "player one");
+  AURA_CHECK(r.read_wstring() == L"Fireball é");
+  AURA_CHECK(r.read_float() == -2.5f);
+  AURA_CHECK(r.read_bool());
+  AURA_CHECK(!r.error());
+}
+
+AURA_TEST(session_round_trips)
+{
+  auto const engine = make_played_engine();
+  auto const& session = engine.get_session_info();
+  auto const encoded = encode_session(session);
+
+  session_info decoded;
+  AURA_REQUIRE(!decode_session(encoded, decoded));
+  AURA_CHECK(hash_session(decoded) == hash_session(session));
+  AURA_CHECK(diff_sessions(decoded, session).empty());
+  AURA_CHECK(encode_session(decoded) == encoded);
+}
+
+AURA_TEST(truncated_session_fails_to_decode)
+{
+  auto const engine = make_played_engine();
+  auto const encoded = encode_session(engine.get_session_info());
+  for (size_t size = 0; size < encoded.size(); size += 1 + size / 16)
+  {
+    session_info decoded;
+    AURA_CHECK(decode_session(std::string_view{encoded}.substr(0, size), decoded));
+  }
+}
+
+AURA_TEST(bogus_vector_size_fails_to_decode)
+{
+  byte_writer w;
+  w.write_int(1'000'000);
+  w.write_int(1);
+
+  byte_reader r{w.buffer};
+  std::vector<player_action> actions;
+  read(r, actions);
+  AURA_CHECK(r.error());
+  AURA_CHECK(actions.empty());
+}
+
+AURA_TEST(requests_round_trip)
+{
+  rest::commit_action::in in{7, 0xfedcba9876543210ull, {{action_type::deploy, 12, 3}, {action_type::end_turn, 0, 0}}};
+  auto const [in_error, in_decoded] = rest::commit_action::to_in(rest::commit_action::to_string(in));
+  AURA_REQUIRE(!in_error);
+  AURA_CHECK(in_decoded.session_id == 7);
+  AURA_CHECK(in_decoded.seat_token == 0xfedcba9876543210ull);
+  AURA_REQUIRE(in_decoded.actions.size() == 2);
+  AURA_CHECK(in_decoded.actions[0].type == action_type::deploy);
+  AURA_CHECK(in_decoded.actions[0].target1 == 12);
+  AURA_CHECK(in_decoded.actions[0].target2 == 3);
+  AURA_CHECK(in_decoded.actions[1].type == action_type::end_turn);
+
+  auto const engine = make_played_engine();
+  rest::commit_action::out out{make_error_code(rules_error::not_legal), 1, 42, engine.get_session_info()};
+  auto const [out_error, out_decoded] = rest::commit_action::to_out(rest::commit_action::to_string(out));
+  AURA_REQUIRE(!out_error);
+  AURA_CHECK(out_decoded.error == make_error_code(rules_error::not_legal));
+  AURA_CHECK(out_decoded.num_applied == 1);
+  AURA_CHECK(out_decoded.version == 42);
+  AURA_CHECK(hash_session(out_decoded.session) == hash_session(engine.get_session_info()));
+
+  // a reply cut short by the transport is an error, not a partial session
+  auto const body = rest::commit_action::to_string(out);
+  auto const [cut_error, cut] = rest::commit_action::to_out(body.substr(0, body.size() / 2));
+  AURA_CHECK(cut_error);
+}
+
+} // namespace aura
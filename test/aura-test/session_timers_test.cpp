@@ -0,0 +1,126 @@
+#include "test.h"
+#include "test_games.h"
+#include <aura-server/session_manager.h>
+#include <thread>
+
+namespace aura
+{
+
+namespace {
+
+session_info info_of(session_manager& sessions, int session_id)
+{
+  session_info info;
+  sessions.with_session(session_id, [&](hosted_session& s) { info = s.engine->get_session_info(); });
+  return info;
+}
+
+void tick_for(session_manager& sessions, std::chrono::milliseconds duration)
+{
+  auto const end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end)
+  {
+    sessions.tick();
+    std::this_thread::sleep_for(session_manager::timer_tick);
+  }
+}
+
+} // namespace {}
+
+AURA_TEST(turn_timer_rearms_for_every_turn)
+{
+  session_manager sessions{ruleset{}, 1};
+  sessions.enable_timers({std::chrono::seconds{0}, std::chrono::seconds{3600}});
+  auto const id = sessions.create_session(game_mode::PvP);
+  auto const first = info_of(sessions, id);
+
+  // with no time allowed, every turn is ended for the player as soon as
+  // the timer is armed for it again
+  tick_for(sessions, std::chrono::milliseconds{300});
+  auto const later = info_of(sessions, id);
+  AURA_CHECK(later.game_over || later.turn > first.turn + 1);
+}
+
+AURA_TEST(abandoned_session_is_forfeited)
+{
+  session_manager sessions{ruleset{}, 1};
+  sessions.enable_timers({std::chrono::seconds{3600}, std::chrono::seconds{0}});
+  auto const id = sessions.create_session(game_mode::PvP);
+
+  tick_for(sessions, std::chrono::milliseconds{100});
+  AURA_CHECK(info_of(sessions, id).game_over);
+}
+
+AURA_TEST(recovered_session_times_out)
+{
+  // a game as the action log brings it back after a restart
+  session_manager before{ruleset{}, 1};
+  auto const id = before.create_session(game_mode::PvP);
+  std::string snapshot;
+  before.with_session(id, [&](hosted_session& s) { snapshot = s.engine->snapshot(); });
+  auto const tokens = seat_tokens{before.seat_token(id, 0), before.seat_token(id, 1)};
+  auto const recover = [&](session_manager& sessions)
+  {
+    auto [error, engine] = local_rules_engine::restore(snapshot);
+    AURA_REQUIRE(!error);
+    sessions.adopt_session(id, tokens, std::move(engine), 0);
+  };
+
+  // recovered once the timers run, as aura_server does it
+  session_manager after{ruleset{}, 1};
+  after.enable_timers({std::chrono::seconds{0}, std::chrono::seconds{3600}});
+  recover(after);
+  auto const first = info_of(after, id);
+  tick_for(after, std::chrono::milliseconds{300});
+  auto const later = info_of(after, id);
+  AURA_CHECK(later.game_over || later.turn > first.turn);
+
+  // recovered before the timers were enabled, and abandoned
+  session_manager early{ruleset{}, 1};
+  recover(early);
+  early.enable_timers({std::chrono::seconds{3600}, std::chrono::seconds{0}});
+  tick_for(early, std::chrono::milliseconds{100});
+  AURA_CHECK(info_of(early, id).game_over);
+}
+
+AURA_TEST(finished_session_is_dropped)
+{
+  test::scratch_directory dir{"finished"};
+  session_manager sessions{ruleset{}, 1};
+  sessions.enable_hibernation({dir.path(), std::chrono::seconds{0}});
+  sessions.enable_timers({std::chrono::seconds{3600}, std::chrono::seconds{3600}, std::chrono::seconds{1}});
+  auto const id = sessions.create_session(game_mode::PvP);
+  sessions.with_session(id, [&](hosted_session& s)
+  {
+    AURA_REQUIRE(!s.engine->commit_action({action_type::forfeit, 0, 0}));
+    sessions.record_action(s, {action_type::forfeit, 0, 0});
+  });
+
+  // the result can still be fetched for a while, from disk at first
+  tick_for(sessions, std::chrono::milliseconds{300});
+  AURA_CHECK(sessions.stats().num_hibernated == 1);
+  AURA_CHECK(info_of(sessions, id).game_over);
+
+  tick_for(sessions, std::chrono::milliseconds{1300});
+  AURA_CHECK(sessions.size() == 0);
+  AURA_CHECK(sessions.stats().num_hibernated == 0);
+  AURA_CHECK(sessions.with_session(id, [](hosted_session&) {}) == std::errc::invalid_argument);
+  AURA_CHECK(std::filesystem::is_empty(dir.path()));
+}
+
+AURA_TEST(abandoned_relayed_session_is_dropped)
+{
+  session_manager sessions{ruleset{}, 1};
+  sessions.enable_timers({std::chrono::seconds{3600}, std::chrono::seconds{0}});
+  auto const relayed = sessions.create_session(game_mode::lockstep);
+  auto const hosted = sessions.create_session(game_mode::PvP);
+
+  tick_for(sessions, std::chrono::milliseconds{100});
+  AURA_CHECK(sessions.seat_token(relayed, 0) == 0);
+  AURA_CHECK(sessions.size() == 1);
+
+  // the hosted game is forfeited and kept for its players to see
+  AURA_CHECK(info_of(sessions, hosted).game_over);
+}
+
+} // namespace aura
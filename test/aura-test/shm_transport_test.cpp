@@ -0,0 +1,64 @@
+#include "test.h"
+#include <aura-core/shm_transport.h>
+#include <aura-server/shm_server.h>
+#include <chrono>
+#include <thread>
+
+namespace aura
+{
+
+namespace {
+
+std::string unique_name()
+{
+  return "/aura-test-shm-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+//! Connects to 'name' once the server has freed a channel, or gives up
+std::unique_ptr<shm_transport> connect_within(std::string const& name, std::chrono::milliseconds limit)
+{
+  auto const end = std::chrono::steady_clock::now() + limit;
+  while (std::chrono::steady_clock::now() < end)
+  {
+    if (auto [error, transport] = make_shm_transport(name, std::chrono::seconds{1}); !error)
+    {
+      return std::move(transport);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+  }
+  return nullptr;
+}
+
+} // namespace {}
+
+AURA_TEST(timed_out_client_hands_its_channel_back)
+{
+  auto const name = unique_name();
+  shm_server server{{name, 1}};
+  server.add_route("/slow", [](std::string const&)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds{300});
+    return std::string{"late"};
+  });
+  server.add_route("/echo", [](std::string const& body) { return body; });
+  AURA_REQUIRE(!server.start());
+
+  auto [error, impatient] = make_shm_transport(name, std::chrono::milliseconds{50});
+  AURA_REQUIRE(!error);
+  AURA_CHECK(impatient->request("/slow", {}).first == std::errc::timed_out);
+  AURA_CHECK(impatient->request("/echo", "x").first == std::errc::connection_aborted);
+
+  // the only channel is reset and freed, and the late response is dropped
+  auto next = connect_within(name, std::chrono::seconds{2});
+  AURA_REQUIRE(next);
+  auto const [echo_error, echo] = next->request("/echo", "hello");
+  AURA_CHECK(!echo_error);
+  AURA_CHECK(echo == "hello");
+
+  // the client that lost the channel must not free it from under the new one
+  impatient.reset();
+  AURA_CHECK(make_shm_transport(name).first == std::errc::connection_refused);
+  AURA_CHECK(next->request("/echo", "again").second == "again");
+}
+
+} // namespace aura
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+namespace aura::test
+{
+
+struct test_case
+{
+  char const* name;
+  void (*fn)();
+};
+
+//! Every test case, in the order their files registered them
+std::vector<test_case>& registry();
+
+struct registrar
+{
+  registrar(char const* name, void (*fn)())
+  {
+    registry().push_back({name, fn});
+  }
+};
+
+//! Records a failed check of the running test case
+void fail(char const* file, int line, char const* expr);
+
+} // namespace aura::test
+
+//! Defines a test case; main() runs each one in turn
+#define AURA_TEST(name) \
+  static void name(); \
+  static ::aura::test::registrar name##_registrar{#name, &name}; \
+  static void name()
+
+//! Fails the running test case if 'cond' is false, and carries on
+#define AURA_CHECK(cond) \
+  do { if (!(cond)) ::aura::test::fail(__FILE__, __LINE__, #cond); } while (0)
+
+//! Fails the running test case and leaves it if 'cond' is false
+#define AURA_REQUIRE(cond) \
+  do { if (!(cond)) { ::aura::test::fail(__FILE__, __LINE__, #cond); return; } } while (0)
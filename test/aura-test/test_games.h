@@ -0,0 +1,123 @@
+#pragma once
+
+#include <aura-core/local_rules_engine.h>
+#include <aura-core/player_action.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace aura::test
+{
+
+//! Plays whatever it can afford, then attacks down its lanes, then ends the
+//! turn; the same seed makes the same choices for the same sessions
+class bot
+{
+public:
+  explicit bot(std::uint64_t seed)
+    : m_rng{static_cast<unsigned>(seed)}
+  {
+  }
+
+  player_action next(session_info const& info)
+  {
+    if (info.turn != m_turn || info.current_player != m_player)
+    {
+      m_tried.clear();
+      m_turn = info.turn;
+      m_player = info.current_player;
+    }
+
+    auto const& me = info.players[info.current_player];
+    auto const& other = info.players[1 - info.current_player];
+    if (!info.picks.empty() && me.picks_available)
+    {
+      return {action_type::pick, info.picks[m_rng() % info.picks.size()].uid, 0};
+    }
+    for (auto const& card : me.hand)
+    {
+      if (card.cost <= me.mana && !card.has_trait(unit_traits::item) && try_card(card.uid))
+      {
+        return {action_type::deploy, card.uid, static_cast<int>(1 + m_rng() % me.lanes.size())};
+      }
+    }
+    for (size_t l = 0; l < me.lanes.size(); ++l)
+    {
+      for (auto const& card : me.lanes[l])
+      {
+        if (card.energy > 0 && card.action_type != card_action_type::none && try_card(card.uid))
+        {
+          auto const& target_lane = other.lanes[l];
+          return {action_type::primary_action, card.uid, target_lane.empty() ? other.uid : target_lane.back().uid};
+        }
+      }
+    }
+    return {action_type::end_turn, 0, 0};
+  }
+
+private:
+  bool try_card(int uid)
+  {
+    if (std::find(m_tried.begin(), m_tried.end(), uid) != m_tried.end())
+    {
+      return false;
+    }
+    m_tried.push_back(uid);
+    return true;
+  }
+
+  std::mt19937 m_rng;
+  std::vector<int> m_tried;
+  int m_turn{-1};
+  int m_player{-1};
+};
+
+//! Lets 'b' play 'num_actions' actions on 'engine' (or until the game ends);
+//! returns the ones the engine accepted, in order
+inline std::vector<player_action> play(local_rules_engine& engine, bot& b, int num_actions)
+{
+  std::vector<player_action> accepted;
+  for (int i = 0; i < num_actions && !engine.is_game_over(); ++i)
+  {
+    auto const action = b.next(engine.get_session_info());
+    if (!engine.commit_action(action))
+    {
+      accepted.push_back(action);
+    }
+  }
+  return accepted;
+}
+
+//! An empty directory of its own under the system's temporary directory,
+//! removed again when the test is done with it
+class scratch_directory
+{
+public:
+  explicit scratch_directory(std::string const& name)
+    : m_path{std::filesystem::temp_directory_path() / ("aura-test-" + name)}
+  {
+    std::error_code e;
+    std::filesystem::remove_all(m_path, e);
+    std::filesystem::create_directories(m_path, e);
+  }
+
+  ~scratch_directory()
+  {
+    std::error_code e;
+    std::filesystem::remove_all(m_path, e);
+  }
+
+  scratch_directory(scratch_directory const&) = delete;
+  scratch_directory& operator=(scratch_directory const&) = delete;
+
+  std::filesystem::path const& path() const noexcept { return m_path; }
+
+private:
+  std::filesystem::path m_path;
+};
+
+} // namespace aura::test
@@ -0,0 +1,146 @@
+#include "test.h"
+#include <aura-server/timing_wheel.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace aura
+{
+
+namespace {
+
+struct test_timer : wheel_timer
+{
+  std::uint64_t fired_at{0};
+  int times_fired{0};
+};
+
+test_timer& owner(wheel_timer& t)
+{
+  return static_cast<test_timer&>(t);
+}
+
+} // namespace {}
+
+AURA_TEST(timing_wheel_fires_on_deadline)
+{
+  // on either side of every level boundary, plus a spread of random ones
+  std::vector<std::uint64_t> deadlines{1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097,
+    262143, 262144, 262145, 300000};
+  std::mt19937 rng{1};
+  for (int i = 0; i < 200; ++i)
+  {
+    deadlines.push_back(1 + rng() % 400000);
+  }
+
+  timing_wheel wheel{0};
+  auto timers = std::make_unique<test_timer[]>(deadlines.size());
+  for (size_t i = 0; i < deadlines.size(); ++i)
+  {
+    wheel.arm(timers[i], deadlines[i]);
+  }
+  AURA_CHECK(wheel.size() == deadlines.size());
+
+  // tick by tick for the near ones, then in strides like the server does
+  auto const on_expire = [&](wheel_timer& t)
+  {
+    owner(t).fired_at = wheel.now();
+    ++owner(t).times_fired;
+  };
+  for (std::uint64_t now = 1; now <= 5000; ++now)
+  {
+    wheel.advance(now, on_expire);
+  }
+  wheel.advance(400000, on_expire);
+
+  AURA_CHECK(wheel.size() == 0);
+  for (size_t i = 0; i < deadlines.size(); ++i)
+  {
+    AURA_CHECK(timers[i].times_fired == 1);
+    if (deadlines[i] <= 5000)
+    {
+      AURA_CHECK(timers[i].fired_at == deadlines[i]);
+    }
+  }
+}
+
+AURA_TEST(timing_wheel_fires_in_deadline_order)
+{
+  timing_wheel wheel{1000};
+  test_timer timers[3];
+  wheel.arm(timers[0], 1000 + 5000);
+  wheel.arm(timers[1], 1000 + 70);
+  wheel.arm(timers[2], 1000 + 300);
+
+  std::vector<std::uint64_t> fired;
+  wheel.advance(1000 + 10000, [&](wheel_timer& t) { fired.push_back(t.deadline); });
+  AURA_REQUIRE(fired.size() == 3);
+  AURA_CHECK(fired[0] == 1070 && fired[1] == 1300 && fired[2] == 6000);
+}
+
+AURA_TEST(timing_wheel_cancel_and_rearm)
+{
+  timing_wheel wheel{0};
+  test_timer a;
+  test_timer b;
+  wheel.arm(a, 100);
+  wheel.arm(b, 100);
+  wheel.cancel(a);
+  AURA_CHECK(!a.armed());
+  AURA_CHECK(wheel.size() == 1);
+  wheel.cancel(a);  // cancelling twice is harmless
+  AURA_CHECK(wheel.size() == 1);
+
+  // re-arming moves a timer rather than adding a second one
+  wheel.arm(b, 5000);
+  wheel.arm(b, 200);
+  AURA_CHECK(wheel.size() == 1);
+
+  auto const on_expire = [&](wheel_timer& t)
+  {
+    owner(t).fired_at = wheel.now();
+    ++owner(t).times_fired;
+  };
+  wheel.advance(10000, on_expire);
+  AURA_CHECK(a.times_fired == 0);
+  AURA_CHECK(b.times_fired == 1);
+  AURA_CHECK(b.fired_at == 200);
+}
+
+AURA_TEST(timing_wheel_clamps_deadlines)
+{
+  timing_wheel wheel{50};
+  test_timer past;
+  test_timer far;
+  wheel.arm(past, 10);
+  wheel.arm(far, ~std::uint64_t{0});
+  AURA_CHECK(past.deadline == 51);
+  AURA_CHECK(far.deadline == 50 + timing_wheel::max_span);
+
+  std::vector<std::uint64_t> fired;
+  wheel.advance(51, [&](wheel_timer& t) { fired.push_back(wheel.now()); owner(t).times_fired++; });
+  AURA_CHECK(fired.size() == 1);
+  AURA_CHECK(past.times_fired == 1);
+  AURA_CHECK(far.armed());
+}
+
+AURA_TEST(timing_wheel_rearm_from_callback)
+{
+  // the way a turn timer keeps itself going
+  timing_wheel wheel{0};
+  test_timer t;
+  wheel.arm(t, 10);
+  std::vector<std::uint64_t> fired;
+  wheel.advance(100, [&](wheel_timer& timer)
+  {
+    fired.push_back(wheel.now());
+    if (fired.size() < 5)
+    {
+      wheel.arm(timer, wheel.now() + 10);
+    }
+  });
+  AURA_CHECK((fired == std::vector<std::uint64_t>{10, 20, 30, 40, 50}));
+  AURA_CHECK(wheel.size() == 0);
+}
+
+} // namespace aura